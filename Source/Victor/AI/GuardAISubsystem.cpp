@@ -0,0 +1,418 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GuardAISubsystem.h"
+
+#include "VictorCharacter.h"
+#include "VictorStats.h"
+#include "Async/ParallelFor.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Characters/CharacterUpdateSubsystem.h"
+#include "Perception/GuardPerceptionSubsystem.h"
+#include "World/SpatialHash2D.h"
+
+DECLARE_CYCLE_STAT(TEXT("Guard AI decisions"), STAT_VictorGuardAIDecide, STATGROUP_Victor);
+DECLARE_CYCLE_STAT(TEXT("Guard AI apply"), STAT_VictorGuardAIApply, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Guard AI guards"), STAT_VictorGuardAIGuards, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Guard AI decisions"), STAT_VictorGuardAIDecisions, STATGROUP_Victor);
+
+//a guard that wants to walk but hasn't moved for this long turns around
+static const float GuardBlockedTurnTime = 0.5f;
+
+void FGuardAIKernel::Run(const TArray<int32>& Slots, const TArray<FGuardAIInput>& Inputs, TArray<FGuardAIState>& States, TArray<FGuardAICommand>& Commands, bool bParallel) const
+{
+	ParallelFor(Slots.Num(), [&](int32 Index)
+	{
+		const int32 Slot = Slots[Index];
+		Decide(Inputs[Slot], States[Slot], Commands[Slot]);
+	}, !bParallel);
+}
+
+void FGuardAIKernel::Decide(const FGuardAIInput& Input, FGuardAIState& State, FGuardAICommand& Command) const
+{
+	Command = FGuardAICommand();
+	if (!Input.bActive)
+	{
+		return;
+	}
+
+	const float DeltaTime = Input.DeltaTime;
+	const EGuardAIState PreviousState = State.State;
+	State.StateTime += DeltaTime;
+	if (Input.bSeesTarget)
+	{
+		State.LastKnownLocation = Input.TargetLocation;
+		State.TimeSinceSeen = 0.f;
+	}
+	else
+	{
+		State.TimeSinceSeen += DeltaTime;
+	}
+
+	const FVector2D ToTarget = State.LastKnownLocation - Input.Location;
+	const float FaceTarget = FMath::Sign(ToTarget.X);
+	const bool bTargetInReach = FMath::Abs(ToTarget.Y) <= AttackHeight;
+
+	switch (State.State)
+	{
+	case EGuardAIState::EGS_Patrol:
+	case EGuardAIState::EGS_Suspicious:
+		if (Input.bSeesTarget)
+		{
+			State.Suspicion = FMath::Min(State.Suspicion + DeltaTime / FMath::Max(SuspicionRiseTime, KINDA_SMALL_NUMBER), 1.f);
+		}
+		else
+		{
+			State.Suspicion = FMath::Max(State.Suspicion - DeltaTime / FMath::Max(SuspicionDecayTime, KINDA_SMALL_NUMBER), 0.f);
+		}
+		if (State.Suspicion >= 1.f)
+		{
+			State.State = EGuardAIState::EGS_Chase;
+		}
+		else
+		{
+			State.State = State.Suspicion > 0.f ? EGuardAIState::EGS_Suspicious : EGuardAIState::EGS_Patrol;
+		}
+		break;
+
+	case EGuardAIState::EGS_Chase:
+		if (Input.bSeesTarget && bTargetInReach && FMath::Abs(ToTarget.X) <= Input.AttackRange)
+		{
+			State.State = EGuardAIState::EGS_Attack;
+		}
+		else if (State.TimeSinceSeen > ChaseMemory)
+		{
+			//still alert, seeing the target again brings the guard back almost at once
+			State.State = EGuardAIState::EGS_Suspicious;
+			State.Suspicion = 0.99f;
+		}
+		break;
+
+	case EGuardAIState::EGS_Attack:
+		if (!Input.bSeesTarget || !bTargetInReach || FMath::Abs(ToTarget.X) > Input.AttackRange * AttackRangeSlack)
+		{
+			State.State = EGuardAIState::EGS_Chase;
+		}
+		break;
+	}
+
+	if (State.State != PreviousState)
+	{
+		State.StateTime = 0.f;
+		State.BlockedTime = 0.f;
+		Command.bStateChanged = true;
+		if (State.State == EGuardAIState::EGS_Patrol)
+		{
+			//patrol around where the guard gave up
+			State.PatrolOriginX = Input.Location.X;
+		}
+	}
+
+	switch (State.State)
+	{
+	case EGuardAIState::EGS_Patrol:
+	{
+		if ((Input.Location.X - State.PatrolOriginX) * State.PatrolDirection > PatrolHalfWidth)
+		{
+			State.PatrolDirection = -State.PatrolDirection;
+		}
+		State.BlockedTime = FMath::Abs(Input.VelocityX) < 1.f ? State.BlockedTime + DeltaTime : 0.f;
+		if (State.BlockedTime > GuardBlockedTurnTime)
+		{
+			State.PatrolDirection = -State.PatrolDirection;
+			State.BlockedTime = 0.f;
+		}
+		Command.MoveInput = State.PatrolDirection * PatrolMoveScale;
+		break;
+	}
+
+	case EGuardAIState::EGS_Suspicious:
+		Command.FaceDirection = FaceTarget;
+		break;
+
+	case EGuardAIState::EGS_Chase:
+		if (FMath::Abs(ToTarget.X) > ArriveDistance)
+		{
+			Command.MoveInput = FaceTarget;
+		}
+		else
+		{
+			Command.FaceDirection = FaceTarget;
+		}
+		break;
+
+	case EGuardAIState::EGS_Attack:
+		Command.FaceDirection = FaceTarget;
+		//AVictorCharacter::Attack has no melee, so guards without a gun only keep facing the target
+		Command.bFire = Input.bRanged && Input.bCanShoot;
+		break;
+	}
+}
+
+void UGuardAISubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	Collection.InitializeDependency(UGuardPerceptionSubsystem::StaticClass());
+
+	UCharacterUpdateSubsystem* Characters = Cast<UCharacterUpdateSubsystem>(Collection.InitializeDependency(UCharacterUpdateSubsystem::StaticClass()));
+	if (Characters != nullptr)
+	{
+		RegisteredHandle = Characters->OnCharacterRegistered.AddUObject(this, &UGuardAISubsystem::AddCharacter);
+		UnregisteredHandle = Characters->OnCharacterUnregistered.AddUObject(this, &UGuardAISubsystem::RemoveCharacter);
+		for (AVictorCharacter* Character : Characters->GetCharacters())
+		{
+			AddCharacter(Character);
+		}
+	}
+}
+
+void UGuardAISubsystem::Deinitialize()
+{
+	if (UCharacterUpdateSubsystem* Characters = GetWorld()->GetSubsystem<UCharacterUpdateSubsystem>())
+	{
+		Characters->OnCharacterRegistered.Remove(RegisteredHandle);
+		Characters->OnCharacterUnregistered.Remove(UnregisteredHandle);
+	}
+	for (AVictorCharacter* Guard : Guards)
+	{
+		if (Guard != nullptr)
+		{
+			Guard->GuardAISlot = INDEX_NONE;
+		}
+	}
+	Guards.Empty();
+	Inputs.Empty();
+	States.Empty();
+	Commands.Empty();
+	TimeToUpdate.Empty();
+	TimeSinceUpdate.Empty();
+	DueSlots.Empty();
+
+	Super::Deinitialize();
+}
+
+EGuardAIState UGuardAISubsystem::GetGuardState(const AVictorCharacter* Guard) const
+{
+	return Guard != nullptr && States.IsValidIndex(Guard->GuardAISlot) ? States[Guard->GuardAISlot].State : EGuardAIState::EGS_Patrol;
+}
+
+void UGuardAISubsystem::SetViewOverride(const FVector2D& Center)
+{
+	ViewOverrideCenter = Center;
+	bHasViewOverride = true;
+}
+
+void UGuardAISubsystem::AddCharacter(AVictorCharacter* Character)
+{
+	if (Character->GetTeam() != ETeam::ET_Guards || Character->GuardAISlot != INDEX_NONE)
+	{
+		return;
+	}
+
+	const int32 Slot = Guards.Add(Character);
+	Character->GuardAISlot = Slot;
+	Inputs.AddZeroed();
+	FGuardAIState& State = States.AddDefaulted_GetRef();
+	State.PatrolOriginX = Character->GetActorLocation().X;
+	State.PatrolDirection = Character->GetActorForwardVector().X >= 0.f ? 1.f : -1.f;
+	Commands.AddDefaulted();
+	//spread the first decisions of guards far away over the interval, so they don't all land on one frame
+	TimeToUpdate.Add((Slot % 8) * MidUpdateInterval / 8.f);
+	TimeSinceUpdate.Add(0.f);
+}
+
+void UGuardAISubsystem::RemoveCharacter(AVictorCharacter* Character)
+{
+	const int32 Slot = Character->GuardAISlot;
+	if (!Guards.IsValidIndex(Slot) || Guards[Slot] != Character)
+	{
+		return;
+	}
+
+	Guards.RemoveAtSwap(Slot, 1, false);
+	Inputs.RemoveAtSwap(Slot, 1, false);
+	States.RemoveAtSwap(Slot, 1, false);
+	Commands.RemoveAtSwap(Slot, 1, false);
+	TimeToUpdate.RemoveAtSwap(Slot, 1, false);
+	TimeSinceUpdate.RemoveAtSwap(Slot, 1, false);
+	if (Guards.IsValidIndex(Slot))
+	{
+		Guards[Slot]->GuardAISlot = Slot;
+	}
+	Character->GuardAISlot = INDEX_NONE;
+}
+
+bool UGuardAISubsystem::GetViewCenter(FVector2D& OutCenter) const
+{
+	if (bHasViewOverride)
+	{
+		OutCenter = ViewOverrideCenter;
+		return true;
+	}
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (PlayerController == nullptr || PlayerController->PlayerCameraManager == nullptr)
+	{
+		return false;
+	}
+	OutCenter = ToPlane2D(PlayerController->PlayerCameraManager->GetCameraCachePOV().Location);
+	return true;
+}
+
+float UGuardAISubsystem::GetUpdateInterval(const FVector2D& Location, const FVector2D& ViewCenter, bool bHasView) const
+{
+	if (!bHasView)
+	{
+		return 0.f;
+	}
+	const FVector2D Distance = (Location - ViewCenter).GetAbs();
+	if (Distance.X <= NearHalfExtent.X && Distance.Y <= NearHalfExtent.Y)
+	{
+		return 0.f;
+	}
+	if (Distance.X <= MidHalfExtent.X && Distance.Y <= MidHalfExtent.Y)
+	{
+		return MidUpdateInterval;
+	}
+	return FarUpdateInterval;
+}
+
+void UGuardAISubsystem::GatherDueGuards(float DeltaTime)
+{
+	DueSlots.Reset();
+	FVector2D ViewCenter = FVector2D::ZeroVector;
+	const bool bHasView = GetViewCenter(ViewCenter);
+	const UGuardPerceptionSubsystem* Perception = GetWorld()->GetSubsystem<UGuardPerceptionSubsystem>();
+
+	for (int32 Slot = 0; Slot < Guards.Num(); Slot++)
+	{
+		AVictorCharacter* Guard = Guards[Slot];
+		TimeSinceUpdate[Slot] += DeltaTime;
+		TimeToUpdate[Slot] -= DeltaTime;
+		//GetTeam also leaves out the body the player spawned in once the player moved on to another one
+		if (Guard->GetTeam() != ETeam::ET_Guards || Guard->bDead)
+		{
+			//the state is kept for when the body is a guard again, but nothing acts on it
+			Commands[Slot] = FGuardAICommand();
+			Inputs[Slot].bActive = false;
+			continue;
+		}
+		if (TimeToUpdate[Slot] > 0.f)
+		{
+			continue;
+		}
+
+		FGuardAIInput& Input = Inputs[Slot];
+		Input.Location = ToPlane2D(Guard->GetActorLocation());
+		TimeToUpdate[Slot] = FMath::Max(TimeToUpdate[Slot] + GetUpdateInterval(Input.Location, ViewCenter, bHasView), 0.f);
+		Input.VelocityX = Guard->GetVelocity().X;
+		Input.DeltaTime = TimeSinceUpdate[Slot];
+		TimeSinceUpdate[Slot] = 0.f;
+
+		const AVictorCharacter* Target = Perception != nullptr ? Perception->GetVisibleTarget(Guard) : nullptr;
+		Input.bSeesTarget = Target != nullptr;
+		Input.TargetLocation = Target != nullptr ? ToPlane2D(Target->GetActorLocation()) : FVector2D::ZeroVector;
+
+		AWeaponBase* Weapon = Guard->Weapon;
+		const bool bRanged = Weapon != nullptr && (Weapon->bHitscan || Weapon->ProjectileSpeed > 0.f);
+		Input.bRanged = bRanged;
+		Input.bCanShoot = Weapon == nullptr || Weapon->CanShoot();
+		Input.AttackRange = bRanged
+			? FMath::Min(RangedAttackRange, Weapon->bHitscan ? Weapon->HitscanRange : Weapon->ProjectileSpeed * Weapon->ProjectileLifetime)
+			: MeleeAttackRange;
+		Input.bActive = true;
+		DueSlots.Add(Slot);
+	}
+}
+
+void UGuardAISubsystem::ApplyCommands()
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorGuardAIApply);
+
+	//guards keep walking with their last decision between decisions
+	for (int32 Slot = 0; Slot < Guards.Num(); Slot++)
+	{
+		if (Commands[Slot].MoveInput != 0.f)
+		{
+			Guards[Slot]->MoveRight(Commands[Slot].MoveInput);
+		}
+	}
+
+	//Fire and the state change listeners may kill or remove guards and reorder the slots, so work on a copy
+	TArray<TPair<AVictorCharacter*, int32>, TInlineAllocator<64>> Decided;
+	for (const int32 Slot : DueSlots)
+	{
+		Decided.Emplace(Guards[Slot], Slot);
+	}
+	for (const TPair<AVictorCharacter*, int32>& Entry : Decided)
+	{
+		AVictorCharacter* Guard = Entry.Key;
+		if (Guard->IsPendingKill() || Guard->GuardAISlot != Entry.Value)
+		{
+			continue;
+		}
+		const FGuardAICommand Command = Commands[Entry.Value];
+		const EGuardAIState State = States[Entry.Value].State;
+		if (Command.FaceDirection != 0.f)
+		{
+			Guard->UpdateFacing(Command.FaceDirection);
+		}
+		if (Command.bFire && Guard->Weapon != nullptr)
+		{
+			const FVector Start = Guard->GetWeaponSocketLocation();
+			const FVector2D Aim = States[Entry.Value].LastKnownLocation;
+			Guard->Weapon->Fire(Start, FVector(Aim.X - Start.X, 0.f, Aim.Y - Start.Z).Rotation());
+		}
+		if (Command.bStateChanged)
+		{
+			OnGuardStateChanged.Broadcast(Guard, State);
+		}
+	}
+}
+
+FGuardAIKernel UGuardAISubsystem::MakeKernel() const
+{
+	FGuardAIKernel Kernel;
+	Kernel.PatrolHalfWidth = PatrolHalfWidth;
+	Kernel.PatrolMoveScale = PatrolMoveScale;
+	Kernel.SuspicionRiseTime = SuspicionRiseTime;
+	Kernel.SuspicionDecayTime = SuspicionDecayTime;
+	Kernel.ChaseMemory = ChaseMemory;
+	return Kernel;
+}
+
+void UGuardAISubsystem::Tick(float DeltaTime)
+{
+	VICTOR_SCOPE_CYCLE_COUNTER(GuardAI);
+
+	double StartTime = FPlatformTime::Seconds();
+	GatherDueGuards(DeltaTime);
+	Stats.GatherSeconds += FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	{
+		SCOPE_CYCLE_COUNTER(STAT_VictorGuardAIDecide);
+		MakeKernel().Run(DueSlots, Inputs, States, Commands, bRunOnWorkerThreads);
+	}
+	Stats.DecideSeconds += FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	Stats.Frames++;
+	Stats.GuardFrames += Guards.Num();
+	Stats.Decisions += DueSlots.Num();
+	SET_DWORD_STAT(STAT_VictorGuardAIGuards, Guards.Num());
+	SET_DWORD_STAT(STAT_VictorGuardAIDecisions, DueSlots.Num());
+	ApplyCommands();
+	Stats.ApplySeconds += FPlatformTime::Seconds() - StartTime;
+}
+
+TStatId UGuardAISubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGuardAISubsystem, STATGROUP_Tickables);
+}
+
+ETickableTickType UGuardAISubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
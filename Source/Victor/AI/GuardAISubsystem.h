@@ -0,0 +1,238 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "GuardAISubsystem.generated.h"
+
+class AVictorCharacter;
+
+UENUM(BlueprintType)
+enum class EGuardAIState : uint8
+{
+	EGS_Patrol UMETA(DisplayName = "Patrol"),
+	EGS_Suspicious UMETA(DisplayName = "Suspicious"),
+	EGS_Chase UMETA(DisplayName = "Chase"),
+	EGS_Attack UMETA(DisplayName = "Attack")
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnGuardAIStateChanged, AVictorCharacter*, Guard, EGuardAIState, NewState);
+
+/** What a guard knows this update, gathered on the game thread */
+struct FGuardAIInput
+{
+	FVector2D Location;
+	float VelocityX;
+	//location of the target perception says the guard sees, valid with bSeesTarget
+	FVector2D TargetLocation;
+	float AttackRange;
+	//seconds since the guard's last decision
+	float DeltaTime;
+	uint8 bActive : 1;
+	uint8 bSeesTarget : 1;
+	uint8 bRanged : 1;
+	uint8 bCanShoot : 1;
+};
+
+/** What a guard remembers between decisions */
+struct FGuardAIState
+{
+	EGuardAIState State = EGuardAIState::EGS_Patrol;
+	//0 to 1, the guard gives chase at 1
+	float Suspicion = 0.f;
+	float StateTime = 0.f;
+	float TimeSinceSeen = 0.f;
+	float BlockedTime = 0.f;
+	float PatrolOriginX = 0.f;
+	float PatrolDirection = 1.f;
+	FVector2D LastKnownLocation = FVector2D::ZeroVector;
+};
+
+/** What the game thread does for a guard. MoveInput is applied every frame until the next decision */
+struct FGuardAICommand
+{
+	float MoveInput = 0.f;
+	//-1 or 1 to turn towards, 0 to leave facing to movement
+	float FaceDirection = 0.f;
+	uint8 bFire : 1;
+	uint8 bStateChanged : 1;
+
+	FGuardAICommand() : bFire(false), bStateChanged(false) {}
+};
+
+/**
+ * Patrol, suspicion, chase and attack decisions for a batch of guards.
+ * Every guard only reads its own input and writes its own state and command, so the batch runs on worker threads.
+ */
+struct VICTOR_API FGuardAIKernel
+{
+	float PatrolHalfWidth = 600.f;
+
+	float PatrolMoveScale = 0.5f;
+
+	float SuspicionRiseTime = 1.f;
+
+	float SuspicionDecayTime = 4.f;
+
+	float ChaseMemory = 3.f;
+
+	/** Chasing guards stop this close to where they last saw the target */
+	float ArriveDistance = 32.f;
+
+	/** Attackers give chase again once the target is this much further than AttackRange */
+	float AttackRangeSlack = 1.25f;
+
+	float AttackHeight = 150.f;
+
+	/** Decides for the guards in Slots */
+	void Run(const TArray<int32>& Slots, const TArray<FGuardAIInput>& Inputs, TArray<FGuardAIState>& States, TArray<FGuardAICommand>& Commands, bool bParallel) const;
+
+	void Decide(const FGuardAIInput& Input, FGuardAIState& State, FGuardAICommand& Command) const;
+};
+
+/** Where UGuardAISubsystem's time went since ResetStats */
+struct FGuardAIStats
+{
+	int32 Frames = 0;
+
+	int64 GuardFrames = 0;
+
+	int64 Decisions = 0;
+
+	double GatherSeconds = 0.0;
+
+	double DecideSeconds = 0.0;
+
+	double ApplySeconds = 0.0;
+};
+
+/**
+ * Runs every ET_Guards character that no player controls, instead of an AIController and behavior tree per guard.
+ * The guards' state lives in packed arrays indexed by AVictorCharacter::GuardAISlot. Each frame the guards due for a
+ * decision are gathered on the game thread, decided in parallel by FGuardAIKernel, and their MoveRight input, facing
+ * and weapon Fire are applied in one batch. Sight comes from UGuardPerceptionSubsystem.
+ * Guards on or near the screen decide every frame, guards further away every MidUpdateInterval or FarUpdateInterval seconds,
+ * and keep walking with their last decision in between.
+ */
+UCLASS(config=Game)
+class VICTOR_API UGuardAISubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	UFUNCTION(BlueprintPure, Category = GuardAI)
+	EGuardAIState GetGuardState(const AVictorCharacter* Guard) const;
+
+	UPROPERTY(BlueprintAssignable, Category = GuardAI)
+	FOnGuardAIStateChanged OnGuardStateChanged;
+
+	/** Decides around this point instead of the first local player's camera, e.g. for benchmarks */
+	void SetViewOverride(const FVector2D& Center);
+
+	void ClearViewOverride() { bHasViewOverride = false; }
+
+	const FGuardAIStats& GetStats() const { return Stats; }
+
+	void ResetStats() { Stats = FGuardAIStats(); }
+
+	/** How far a patrolling guard walks either side of where it started */
+	UPROPERTY(Config, EditAnywhere, Category = Patrol)
+	float PatrolHalfWidth = 600.f;
+
+	/** Patrolling guards walk at this fraction of their speed */
+	UPROPERTY(Config, EditAnywhere, Category = Patrol, meta = (ClampMin = "0", ClampMax = "1"))
+	float PatrolMoveScale = 0.5f;
+
+	/** Seconds a guard must see the target to give chase */
+	UPROPERTY(Config, EditAnywhere, Category = Suspicion)
+	float SuspicionRiseTime = 1.f;
+
+	/** Seconds a guard that lost sight takes to go back from full suspicion to patrolling */
+	UPROPERTY(Config, EditAnywhere, Category = Suspicion)
+	float SuspicionDecayTime = 4.f;
+
+	/** Seconds a chasing guard keeps going to where it last saw the target */
+	UPROPERTY(Config, EditAnywhere, Category = Chase)
+	float ChaseMemory = 3.f;
+
+	UPROPERTY(Config, EditAnywhere, Category = Attack)
+	float MeleeAttackRange = 120.f;
+
+	/** Upper bound for guards with hitscan or projectile weapons, which also can't shoot further than their weapon reaches */
+	UPROPERTY(Config, EditAnywhere, Category = Attack)
+	float RangedAttackRange = 900.f;
+
+	/** Guards closer than this to the camera on X and Z decide every frame. One screen is 1024 x 576 */
+	UPROPERTY(Config, EditAnywhere, Category = LOD)
+	FVector2D NearHalfExtent = FVector2D(1536.f, 864.f);
+
+	/** Guards between NearHalfExtent and this decide every MidUpdateInterval, guards outside it every FarUpdateInterval */
+	UPROPERTY(Config, EditAnywhere, Category = LOD)
+	FVector2D MidHalfExtent = FVector2D(4096.f, 2304.f);
+
+	UPROPERTY(Config, EditAnywhere, Category = LOD)
+	float MidUpdateInterval = 0.2f;
+
+	UPROPERTY(Config, EditAnywhere, Category = LOD)
+	float FarUpdateInterval = 1.f;
+
+	UPROPERTY(Config, EditAnywhere, Category = GuardAI)
+	bool bRunOnWorkerThreads = true;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return Guards.Num() > 0; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual ETickableTickType GetTickableTickType() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	void AddCharacter(AVictorCharacter* Character);
+
+	void RemoveCharacter(AVictorCharacter* Character);
+
+	/** Fills the inputs of the guards due for a decision this frame */
+	void GatherDueGuards(float DeltaTime);
+
+	void ApplyCommands();
+
+	bool GetViewCenter(FVector2D& OutCenter) const;
+
+	float GetUpdateInterval(const FVector2D& Location, const FVector2D& ViewCenter, bool bHasView) const;
+
+	FGuardAIKernel MakeKernel() const;
+
+	UPROPERTY(Transient)
+	TArray<AVictorCharacter*> Guards;
+
+	TArray<FGuardAIInput> Inputs;
+
+	TArray<FGuardAIState> States;
+
+	TArray<FGuardAICommand> Commands;
+
+	//seconds until each guard's next decision, and since its last one
+	TArray<float> TimeToUpdate;
+
+	TArray<float> TimeSinceUpdate;
+
+	//slots deciding this frame
+	TArray<int32> DueSlots;
+
+	FGuardAIStats Stats;
+
+	FDelegateHandle RegisteredHandle;
+
+	FDelegateHandle UnregisteredHandle;
+
+	FVector2D ViewOverrideCenter = FVector2D::ZeroVector;
+
+	bool bHasViewOverride = false;
+};
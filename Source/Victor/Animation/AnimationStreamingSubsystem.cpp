@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AnimationStreamingSubsystem.h"
+
+#include "VictorCharacter.h"
+#include "VictorStats.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Characters/CharacterUpdateSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Animation streaming"), STAT_VictorAnimationStreaming, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Characters with flipbook bundles"), STAT_VictorPrefetchedCharacters, STATGROUP_Victor);
+
+void UAnimationStreamingSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	Collection.InitializeDependency(UCharacterUpdateSubsystem::StaticClass());
+}
+
+void UAnimationStreamingSubsystem::SetViewOverride(const FVector2D& Center)
+{
+	ViewOverrideCenter = Center;
+	bHasViewOverride = true;
+}
+
+bool UAnimationStreamingSubsystem::GetViewCenter(FVector2D& OutCenter) const
+{
+	if (bHasViewOverride)
+	{
+		OutCenter = ViewOverrideCenter;
+		return true;
+	}
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (PlayerController == nullptr || PlayerController->PlayerCameraManager == nullptr)
+	{
+		return false;
+	}
+	const FVector Location = PlayerController->PlayerCameraManager->GetCameraCachePOV().Location;
+	OutCenter = FVector2D(Location.X, Location.Z);
+	return true;
+}
+
+void UAnimationStreamingSubsystem::Tick(float DeltaTime)
+{
+	TimeSinceUpdate += DeltaTime;
+	if (TimeSinceUpdate < UpdateInterval)
+	{
+		return;
+	}
+	TimeSinceUpdate = 0.f;
+
+	SCOPE_CYCLE_COUNTER(STAT_VictorAnimationStreaming);
+	FVector2D ViewCenter;
+	if (!GetViewCenter(ViewCenter))
+	{
+		return;
+	}
+
+	NumPrefetchedCharacters = 0;
+	const UCharacterUpdateSubsystem* Characters = GetWorld()->GetSubsystem<UCharacterUpdateSubsystem>();
+	for (AVictorCharacter* Character : Characters->GetCharacters())
+	{
+		if (!Character->bLoadAnimationsOnDemand)
+		{
+			continue;
+		}
+		const FVector Location = Character->GetActorLocation();
+		const float DistanceX = FMath::Abs(Location.X - ViewCenter.X);
+		const float DistanceZ = FMath::Abs(Location.Z - ViewCenter.Y);
+		if (Character->bControlledByPlayer || (!Character->bDead && DistanceX <= PrefetchHalfExtent.X && DistanceZ <= PrefetchHalfExtent.Y))
+		{
+			Character->RequestWeaponAnimationBundles();
+		}
+		else if (DistanceX > ReleaseHalfExtent.X || DistanceZ > ReleaseHalfExtent.Y)
+		{
+			//the sprite keeps the flipbook it shows now loaded
+			Character->ReleaseAnimationBundles(MinBundleResidency);
+		}
+
+		for (int32 Bundle = 0; Bundle < (int32)EAnimationBundle::Num; Bundle++)
+		{
+			if (Character->IsAnimationBundleRequested((EAnimationBundle)Bundle))
+			{
+				NumPrefetchedCharacters++;
+				break;
+			}
+		}
+	}
+	SET_DWORD_STAT(STAT_VictorPrefetchedCharacters, NumPrefetchedCharacters);
+}
+
+bool UAnimationStreamingSubsystem::IsTickable() const
+{
+	const UCharacterUpdateSubsystem* Characters = GetWorld()->GetSubsystem<UCharacterUpdateSubsystem>();
+	return Characters != nullptr && Characters->GetCharacters().Num() > 0;
+}
+
+TStatId UAnimationStreamingSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAnimationStreamingSubsystem, STATGROUP_Tickables);
+}
+
+ETickableTickType UAnimationStreamingSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
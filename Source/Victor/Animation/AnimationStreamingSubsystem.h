@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "AnimationStreamingSubsystem.generated.h"
+
+/**
+ * Loads the flipbook bundles of characters coming near the side view camera and lets go of them once they are far away,
+ * so only the characters around the player keep their animation sets loaded. See AVictorCharacter::RequestWeaponAnimationBundles.
+ * A character the player controls keeps its bundles wherever it is. Does nothing with victor.AnimationBundles 0,
+ * where every character loads all its bundles when it begins play.
+ */
+UCLASS(config=Game)
+class VICTOR_API UAnimationStreamingSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Prefetches around this point instead of the first local player's camera, e.g. for benchmarks */
+	void SetViewOverride(const FVector2D& Center);
+
+	void ClearViewOverride() { bHasViewOverride = false; }
+
+	/** Characters holding bundles after the last update */
+	int32 GetNumPrefetchedCharacters() const { return NumPrefetchedCharacters; }
+
+	/** Characters closer than this to the camera on X and Z get the bundles for their weapon. One screen is 1024 x 576 */
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	FVector2D PrefetchHalfExtent = FVector2D(2048.f, 1152.f);
+
+	/** Characters further than this let go of their bundles, larger than PrefetchHalfExtent so walking back and forth doesn't reload them */
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	FVector2D ReleaseHalfExtent = FVector2D(3072.f, 1728.f);
+
+	/**
+	 * Seconds a bundle stays loaded after it was last requested, even far from the camera. A character out there changing
+	 * state requests the bundle of its new flipbook, which would otherwise be loaded and released again on every pass
+	 */
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	float MinBundleResidency = 4.f;
+
+	/** Seconds between two passes over the characters */
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	float UpdateInterval = 0.25f;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual ETickableTickType GetTickableTickType() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	bool GetViewCenter(FVector2D& OutCenter) const;
+
+	FVector2D ViewOverrideCenter = FVector2D::ZeroVector;
+
+	bool bHasViewOverride = false;
+
+	float TimeSinceUpdate = 0.f;
+
+	int32 NumPrefetchedCharacters = 0;
+};
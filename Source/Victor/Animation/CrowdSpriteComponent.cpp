@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CrowdSpriteComponent.h"
+
+#include "VictorStats.h"
+#include "PaperFlipbook.h"
+#include "PaperSprite.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd sprite instances changed"), STAT_VictorCrowdInstancesChanged, STATGROUP_Victor);
+
+UCrowdSpriteComponent::UCrowdSpriteComponent()
+{
+	SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	SetGenerateOverlapEvents(false);
+	CastShadow = false;
+}
+
+int32 UCrowdSpriteComponent::AddCrowdInstance(const FCrowdSpriteInstance& Instance)
+{
+	CrowdInstances.Add(Instance);
+	NumChangedInstances++;
+	return AddInstance(GetInstanceTransform(Instance), GetInstanceSprite(Instance), false, Instance.Tint);
+}
+
+void UCrowdSpriteComponent::RemoveCrowdInstance(int32 Index)
+{
+	if (!CrowdInstances.IsValidIndex(Index))
+	{
+		return;
+	}
+	CrowdInstances.RemoveAtSwap(Index, 1, false);
+	PerInstanceSpriteData.RemoveAtSwap(Index, 1, false);
+	NumChangedInstances++;
+}
+
+void UCrowdSpriteComponent::SetCrowdInstance(int32 Index, const FCrowdSpriteInstance& Instance)
+{
+	if (!CrowdInstances.IsValidIndex(Index) || CrowdInstances[Index] == Instance)
+	{
+		return;
+	}
+	const FCrowdSpriteInstance& Previous = CrowdInstances[Index];
+	FSpriteInstanceData& SpriteData = PerInstanceSpriteData[Index];
+	if (Previous.Location != Instance.Location || Previous.Scale != Instance.Scale || Previous.bFacingLeft != Instance.bFacingLeft)
+	{
+		SpriteData.Transform = GetInstanceTransform(Instance).ToMatrixWithScale();
+	}
+	if (Previous.Flipbook != Instance.Flipbook || Previous.FrameIndex != Instance.FrameIndex)
+	{
+		//frames of the character's flipbooks share the default sprite material, so the material slot stays
+		SpriteData.SourceSprite = GetInstanceSprite(Instance);
+	}
+	SpriteData.VertexColor = Instance.Tint.ToFColor(false);
+	CrowdInstances[Index] = Instance;
+	NumChangedInstances++;
+}
+
+void UCrowdSpriteComponent::FlushCrowdInstances()
+{
+	SET_DWORD_STAT(STAT_VictorCrowdInstancesChanged, NumChangedInstances);
+	if (NumChangedInstances > 0)
+	{
+		MarkRenderStateDirty();
+		NumChangedInstances = 0;
+	}
+}
+
+void UCrowdSpriteComponent::ClearCrowdInstances()
+{
+	CrowdInstances.Reset();
+	ClearInstances();
+	NumChangedInstances = 0;
+}
+
+FTransform UCrowdSpriteComponent::GetInstanceTransform(const FCrowdSpriteInstance& Instance)
+{
+	return FTransform(Instance.bFacingLeft ? FRotator(0.f, 180.f, 0.f) : FRotator::ZeroRotator, Instance.Location, Instance.Scale);
+}
+
+UPaperSprite* UCrowdSpriteComponent::GetInstanceSprite(const FCrowdSpriteInstance& Instance)
+{
+	return Instance.Flipbook != nullptr ? Instance.Flipbook->GetSpriteAtFrame(Instance.FrameIndex) : nullptr;
+}
@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PaperGroupedSpriteComponent.h"
+#include "CrowdSpriteComponent.generated.h"
+
+class UPaperFlipbook;
+
+/** What one character looks like this frame */
+struct FCrowdSpriteInstance
+{
+	FVector Location = FVector::ZeroVector;
+	FVector Scale = FVector::OneVector;
+	UPaperFlipbook* Flipbook = nullptr;
+	int32 FrameIndex = INDEX_NONE;
+	FLinearColor Tint = FLinearColor::White;
+	bool bFacingLeft = false;
+
+	bool operator==(const FCrowdSpriteInstance& Other) const
+	{
+		return Location == Other.Location
+			&& Scale == Other.Scale
+			&& Flipbook == Other.Flipbook
+			&& FrameIndex == Other.FrameIndex
+			&& Tint == Other.Tint
+			&& bFacingLeft == Other.bFacingLeft;
+	}
+};
+
+/**
+ * Draws the current flipbook frame of many characters as instances of one grouped sprite component,
+ * so a crowd costs one scene proxy instead of one per character.
+ * Instances only touch the render state when their frame, tint, facing or location changed,
+ * and the proxy is rebuilt at most once per frame in FlushCrowdInstances.
+ * The owner is expected to sit at the world origin, instance locations are world locations.
+ */
+UCLASS()
+class VICTOR_API UCrowdSpriteComponent : public UPaperGroupedSpriteComponent
+{
+	GENERATED_BODY()
+
+public:
+	UCrowdSpriteComponent();
+
+	int32 AddCrowdInstance(const FCrowdSpriteInstance& Instance);
+
+	/** Swaps the last instance into Index, like TArray::RemoveAtSwap */
+	void RemoveCrowdInstance(int32 Index);
+
+	/** Records the instance's state, changing the sprite data only if something differs */
+	void SetCrowdInstance(int32 Index, const FCrowdSpriteInstance& Instance);
+
+	/** Sends this frame's changes to the renderer */
+	void FlushCrowdInstances();
+
+	int32 GetNumCrowdInstances() const { return CrowdInstances.Num(); }
+
+	/** Instances changed since the last flush */
+	int32 GetNumChangedInstances() const { return NumChangedInstances; }
+
+	void ClearCrowdInstances();
+
+protected:
+	static FTransform GetInstanceTransform(const FCrowdSpriteInstance& Instance);
+
+	static UPaperSprite* GetInstanceSprite(const FCrowdSpriteInstance& Instance);
+
+	TArray<FCrowdSpriteInstance> CrowdInstances;
+
+	int32 NumChangedInstances = 0;
+};
@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CrowdSpriteSubsystem.h"
+
+#include "VictorCharacter.h"
+#include "VictorStats.h"
+#include "CrowdSpriteComponent.h"
+#include "PaperFlipbook.h"
+#include "PaperFlipbookComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Crowd sprite update"), STAT_VictorCrowdSpriteUpdate, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd characters"), STAT_VictorCrowdCharacters, STATGROUP_Victor);
+
+namespace
+{
+	FCrowdSpriteInstance MakeInstance(const AVictorCharacter* Character)
+	{
+		const UPaperFlipbookComponent* Sprite = Character->GetSprite();
+		FCrowdSpriteInstance Instance;
+		Instance.Location = Sprite->GetComponentLocation();
+		Instance.Scale = Sprite->GetComponentScale();
+		Instance.Flipbook = Sprite->GetFlipbook();
+		Instance.FrameIndex = Instance.Flipbook != nullptr ? Instance.Flipbook->GetKeyFrameIndexAtTime(Sprite->GetPlaybackPosition()) : INDEX_NONE;
+		Instance.Tint = Sprite->GetSpriteColor();
+		Instance.bFacingLeft = Character->GetActorForwardVector().X < 0.f;
+		return Instance;
+	}
+}
+
+void UCrowdSpriteSubsystem::Deinitialize()
+{
+	for (AVictorCharacter* Character : Characters)
+	{
+		if (Character != nullptr)
+		{
+			Character->CrowdSlot = INDEX_NONE;
+		}
+	}
+	Characters.Empty();
+	CrowdComponent = nullptr;
+
+	Super::Deinitialize();
+}
+
+void UCrowdSpriteSubsystem::AddCharacter(AVictorCharacter* Character)
+{
+	if (Character == nullptr || Character->CrowdSlot != INDEX_NONE)
+	{
+		return;
+	}
+	UCrowdSpriteComponent* Crowd = GetOrCreateCrowdComponent();
+	if (Crowd == nullptr)
+	{
+		return;
+	}
+	Character->CrowdSlot = Characters.Add(Character);
+	Crowd->AddCrowdInstance(MakeInstance(Character));
+	Character->GetSprite()->SetVisibility(false);
+}
+
+void UCrowdSpriteSubsystem::RemoveCharacter(AVictorCharacter* Character)
+{
+	if (Character == nullptr || !Characters.IsValidIndex(Character->CrowdSlot) || Characters[Character->CrowdSlot] != Character)
+	{
+		return;
+	}
+	const int32 Slot = Character->CrowdSlot;
+	Characters.RemoveAtSwap(Slot, 1, false);
+	CrowdComponent->RemoveCrowdInstance(Slot);
+
+	//the last character was moved into the freed slot
+	if (Characters.IsValidIndex(Slot))
+	{
+		Characters[Slot]->CrowdSlot = Slot;
+	}
+	Character->CrowdSlot = INDEX_NONE;
+	Character->GetSprite()->SetVisibility(true);
+}
+
+void UCrowdSpriteSubsystem::UpdateInstances()
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorCrowdSpriteUpdate);
+	for (int32 Slot = 0; Slot < Characters.Num(); Slot++)
+	{
+		CrowdComponent->SetCrowdInstance(Slot, MakeInstance(Characters[Slot]));
+	}
+	CrowdComponent->FlushCrowdInstances();
+	SET_DWORD_STAT(STAT_VictorCrowdCharacters, Characters.Num());
+}
+
+UCrowdSpriteComponent* UCrowdSpriteSubsystem::GetOrCreateCrowdComponent()
+{
+	if (CrowdComponent == nullptr)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.ObjectFlags |= RF_Transient;
+		AActor* Owner = GetWorld()->SpawnActor<AActor>(SpawnParameters);
+		if (Owner == nullptr)
+		{
+			return nullptr;
+		}
+		CrowdComponent = NewObject<UCrowdSpriteComponent>(Owner);
+		Owner->SetRootComponent(CrowdComponent);
+		CrowdComponent->RegisterComponent();
+	}
+	return CrowdComponent;
+}
+
+void UCrowdSpriteSubsystem::Tick(float DeltaTime)
+{
+	UpdateInstances();
+}
+
+TStatId UCrowdSpriteSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCrowdSpriteSubsystem, STATGROUP_Tickables);
+}
+
+ETickableTickType UCrowdSpriteSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "CrowdSpriteSubsystem.generated.h"
+
+class AVictorCharacter;
+class UCrowdSpriteComponent;
+
+/**
+ * Draws every character with bDrawInCrowd through one UCrowdSpriteComponent.
+ * The characters' own flipbook components keep animating but are hidden, so they have no scene proxy;
+ * once per frame their current frame, tint and facing are copied into the crowd instances.
+ * Characters keep their instance in AVictorCharacter::CrowdSlot.
+ */
+UCLASS()
+class VICTOR_API UCrowdSpriteSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	void AddCharacter(AVictorCharacter* Character);
+
+	void RemoveCharacter(AVictorCharacter* Character);
+
+	/** Copies every crowd character's sprite state into its instance. Called from Tick */
+	void UpdateInstances();
+
+	UCrowdSpriteComponent* GetCrowdComponent() const { return CrowdComponent; }
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return Characters.Num() > 0; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual ETickableTickType GetTickableTickType() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	UCrowdSpriteComponent* GetOrCreateCrowdComponent();
+
+	UPROPERTY(Transient)
+	TArray<AVictorCharacter*> Characters;
+
+	UPROPERTY(Transient)
+	UCrowdSpriteComponent* CrowdComponent = nullptr;
+};
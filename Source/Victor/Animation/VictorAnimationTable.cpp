@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VictorAnimationTable.h"
+
+const TSoftObjectPtr<UPaperFlipbook>* UVictorAnimationTable::FindAnimation(uint16 StateKey) const
+{
+	if (!bRulesCompiled)
+	{
+		CompileRules();
+	}
+	return CompiledRules.Find(StateKey);
+}
+
+void UVictorAnimationTable::GetBundlePaths(EAnimationBundle Bundle, TArray<FSoftObjectPath>& OutPaths) const
+{
+	if (!bRulesCompiled)
+	{
+		CompileRules();
+	}
+	for (const TPair<uint16, TSoftObjectPtr<UPaperFlipbook>>& Rule : CompiledRules)
+	{
+		if (GetAnimationBundle(Rule.Key) == Bundle)
+		{
+			OutPaths.AddUnique(Rule.Value.ToSoftObjectPath());
+		}
+	}
+}
+
+#if WITH_EDITOR
+void UVictorAnimationTable::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	bRulesCompiled = false;
+}
+#endif
+
+void UVictorAnimationTable::CompileRules() const
+{
+	CompiledRules.Reset();
+	for (const FVictorAnimationRule& Rule : Rules)
+	{
+		if (!Rule.Flipbook.IsNull())
+		{
+			//later rules override earlier ones
+			CompiledRules.Add(FAnimationStateKey::Make(Rule.WeaponAnimType, Rule.bArmed, Rule.Locomotion, Rule.bDead, Rule.bAttacking), Rule.Flipbook);
+		}
+	}
+	bRulesCompiled = true;
+}
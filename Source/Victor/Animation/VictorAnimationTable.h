@@ -0,0 +1,144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Weapons/WeaponAnimTypes.h"
+#include "VictorAnimationTable.generated.h"
+
+class UPaperFlipbook;
+
+UENUM(BlueprintType)
+enum class ELocomotionState : uint8
+{
+	ELS_Idle UMETA(DisplayName = "Idle"),
+	ELS_Moving UMETA(DisplayName = "Moving"),
+	ELS_Falling UMETA(DisplayName = "Falling"),
+	ELS_HoldingWall UMETA(DisplayName = "HoldingWall")
+};
+
+/** Locomotion state as the animation update sees it. Shared by the per-actor and batched paths */
+inline ELocomotionState ComputeLocomotionState(bool bHoldingWall, float SpeedSquared, bool bFalling)
+{
+	if (bHoldingWall)
+	{
+		return ELocomotionState::ELS_HoldingWall;
+	}
+	if (SpeedSquared > 0.0f)
+	{
+		return bFalling ? ELocomotionState::ELS_Falling : ELocomotionState::ELS_Moving;
+	}
+	return ELocomotionState::ELS_Idle;
+}
+
+/**
+ * Packed (weapon anim type, armed, locomotion, dead, attacking) tuple.
+ * Characters only look up a new flipbook when their key changes.
+ */
+struct FAnimationStateKey
+{
+	static constexpr uint16 Invalid = 0xFFFF;
+
+	static uint16 Make(EWeaponAnimType WeaponAnimType, bool bArmed, ELocomotionState Locomotion, bool bDead, bool bAttacking)
+	{
+		//unarmed characters ignore the weapon type
+		return (bArmed ? static_cast<uint16>(WeaponAnimType) : 0)
+			| (static_cast<uint16>(Locomotion) << 4)
+			| (bArmed ? 1 << 6 : 0)
+			| (bDead ? 1 << 7 : 0)
+			| (bAttacking ? 1 << 8 : 0);
+	}
+
+	static EWeaponAnimType GetWeaponAnimType(uint16 Key) { return static_cast<EWeaponAnimType>(Key & 0xF); }
+	static ELocomotionState GetLocomotion(uint16 Key) { return static_cast<ELocomotionState>((Key >> 4) & 0x3); }
+	static bool IsArmed(uint16 Key) { return (Key & (1 << 6)) != 0; }
+	static bool IsDead(uint16 Key) { return (Key & (1 << 7)) != 0; }
+	static bool IsAttacking(uint16 Key) { return (Key & (1 << 8)) != 0; }
+};
+
+/** Groups of AVictorCharacter flipbooks that are loaded and released together, see AVictorCharacter::RequestAnimationBundle */
+enum class EAnimationBundle : uint8
+{
+	//Idle and Running, which knife holders use too
+	Unarmed,
+	//PistolIdle and PistolWalk
+	Pistol,
+	Stab,
+	Death,
+	//UnPosses, for bodies the player controls
+	Possession,
+	Num
+};
+
+/** Bundle a character's own flipbook for the state key is in, when AnimationTable has no rule for it */
+inline EAnimationBundle GetAnimationBundle(uint16 StateKey)
+{
+	if (FAnimationStateKey::IsDead(StateKey))
+	{
+		return EAnimationBundle::Death;
+	}
+	if (FAnimationStateKey::IsAttacking(StateKey))
+	{
+		return EAnimationBundle::Stab;
+	}
+	const bool bPistol = FAnimationStateKey::IsArmed(StateKey) && FAnimationStateKey::GetWeaponAnimType(StateKey) == EWeaponAnimType::EWT_Pistol;
+	return bPistol ? EAnimationBundle::Pistol : EAnimationBundle::Unarmed;
+}
+
+USTRUCT(BlueprintType)
+struct FVictorAnimationRule
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Animations)
+	EWeaponAnimType WeaponAnimType = EWeaponAnimType::EWT_MeleeKnife;
+
+	//unarmed characters use rules with this unchecked, WeaponAnimType is ignored for them
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Animations)
+	bool bArmed = true;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Animations)
+	ELocomotionState Locomotion = ELocomotionState::ELS_Idle;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Animations)
+	bool bDead = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Animations)
+	bool bAttacking = false;
+
+	//loaded with the bundle the state is in, like the character's own flipbooks
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Animations)
+	TSoftObjectPtr<UPaperFlipbook> Flipbook;
+};
+
+/**
+ * Designer editable mapping from animation state to flipbook.
+ * States without a rule fall back to the flipbooks set on the character.
+ */
+UCLASS(BlueprintType)
+class VICTOR_API UVictorAnimationTable : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Animations)
+	TArray<FVictorAnimationRule> Rules;
+
+	/** Flipbook rule for the packed state key, nullptr if no rule matches. The flipbook may not be loaded yet */
+	const TSoftObjectPtr<UPaperFlipbook>* FindAnimation(uint16 StateKey) const;
+
+	/** Adds the paths of the rule flipbooks whose state is in the bundle */
+	void GetBundlePaths(EAnimationBundle Bundle, TArray<FSoftObjectPath>& OutPaths) const;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+	void CompileRules() const;
+
+	mutable TMap<uint16, TSoftObjectPtr<UPaperFlipbook>> CompiledRules;
+
+	mutable bool bRulesCompiled = false;
+};
@@ -0,0 +1,206 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayAudioSubsystem.h"
+
+#include "VictorStats.h"
+#include "Components/AudioComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Sound/SoundBase.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voices requested"), STAT_VictorVoicesRequested, STATGROUP_Victor);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voices played"), STAT_VictorVoicesPlayed, STATGROUP_Victor);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voices culled"), STAT_VictorVoicesCulled, STATGROUP_Victor);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voices stolen"), STAT_VictorVoicesStolen, STATGROUP_Victor);
+
+void UGameplayAudioSubsystem::Deinitialize()
+{
+	for (UAudioComponent* Voice : Voices)
+	{
+		if (Voice != nullptr)
+		{
+			Voice->Stop();
+		}
+	}
+	Voices.Empty();
+	VoiceCategories.Empty();
+	VoicePriorities.Empty();
+	if (VoiceOwner != nullptr && !VoiceOwner->IsPendingKillPending())
+	{
+		VoiceOwner->Destroy();
+	}
+	VoiceOwner = nullptr;
+
+	Super::Deinitialize();
+}
+
+bool UGameplayAudioSubsystem::PlaySound(USoundBase* Sound, EGameplaySoundCategory Category, FVector Location, float Priority, bool bSpatialized)
+{
+	if (Sound == nullptr || Category == EGameplaySoundCategory::Num)
+	{
+		return false;
+	}
+	VoicesRequested++;
+	INC_DWORD_STAT(STAT_VictorVoicesRequested);
+
+	const FVector ListenerLocation = GetListenerLocation();
+	if (bSpatialized && MaxAudibleDistance > 0.f && FVector::DistSquared(Location, ListenerLocation) > FMath::Square(MaxAudibleDistance))
+	{
+		VoicesCulled++;
+		INC_DWORD_STAT(STAT_VictorVoicesCulled);
+		return false;
+	}
+	const float Score = GetVoiceScore(Priority, Location, bSpatialized, ListenerLocation);
+
+	//finished components are free, there is no callback to miss
+	int32 NumInCategory = 0;
+	int32 FreeVoice = INDEX_NONE;
+	int32 WeakestInCategory = INDEX_NONE;
+	int32 WeakestOverall = INDEX_NONE;
+	float WeakestInCategoryScore = MAX_flt;
+	float WeakestOverallScore = MAX_flt;
+	for (int32 Index = 0; Index < Voices.Num(); Index++)
+	{
+		UAudioComponent* Voice = Voices[Index];
+		if (!Voice->IsPlaying())
+		{
+			FreeVoice = FreeVoice == INDEX_NONE ? Index : FreeVoice;
+			continue;
+		}
+		const float VoiceScore = GetVoiceScore(VoicePriorities[Index], Voice->GetComponentLocation(), Voice->bAllowSpatialization, ListenerLocation);
+		if (VoiceCategories[Index] == Category)
+		{
+			NumInCategory++;
+			if (VoiceScore < WeakestInCategoryScore)
+			{
+				WeakestInCategoryScore = VoiceScore;
+				WeakestInCategory = Index;
+			}
+		}
+		if (VoiceScore < WeakestOverallScore)
+		{
+			WeakestOverallScore = VoiceScore;
+			WeakestOverall = Index;
+		}
+	}
+
+	int32 VoiceIndex = INDEX_NONE;
+	bool bSteal = false;
+	if (NumInCategory >= GetVoiceLimit(Category))
+	{
+		bSteal = WeakestInCategory != INDEX_NONE && WeakestInCategoryScore < Score;
+		VoiceIndex = bSteal ? WeakestInCategory : INDEX_NONE;
+	}
+	else if (FreeVoice != INDEX_NONE)
+	{
+		VoiceIndex = FreeVoice;
+	}
+	else if (Voices.Num() < MaxVoices)
+	{
+		if (CreateVoice() != nullptr)
+		{
+			VoiceIndex = Voices.Num() - 1;
+		}
+	}
+	else
+	{
+		bSteal = WeakestOverall != INDEX_NONE && WeakestOverallScore < Score;
+		VoiceIndex = bSteal ? WeakestOverall : INDEX_NONE;
+	}
+
+	if (VoiceIndex == INDEX_NONE)
+	{
+		VoicesCulled++;
+		INC_DWORD_STAT(STAT_VictorVoicesCulled);
+		return false;
+	}
+
+	UAudioComponent* Voice = Voices[VoiceIndex];
+	if (bSteal)
+	{
+		Voice->Stop();
+		VoicesStolen++;
+		INC_DWORD_STAT(STAT_VictorVoicesStolen);
+	}
+	VoiceCategories[VoiceIndex] = Category;
+	VoicePriorities[VoiceIndex] = Priority;
+	Voice->bAllowSpatialization = bSpatialized;
+	Voice->bIsUISound = Category == EGameplaySoundCategory::UI;
+	Voice->SetWorldLocation(bSpatialized ? Location : ListenerLocation);
+	Voice->SetSound(Sound);
+	Voice->Play();
+
+	VoicesPlayed++;
+	INC_DWORD_STAT(STAT_VictorVoicesPlayed);
+	return true;
+}
+
+int32 UGameplayAudioSubsystem::GetVoiceLimit(EGameplaySoundCategory Category) const
+{
+	switch (Category)
+	{
+	case EGameplaySoundCategory::Weapons:
+		return MaxWeaponVoices;
+	case EGameplaySoundCategory::Deaths:
+		return MaxDeathVoices;
+	case EGameplaySoundCategory::Footsteps:
+		return MaxFootstepVoices;
+	case EGameplaySoundCategory::UI:
+		return MaxUIVoices;
+	default:
+		return 0;
+	}
+}
+
+void UGameplayAudioSubsystem::ResetVoiceCounters()
+{
+	VoicesRequested = 0;
+	VoicesPlayed = 0;
+	VoicesCulled = 0;
+	VoicesStolen = 0;
+}
+
+FVector UGameplayAudioSubsystem::GetListenerLocation() const
+{
+	if (const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController())
+	{
+		FVector Location;
+		FVector FrontDirection;
+		FVector RightDirection;
+		PlayerController->GetAudioListenerPosition(Location, FrontDirection, RightDirection);
+		return Location;
+	}
+	return FVector::ZeroVector;
+}
+
+float UGameplayAudioSubsystem::GetVoiceScore(float Priority, const FVector& Location, bool bSpatialized, const FVector& ListenerLocation) const
+{
+	//a sound at the listener counts its full priority, one a screen away half of it
+	const float Distance = bSpatialized ? FVector::Dist(Location, ListenerLocation) : 0.f;
+	return Priority / (1.f + Distance / 1000.f);
+}
+
+UAudioComponent* UGameplayAudioSubsystem::CreateVoice()
+{
+	if (VoiceOwner == nullptr)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.ObjectFlags |= RF_Transient;
+		VoiceOwner = GetWorld()->SpawnActor<AActor>(SpawnParameters);
+		if (VoiceOwner == nullptr)
+		{
+			return nullptr;
+		}
+	}
+
+	UAudioComponent* Voice = NewObject<UAudioComponent>(VoiceOwner);
+	Voice->bAutoActivate = false;
+	Voice->bAutoDestroy = false;
+	Voice->bStopWhenOwnerDestroyed = true;
+	Voice->RegisterComponent();
+	Voices.Add(Voice);
+	VoiceCategories.Add(EGameplaySoundCategory::Num);
+	VoicePriorities.Add(0.f);
+	return Voice;
+}
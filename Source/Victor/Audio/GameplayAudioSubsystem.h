@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameplayAudioSubsystem.generated.h"
+
+class UAudioComponent;
+class USoundBase;
+
+UENUM(BlueprintType)
+enum class EGameplaySoundCategory : uint8
+{
+	Weapons,
+	Deaths,
+	Footsteps,
+	UI,
+	Num UMETA(Hidden)
+};
+
+/**
+ * Plays gameplay sounds on a fixed pool of audio components instead of spawning one per sound.
+ * Every category has a voice cap. A sound over its cap, or over the pool size, takes the voice of the weakest
+ * sound playing if it is stronger, and is culled otherwise. Strength is priority divided by distance to the listener,
+ * so far away gunfire makes room for the fight on screen.
+ */
+UCLASS(config=Game)
+class VICTOR_API UGameplayAudioSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	/** Plays Sound at Location, or as a 2D sound if not spatialized. False if it was culled */
+	UFUNCTION(BlueprintCallable, Category = Audio)
+	bool PlaySound(USoundBase* Sound, EGameplaySoundCategory Category, FVector Location, float Priority = 1.f, bool bSpatialized = true);
+
+	UFUNCTION(BlueprintCallable, Category = Audio)
+	bool PlaySound2D(USoundBase* Sound, EGameplaySoundCategory Category, float Priority = 1.f) { return PlaySound(Sound, Category, FVector::ZeroVector, Priority, false); }
+
+	UFUNCTION(BlueprintPure, Category = Audio)
+	int32 GetVoiceLimit(EGameplaySoundCategory Category) const;
+
+	/** How many sounds were asked for */
+	UFUNCTION(BlueprintPure, Category = Audio)
+	int32 GetVoicesRequested() const { return VoicesRequested; }
+
+	/** How many of them got a voice, including the ones that took it from a weaker sound */
+	UFUNCTION(BlueprintPure, Category = Audio)
+	int32 GetVoicesPlayed() const { return VoicesPlayed; }
+
+	/** How many were too weak or too far away to get a voice */
+	UFUNCTION(BlueprintPure, Category = Audio)
+	int32 GetVoicesCulled() const { return VoicesCulled; }
+
+	/** How many playing sounds were stopped to make room */
+	UFUNCTION(BlueprintPure, Category = Audio)
+	int32 GetVoicesStolen() const { return VoicesStolen; }
+
+	UFUNCTION(BlueprintCallable, Category = Audio)
+	void ResetVoiceCounters();
+
+	/** Audio components shared by all categories */
+	UPROPERTY(Config, EditAnywhere, Category = Audio)
+	int32 MaxVoices = 24;
+
+	UPROPERTY(Config, EditAnywhere, Category = Audio)
+	int32 MaxWeaponVoices = 8;
+
+	UPROPERTY(Config, EditAnywhere, Category = Audio)
+	int32 MaxDeathVoices = 4;
+
+	UPROPERTY(Config, EditAnywhere, Category = Audio)
+	int32 MaxFootstepVoices = 6;
+
+	UPROPERTY(Config, EditAnywhere, Category = Audio)
+	int32 MaxUIVoices = 2;
+
+	/** Spatialized sounds further than this from the listener are culled. 0 never culls by distance */
+	UPROPERTY(Config, EditAnywhere, Category = Audio)
+	float MaxAudibleDistance = 4000.f;
+
+protected:
+	FVector GetListenerLocation() const;
+
+	float GetVoiceScore(float Priority, const FVector& Location, bool bSpatialized, const FVector& ListenerLocation) const;
+
+	UAudioComponent* CreateVoice();
+
+	UPROPERTY(Transient)
+	AActor* VoiceOwner = nullptr;
+
+	UPROPERTY(Transient)
+	TArray<UAudioComponent*> Voices;
+
+	//per voice, what it was last started with
+	TArray<EGameplaySoundCategory> VoiceCategories;
+
+	TArray<float> VoicePriorities;
+
+	int32 VoicesRequested = 0;
+
+	int32 VoicesPlayed = 0;
+
+	int32 VoicesCulled = 0;
+
+	int32 VoicesStolen = 0;
+};
@@ -0,0 +1,219 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CharacterUpdateSubsystem.h"
+
+#include "VictorCharacter.h"
+#include "VictorStats.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "World/LevelGridSubsystem.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Updated characters"), STAT_VictorUpdatedCharacters, STATGROUP_Victor);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Update time per character (us)"), STAT_VictorUpdateTimePerCharacter, STATGROUP_Victor);
+
+static TAutoConsoleVariable<int32> CVarBatchedCharacterUpdate(
+	TEXT("victor.BatchedCharacterUpdate"),
+	1,
+	TEXT("1 - update all Victor characters in one batched pass (default).\n")
+	TEXT("0 - call UpdateCharacter() on each character, same as the old per-actor Tick."),
+	ECVF_Default);
+
+void UCharacterUpdateSubsystem::Deinitialize()
+{
+	for (AVictorCharacter* Character : Characters)
+	{
+		if (Character != nullptr)
+		{
+			Character->UpdateSlot = INDEX_NONE;
+		}
+	}
+	Characters.Empty();
+	VelocityX.Empty();
+	SpeedSquared.Empty();
+	StateFlags.Empty();
+	WeaponAnimTypes.Empty();
+	AnimationStateKeys.Empty();
+	ChangedSlots.Empty();
+	DesiredFlipbooks.Empty();
+
+	Super::Deinitialize();
+}
+
+void UCharacterUpdateSubsystem::RegisterCharacter(AVictorCharacter* Character)
+{
+	if (Character == nullptr || Character->UpdateSlot != INDEX_NONE)
+	{
+		return;
+	}
+	Character->UpdateSlot = Characters.Add(Character);
+	VelocityX.Add(0.f);
+	SpeedSquared.Add(0.f);
+	StateFlags.Add(0);
+	WeaponAnimTypes.Add(EWeaponAnimType::EWT_MeleeKnife);
+	AnimationStateKeys.Add(FAnimationStateKey::Invalid);
+	DesiredFlipbooks.Add(nullptr);
+
+	OnCharacterRegistered.Broadcast(Character);
+}
+
+void UCharacterUpdateSubsystem::UnregisterCharacter(AVictorCharacter* Character)
+{
+	if (Character == nullptr || !Characters.IsValidIndex(Character->UpdateSlot) || Characters[Character->UpdateSlot] != Character)
+	{
+		return;
+	}
+	OnCharacterUnregistered.Broadcast(Character);
+
+	const int32 Slot = Character->UpdateSlot;
+	Characters.RemoveAtSwap(Slot, 1, false);
+	VelocityX.RemoveAtSwap(Slot, 1, false);
+	SpeedSquared.RemoveAtSwap(Slot, 1, false);
+	StateFlags.RemoveAtSwap(Slot, 1, false);
+	WeaponAnimTypes.RemoveAtSwap(Slot, 1, false);
+	AnimationStateKeys.RemoveAtSwap(Slot, 1, false);
+	DesiredFlipbooks.RemoveAtSwap(Slot, 1, false);
+
+	//the last character was moved into the freed slot
+	if (Characters.IsValidIndex(Slot))
+	{
+		Characters[Slot]->UpdateSlot = Slot;
+	}
+	Character->UpdateSlot = INDEX_NONE;
+}
+
+void UCharacterUpdateSubsystem::UpdateCharacters()
+{
+	//one UpdateCharacter call per character, so the stat reads the same as the per-actor path
+	VICTOR_SCOPE_CYCLE_COUNTER_CALLS(UpdateCharacter, Characters.Num());
+#if STATS
+	const uint32 StartCycles = FPlatformTime::Cycles();
+#endif
+
+	ULevelGridSubsystem* LevelGrid = GetWorld()->GetSubsystem<ULevelGridSubsystem>();
+	for (AVictorCharacter* Character : Characters)
+	{
+		Character->UpdateWallGrab(*LevelGrid);
+	}
+
+	if (CVarBatchedCharacterUpdate.GetValueOnGameThread() != 0)
+	{
+		GatherState();
+		{
+			VICTOR_SCOPE_CYCLE_COUNTER_CALLS(UpdateAnimation, Characters.Num());
+			ResolveAnimations();
+			ApplyAnimations();
+		}
+		ApplyFacing();
+	}
+	else
+	{
+		for (AVictorCharacter* Character : Characters)
+		{
+			Character->UpdateCharacter();
+		}
+	}
+
+#if STATS
+	const int32 Count = Characters.Num();
+	SET_DWORD_STAT(STAT_VictorUpdatedCharacters, Count);
+	SET_FLOAT_STAT(STAT_VictorUpdateTimePerCharacter, Count > 0 ? FPlatformTime::ToMilliseconds(FPlatformTime::Cycles() - StartCycles) * 1000.f / Count : 0.f);
+#endif
+}
+
+void UCharacterUpdateSubsystem::GatherState()
+{
+	const int32 Count = Characters.Num();
+	for (int32 i = 0; i < Count; i++)
+	{
+		const AVictorCharacter* Character = Characters[i];
+		const UCharacterMovementComponent* Movement = Character->GetCharacterMovement();
+		const FVector Velocity = Movement->Velocity;
+		VelocityX[i] = Velocity.X;
+		SpeedSquared[i] = Velocity.SizeSquared();
+
+		uint8 Flags = 0;
+		Flags |= Character->bDead ? SF_Dead : 0;
+		Flags |= Character->bPlayingMeleeAttackAnim ? SF_PlayingMeleeAttackAnim : 0;
+		Flags |= Character->bIsHoldingWall ? SF_HoldingWall : 0;
+		Flags |= Character->bControlledByPlayer ? SF_ControlledByPlayer : 0;
+		Flags |= Character->Weapon != nullptr ? SF_HasWeapon : 0;
+		Flags |= Character->GetController() != nullptr ? SF_HasController : 0;
+		StateFlags[i] = Flags;
+
+		WeaponAnimTypes[i] = Character->Weapon != nullptr ? Character->Weapon->AnimType : EWeaponAnimType::EWT_MeleeKnife;
+		AnimationStateKeys[i] = FAnimationStateKey::Make(
+			WeaponAnimTypes[i],
+			(Flags & SF_HasWeapon) != 0,
+			ComputeLocomotionState((Flags & SF_HoldingWall) != 0, SpeedSquared[i], Movement->IsFalling()),
+			(Flags & SF_Dead) != 0,
+			(Flags & SF_PlayingMeleeAttackAnim) != 0);
+	}
+}
+
+void UCharacterUpdateSubsystem::ResolveAnimations()
+{
+	ChangedSlots.Reset();
+	const int32 Count = Characters.Num();
+	for (int32 i = 0; i < Count; i++)
+	{
+		if (AnimationStateKeys[i] != Characters[i]->AnimationStateKey)
+		{
+			ChangedSlots.Add(i);
+		}
+	}
+
+	//through the virtual, so subclasses that pick their own flipbook are honoured by the batched path too
+	for (const int32 Slot : ChangedSlots)
+	{
+		DesiredFlipbooks[Slot] = Characters[Slot]->GetDesiredAnimation();
+	}
+}
+
+void UCharacterUpdateSubsystem::ApplyAnimations()
+{
+	for (const int32 Slot : ChangedSlots)
+	{
+		Characters[Slot]->ApplyAnimationState(AnimationStateKeys[Slot], DesiredFlipbooks[Slot]);
+	}
+}
+
+void UCharacterUpdateSubsystem::ApplyFacing()
+{
+	const int32 Count = Characters.Num();
+	for (int32 i = 0; i < Count; i++)
+	{
+		const uint8 Flags = StateFlags[i];
+		const bool bCanTurn = (Flags & SF_HoldingWall) == 0 || (Flags & SF_ControlledByPlayer) == 0;
+		if (bCanTurn && (Flags & SF_HasController) != 0 && VelocityX[i] != 0.f)
+		{
+			Characters[i]->UpdateFacing(VelocityX[i]);
+		}
+	}
+}
+
+void UCharacterUpdateSubsystem::Tick(float DeltaTime)
+{
+	UpdateCharacters();
+
+	for (AVictorCharacter* Character : Characters)
+	{
+		Character->UpdateFootsteps(DeltaTime);
+		Character->UpdateDeathDormancy();
+	}
+}
+
+bool UCharacterUpdateSubsystem::IsTickable() const
+{
+	return Characters.Num() > 0;
+}
+
+TStatId UCharacterUpdateSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCharacterUpdateSubsystem, STATGROUP_Tickables);
+}
+
+ETickableTickType UCharacterUpdateSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
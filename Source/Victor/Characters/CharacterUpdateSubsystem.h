@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Weapons/WeaponAnimTypes.h"
+#include "CharacterUpdateSubsystem.generated.h"
+
+class AVictorCharacter;
+class UPaperFlipbook;
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnVictorCharacterRegistration, AVictorCharacter*);
+
+/**
+ * Owns every AVictorCharacter in the world and runs their facing/animation update in one pass per frame
+ * instead of each character doing it from its own Tick.
+ * Hot state is kept in parallel arrays indexed by AVictorCharacter::UpdateSlot.
+ * Flipbooks are only looked up for characters whose animation state key changed, so idle characters cost a compare.
+ * The lookup goes through AVictorCharacter::GetDesiredAnimation(), so an override must depend only on the state key.
+ * Set victor.BatchedCharacterUpdate 0 to fall back to the per-actor UpdateCharacter() path for comparison.
+ */
+UCLASS()
+class VICTOR_API UCharacterUpdateSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/** Bits stored in StateFlags */
+	enum EStateFlags : uint8
+	{
+		SF_Dead = 1 << 0,
+		SF_PlayingMeleeAttackAnim = 1 << 1,
+		SF_HoldingWall = 1 << 2,
+		SF_ControlledByPlayer = 1 << 3,
+		SF_HasWeapon = 1 << 4,
+		SF_HasController = 1 << 5
+	};
+
+	virtual void Deinitialize() override;
+
+	void RegisterCharacter(AVictorCharacter* Character);
+
+	void UnregisterCharacter(AVictorCharacter* Character);
+
+	/** All registered characters. Other systems should iterate this instead of using actor iterators */
+	const TArray<AVictorCharacter*>& GetCharacters() const { return Characters; }
+
+	int32 Num() const { return Characters.Num(); }
+
+	/** Broadcast after a character was added, so other systems don't need their own registration */
+	FOnVictorCharacterRegistration OnCharacterRegistered;
+
+	/** Broadcast before a character is removed */
+	FOnVictorCharacterRegistration OnCharacterUnregistered;
+
+	/** Runs the facing/animation update for every character. Called from Tick */
+	void UpdateCharacters();
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual ETickableTickType GetTickableTickType() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	void GatherState();
+
+	void ResolveAnimations();
+
+	void ApplyAnimations();
+
+	void ApplyFacing();
+
+	UPROPERTY(Transient)
+	TArray<AVictorCharacter*> Characters;
+
+	TArray<float> VelocityX;
+
+	TArray<float> SpeedSquared;
+
+	TArray<uint8> StateFlags;
+
+	TArray<EWeaponAnimType> WeaponAnimTypes;
+
+	//FAnimationStateKey computed this frame
+	TArray<uint16> AnimationStateKeys;
+
+	//slots whose state key changed this frame, only these resolve and apply a flipbook
+	TArray<int32> ChangedSlots;
+
+	UPROPERTY(Transient)
+	TArray<UPaperFlipbook*> DesiredFlipbooks;
+};
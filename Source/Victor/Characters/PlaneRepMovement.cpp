@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlaneRepMovement.h"
+
+#include "Serialization/VictorVarInt.h"
+
+FPlaneRepMovement FPlaneRepMovement::Quantize(const FVector& Location, const FVector& Velocity, bool bInFacingLeft)
+{
+	FPlaneRepMovement Movement;
+	Movement.X = FMath::RoundToInt(Location.X * 10.f);
+	Movement.Z = FMath::RoundToInt(Location.Z * 10.f);
+	Movement.VelocityX = (int16)FMath::Clamp(FMath::RoundToInt(Velocity.X), (int32)MIN_int16, (int32)MAX_int16);
+	Movement.VelocityZ = (int16)FMath::Clamp(FMath::RoundToInt(Velocity.Z), (int32)MIN_int16, (int32)MAX_int16);
+	Movement.bFacingLeft = bInFacingLeft;
+	return Movement;
+}
+
+bool FPlaneRepMovement::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	VictorVarInt::Serialize(Ar, X);
+	VictorVarInt::Serialize(Ar, Z);
+
+	//most characters stand still, a bit says whether a velocity follows
+	uint8 bMoving = VelocityX != 0 || VelocityZ != 0;
+	Ar.SerializeBits(&bMoving, 1);
+	if (bMoving)
+	{
+		int32 PackedVelocityX = VelocityX;
+		int32 PackedVelocityZ = VelocityZ;
+		VictorVarInt::Serialize(Ar, PackedVelocityX);
+		VictorVarInt::Serialize(Ar, PackedVelocityZ);
+		VelocityX = (int16)PackedVelocityX;
+		VelocityZ = (int16)PackedVelocityZ;
+	}
+	else
+	{
+		VelocityX = 0;
+		VelocityZ = 0;
+	}
+
+	uint8 bPackedFacingLeft = bFacingLeft;
+	Ar.SerializeBits(&bPackedFacingLeft, 1);
+	bFacingLeft = bPackedFacingLeft != 0;
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
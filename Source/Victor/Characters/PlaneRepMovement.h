@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PlaneRepMovement.generated.h"
+
+/**
+ * Movement of a character as simulated proxies see it: location and velocity on the XZ plane and the facing.
+ * Replaces FRepMovement, which sends a 3D location, rotation and velocity. Locations are kept in tenths of a unit
+ * and velocities in whole units per second, so two states compare equal when nothing visible changed.
+ */
+USTRUCT()
+struct VICTOR_API FPlaneRepMovement
+{
+	GENERATED_BODY()
+
+	int32 X = 0;
+
+	int32 Z = 0;
+
+	int16 VelocityX = 0;
+
+	int16 VelocityZ = 0;
+
+	bool bFacingLeft = false;
+
+	static FPlaneRepMovement Quantize(const FVector& Location, const FVector& Velocity, bool bInFacingLeft);
+
+	/** Location on the plane, Y is kept from the character since it never changes */
+	FVector GetLocation(float Y) const { return FVector(X * 0.1f, Y, Z * 0.1f); }
+
+	FVector GetVelocity() const { return FVector(VelocityX, 0.f, VelocityZ); }
+
+	FRotator GetRotation() const { return FRotator(0.f, bFacingLeft ? 180.f : 0.f, 0.f); }
+
+	bool operator==(const FPlaneRepMovement& Other) const
+	{
+		return X == Other.X && Z == Other.Z && VelocityX == Other.VelocityX && VelocityZ == Other.VelocityZ && bFacingLeft == Other.bFacingLeft;
+	}
+
+	bool operator!=(const FPlaneRepMovement& Other) const { return !(*this == Other); }
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FPlaneRepMovement> : public TStructOpsTypeTraitsBase2<FPlaneRepMovement>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
+};
@@ -0,0 +1,255 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VictorMovementComponent.h"
+
+#include "VictorStats.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/Character.h"
+#include "HAL/IConsoleManager.h"
+#include "World/LevelGridSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Plane movement"), STAT_VictorPlaneMovement, STATGROUP_Victor);
+
+static TAutoConsoleVariable<int32> CVarPlaneMovement(
+	TEXT("victor.PlaneMovement"),
+	0,
+	TEXT("1 - Victor characters walk and fall on the XZ plane against the level collision grid.\n")
+	TEXT("0 - the stock walking and falling modes with capsule sweeps, as before (default). Read when a character begins play."),
+	ECVF_Default);
+
+namespace
+{
+	//gap kept between the box and the cells it was stopped by, so it never ends up inside them
+	const float PlaneSkin = 0.1f;
+
+	/** The part of Delta the grid allowed, pulled back by the skin if the move was cut short */
+	float ClipMove(float Allowed, float Delta, bool& bOutBlocked)
+	{
+		bOutBlocked = FMath::Abs(Allowed) < FMath::Abs(Delta);
+		return bOutBlocked ? FMath::Sign(Delta) * FMath::Max(FMath::Abs(Allowed) - PlaneSkin, 0.f) : Delta;
+	}
+}
+
+void UVictorMovementComponent::BeginPlay()
+{
+	Super::BeginPlay();
+	LevelGrid = GetWorld()->GetSubsystem<ULevelGridSubsystem>();
+	SetPlaneMovementEnabled(CVarPlaneMovement.GetValueOnGameThread() != 0);
+}
+
+void UVictorMovementComponent::SetPlaneMovementEnabled(bool bEnabled)
+{
+	bWantsPlaneMovement = bEnabled && LevelGrid != nullptr;
+	ApplyPlaneMovement(bWantsPlaneMovement);
+}
+
+void UVictorMovementComponent::ApplyPlaneMovement(bool bEnabled)
+{
+	if (bEnabled == bPlaneMovementEnabled)
+	{
+		return;
+	}
+	const bool bWasMovingOnGround = IsMovingOnGround();
+	const bool bWasFalling = IsFalling();
+	bPlaneMovementEnabled = bEnabled;
+	if (bWasMovingOnGround)
+	{
+		SetMovementMode(MOVE_Walking);
+	}
+	else if (bWasFalling)
+	{
+		SetMovementMode(MOVE_Falling);
+	}
+}
+
+void UVictorMovementComponent::SetMovementMode(EMovementMode NewMovementMode, uint8 NewCustomMode)
+{
+	if (bPlaneMovementEnabled)
+	{
+		if (NewMovementMode == MOVE_Walking || NewMovementMode == MOVE_NavWalking)
+		{
+			NewMovementMode = MOVE_Custom;
+			NewCustomMode = (uint8)EVictorMovementMode::PlaneWalking;
+		}
+		else if (NewMovementMode == MOVE_Falling)
+		{
+			NewMovementMode = MOVE_Custom;
+			NewCustomMode = (uint8)EVictorMovementMode::PlaneFalling;
+		}
+	}
+	Super::SetMovementMode(NewMovementMode, NewCustomMode);
+}
+
+bool UVictorMovementComponent::IsMovingOnGround() const
+{
+	return (IsInPlaneMode(EVictorMovementMode::PlaneWalking) && UpdatedComponent != nullptr) || Super::IsMovingOnGround();
+}
+
+bool UVictorMovementComponent::IsFalling() const
+{
+	return (IsInPlaneMode(EVictorMovementMode::PlaneFalling) && UpdatedComponent != nullptr) || Super::IsFalling();
+}
+
+void UVictorMovementComponent::PerformMovement(float DeltaTime)
+{
+	VICTOR_SCOPE_CYCLE_COUNTER(Movement);
+	//the grid had nothing in it when plane movement was wanted, e.g. before the level streamed in
+	if (bWantsPlaneMovement && !bPlaneMovementEnabled && LevelGrid->GetCollisionGrid().IsBuilt())
+	{
+		ApplyPlaneMovement(true);
+	}
+	Super::PerformMovement(DeltaTime);
+}
+
+void UVictorMovementComponent::PhysCustom(float DeltaTime, int32 Iterations)
+{
+	if (!bPlaneMovementEnabled || CharacterOwner == nullptr)
+	{
+		Super::PhysCustom(DeltaTime, Iterations);
+		return;
+	}
+	if (DeltaTime < MIN_TICK_TIME)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_VictorPlaneMovement);
+	const FLevelCollisionGrid& Grid = LevelGrid->GetCollisionGrid();
+	if (!Grid.IsBuilt())
+	{
+		//nothing to stand on in the grid, the stock modes take over from the next frame until it has geometry
+		ApplyPlaneMovement(false);
+		return;
+	}
+
+	if (IsInPlaneMode(EVictorMovementMode::PlaneWalking))
+	{
+		PhysPlaneWalking(DeltaTime, Grid);
+	}
+	else if (IsInPlaneMode(EVictorMovementMode::PlaneFalling))
+	{
+		PhysPlaneFalling(DeltaTime, Grid);
+	}
+	else
+	{
+		Super::PhysCustom(DeltaTime, Iterations);
+	}
+}
+
+void UVictorMovementComponent::PhysPlaneWalking(float DeltaTime, const FLevelCollisionGrid& Grid)
+{
+	Velocity.Z = 0.f;
+	Acceleration.Z = 0.f;
+	CalcVelocity(DeltaTime, GroundFriction, false, GetMaxBrakingDeceleration());
+
+	const FBox2D Box = GetPlaneBox();
+	const float DeltaX = Velocity.X * DeltaTime;
+	bool bBlocked = false;
+	float MoveX = ClipMove(Grid.SweepBox(Box, 0, DeltaX), DeltaX, bBlocked);
+	float MoveZ = 0.f;
+	if (bBlocked)
+	{
+		//step up onto a ledge no higher than MaxStepHeight
+		const float Lift = Grid.SweepBox(Box, 1, MaxStepHeight);
+		bool bSteppedBlocked = false;
+		const float SteppedMoveX = ClipMove(Grid.SweepBox(Box.ShiftBy(FVector2D(0.f, Lift)), 0, DeltaX), DeltaX, bSteppedBlocked);
+		if (FMath::Abs(SteppedMoveX) > FMath::Abs(MoveX) + KINDA_SMALL_NUMBER)
+		{
+			MoveX = SteppedMoveX;
+			MoveZ = Lift;
+			bBlocked = bSteppedBlocked;
+		}
+		if (bBlocked)
+		{
+			Velocity.X = 0.f;
+		}
+	}
+
+	//stay on the floor over steps down, or start falling off the ledge
+	const float ProbeDistance = MaxStepHeight + MoveZ + PlaneSkin;
+	const float Drop = Grid.SweepBox(Box.ShiftBy(FVector2D(MoveX, MoveZ)), 1, -ProbeDistance);
+	const bool bOnFloor = Drop > -ProbeDistance;
+	if (bOnFloor)
+	{
+		MoveZ += FMath::Min(Drop + PlaneSkin, 0.f);
+	}
+	MovePlaneBox(FVector2D(MoveX, MoveZ));
+
+	if (!bOnFloor)
+	{
+		SetMovementMode(MOVE_Falling);
+	}
+}
+
+void UVictorMovementComponent::PhysPlaneFalling(float DeltaTime, const FLevelCollisionGrid& Grid)
+{
+	//horizontal velocity under AirControl, the same way the stock falling mode does it
+	const FVector SavedAcceleration = Acceleration;
+	Acceleration = GetFallingLateralAcceleration(DeltaTime);
+	Acceleration.Z = 0.f;
+	const float VelocityZ = Velocity.Z;
+	Velocity.Z = 0.f;
+	CalcVelocity(DeltaTime, FallingLateralFriction, false, GetMaxBrakingDeceleration());
+	Velocity.Z = VelocityZ;
+	Acceleration = SavedAcceleration;
+
+	//GravityScale is part of GetGravityZ, so holding a wall (scale 0) hangs in place
+	const FVector OldVelocity = Velocity;
+	Velocity = NewFallVelocity(Velocity, FVector(0.f, 0.f, GetGravityZ()), DeltaTime);
+	const FVector2D Delta(0.5f * (OldVelocity.X + Velocity.X) * DeltaTime, 0.5f * (OldVelocity.Z + Velocity.Z) * DeltaTime);
+
+	const FBox2D Box = GetPlaneBox();
+	bool bBlockedX = false;
+	const float MoveX = ClipMove(Grid.SweepBox(Box, 0, Delta.X), Delta.X, bBlockedX);
+	bool bBlockedZ = false;
+	const float MoveZ = ClipMove(Grid.SweepBox(Box.ShiftBy(FVector2D(MoveX, 0.f)), 1, Delta.Y), Delta.Y, bBlockedZ);
+	MovePlaneBox(FVector2D(MoveX, MoveZ));
+
+	if (bBlockedX)
+	{
+		Velocity.X = 0.f;
+	}
+	if (bBlockedZ)
+	{
+		Velocity.Z = 0.f;
+		if (Delta.Y < 0.f)
+		{
+			const FVector Location = UpdatedComponent->GetComponentLocation();
+			FHitResult Hit(1.f);
+			Hit.bBlockingHit = true;
+			Hit.Location = Location;
+			Hit.ImpactPoint = FVector(Location.X, Location.Y, Location.Z + Box.Min.Y - Box.GetCenter().Y - PlaneSkin);
+			Hit.Normal = FVector::UpVector;
+			Hit.ImpactNormal = FVector::UpVector;
+			if (CharacterOwner->ShouldNotifyLanded(Hit))
+			{
+				CharacterOwner->Landed(Hit);
+			}
+			//Landed may have changed the mode already
+			if (IsFalling())
+			{
+				SetMovementMode(MOVE_Walking);
+			}
+		}
+	}
+}
+
+FBox2D UVictorMovementComponent::GetPlaneBox() const
+{
+	float Radius = 0.f;
+	float HalfHeight = 0.f;
+	CharacterOwner->GetCapsuleComponent()->GetScaledCapsuleSize(Radius, HalfHeight);
+	const FVector Location = UpdatedComponent->GetComponentLocation();
+	const FVector2D Center(Location.X, Location.Z);
+	const FVector2D HalfExtent(Radius, HalfHeight);
+	return FBox2D(Center - HalfExtent, Center + HalfExtent);
+}
+
+void UVictorMovementComponent::MovePlaneBox(const FVector2D& Delta)
+{
+	if (!Delta.IsZero())
+	{
+		MoveUpdatedComponent(FVector(Delta.X, 0.f, Delta.Y), UpdatedComponent->GetComponentQuat(), false);
+	}
+}
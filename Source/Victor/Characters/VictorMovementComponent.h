@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "VictorMovementComponent.generated.h"
+
+class FLevelCollisionGrid;
+class ULevelGridSubsystem;
+
+/** CustomMovementMode values of UVictorMovementComponent */
+UENUM(BlueprintType)
+enum class EVictorMovementMode : uint8
+{
+	None,
+	PlaneWalking,
+	PlaneFalling
+};
+
+/**
+ * Character movement that walks, jumps and falls on the XZ plane against the level collision grid.
+ * While plane movement is on, every request for walking or falling switches to the matching custom mode instead,
+ * so jumps, launches and landings keep going through the usual UCharacterMovementComponent and ACharacter paths.
+ * The collision shape is the capsule's bounding box, moved one axis at a time with no 3D sweeps or floor finds;
+ * only static level geometry blocks it. Gravity follows GravityScale and air movement follows AirControl as before.
+ * Off by default; set victor.PlaneMovement 1 to use it, 0 keeps the stock walking and falling modes.
+ */
+UCLASS()
+class VICTOR_API UVictorMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	virtual void BeginPlay() override;
+
+	/**
+	 * Switches between the plane modes and the stock walking/falling modes, keeping whether the character is on the ground.
+	 * While the level collision grid is empty the stock modes stand in, plane movement starts once it has geometry.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Character Movement: Plane")
+	void SetPlaneMovementEnabled(bool bEnabled);
+
+	UFUNCTION(BlueprintPure, Category = "Character Movement: Plane")
+	bool IsPlaneMovementEnabled() const { return bPlaneMovementEnabled; }
+
+	virtual void SetMovementMode(EMovementMode NewMovementMode, uint8 NewCustomMode = 0) override;
+
+	virtual bool IsMovingOnGround() const override;
+
+	virtual bool IsFalling() const override;
+
+protected:
+	virtual void PerformMovement(float DeltaTime) override;
+
+	virtual void PhysCustom(float DeltaTime, int32 Iterations) override;
+
+	/** Switches the modes without changing whether plane movement is wanted */
+	void ApplyPlaneMovement(bool bEnabled);
+
+	void PhysPlaneWalking(float DeltaTime, const FLevelCollisionGrid& Grid);
+
+	void PhysPlaneFalling(float DeltaTime, const FLevelCollisionGrid& Grid);
+
+	/** The capsule's bounding box on the XZ plane */
+	FBox2D GetPlaneBox() const;
+
+	/** Moves the updated component by Delta on the XZ plane, without a sweep so overlaps still update */
+	void MovePlaneBox(const FVector2D& Delta);
+
+	bool IsInPlaneMode(EVictorMovementMode Mode) const
+	{
+		return MovementMode == MOVE_Custom && CustomMovementMode == (uint8)Mode;
+	}
+
+	UPROPERTY(Transient)
+	ULevelGridSubsystem* LevelGrid = nullptr;
+
+	bool bPlaneMovementEnabled = false;
+
+	//what SetPlaneMovementEnabled asked for, bPlaneMovementEnabled may be off for now while the grid is empty
+	bool bWantsPlaneMovement = false;
+};
@@ -0,0 +1,1824 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VictorBenchmarkCommandlet.h"
+
+#include "VictorCharacter.h"
+#include "VictorStats.h"
+#include "Player/PossesivePlayerController.h"
+#include "AI/GuardAISubsystem.h"
+#include "Audio/GameplayAudioSubsystem.h"
+#include "AssetRegistryModule.h"
+#include "EngineUtils.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/LevelStreamingDynamic.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/DamageType.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/GameplayStatics.h"
+#include "PaperFlipbook.h"
+#include "PaperFlipbookComponent.h"
+#include "PaperSprite.h"
+#include "Animation/AnimationStreamingSubsystem.h"
+#include "Animation/CrowdSpriteComponent.h"
+#include "Lighting/LevelLightField.h"
+#include "Navigation/PlatformNavGraph.h"
+#include "Navigation/PlatformNavSubsystem.h"
+#include "Perception/GuardPerceptionSubsystem.h"
+#include "Timers/GameplayTimerSubsystem.h"
+#include "Weapons/DamageQueueSubsystem.h"
+#include "Weapons/ProjectileSubsystem.h"
+#include "World/ChunkStreamingSubsystem.h"
+#include "World/LevelCollisionGrid.h"
+#include "World/LevelGridSubsystem.h"
+#include "World/SpatialHash2D.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/Texture2D.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformTime.h"
+#include "Serialization/MemoryWriter.h"
+#include "TimerManager.h"
+#include "UObject/UObjectIterator.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogVictorBenchmark, Log, All);
+
+namespace VictorBenchmark
+{
+	struct FArgs
+	{
+		int32 Count = 0;
+		int32 Iterations = 0;
+		int32 Seed = 0;
+		FString Params;
+	};
+
+	/** Named results of one scenario, in the order they were added */
+	struct FReport
+	{
+		FString Scenario;
+		TArray<TPair<FString, double>> Values;
+
+		void Add(const FString& Name, double Value)
+		{
+			Values.Emplace(Name, Value);
+			UE_LOG(LogVictorBenchmark, Display, TEXT("  %s: %.4f"), *Name, Value);
+		}
+
+		FString ToJson() const
+		{
+			FString Json = FString::Printf(TEXT("{\"scenario\":\"%s\""), *Scenario);
+			for (const TPair<FString, double>& Value : Values)
+			{
+				Json += FString::Printf(TEXT(",\"%s\":%f"), *Value.Key, Value.Value);
+			}
+			return Json + TEXT("}");
+		}
+	};
+
+	typedef void (*FScenarioFunction)(const FArgs& Args, FReport& Report);
+
+	struct FScenario
+	{
+		const TCHAR* Name;
+		int32 DefaultCount;
+		int32 DefaultIterations;
+		FScenarioFunction Run;
+	};
+
+	//one orthographic screen of the side view camera
+	static const FVector2D ScreenSize(2048.f, 1152.f);
+
+	static const FVector2D CapsuleHalfExtent(40.f, 96.f);
+
+	/** Cursor picks against Count bodies on one screen, spatial hash vs testing every body */
+	static void RunPossessionPick(const FArgs& Args, FReport& Report)
+	{
+		FRandomStream Random(Args.Seed);
+		TArray<FVector2D> Bodies;
+		TSpatialHash2D<int32> Hash(256.f);
+		for (int32 i = 0; i < Args.Count; i++)
+		{
+			Bodies.Add(FVector2D(Random.FRandRange(0.f, ScreenSize.X), Random.FRandRange(0.f, ScreenSize.Y)));
+			Hash.Add(i, Bodies[i], CapsuleHalfExtent);
+		}
+
+		TArray<FVector2D> Cursors;
+		for (int32 i = 0; i < Args.Iterations; i++)
+		{
+			Cursors.Add(FVector2D(Random.FRandRange(0.f, ScreenSize.X), Random.FRandRange(0.f, ScreenSize.Y)));
+		}
+
+		//the body each cursor picked, INDEX_NONE for a miss
+		TArray<int32> HashPicks;
+		HashPicks.Init(INDEX_NONE, Cursors.Num());
+		int32 HashHits = 0;
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 Pick = 0; Pick < Cursors.Num(); Pick++)
+		{
+			HashHits += Hash.FindAtPoint(Cursors[Pick], [](int32) { return true; }, HashPicks[Pick]) ? 1 : 0;
+		}
+		const double HashSeconds = FPlatformTime::Seconds() - StartTime;
+
+		TArray<int32> ScanPicks;
+		ScanPicks.Init(INDEX_NONE, Cursors.Num());
+		StartTime = FPlatformTime::Seconds();
+		for (int32 Pick = 0; Pick < Cursors.Num(); Pick++)
+		{
+			const FVector2D& Cursor = Cursors[Pick];
+			float BestDistanceSquared = MAX_flt;
+			int32 Found = INDEX_NONE;
+			for (int32 i = 0; i < Bodies.Num(); i++)
+			{
+				const FVector2D Delta = Bodies[i] - Cursor;
+				if (FMath::Abs(Delta.X) <= CapsuleHalfExtent.X && FMath::Abs(Delta.Y) <= CapsuleHalfExtent.Y && Delta.SizeSquared() < BestDistanceSquared)
+				{
+					BestDistanceSquared = Delta.SizeSquared();
+					Found = i;
+				}
+			}
+			ScanPicks[Pick] = Found;
+		}
+		const double ScanSeconds = FPlatformTime::Seconds() - StartTime;
+
+		//one frame of every body walking a little
+		StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Bodies.Num(); i++)
+		{
+			Bodies[i].X += Random.FRandRange(-10.f, 10.f);
+			Hash.Move(i, Bodies[i]);
+		}
+		const double MoveSeconds = FPlatformTime::Seconds() - StartTime;
+
+		Report.Add(TEXT("bodies"), Args.Count);
+		Report.Add(TEXT("picks"), Args.Iterations);
+		Report.Add(TEXT("hash_pick_us"), HashSeconds * 1e6 / FMath::Max(1, Args.Iterations));
+		Report.Add(TEXT("scan_pick_us"), ScanSeconds * 1e6 / FMath::Max(1, Args.Iterations));
+		Report.Add(TEXT("hash_update_frame_us"), MoveSeconds * 1e6);
+		Report.Add(TEXT("hit_rate"), double(HashHits) / FMath::Max(1, Args.Iterations));
+		//the same body for every cursor, not only the same number of hits
+		Report.Add(TEXT("results_match"), HashPicks == ScanPicks ? 1.0 : 0.0);
+	}
+
+	/** Fills Grid with a floor and random platforms and pillars over Width units of level */
+	static void BuildSyntheticLevel(FRandomStream& Random, float Width, FLevelCollisionGrid& Grid)
+	{
+		const float CellSize = 32.f;
+		Grid.Init(FVector2D(0.f, 0.f), CellSize, FMath::CeilToInt(Width / CellSize), FMath::CeilToInt(ScreenSize.Y / CellSize));
+		Grid.FillBox(FBox2D(FVector2D(0.f, 0.f), FVector2D(Width, CellSize)));
+		for (float X = 0.f; X < Width; X += 256.f)
+		{
+			const FVector2D Min(X + Random.FRandRange(0.f, 128.f), Random.FRandRange(CellSize, ScreenSize.Y - 256.f));
+			const FVector2D Size = Random.FRand() < 0.7f ? FVector2D(Random.FRandRange(128.f, 512.f), CellSize) : FVector2D(CellSize * 2.f, Random.FRandRange(128.f, 512.f));
+			Grid.FillBox(FBox2D(Min, Min + Size));
+		}
+	}
+
+	/**
+	 * Guard line of sight checks against a synthetic level for 10, 100, ... up to Count guards,
+	 * all pairs on one thread vs ParallelFor.
+	 */
+	static void RunPerception(const FArgs& Args, FReport& Report)
+	{
+		const int32 NumTargets = 4;
+		FRandomStream Random(Args.Seed);
+
+		for (int32 NumGuards = 10; NumGuards <= Args.Count; NumGuards *= 10)
+		{
+			//keep the guard density of a normal level, one every few hundred units
+			const float Width = FMath::Max(ScreenSize.X, NumGuards * 256.f);
+			FLevelCollisionGrid Grid;
+			BuildSyntheticLevel(Random, Width, Grid);
+
+			TArray<FVector2D> Eyes;
+			TArray<float> Facing;
+			for (int32 i = 0; i < NumGuards; i++)
+			{
+				Eyes.Add(FVector2D(Random.FRandRange(0.f, Width), Random.FRandRange(CapsuleHalfExtent.Y, ScreenSize.Y)));
+				Facing.Add(Random.FRand() < 0.5f ? -1.f : 1.f);
+			}
+			TArray<FVector2D> TargetLocations;
+			for (int32 i = 0; i < NumTargets; i++)
+			{
+				TargetLocations.Add(FVector2D(Random.FRandRange(0.f, Width), Random.FRandRange(CapsuleHalfExtent.Y, ScreenSize.Y)));
+			}
+			TArray<FPerceptionCheck> Checks;
+			for (int32 Viewer = 0; Viewer < NumGuards; Viewer++)
+			{
+				for (int32 Target = 0; Target < NumTargets; Target++)
+				{
+					Checks.Add({ Viewer, Target });
+				}
+			}
+
+			FGuardPerceptionKernel Kernel;
+			TArray<uint8> SerialResults;
+			TArray<uint8> ParallelResults;
+
+			double StartTime = FPlatformTime::Seconds();
+			for (int32 Frame = 0; Frame < Args.Iterations; Frame++)
+			{
+				Kernel.Run(Grid, Eyes, Facing, TargetLocations, Checks, SerialResults, false);
+			}
+			const double SerialSeconds = FPlatformTime::Seconds() - StartTime;
+
+			StartTime = FPlatformTime::Seconds();
+			for (int32 Frame = 0; Frame < Args.Iterations; Frame++)
+			{
+				Kernel.Run(Grid, Eyes, Facing, TargetLocations, Checks, ParallelResults, true);
+			}
+			const double ParallelSeconds = FPlatformTime::Seconds() - StartTime;
+
+			int32 Visible = 0;
+			for (const uint8 Result : SerialResults)
+			{
+				Visible += Result;
+			}
+
+			const FString Prefix = FString::Printf(TEXT("guards_%d_"), NumGuards);
+			Report.Add(Prefix + TEXT("checks"), Checks.Num());
+			Report.Add(Prefix + TEXT("visible"), Visible);
+			Report.Add(Prefix + TEXT("serial_frame_ms"), SerialSeconds * 1000.0 / FMath::Max(1, Args.Iterations));
+			Report.Add(Prefix + TEXT("parallel_frame_ms"), ParallelSeconds * 1000.0 / FMath::Max(1, Args.Iterations));
+			Report.Add(Prefix + TEXT("results_match"), SerialResults == ParallelResults ? 1.0 : 0.0);
+		}
+	}
+
+	/**
+	 * Shadow decisions for Count characters under 1, 10, 100 and 1000 light volumes,
+	 * testing every volume per character vs one light field lookup.
+	 */
+	static void RunLightField(const FArgs& Args, FReport& Report)
+	{
+		const float CellSize = 32.f;
+		const float ShadowThreshold = 0.5f;
+		FRandomStream Random(Args.Seed);
+
+		TArray<FVector2D> Characters;
+		for (int32 i = 0; i < Args.Count; i++)
+		{
+			Characters.Add(FVector2D(Random.FRandRange(0.f, ScreenSize.X * 8.f), Random.FRandRange(0.f, ScreenSize.Y)));
+		}
+
+		for (int32 NumLights = 1; NumLights <= 1000; NumLights *= 10)
+		{
+			//volumes snapped to cells, so both approaches must agree exactly
+			TArray<FBox2D> Volumes;
+			FLevelLightField Field;
+			Field.Init(FVector2D::ZeroVector, CellSize, FMath::CeilToInt(ScreenSize.X * 8.f / CellSize), FMath::CeilToInt(ScreenSize.Y / CellSize));
+			for (int32 i = 0; i < NumLights; i++)
+			{
+				const FVector2D Min(FMath::GridSnap(Random.FRandRange(0.f, ScreenSize.X * 8.f), CellSize), FMath::GridSnap(Random.FRandRange(0.f, ScreenSize.Y), CellSize));
+				const FVector2D Size(FMath::GridSnap(Random.FRandRange(64.f, 512.f), CellSize), FMath::GridSnap(Random.FRandRange(64.f, 512.f), CellSize));
+				Volumes.Add(FBox2D(Min, Min + Size));
+				Field.AddLitBox(Volumes.Last(), 1.f);
+			}
+
+			TArray<bool> VolumeHidden;
+			VolumeHidden.SetNumZeroed(Characters.Num());
+			double StartTime = FPlatformTime::Seconds();
+			for (int32 Frame = 0; Frame < Args.Iterations; Frame++)
+			{
+				for (int32 i = 0; i < Characters.Num(); i++)
+				{
+					bool bLit = false;
+					for (const FBox2D& Volume : Volumes)
+					{
+						if (Volume.IsInside(Characters[i]))
+						{
+							bLit = true;
+							break;
+						}
+					}
+					VolumeHidden[i] = !bLit;
+				}
+			}
+			const double VolumeSeconds = FPlatformTime::Seconds() - StartTime;
+
+			TArray<bool> FieldHidden;
+			FieldHidden.SetNumZeroed(Characters.Num());
+			StartTime = FPlatformTime::Seconds();
+			for (int32 Frame = 0; Frame < Args.Iterations; Frame++)
+			{
+				for (int32 i = 0; i < Characters.Num(); i++)
+				{
+					FieldHidden[i] = Field.GetLightLevel(Characters[i]) < ShadowThreshold;
+				}
+			}
+			const double FieldSeconds = FPlatformTime::Seconds() - StartTime;
+
+			const FString Prefix = FString::Printf(TEXT("lights_%d_"), NumLights);
+			Report.Add(Prefix + TEXT("volume_frame_us"), VolumeSeconds * 1e6 / FMath::Max(1, Args.Iterations));
+			Report.Add(Prefix + TEXT("field_frame_us"), FieldSeconds * 1e6 / FMath::Max(1, Args.Iterations));
+			Report.Add(Prefix + TEXT("results_match"), VolumeHidden == FieldHidden ? 1.0 : 0.0);
+		}
+	}
+
+	/**
+	 * Count simultaneous projectiles flying through a synthetic level with 200 characters of both teams.
+	 * Every projectile that stops is replaced, so Count stay live; one thread vs ParallelFor sweeps.
+	 */
+	static void RunProjectiles(const FArgs& Args, FReport& Report)
+	{
+		const int32 NumTargets = 200;
+		const float Width = NumTargets * 256.f;
+		const float DeltaTime = 1.f / 60.f;
+		const float Speed = 1500.f;
+		FRandomStream LevelRandom(Args.Seed);
+		FLevelCollisionGrid Grid;
+		BuildSyntheticLevel(LevelRandom, Width, Grid);
+
+		TArray<FProjectileTarget> Targets;
+		TSpatialHash2D<int32> TargetHash(256.f);
+		for (int32 i = 0; i < NumTargets; i++)
+		{
+			const FVector2D Center(LevelRandom.FRandRange(0.f, Width), LevelRandom.FRandRange(CapsuleHalfExtent.Y, ScreenSize.Y));
+			TargetHash.Add(Targets.Add({ Center, CapsuleHalfExtent, i % 2 == 0 ? ETeam::ET_Guards : ETeam::ET_Player }), Center, CapsuleHalfExtent);
+		}
+
+		auto SpawnProjectile = [&](FRandomStream& Random, FProjectileSimulation& Simulation)
+		{
+			const FProjectileTarget& Shooter = Targets[Random.RandHelper(NumTargets)];
+			const float Direction = Random.FRand() < 0.5f ? -1.f : 1.f;
+			const FVector2D Muzzle = Shooter.Center + FVector2D(Direction * (CapsuleHalfExtent.X + 1.f), Random.FRandRange(-20.f, 20.f));
+			Simulation.Spawn(Muzzle, FVector2D(Direction * Speed, Random.FRandRange(-50.f, 50.f)), 2.f, Shooter.Team, 10.f, nullptr);
+		};
+
+		auto RunFrames = [&](bool bParallel, FProjectileSimulation& Simulation, int32& OutHits, double& OutStepSeconds, double& OutMaxFrameSeconds)
+		{
+			FRandomStream Random(Args.Seed);
+			OutHits = 0;
+			OutStepSeconds = 0.0;
+			OutMaxFrameSeconds = 0.0;
+			for (int32 Frame = 0; Frame < Args.Iterations; Frame++)
+			{
+				while (Simulation.Num() < Args.Count)
+				{
+					SpawnProjectile(Random, Simulation);
+				}
+				const double StartTime = FPlatformTime::Seconds();
+				Simulation.Step(DeltaTime, 0.f, &Grid, TargetHash, Targets, bParallel);
+				const double FrameSeconds = FPlatformTime::Seconds() - StartTime;
+				OutStepSeconds += FrameSeconds;
+				OutMaxFrameSeconds = FMath::Max(OutMaxFrameSeconds, FrameSeconds);
+				OutHits += Simulation.Hits.Num();
+			}
+		};
+
+		FProjectileSimulation SerialSimulation;
+		int32 SerialHits = 0;
+		double SerialSeconds = 0.0;
+		double SerialMaxSeconds = 0.0;
+		RunFrames(false, SerialSimulation, SerialHits, SerialSeconds, SerialMaxSeconds);
+
+		FProjectileSimulation ParallelSimulation;
+		int32 ParallelHits = 0;
+		double ParallelSeconds = 0.0;
+		double ParallelMaxSeconds = 0.0;
+		RunFrames(true, ParallelSimulation, ParallelHits, ParallelSeconds, ParallelMaxSeconds);
+
+		const int32 Frames = FMath::Max(1, Args.Iterations);
+		Report.Add(TEXT("projectiles"), Args.Count);
+		Report.Add(TEXT("targets"), NumTargets);
+		Report.Add(TEXT("hits_per_frame"), double(SerialHits) / Frames);
+		Report.Add(TEXT("serial_frame_ms"), SerialSeconds * 1000.0 / Frames);
+		Report.Add(TEXT("serial_max_frame_ms"), SerialMaxSeconds * 1000.0);
+		Report.Add(TEXT("parallel_frame_ms"), ParallelSeconds * 1000.0 / Frames);
+		Report.Add(TEXT("parallel_max_frame_ms"), ParallelMaxSeconds * 1000.0);
+		Report.Add(TEXT("ns_per_projectile"), ParallelSeconds * 1e9 / (double(Frames) * FMath::Max(1, Args.Count)));
+		Report.Add(TEXT("results_match"), SerialHits == ParallelHits && SerialSimulation.Positions == ParallelSimulation.Positions ? 1.0 : 0.0);
+	}
+
+	/** Scripted input for the guards and the player, the same every run for a given frame number */
+	static void DriveCharacters(int32 Frame, APlayerController* PlayerController, const TArray<AVictorCharacter*>& Guards, FRandomStream& Random)
+	{
+		for (int32 i = 0; i < Guards.Num(); i++)
+		{
+			AVictorCharacter* Guard = Guards[i];
+			if (Guard->bDead || Guard->IsPlayerControlled())
+			{
+				continue;
+			}
+			//UGuardAISubsystem walks them, the jumps are only there to exercise falling and landing
+			if ((Frame + i * 31) % 240 == 0)
+			{
+				Guard->Jump();
+			}
+		}
+
+		AVictorCharacter* Player = PlayerController != nullptr ? Cast<AVictorCharacter>(PlayerController->GetPawn()) : nullptr;
+		if (Player == nullptr)
+		{
+			return;
+		}
+		Player->MoveRight(FMath::Sin(Frame * 0.02f) > 0.f ? 1.f : -1.f);
+		if (Frame % 60 == 0)
+		{
+			Player->Jump();
+		}
+		if (Frame % 60 == 30)
+		{
+			Player->StopJumping();
+		}
+		if (Frame % 20 == 0)
+		{
+			Player->Attack();
+		}
+		if (Frame % 30 == 15)
+		{
+			Player->Interact();
+		}
+
+		//possess the nearest guard, next time go back to the original body
+		if (Frame % 300 == 150)
+		{
+			if (Player->OriginalBody == nullptr)
+			{
+				AVictorCharacter* Nearest = nullptr;
+				float NearestDistanceSquared = MAX_flt;
+				for (AVictorCharacter* Guard : Guards)
+				{
+					const float DistanceSquared = FVector::DistSquared(Guard->GetActorLocation(), Player->GetActorLocation());
+					if (!Guard->bDead && !Guard->IsPlayerControlled() && DistanceSquared < NearestDistanceSquared)
+					{
+						Nearest = Guard;
+						NearestDistanceSquared = DistanceSquared;
+					}
+				}
+				Player->PossessTarget = Nearest;
+			}
+			Player->Possess();
+		}
+
+		//something hits a random guard
+		if (Frame % 90 == 45 && Guards.Num() > 0)
+		{
+			AVictorCharacter* Victim = Guards[Random.RandHelper(Guards.Num())];
+			UGameplayStatics::ApplyDamage(Victim, 10.f, PlayerController, Player, UDamageType::StaticClass());
+		}
+	}
+
+	/** Starts a standalone game instance on the -Map= level, nullptr if it can't be loaded */
+	static UWorld* LoadBenchmarkMap(const FArgs& Args, UGameInstance*& OutGameInstance)
+	{
+		FString MapName = TEXT("/Game/2DSideScrollerCPP/Maps/2DSideScrollerExampleMap");
+		FParse::Value(*Args.Params, TEXT("Map="), MapName);
+
+		OutGameInstance = NewObject<UGameInstance>(GEngine);
+		OutGameInstance->AddToRoot();
+		OutGameInstance->InitializeStandalone();
+		FWorldContext* WorldContext = OutGameInstance->GetWorldContext();
+
+		FString Error;
+		if (!GEngine->LoadMap(*WorldContext, FURL(nullptr, *MapName, TRAVEL_Absolute), nullptr, Error))
+		{
+			UE_LOG(LogVictorBenchmark, Error, TEXT("Could not load %s: %s"), *MapName, *Error);
+			OutGameInstance->Shutdown();
+			OutGameInstance->RemoveFromRoot();
+			OutGameInstance = nullptr;
+			return nullptr;
+		}
+		return WorldContext->World();
+	}
+
+	/** -PawnClass=, or the game mode's default pawn if it is a Victor character */
+	static TSubclassOf<AVictorCharacter> GetBenchmarkPawnClass(const FArgs& Args, const AGameModeBase* GameMode)
+	{
+		TSubclassOf<AVictorCharacter> PawnClass = AVictorCharacter::StaticClass();
+		FString PawnClassName;
+		if (FParse::Value(*Args.Params, TEXT("PawnClass="), PawnClassName))
+		{
+			PawnClass = LoadClass<AVictorCharacter>(nullptr, *PawnClassName);
+		}
+		else if (GameMode != nullptr && GameMode->DefaultPawnClass != nullptr && GameMode->DefaultPawnClass->IsChildOf<AVictorCharacter>())
+		{
+			PawnClass = *GameMode->DefaultPawnClass;
+		}
+		if (PawnClass == nullptr)
+		{
+			UE_LOG(LogVictorBenchmark, Error, TEXT("Could not load pawn class %s"), *PawnClassName);
+			PawnClass = AVictorCharacter::StaticClass();
+		}
+		return PawnClass;
+	}
+
+	static void UnloadBenchmarkMap(UWorld* World, UGameInstance* GameInstance)
+	{
+		World->BeginTearingDown();
+		GameInstance->Shutdown();
+		World->DestroyWorld(false);
+		GameInstance->RemoveFromRoot();
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	/**
+	 * Loads a map into a game world ticked by hand, spawns Count guards and a player
+	 * and plays scripted input for Iterations frames at a fixed timestep.
+	 * -Map= picks the map, -PawnClass= the character class (the game mode's default pawn otherwise),
+	 * -DeltaTime= the timestep and -Warmup= the frames left out of the results.
+	 * -Replay=Name drives the player from Saved/InputRecordings/Name.vinput instead of the script,
+	 * at the recorded frame times and for as many frames as were recorded.
+	 */
+	static void RunGameplay(const FArgs& Args, FReport& Report)
+	{
+		float DeltaTime = 1.f / 60.f;
+		FParse::Value(*Args.Params, TEXT("DeltaTime="), DeltaTime);
+		int32 WarmupFrames = 60;
+		FParse::Value(*Args.Params, TEXT("Warmup="), WarmupFrames);
+
+		UGameInstance* GameInstance = nullptr;
+		UWorld* World = LoadBenchmarkMap(Args, GameInstance);
+		if (World == nullptr)
+		{
+			Report.Add(TEXT("failed"), 1.0);
+			return;
+		}
+		AGameModeBase* GameMode = World->GetAuthGameMode();
+		const TSubclassOf<AVictorCharacter> PawnClass = GetBenchmarkPawnClass(Args, GameMode);
+
+		const AActor* PlayerStart = GameMode != nullptr ? GameMode->FindPlayerStart(nullptr) : nullptr;
+		const FVector StartLocation = PlayerStart != nullptr ? PlayerStart->GetActorLocation() : FVector::ZeroVector;
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+		TArray<AVictorCharacter*> Guards;
+		for (int32 i = 0; i < Args.Count; i++)
+		{
+			const FVector Location = StartLocation + FVector((i - Args.Count / 2) * 120.f, 0.f, 0.f);
+			AVictorCharacter* Guard = World->SpawnActor<AVictorCharacter>(PawnClass, Location, FRotator::ZeroRotator, SpawnParameters);
+			if (Guard != nullptr)
+			{
+				Guard->Team = ETeam::ET_Guards;
+				Guard->SpawnDefaultController();
+				Guards.Add(Guard);
+			}
+		}
+
+		TSubclassOf<APlayerController> PlayerControllerClass = GameMode != nullptr && GameMode->PlayerControllerClass != nullptr
+			? GameMode->PlayerControllerClass
+			: TSubclassOf<APlayerController>(APlayerController::StaticClass());
+		APlayerController* PlayerController = World->SpawnActor<APlayerController>(PlayerControllerClass, StartLocation, FRotator::ZeroRotator, SpawnParameters);
+		AVictorCharacter* Player = World->SpawnActor<AVictorCharacter>(PawnClass, StartLocation + FVector(0.f, 0.f, 200.f), FRotator::ZeroRotator, SpawnParameters);
+		if (PlayerController != nullptr && Player != nullptr)
+		{
+			Player->Team = ETeam::ET_Player;
+			Player->Tags.AddUnique(TEXT("Player"));
+			PlayerController->Possess(Player);
+		}
+
+		FString ReplayName;
+		APossesivePlayerController* ReplayController = nullptr;
+		if (FParse::Value(*Args.Params, TEXT("Replay="), ReplayName))
+		{
+			ReplayController = Cast<APossesivePlayerController>(PlayerController);
+			if (ReplayController == nullptr || !ReplayController->StartInputReplay(ReplayName))
+			{
+				UE_LOG(LogVictorBenchmark, Error, TEXT("Could not replay %s, the player controller must be an APossesivePlayerController"), *ReplayName);
+				ReplayController = nullptr;
+			}
+		}
+
+		FRandomStream Random(Args.Seed);
+		TArray<double> FrameMilliseconds;
+		FrameMilliseconds.Reserve(Args.Iterations);
+		FVictorTimings::Reset();
+		for (int32 Frame = 0; ReplayController != nullptr ? ReplayController->IsReplayingInput() : Frame < WarmupFrames + Args.Iterations; Frame++)
+		{
+			FVictorTimings::bEnabled = Frame >= WarmupFrames;
+			if (ReplayController != nullptr)
+			{
+				DeltaTime = ReplayController->GetReplayDeltaTime();
+			}
+			FApp::SetDeltaTime(DeltaTime);
+			FApp::SetCurrentTime(FApp::GetCurrentTime() + DeltaTime);
+
+			const double StartTime = FPlatformTime::Seconds();
+			if (ReplayController != nullptr)
+			{
+				ReplayController->StepInputReplay();
+			}
+			else
+			{
+				DriveCharacters(Frame, PlayerController, Guards, Random);
+			}
+			World->Tick(LEVELTICK_All, DeltaTime);
+			const double FrameTime = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+			if (Frame >= WarmupFrames)
+			{
+				FrameMilliseconds.Add(FrameTime);
+			}
+			GFrameCounter++;
+		}
+		FVictorTimings::bEnabled = false;
+
+		int32 NumActors = 0;
+		for (TActorIterator<AActor> It(World); It; ++It)
+		{
+			NumActors++;
+		}
+		const int32 NumObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+
+		double TotalMilliseconds = 0.0;
+		for (const double FrameTime : FrameMilliseconds)
+		{
+			TotalMilliseconds += FrameTime;
+		}
+		FrameMilliseconds.Sort();
+		const int32 NumFrames = FMath::Max(FrameMilliseconds.Num(), 1);
+
+		Report.Add(TEXT("guards"), Guards.Num());
+		Report.Add(TEXT("frames"), FrameMilliseconds.Num());
+		Report.Add(TEXT("mean_frame_ms"), TotalMilliseconds / NumFrames);
+		Report.Add(TEXT("p99_frame_ms"), FrameMilliseconds.Num() > 0 ? FrameMilliseconds[FMath::Min(FMath::CeilToInt(FrameMilliseconds.Num() * 0.99f), FrameMilliseconds.Num()) - 1] : 0.0);
+		Report.Add(TEXT("max_frame_ms"), FrameMilliseconds.Num() > 0 ? FrameMilliseconds.Last() : 0.0);
+		for (int32 Section = 0; Section < FVictorTimings::NumSections; Section++)
+		{
+			const FString Name = FVictorTimings::GetSectionName((FVictorTimings::ESection)Section);
+			Report.Add(Name + TEXT("_ms_per_frame"), FVictorTimings::Seconds[Section] * 1000.0 / NumFrames);
+			Report.Add(Name + TEXT("_calls"), FVictorTimings::Calls[Section]);
+		}
+		if (ReplayController != nullptr)
+		{
+			Report.Add(TEXT("replay_divergences"), ReplayController->GetReplayDivergences());
+		}
+		const UGameplayAudioSubsystem* Audio = World->GetSubsystem<UGameplayAudioSubsystem>();
+		Report.Add(TEXT("voices_requested"), Audio->GetVoicesRequested());
+		Report.Add(TEXT("voices_played"), Audio->GetVoicesPlayed());
+		Report.Add(TEXT("voices_culled"), Audio->GetVoicesCulled());
+		Report.Add(TEXT("voices_stolen"), Audio->GetVoicesStolen());
+		Report.Add(TEXT("actors"), NumActors);
+		Report.Add(TEXT("uobjects"), NumObjects);
+
+		UnloadBenchmarkMap(World, GameInstance);
+	}
+
+	/**
+	 * Game thread cost of drawing 100 to Count animated characters on the -Map= level, one flipbook component
+	 * per character vs one UCrowdSpriteComponent. Every frame the characters walk and a tenth of them change tint.
+	 * -Flipbook= picks the animation. Needs -AllowCommandletRendering so the world has a scene to add proxies to;
+	 * with -nullrhi nothing is drawn but the proxies are still created and updated.
+	 */
+	static void RunCrowdSprites(const FArgs& Args, FReport& Report)
+	{
+		FString FlipbookPath = TEXT("/Game/Sprites/Humans/Guard/GuardIdle.GuardIdle");
+		FParse::Value(*Args.Params, TEXT("Flipbook="), FlipbookPath);
+		UPaperFlipbook* Flipbook = LoadObject<UPaperFlipbook>(nullptr, *FlipbookPath);
+		UGameInstance* GameInstance = nullptr;
+		UWorld* World = Flipbook != nullptr ? LoadBenchmarkMap(Args, GameInstance) : nullptr;
+		if (World == nullptr)
+		{
+			UE_LOG(LogVictorBenchmark, Error, TEXT("Could not load %s or the map"), *FlipbookPath);
+			Report.Add(TEXT("failed"), 1.0);
+			return;
+		}
+		const float DeltaTime = 1.f / 60.f;
+
+		for (const int32 NumCharacters : { 100, 250, 500, 1000, 2000 })
+		{
+			if (NumCharacters > Args.Count)
+			{
+				break;
+			}
+
+			TArray<UPaperFlipbookComponent*> Sprites;
+			for (int32 i = 0; i < NumCharacters; i++)
+			{
+				AActor* Actor = World->SpawnActor<AActor>();
+				UPaperFlipbookComponent* Sprite = NewObject<UPaperFlipbookComponent>(Actor);
+				Sprite->SetFlipbook(Flipbook);
+				Sprite->SetPlaybackPosition(FMath::Fmod(i * 0.1f, FMath::Max(Flipbook->GetTotalDuration(), 0.1f)), false);
+				Actor->SetRootComponent(Sprite);
+				Sprite->RegisterComponent();
+				Actor->SetActorLocation(FVector((i % 100) * 60.f, 0.f, (i / 100) * 120.f));
+				Sprites.Add(Sprite);
+			}
+
+			AActor* CrowdOwner = World->SpawnActor<AActor>();
+			UCrowdSpriteComponent* Crowd = NewObject<UCrowdSpriteComponent>(CrowdOwner);
+			CrowdOwner->SetRootComponent(Crowd);
+			Crowd->RegisterComponent();
+
+			auto RunFrames = [&](bool bCrowd)
+			{
+				double TotalSeconds = 0.0;
+				for (int32 Frame = 0; Frame < Args.Iterations; Frame++)
+				{
+					const double StartTime = FPlatformTime::Seconds();
+					for (int32 i = 0; i < Sprites.Num(); i++)
+					{
+						UPaperFlipbookComponent* Sprite = Sprites[i];
+						const float Direction = (Frame / 60 + i) % 2 == 0 ? 1.f : -1.f;
+						Sprite->GetOwner()->SetActorLocationAndRotation(Sprite->GetComponentLocation() + FVector(Direction * 2.f, 0.f, 0.f), FRotator(0.f, Direction > 0.f ? 0.f : 180.f, 0.f));
+						if ((Frame + i) % 10 == 0)
+						{
+							Sprite->SetSpriteColor(Sprite->GetSpriteColor() == FLinearColor::White ? FLinearColor::Black : FLinearColor::White);
+						}
+						if (bCrowd)
+						{
+							FCrowdSpriteInstance Instance;
+							Instance.Location = Sprite->GetComponentLocation();
+							Instance.Flipbook = Flipbook;
+							Instance.FrameIndex = Flipbook->GetKeyFrameIndexAtTime(Sprite->GetPlaybackPosition());
+							Instance.Tint = Sprite->GetSpriteColor();
+							Instance.bFacingLeft = Direction < 0.f;
+							Crowd->SetCrowdInstance(i, Instance);
+						}
+					}
+					if (bCrowd)
+					{
+						Crowd->FlushCrowdInstances();
+					}
+					World->Tick(LEVELTICK_All, DeltaTime);
+					TotalSeconds += FPlatformTime::Seconds() - StartTime;
+					GFrameCounter++;
+
+					//render thread work isn't part of the measurement, don't let it pile up
+					FlushRenderingCommands();
+				}
+				return TotalSeconds * 1000.0 / FMath::Max(1, Args.Iterations);
+			};
+
+			const double ComponentFrameMs = RunFrames(false);
+			for (UPaperFlipbookComponent* Sprite : Sprites)
+			{
+				Sprite->SetVisibility(false);
+				Crowd->AddCrowdInstance(FCrowdSpriteInstance());
+			}
+			const double CrowdFrameMs = RunFrames(true);
+
+			const FString Prefix = FString::Printf(TEXT("characters_%d_"), NumCharacters);
+			Report.Add(Prefix + TEXT("components_frame_ms"), ComponentFrameMs);
+			Report.Add(Prefix + TEXT("crowd_frame_ms"), CrowdFrameMs);
+
+			for (UPaperFlipbookComponent* Sprite : Sprites)
+			{
+				Sprite->GetOwner()->Destroy();
+			}
+			CrowdOwner->Destroy();
+			FlushRenderingCommands();
+		}
+
+		UnloadBenchmarkMap(World, GameInstance);
+	}
+
+	/** What one scripted run of characters did, frame by frame */
+	struct FScriptedRun
+	{
+		//bIsHoldingWall of every character, frame after frame
+		TArray<bool> HoldingWall;
+		int32 Grabs = 0;
+		int64 OverlapPairs = 0;
+		//character frames spent on the ground
+		int64 GroundedFrames = 0;
+		//horizontal distance covered by all characters
+		double TravelledX = 0.0;
+		double Seconds = 0.0;
+		double MovementSeconds = 0.0;
+	};
+
+	/** Count characters walking and jumping along the -Map= level, with the console variable CVarName set to CVarValue */
+	static bool RunScriptedCharacters(const FArgs& Args, const TCHAR* CVarName, int32 CVarValue, FScriptedRun& OutRun)
+	{
+		IConsoleVariable* CVar = IConsoleManager::Get().FindConsoleVariable(CVarName);
+		const int32 PreviousValue = CVar->GetInt();
+		CVar->Set(CVarValue, ECVF_SetByCode);
+
+		UGameInstance* GameInstance = nullptr;
+		UWorld* World = LoadBenchmarkMap(Args, GameInstance);
+		if (World == nullptr)
+		{
+			CVar->Set(PreviousValue, ECVF_SetByCode);
+			return false;
+		}
+		AGameModeBase* GameMode = World->GetAuthGameMode();
+		const TSubclassOf<AVictorCharacter> PawnClass = GetBenchmarkPawnClass(Args, GameMode);
+		const AActor* PlayerStart = GameMode != nullptr ? GameMode->FindPlayerStart(nullptr) : nullptr;
+		const FVector StartLocation = PlayerStart != nullptr ? PlayerStart->GetActorLocation() : FVector::ZeroVector;
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+		TArray<AVictorCharacter*> Characters;
+		for (int32 i = 0; i < Args.Count; i++)
+		{
+			const FVector Location = StartLocation + FVector((i - Args.Count / 2) * 150.f, 0.f, 0.f);
+			AVictorCharacter* Character = World->SpawnActor<AVictorCharacter>(PawnClass, Location, FRotator::ZeroRotator, SpawnParameters);
+			if (Character != nullptr)
+			{
+				Character->SpawnDefaultController();
+				Characters.Add(Character);
+			}
+		}
+
+		const float DeltaTime = 1.f / 60.f;
+		OutRun.HoldingWall.Reset(Args.Iterations * Characters.Num());
+		TArray<UPrimitiveComponent*> Components;
+		FVictorTimings::Reset();
+		FVictorTimings::bEnabled = true;
+		for (int32 Frame = 0; Frame < Args.Iterations; Frame++)
+		{
+			for (int32 i = 0; i < Characters.Num(); i++)
+			{
+				//run at walls and jump often, so both grabbing and letting go happen
+				Characters[i]->MoveRight(((Frame + i * 23) / 90) % 2 == 0 ? 1.f : -1.f);
+				if ((Frame + i * 7) % 45 == 0)
+				{
+					Characters[i]->Jump();
+				}
+				else if ((Frame + i * 7) % 45 == 20)
+				{
+					Characters[i]->StopJumping();
+				}
+			}
+
+			FApp::SetDeltaTime(DeltaTime);
+			FApp::SetCurrentTime(FApp::GetCurrentTime() + DeltaTime);
+			const double StartTime = FPlatformTime::Seconds();
+			World->Tick(LEVELTICK_All, DeltaTime);
+			OutRun.Seconds += FPlatformTime::Seconds() - StartTime;
+			GFrameCounter++;
+
+			for (AVictorCharacter* Character : Characters)
+			{
+				OutRun.GroundedFrames += Character->GetCharacterMovement()->IsMovingOnGround() ? 1 : 0;
+				OutRun.TravelledX += FMath::Abs(Character->GetVelocity().X) * DeltaTime;
+
+				const bool bWasHolding = OutRun.HoldingWall.Num() >= Characters.Num() && OutRun.HoldingWall[OutRun.HoldingWall.Num() - Characters.Num()];
+				OutRun.Grabs += Character->bIsHoldingWall && !bWasHolding ? 1 : 0;
+				OutRun.HoldingWall.Add(Character->bIsHoldingWall);
+
+				Character->GetComponents(Components);
+				for (const UPrimitiveComponent* Component : Components)
+				{
+					OutRun.OverlapPairs += Component->GetOverlapInfos().Num();
+				}
+			}
+		}
+
+		FVictorTimings::bEnabled = false;
+		OutRun.MovementSeconds = FVictorTimings::Seconds[FVictorTimings::Movement];
+
+		UnloadBenchmarkMap(World, GameInstance);
+		CVar->Set(PreviousValue, ECVF_SetByCode);
+		return true;
+	}
+
+	/**
+	 * The same scripted run of Count characters on the -Map= level with WallGrabBox overlap events and with
+	 * the wall grab tested against the collision grid and the movable blockers. Reports how many frames agree on every character's bIsHoldingWall,
+	 * and the overlap pairs the characters' components keep per frame.
+	 */
+	static void RunWallGrab(const FArgs& Args, FReport& Report)
+	{
+		FScriptedRun OverlapRun;
+		FScriptedRun QueryRun;
+		if (!RunScriptedCharacters(Args, TEXT("victor.WallGrabQuery"), 0, OverlapRun) || !RunScriptedCharacters(Args, TEXT("victor.WallGrabQuery"), 1, QueryRun))
+		{
+			Report.Add(TEXT("failed"), 1.0);
+			return;
+		}
+
+		const int32 NumCharacters = OverlapRun.HoldingWall.Num() / FMath::Max(1, Args.Iterations);
+		int32 MatchingFrames = 0;
+		for (int32 Frame = 0; Frame < Args.Iterations && NumCharacters > 0; Frame++)
+		{
+			bool bMatch = true;
+			for (int32 i = Frame * NumCharacters; i < (Frame + 1) * NumCharacters && bMatch; i++)
+			{
+				bMatch = QueryRun.HoldingWall.IsValidIndex(i) && OverlapRun.HoldingWall[i] == QueryRun.HoldingWall[i];
+			}
+			MatchingFrames += bMatch ? 1 : 0;
+		}
+
+		const int32 Frames = FMath::Max(1, Args.Iterations);
+		Report.Add(TEXT("characters"), NumCharacters);
+		Report.Add(TEXT("overlap_grabs"), OverlapRun.Grabs);
+		Report.Add(TEXT("query_grabs"), QueryRun.Grabs);
+		Report.Add(TEXT("matching_frames"), MatchingFrames);
+		Report.Add(TEXT("results_match"), MatchingFrames == Args.Iterations ? 1.0 : 0.0);
+		Report.Add(TEXT("overlap_pairs_per_frame_overlap"), double(OverlapRun.OverlapPairs) / Frames);
+		Report.Add(TEXT("overlap_pairs_per_frame_query"), double(QueryRun.OverlapPairs) / Frames);
+		Report.Add(TEXT("overlap_frame_ms"), OverlapRun.Seconds * 1000.0 / Frames);
+		Report.Add(TEXT("query_frame_ms"), QueryRun.Seconds * 1000.0 / Frames);
+	}
+
+	/**
+	 * The same scripted run of Count characters on the -Map= level with the stock walking and falling modes and with
+	 * plane movement on the level collision grid. Reports the time spent in character movement, the frame time,
+	 * and how much the two runs differ in time on the ground, distance covered and wall grabs.
+	 */
+	static void RunPlaneMovement(const FArgs& Args, FReport& Report)
+	{
+		FScriptedRun StockRun;
+		FScriptedRun PlaneRun;
+		if (!RunScriptedCharacters(Args, TEXT("victor.PlaneMovement"), 0, StockRun) || !RunScriptedCharacters(Args, TEXT("victor.PlaneMovement"), 1, PlaneRun))
+		{
+			Report.Add(TEXT("failed"), 1.0);
+			return;
+		}
+
+		const int32 Frames = FMath::Max(1, Args.Iterations);
+		const int32 NumCharacters = StockRun.HoldingWall.Num() / Frames;
+		const double CharacterFrames = FMath::Max(1.0, double(StockRun.HoldingWall.Num()));
+		Report.Add(TEXT("characters"), NumCharacters);
+		Report.Add(TEXT("stock_movement_ms_per_frame"), StockRun.MovementSeconds * 1000.0 / Frames);
+		Report.Add(TEXT("plane_movement_ms_per_frame"), PlaneRun.MovementSeconds * 1000.0 / Frames);
+		Report.Add(TEXT("movement_speedup"), PlaneRun.MovementSeconds > 0.0 ? StockRun.MovementSeconds / PlaneRun.MovementSeconds : 0.0);
+		Report.Add(TEXT("stock_frame_ms"), StockRun.Seconds * 1000.0 / Frames);
+		Report.Add(TEXT("plane_frame_ms"), PlaneRun.Seconds * 1000.0 / Frames);
+		Report.Add(TEXT("stock_grounded_fraction"), StockRun.GroundedFrames / CharacterFrames);
+		Report.Add(TEXT("plane_grounded_fraction"), PlaneRun.GroundedFrames / CharacterFrames);
+		Report.Add(TEXT("stock_travelled_x"), StockRun.TravelledX);
+		Report.Add(TEXT("plane_travelled_x"), PlaneRun.TravelledX);
+		Report.Add(TEXT("stock_grabs"), StockRun.Grabs);
+		Report.Add(TEXT("plane_grabs"), PlaneRun.Grabs);
+	}
+
+	/**
+	 * Adds NumCopies instances of the loaded map as streaming levels <Map>_Chunk<N>, one chunk width apart, for maps
+	 * without chunk sublevels of their own like the example map. They start unloaded, the subsystem streams them in.
+	 */
+	static int32 AddMapCopiesAsChunks(UWorld* World, const UChunkStreamingSubsystem* Streaming, int32 NumCopies)
+	{
+		const FString MapPackage = World->GetOutermost()->GetName();
+		int32 NumAdded = 0;
+		for (int32 Index = 0; Index < NumCopies; Index++)
+		{
+			bool bSuccess = false;
+			const FVector Location(Streaming->ChunkOriginX + Index * Streaming->ChunkWidth, 0.f, 0.f);
+			const FString ChunkPackage = FString::Printf(TEXT("%s_Chunk%d"), *MapPackage, Index);
+			ULevelStreamingDynamic* Chunk = ULevelStreamingDynamic::LoadLevelInstance(World, MapPackage, Location, FRotator::ZeroRotator, bSuccess, ChunkPackage);
+			if (Chunk != nullptr && bSuccess)
+			{
+				Chunk->SetShouldBeVisible(false);
+				Chunk->SetShouldBeLoaded(false);
+				NumAdded++;
+			}
+		}
+		return NumAdded;
+	}
+
+	/**
+	 * Drives the streaming view back and forth across the chunks of the -Map= level for Iterations frames, at Count units
+	 * per second with every fourth second at three times that, and loads packages with the engine's default 5 ms budget.
+	 * A map without chunk sublevels is streamed as copies of itself, see AddMapCopiesAsChunks.
+	 * Reports stalls, chunk load latency, collision grid updates, loaded chunks and the process' resident memory.
+	 */
+	static void RunChunkStreaming(const FArgs& Args, FReport& Report)
+	{
+		UGameInstance* GameInstance = nullptr;
+		UWorld* World = LoadBenchmarkMap(Args, GameInstance);
+		if (World == nullptr)
+		{
+			Report.Add(TEXT("failed"), 1.0);
+			return;
+		}
+
+		UChunkStreamingSubsystem* Streaming = World->GetSubsystem<UChunkStreamingSubsystem>();
+		const float OrthoWidth = ScreenSize.X;
+		const float DeltaTime = 1.f / 60.f;
+		//the first tick finds the chunks
+		Streaming->SetViewOverride(FVector2D::ZeroVector, OrthoWidth);
+		Streaming->Tick(DeltaTime);
+		int32 NumMapCopies = 0;
+		if (!Streaming->GetChunkBounds().bIsValid)
+		{
+			NumMapCopies = AddMapCopiesAsChunks(World, Streaming, 8);
+			Streaming->Tick(DeltaTime);
+		}
+		const FBox2D Bounds = Streaming->GetChunkBounds();
+		if (!Bounds.bIsValid)
+		{
+			UE_LOG(LogVictorBenchmark, Warning, TEXT("No <Name>_Chunk<N> streaming levels, and the map could not be streamed as copies of itself"));
+			Report.Add(TEXT("chunks"), 0.0);
+			UnloadBenchmarkMap(World, GameInstance);
+			return;
+		}
+		const int32 FullBuildsBefore = World->GetSubsystem<ULevelGridSubsystem>()->GetNumFullBuilds();
+
+		const float MinViewX = Bounds.Min.X + OrthoWidth * 0.5f;
+		const float MaxViewX = FMath::Max(Bounds.Max.X - OrthoWidth * 0.5f, MinViewX);
+		float ViewX = MinViewX;
+		float Direction = 1.f;
+		int32 PeakLoadedChunks = 0;
+		int64 LoadedChunkFrames = 0;
+		uint64 PeakUsedPhysical = 0;
+		double UsedPhysicalSum = 0.0;
+		int32 MemorySamples = 0;
+		double Seconds = 0.0;
+		for (int32 Frame = 0; Frame < Args.Iterations; Frame++)
+		{
+			const bool bSprinting = (Frame / 60) % 4 == 3;
+			ViewX += Direction * Args.Count * (bSprinting ? 3.f : 1.f) * DeltaTime;
+			if (ViewX >= MaxViewX || ViewX <= MinViewX)
+			{
+				ViewX = FMath::Clamp(ViewX, MinViewX, MaxViewX);
+				Direction = -Direction;
+			}
+			Streaming->SetViewOverride(FVector2D(ViewX, 0.f), OrthoWidth);
+
+			FApp::SetDeltaTime(DeltaTime);
+			FApp::SetCurrentTime(FApp::GetCurrentTime() + DeltaTime);
+			const double StartTime = FPlatformTime::Seconds();
+			World->Tick(LEVELTICK_All, DeltaTime);
+			World->UpdateLevelStreaming();
+			ProcessAsyncLoading(true, false, 0.005f);
+			Seconds += FPlatformTime::Seconds() - StartTime;
+			GFrameCounter++;
+
+			const FChunkStreamingStats& Stats = Streaming->GetStats();
+			PeakLoadedChunks = FMath::Max(PeakLoadedChunks, Stats.NumLoadedChunks);
+			LoadedChunkFrames += Stats.NumLoadedChunks;
+			if (Frame % 30 == 0)
+			{
+				const uint64 UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+				PeakUsedPhysical = FMath::Max(PeakUsedPhysical, UsedPhysical);
+				UsedPhysicalSum += UsedPhysical;
+				MemorySamples++;
+			}
+		}
+
+		const FChunkStreamingStats& Stats = Streaming->GetStats();
+		const int32 Frames = FMath::Max(1, Args.Iterations);
+		Report.Add(TEXT("chunks"), Stats.NumChunks);
+		Report.Add(TEXT("map_copies"), NumMapCopies);
+		Report.Add(TEXT("requests"), Stats.NumRequests);
+		Report.Add(TEXT("stalls"), Stats.NumStalls);
+		Report.Add(TEXT("stall_frames"), Stats.StallFrames);
+		Report.Add(TEXT("stall_ms"), Stats.StallSeconds * 1000.0);
+		Report.Add(TEXT("max_load_ms"), Stats.MaxLoadSeconds * 1000.0);
+		Report.Add(TEXT("grid_updates"), Stats.NumGridUpdates);
+		Report.Add(TEXT("grid_update_ms"), Stats.GridUpdateSeconds * 1000.0);
+		Report.Add(TEXT("max_grid_update_ms"), Stats.MaxGridUpdateSeconds * 1000.0);
+		Report.Add(TEXT("grid_full_builds"), World->GetSubsystem<ULevelGridSubsystem>()->GetNumFullBuilds() - FullBuildsBefore);
+		Report.Add(TEXT("avg_loaded_chunks"), double(LoadedChunkFrames) / Frames);
+		Report.Add(TEXT("peak_loaded_chunks"), PeakLoadedChunks);
+		Report.Add(TEXT("avg_resident_mb"), UsedPhysicalSum / FMath::Max(MemorySamples, 1) / (1024.0 * 1024.0));
+		Report.Add(TEXT("peak_resident_mb"), PeakUsedPhysical / (1024.0 * 1024.0));
+		Report.Add(TEXT("frame_ms"), Seconds * 1000.0 / Frames);
+
+		UnloadBenchmarkMap(World, GameInstance);
+	}
+
+	/** Flipbooks and sprites in memory, and what their textures take */
+	struct FFlipbookMemory
+	{
+		int32 Flipbooks = 0;
+		int32 Sprites = 0;
+		int64 TextureBytes = 0;
+	};
+
+	static FFlipbookMemory MeasureFlipbookMemory()
+	{
+		FFlipbookMemory Memory;
+		for (TObjectIterator<UPaperFlipbook> It; It; ++It)
+		{
+			Memory.Flipbooks++;
+		}
+		TSet<UTexture2D*> Textures;
+		for (TObjectIterator<UPaperSprite> It; It; ++It)
+		{
+			Memory.Sprites++;
+			if (UTexture2D* Texture = It->GetBakedTexture())
+			{
+				Textures.Add(Texture);
+			}
+		}
+		for (const UTexture2D* Texture : Textures)
+		{
+			Memory.TextureBytes += Texture->CalcTextureMemorySizeEnum(TMC_ResidentMips);
+		}
+		return Memory;
+	}
+
+	/** What one synthetic guard level did with victor.AnimationBundles at one value */
+	struct FAnimationBundleRun
+	{
+		int32 Guards = 0;
+		//from loading the map to every guard having begun play
+		double LevelLoadSeconds = 0.0;
+		double FrameSeconds = 0.0;
+		//guard frames on screen without their flipbook loaded, they kept showing the one before
+		int64 UnloadedOnScreenFrames = 0;
+		//resident after the frames, less what was resident before the map
+		FFlipbookMemory Memory;
+		int64 UsedPhysicalBytes = 0;
+	};
+
+	/**
+	 * Loads the -Map= level and spawns Count guard variants of -GuardsPerVariant= guards each, every variant with its own
+	 * flipbooks picked from Flipbooks, then walks the camera along them for Iterations frames.
+	 */
+	static bool RunAnimationBundleLevel(const FArgs& Args, const TArray<FSoftObjectPath>& Flipbooks, int32 CVarValue, FAnimationBundleRun& OutRun)
+	{
+		IConsoleVariable* CVar = IConsoleManager::Get().FindConsoleVariable(TEXT("victor.AnimationBundles"));
+		const int32 PreviousValue = CVar->GetInt();
+		CVar->Set(CVarValue, ECVF_SetByCode);
+
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+		const FFlipbookMemory MemoryBefore = MeasureFlipbookMemory();
+		const uint64 UsedPhysicalBefore = FPlatformMemory::GetStats().UsedPhysical;
+
+		const double LoadStartTime = FPlatformTime::Seconds();
+		UGameInstance* GameInstance = nullptr;
+		UWorld* World = LoadBenchmarkMap(Args, GameInstance);
+		if (World == nullptr)
+		{
+			CVar->Set(PreviousValue, ECVF_SetByCode);
+			return false;
+		}
+		AGameModeBase* GameMode = World->GetAuthGameMode();
+		const TSubclassOf<AVictorCharacter> PawnClass = GetBenchmarkPawnClass(Args, GameMode);
+		const AActor* PlayerStart = GameMode != nullptr ? GameMode->FindPlayerStart(nullptr) : nullptr;
+		const FVector StartLocation = PlayerStart != nullptr ? PlayerStart->GetActorLocation() : FVector::ZeroVector;
+		int32 GuardsPerVariant = 4;
+		FParse::Value(*Args.Params, TEXT("GuardsPerVariant="), GuardsPerVariant);
+
+		//the flipbooks are protected, and a real variant would have them set in its Blueprint defaults
+		static const TCHAR* AnimationProperties[] = { TEXT("IdleAnimation"), TEXT("RunningAnimation"), TEXT("PistolIdleAnimation"), TEXT("PistolWalkAnimation"), TEXT("StabAnimation"), TEXT("DeathAnimation"), TEXT("UnPossesAnimation") };
+		const int32 NumProperties = UE_ARRAY_COUNT(AnimationProperties);
+		TArray<FSoftObjectProperty*> Properties;
+		for (const TCHAR* Name : AnimationProperties)
+		{
+			Properties.Add(FindFProperty<FSoftObjectProperty>(AVictorCharacter::StaticClass(), Name));
+		}
+
+		//variants stand a quarter screen apart, so about eight of them are near the camera at a time
+		const float VariantSpacing = ScreenSize.X * 0.25f;
+		TArray<AVictorCharacter*> Guards;
+		for (int32 Variant = 0; Variant < Args.Count; Variant++)
+		{
+			for (int32 Copy = 0; Copy < GuardsPerVariant; Copy++)
+			{
+				const FTransform SpawnTransform(StartLocation + FVector(Variant * VariantSpacing + Copy * 100.f, 0.f, 0.f));
+				AVictorCharacter* Guard = World->SpawnActorDeferred<AVictorCharacter>(PawnClass, SpawnTransform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+				if (Guard == nullptr)
+				{
+					continue;
+				}
+				for (int32 Slot = 0; Slot < NumProperties; Slot++)
+				{
+					if (Properties[Slot] != nullptr)
+					{
+						Properties[Slot]->SetPropertyValue_InContainer(Guard, FSoftObjectPtr(Flipbooks[(Variant * NumProperties + Slot) % Flipbooks.Num()]));
+					}
+				}
+				Guard->FinishSpawning(SpawnTransform);
+				Guard->SpawnDefaultController();
+				Guards.Add(Guard);
+			}
+		}
+		OutRun.Guards = Guards.Num();
+		OutRun.LevelLoadSeconds = FPlatformTime::Seconds() - LoadStartTime;
+
+		UAnimationStreamingSubsystem* AnimationStreaming = World->GetSubsystem<UAnimationStreamingSubsystem>();
+		const float DeltaTime = 1.f / 60.f;
+		const FVector2D ScreenHalfExtent = ScreenSize * 0.5f;
+		for (int32 Frame = 0; Frame < Args.Iterations; Frame++)
+		{
+			//the camera walks along the variants at running speed
+			const FVector2D ViewCenter(StartLocation.X + Frame * DeltaTime * 600.f, StartLocation.Z);
+			AnimationStreaming->SetViewOverride(ViewCenter);
+			for (int32 i = 0; i < Guards.Num(); i++)
+			{
+				Guards[i]->MoveRight(float((Frame / 60 + i) % 3 - 1));
+			}
+
+			FApp::SetDeltaTime(DeltaTime);
+			FApp::SetCurrentTime(FApp::GetCurrentTime() + DeltaTime);
+			const double StartTime = FPlatformTime::Seconds();
+			World->Tick(LEVELTICK_All, DeltaTime);
+			ProcessAsyncLoading(true, false, 0.005f);
+			OutRun.FrameSeconds += FPlatformTime::Seconds() - StartTime;
+			GFrameCounter++;
+
+			for (const AVictorCharacter* Guard : Guards)
+			{
+				const FVector Location = Guard->GetActorLocation();
+				const bool bOnScreen = FMath::Abs(Location.X - ViewCenter.X) <= ScreenHalfExtent.X && FMath::Abs(Location.Z - ViewCenter.Y) <= ScreenHalfExtent.Y;
+				OutRun.UnloadedOnScreenFrames += bOnScreen && Guard->ResolveAnimation(Guard->GetAnimationStateKey()) == nullptr ? 1 : 0;
+			}
+		}
+
+		FlushAsyncLoading();
+		const FFlipbookMemory MemoryAfter = MeasureFlipbookMemory();
+		OutRun.Memory.Flipbooks = MemoryAfter.Flipbooks - MemoryBefore.Flipbooks;
+		OutRun.Memory.Sprites = MemoryAfter.Sprites - MemoryBefore.Sprites;
+		OutRun.Memory.TextureBytes = MemoryAfter.TextureBytes - MemoryBefore.TextureBytes;
+		OutRun.UsedPhysicalBytes = int64(FPlatformMemory::GetStats().UsedPhysical) - int64(UsedPhysicalBefore);
+
+		UnloadBenchmarkMap(World, GameInstance);
+		CVar->Set(PreviousValue, ECVF_SetByCode);
+		return true;
+	}
+
+	/**
+	 * The same synthetic level of Count guard variants, each with its own seven flipbooks from -FlipbookPath=, with every
+	 * flipbook loaded when a guard begins play, as the hard references did, and with bundles loaded on demand near the camera.
+	 * Reports the level load time, the flipbooks, sprites and texture memory resident afterwards, the process' memory growth,
+	 * and how many guard frames on screen were still waiting for their flipbook.
+	 */
+	static void RunAnimationBundles(const FArgs& Args, FReport& Report)
+	{
+		FString FlipbookPath = TEXT("/Game/Sprites");
+		FParse::Value(*Args.Params, TEXT("FlipbookPath="), FlipbookPath);
+		IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+		AssetRegistry.SearchAllAssets(true);
+		TArray<FAssetData> Assets;
+		AssetRegistry.GetAssetsByPath(FName(*FlipbookPath), Assets, true);
+		TArray<FSoftObjectPath> Flipbooks;
+		for (const FAssetData& Asset : Assets)
+		{
+			if (Asset.AssetClass == UPaperFlipbook::StaticClass()->GetFName())
+			{
+				Flipbooks.Add(Asset.ToSoftObjectPath());
+			}
+		}
+		//the same variants on every machine
+		Flipbooks.Sort([](const FSoftObjectPath& A, const FSoftObjectPath& B) { return A.ToString() < B.ToString(); });
+		if (Flipbooks.Num() == 0)
+		{
+			UE_LOG(LogVictorBenchmark, Error, TEXT("No flipbooks under %s"), *FlipbookPath);
+			Report.Add(TEXT("failed"), 1.0);
+			return;
+		}
+
+		//on demand first, so the eager run can't leave flipbooks behind for it
+		FAnimationBundleRun OnDemandRun;
+		FAnimationBundleRun EagerRun;
+		if (!RunAnimationBundleLevel(Args, Flipbooks, 1, OnDemandRun) || !RunAnimationBundleLevel(Args, Flipbooks, 0, EagerRun))
+		{
+			Report.Add(TEXT("failed"), 1.0);
+			return;
+		}
+
+		const int32 Frames = FMath::Max(1, Args.Iterations);
+		const double Megabyte = 1024.0 * 1024.0;
+		Report.Add(TEXT("variants"), Args.Count);
+		Report.Add(TEXT("guards"), OnDemandRun.Guards);
+		Report.Add(TEXT("flipbooks_available"), Flipbooks.Num());
+		Report.Add(TEXT("eager_level_load_ms"), EagerRun.LevelLoadSeconds * 1000.0);
+		Report.Add(TEXT("ondemand_level_load_ms"), OnDemandRun.LevelLoadSeconds * 1000.0);
+		Report.Add(TEXT("eager_resident_flipbooks"), EagerRun.Memory.Flipbooks);
+		Report.Add(TEXT("ondemand_resident_flipbooks"), OnDemandRun.Memory.Flipbooks);
+		Report.Add(TEXT("eager_resident_sprites"), EagerRun.Memory.Sprites);
+		Report.Add(TEXT("ondemand_resident_sprites"), OnDemandRun.Memory.Sprites);
+		Report.Add(TEXT("eager_texture_mb"), EagerRun.Memory.TextureBytes / Megabyte);
+		Report.Add(TEXT("ondemand_texture_mb"), OnDemandRun.Memory.TextureBytes / Megabyte);
+		Report.Add(TEXT("eager_resident_growth_mb"), EagerRun.UsedPhysicalBytes / Megabyte);
+		Report.Add(TEXT("ondemand_resident_growth_mb"), OnDemandRun.UsedPhysicalBytes / Megabyte);
+		Report.Add(TEXT("eager_frame_ms"), EagerRun.FrameSeconds * 1000.0 / Frames);
+		Report.Add(TEXT("ondemand_frame_ms"), OnDemandRun.FrameSeconds * 1000.0 / Frames);
+		Report.Add(TEXT("eager_unloaded_on_screen_frames"), EagerRun.UnloadedOnScreenFrames);
+		Report.Add(TEXT("ondemand_unloaded_on_screen_frames"), OnDemandRun.UnloadedOnScreenFrames);
+	}
+
+	/** What one run of the guard AI level measured */
+	struct FGuardAIRun
+	{
+		FGuardAIStats Stats;
+		double FrameSeconds = 0.0;
+		//guards chasing or attacking after the last frame
+		int32 AlertGuards = 0;
+	};
+
+	/**
+	 * Count guards along the -Map= level and a player team target for every 50 of them walking back and forth through
+	 * them, for Iterations frames around a fixed camera. bDistanceLOD off makes every guard decide every frame.
+	 */
+	static bool RunGuardAILevel(const FArgs& Args, bool bParallel, bool bDistanceLOD, FGuardAIRun& OutRun)
+	{
+		UGameInstance* GameInstance = nullptr;
+		UWorld* World = LoadBenchmarkMap(Args, GameInstance);
+		if (World == nullptr)
+		{
+			return false;
+		}
+		AGameModeBase* GameMode = World->GetAuthGameMode();
+		const TSubclassOf<AVictorCharacter> PawnClass = GetBenchmarkPawnClass(Args, GameMode);
+		const AActor* PlayerStart = GameMode != nullptr ? GameMode->FindPlayerStart(nullptr) : nullptr;
+		const FVector StartLocation = PlayerStart != nullptr ? PlayerStart->GetActorLocation() : FVector::ZeroVector;
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+		TArray<AVictorCharacter*> Guards;
+		for (int32 i = 0; i < Args.Count; i++)
+		{
+			const FVector Location = StartLocation + FVector((i - Args.Count / 2) * 120.f, 0.f, 0.f);
+			AVictorCharacter* Guard = World->SpawnActor<AVictorCharacter>(PawnClass, Location, FRotator::ZeroRotator, SpawnParameters);
+			if (Guard != nullptr)
+			{
+				Guard->SpawnDefaultController();
+				Guards.Add(Guard);
+			}
+		}
+		TArray<AVictorCharacter*> Targets;
+		for (int32 i = 0; i <= Args.Count / 50; i++)
+		{
+			const FVector Location = StartLocation + FVector((i - Args.Count / 100) * 120.f * 50.f, 0.f, 0.f);
+			AVictorCharacter* Target = World->SpawnActor<AVictorCharacter>(PawnClass, Location, FRotator::ZeroRotator, SpawnParameters);
+			if (Target != nullptr)
+			{
+				Target->Team = ETeam::ET_Player;
+				Target->SpawnDefaultController();
+				Targets.Add(Target);
+			}
+		}
+
+		UGuardAISubsystem* GuardAI = World->GetSubsystem<UGuardAISubsystem>();
+		GuardAI->bRunOnWorkerThreads = bParallel;
+		if (!bDistanceLOD)
+		{
+			GuardAI->MidUpdateInterval = 0.f;
+			GuardAI->FarUpdateInterval = 0.f;
+		}
+		GuardAI->SetViewOverride(ToPlane2D(StartLocation));
+		GuardAI->ResetStats();
+
+		const float DeltaTime = 1.f / 60.f;
+		for (int32 Frame = 0; Frame < Args.Iterations; Frame++)
+		{
+			for (int32 i = 0; i < Targets.Num(); i++)
+			{
+				Targets[i]->MoveRight(((Frame + i * 37) / 180) % 2 == 0 ? 1.f : -1.f);
+			}
+
+			FApp::SetDeltaTime(DeltaTime);
+			FApp::SetCurrentTime(FApp::GetCurrentTime() + DeltaTime);
+			const double StartTime = FPlatformTime::Seconds();
+			World->Tick(LEVELTICK_All, DeltaTime);
+			OutRun.FrameSeconds += FPlatformTime::Seconds() - StartTime;
+			GFrameCounter++;
+		}
+
+		OutRun.Stats = GuardAI->GetStats();
+		for (const AVictorCharacter* Guard : Guards)
+		{
+			const EGuardAIState State = GuardAI->GetGuardState(Guard);
+			OutRun.AlertGuards += State == EGuardAIState::EGS_Chase || State == EGuardAIState::EGS_Attack ? 1 : 0;
+		}
+
+		UnloadBenchmarkMap(World, GameInstance);
+		return true;
+	}
+
+	/**
+	 * UGuardAISubsystem with Count guards on the -Map= level: every guard deciding every frame on the game thread,
+	 * every guard deciding every frame on worker threads, and with guards away from the camera deciding less often.
+	 * Reports the AI's cost per guard and per decision, split into gathering, deciding and applying, and the frame time.
+	 */
+	static void RunGuardAI(const FArgs& Args, FReport& Report)
+	{
+		struct FConfiguration
+		{
+			const TCHAR* Name;
+			bool bParallel;
+			bool bDistanceLOD;
+		};
+		static const FConfiguration Configurations[] =
+		{
+			{ TEXT("serial"), false, false },
+			{ TEXT("parallel"), true, false },
+			{ TEXT("parallel_lod"), true, true },
+		};
+
+		bool bReportedGuards = false;
+		for (const FConfiguration& Configuration : Configurations)
+		{
+			FGuardAIRun Run;
+			if (!RunGuardAILevel(Args, Configuration.bParallel, Configuration.bDistanceLOD, Run))
+			{
+				Report.Add(TEXT("failed"), 1.0);
+				return;
+			}
+
+			const FGuardAIStats& Stats = Run.Stats;
+			if (!bReportedGuards)
+			{
+				Report.Add(TEXT("guards"), Stats.Frames > 0 ? double(Stats.GuardFrames) / Stats.Frames : 0.0);
+				bReportedGuards = true;
+			}
+			const double TotalSeconds = Stats.GatherSeconds + Stats.DecideSeconds + Stats.ApplySeconds;
+			const double GuardFrames = FMath::Max<double>(Stats.GuardFrames, 1.0);
+			const FString Prefix = FString(Configuration.Name) + TEXT("_");
+			Report.Add(Prefix + TEXT("ai_us_per_guard"), TotalSeconds * 1e6 / GuardFrames);
+			Report.Add(Prefix + TEXT("gather_us_per_guard"), Stats.GatherSeconds * 1e6 / GuardFrames);
+			Report.Add(Prefix + TEXT("decide_us_per_guard"), Stats.DecideSeconds * 1e6 / GuardFrames);
+			Report.Add(Prefix + TEXT("apply_us_per_guard"), Stats.ApplySeconds * 1e6 / GuardFrames);
+			Report.Add(Prefix + TEXT("decide_us_per_decision"), Stats.DecideSeconds * 1e6 / FMath::Max<double>(Stats.Decisions, 1.0));
+			Report.Add(Prefix + TEXT("decisions_per_frame"), double(Stats.Decisions) / FMath::Max(Stats.Frames, 1));
+			Report.Add(Prefix + TEXT("ai_ms_per_frame"), TotalSeconds * 1000.0 / FMath::Max(Stats.Frames, 1));
+			Report.Add(Prefix + TEXT("frame_ms"), Run.FrameSeconds * 1000.0 / FMath::Max(Args.Iterations, 1));
+			Report.Add(Prefix + TEXT("alert_guards"), Run.AlertGuards);
+		}
+	}
+
+	/**
+	 * Platform nav graph of a synthetic level Count screens wide: build time, size in memory and on disk, and Iterations
+	 * path queries between floors up to two screens apart. Cold searches on one thread and on the worker threads, then
+	 * the same number of queries drawn from an eighth as many pairs through FPlatformPathCache, the way guards re-path
+	 * to the same places.
+	 */
+	static void RunPlatformNav(const FArgs& Args, FReport& Report)
+	{
+		const float Width = ScreenSize.X * FMath::Max(Args.Count, 1);
+		FRandomStream Random(Args.Seed);
+		FLevelCollisionGrid Grid;
+		BuildSyntheticLevel(Random, Width, Grid);
+
+		double StartTime = FPlatformTime::Seconds();
+		FPlatformNavGraph Graph;
+		Graph.Build(Grid, FPlatformNavBuildSettings());
+		const double BuildSeconds = FPlatformTime::Seconds() - StartTime;
+
+		TArray<uint8> FileData;
+		FMemoryWriter Writer(FileData);
+		Writer << Graph;
+
+		const int32 NumNodes = Graph.GetNodes().Num();
+		const int32 NumEdges = Graph.GetEdges().Num();
+		Report.Add(TEXT("build_ms"), BuildSeconds * 1000.0);
+		Report.Add(TEXT("floor_nodes"), Graph.GetNumFloorNodes());
+		Report.Add(TEXT("wall_nodes"), NumNodes - Graph.GetNumFloorNodes());
+		Report.Add(TEXT("walk_edges"), Graph.GetNumEdges(EPlatformNavEdge::Walk));
+		Report.Add(TEXT("drop_edges"), Graph.GetNumEdges(EPlatformNavEdge::Drop));
+		Report.Add(TEXT("jump_edges"), Graph.GetNumEdges(EPlatformNavEdge::Jump));
+		Report.Add(TEXT("wall_grab_edges"), Graph.GetNumEdges(EPlatformNavEdge::WallGrab));
+		Report.Add(TEXT("graph_kb"), Graph.GetAllocatedSize() / 1024.0);
+		Report.Add(TEXT("file_kb"), FileData.Num() / 1024.0);
+		if (Graph.GetNumFloorNodes() == 0)
+		{
+			Report.Add(TEXT("failed"), 1.0);
+			return;
+		}
+
+		auto MakeQuery = [&]()
+		{
+			const int32 Start = Random.RandHelper(Graph.GetNumFloorNodes());
+			const FVector2D Offset(Random.FRandRange(-2.f, 2.f) * ScreenSize.X, Random.FRandRange(0.f, ScreenSize.Y));
+			const int32 Goal = Graph.FindFloorNode(Graph.GetNodes()[Start].Location + Offset);
+			return FIntPoint(Start, Goal != INDEX_NONE ? Goal : Random.RandHelper(Graph.GetNumFloorNodes()));
+		};
+		TArray<FIntPoint> Queries;
+		for (int32 i = 0; i < Args.Iterations; i++)
+		{
+			Queries.Add(MakeQuery());
+		}
+
+		TArray<FPlatformPath> SerialPaths;
+		int64 NodesExpanded = 0;
+		StartTime = FPlatformTime::Seconds();
+		Graph.FindPaths(Queries, SerialPaths, false, &NodesExpanded);
+		const double SerialSeconds = FPlatformTime::Seconds() - StartTime;
+
+		TArray<FPlatformPath> ParallelPaths;
+		StartTime = FPlatformTime::Seconds();
+		Graph.FindPaths(Queries, ParallelPaths, true);
+		const double ParallelSeconds = FPlatformTime::Seconds() - StartTime;
+
+		int32 NumFound = 0;
+		bool bResultsMatch = true;
+		for (int32 i = 0; i < Queries.Num(); i++)
+		{
+			NumFound += SerialPaths[i].IsValid() ? 1 : 0;
+			bResultsMatch &= SerialPaths[i].IsValid() == ParallelPaths[i].IsValid() && SerialPaths[i].Cost == ParallelPaths[i].Cost;
+		}
+		const double NumQueries = FMath::Max(Queries.Num(), 1);
+		Report.Add(TEXT("found_ratio"), NumFound / NumQueries);
+		Report.Add(TEXT("expanded_per_query"), NodesExpanded / NumQueries);
+		Report.Add(TEXT("serial_queries_per_s"), NumQueries / FMath::Max(SerialSeconds, 1e-9));
+		Report.Add(TEXT("parallel_queries_per_s"), NumQueries / FMath::Max(ParallelSeconds, 1e-9));
+		Report.Add(TEXT("search_scratch_kb"), NumNodes * (sizeof(float) + sizeof(int32) * 2 + sizeof(uint32)) / 1024.0);
+		Report.Add(TEXT("results_match"), bResultsMatch ? 1.0 : 0.0);
+
+		TArray<FIntPoint> HotPairs;
+		for (int32 i = 0; i < FMath::Max(Args.Iterations / 8, 1); i++)
+		{
+			HotPairs.Add(MakeQuery());
+		}
+		FPlatformPathCache Cache;
+		Cache.SetCapacity(GetDefault<UPlatformNavSubsystem>()->MaxCachedPaths);
+		FPlatformNavSearch Search;
+		int32 CacheHits = 0;
+		StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Args.Iterations; i++)
+		{
+			const FIntPoint Pair = HotPairs[Random.RandHelper(HotPairs.Num())];
+			if (Cache.Find(Pair.X, Pair.Y).IsValid())
+			{
+				CacheHits++;
+				continue;
+			}
+			TSharedRef<FPlatformPath, ESPMode::ThreadSafe> Path = MakeShared<FPlatformPath, ESPMode::ThreadSafe>();
+			Graph.FindPath(Pair.X, Pair.Y, Search, *Path);
+			Cache.Add(Pair.X, Pair.Y, Path);
+		}
+		const double CachedSeconds = FPlatformTime::Seconds() - StartTime;
+		Report.Add(TEXT("cached_queries_per_s"), Args.Iterations / FMath::Max(CachedSeconds, 1e-9));
+		Report.Add(TEXT("cache_hit_ratio"), CacheHits / double(FMath::Max(Args.Iterations, 1)));
+		Report.Add(TEXT("cache_kb"), Cache.GetAllocatedSize() / 1024.0);
+	}
+
+	struct FMassExplosionRun
+	{
+		int32 Guards = 0;
+		int32 Deaths = 0;
+		double QueueSeconds = 0.0;
+		double FlushSeconds = 0.0;
+		FDamageQueueStats Stats;
+	};
+
+	/**
+	 * Count guards on the -Map= level and Iterations explosions on top of random guards in one frame.
+	 * bStock deals them with UGameplayStatics::ApplyRadialDamage, a physics overlap and a visibility trace per character
+	 * per explosion; otherwise they go through UDamageQueueSubsystem::QueueRadialDamage. Both die in the queue's flush.
+	 */
+	static bool RunMassExplosionLevel(const FArgs& Args, bool bStock, FMassExplosionRun& OutRun)
+	{
+		UGameInstance* GameInstance = nullptr;
+		UWorld* World = LoadBenchmarkMap(Args, GameInstance);
+		if (World == nullptr)
+		{
+			return false;
+		}
+		AGameModeBase* GameMode = World->GetAuthGameMode();
+		const TSubclassOf<AVictorCharacter> PawnClass = GetBenchmarkPawnClass(Args, GameMode);
+		const AActor* PlayerStart = GameMode != nullptr ? GameMode->FindPlayerStart(nullptr) : nullptr;
+		const FVector StartLocation = PlayerStart != nullptr ? PlayerStart->GetActorLocation() : FVector::ZeroVector;
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+		//a crowd 50 guards wide, a row every capsule height
+		TArray<AVictorCharacter*> Guards;
+		for (int32 i = 0; i < Args.Count; i++)
+		{
+			const FVector Location = StartLocation + FVector((i % 50 - 25) * 100.f, 0.f, (i / 50) * CapsuleHalfExtent.Y * 2.f);
+			AVictorCharacter* Guard = World->SpawnActor<AVictorCharacter>(PawnClass, Location, FRotator::ZeroRotator, SpawnParameters);
+			if (Guard != nullptr)
+			{
+				Guard->SpawnDefaultController();
+				Guards.Add(Guard);
+			}
+		}
+		OutRun.Guards = Guards.Num();
+		if (Guards.Num() == 0)
+		{
+			UnloadBenchmarkMap(World, GameInstance);
+			return false;
+		}
+
+		//one frame so everyone is registered and standing where the explosions will be
+		const float DeltaTime = 1.f / 60.f;
+		FApp::SetDeltaTime(DeltaTime);
+		FApp::SetCurrentTime(FApp::GetCurrentTime() + DeltaTime);
+		World->Tick(LEVELTICK_All, DeltaTime);
+		GFrameCounter++;
+
+		UDamageQueueSubsystem* DamageQueue = World->GetSubsystem<UDamageQueueSubsystem>();
+		DamageQueue->ResetStats();
+		const float Radius = 300.f;
+		FRandomStream Random(Args.Seed);
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Args.Iterations; i++)
+		{
+			const FVector Origin = Guards[Random.RandHelper(Guards.Num())]->GetActorLocation() + FVector(Random.FRandRange(-Radius, Radius), 0.f, 0.f);
+			if (bStock)
+			{
+				UGameplayStatics::ApplyRadialDamage(World, 100.f, Origin, Radius, UDamageType::StaticClass(), TArray<AActor*>(), nullptr, nullptr, false, ECC_Visibility);
+			}
+			else
+			{
+				//no attacker, like the stock path it hurts everyone
+				DamageQueue->QueueRadialDamage(Origin, Radius, 100.f, 100.f, ETeam::ET_Player, false, nullptr, nullptr);
+			}
+		}
+		OutRun.QueueSeconds = FPlatformTime::Seconds() - StartTime;
+
+		StartTime = FPlatformTime::Seconds();
+		DamageQueue->Flush();
+		OutRun.FlushSeconds = FPlatformTime::Seconds() - StartTime;
+
+		OutRun.Stats = DamageQueue->GetStats();
+		for (const AVictorCharacter* Guard : Guards)
+		{
+			OutRun.Deaths += Guard->bDead ? 1 : 0;
+		}
+
+		UnloadBenchmarkMap(World, GameInstance);
+		return true;
+	}
+
+	/**
+	 * Mass explosion: Iterations explosions in one frame over a crowd of Count guards, dealt by the engine's radial
+	 * damage and by the damage queue's grid. Reports the frame's damage cost, how many guards each explosion looked at
+	 * and the deaths, which only differ where the level collision grid and the visibility channel disagree on walls.
+	 */
+	static void RunMassExplosion(const FArgs& Args, FReport& Report)
+	{
+		FMassExplosionRun StockRun;
+		FMassExplosionRun QueueRun;
+		if (!RunMassExplosionLevel(Args, true, StockRun) || !RunMassExplosionLevel(Args, false, QueueRun))
+		{
+			Report.Add(TEXT("failed"), 1.0);
+			return;
+		}
+		const double Explosions = FMath::Max(Args.Iterations, 1);
+		Report.Add(TEXT("guards"), QueueRun.Guards);
+		Report.Add(TEXT("explosions"), Args.Iterations);
+		Report.Add(TEXT("stock_ms"), (StockRun.QueueSeconds + StockRun.FlushSeconds) * 1000.0);
+		Report.Add(TEXT("stock_us_per_explosion"), StockRun.QueueSeconds * 1e6 / Explosions);
+		Report.Add(TEXT("stock_deaths"), StockRun.Deaths);
+		Report.Add(TEXT("queue_ms"), (QueueRun.QueueSeconds + QueueRun.FlushSeconds) * 1000.0);
+		Report.Add(TEXT("queue_resolve_us_per_explosion"), QueueRun.Stats.ResolveSeconds * 1e6 / Explosions);
+		Report.Add(TEXT("queue_apply_ms"), QueueRun.Stats.ApplySeconds * 1000.0);
+		Report.Add(TEXT("queue_examined_per_explosion"), QueueRun.Stats.TargetsExamined / Explosions);
+		Report.Add(TEXT("queue_deaths"), QueueRun.Deaths);
+		Report.Add(TEXT("speedup"), (StockRun.QueueSeconds + StockRun.FlushSeconds) / FMath::Max(QueueRun.QueueSeconds + QueueRun.FlushSeconds, 1e-9));
+	}
+
+	/**
+	 * Count armed guards firing whenever their weapon is off cooldown, for Iterations frames at 60 Hz, each shot also
+	 * arming the attack animation timer a character would. Cooldowns and animation timers through FTimerManager,
+	 * through FGameplayTimerWheel, and cooldowns as timestamps with only the animation timers on the wheel.
+	 */
+	static void RunGameplayTimers(const FArgs& Args, FReport& Report)
+	{
+		enum EMode
+		{
+			TimerManager,
+			Wheel,
+			Timestamps
+		};
+		static const TCHAR* ModeNames[] = { TEXT("timer_manager"), TEXT("wheel"), TEXT("timestamps") };
+
+		const int32 NumGuards = FMath::Max(Args.Count, 1);
+		const float DeltaTime = 1.f / 60.f;
+		const float TickSeconds = GetDefault<UGameplayTimerSubsystem>()->TickSeconds;
+		const float AttackAnimSeconds = 0.3f;
+		FRandomStream Random(Args.Seed);
+		TArray<float> Cooldowns;
+		for (int32 i = 0; i < NumGuards; i++)
+		{
+			Cooldowns.Add(Random.FRandRange(0.2f, 1.5f));
+		}
+
+		for (int32 Mode = TimerManager; Mode <= Timestamps; Mode++)
+		{
+			TArray<bool> CoolingDown;
+			CoolingDown.SetNumZeroed(NumGuards);
+			TArray<float> CooldownEndTimes;
+			CooldownEndTimes.SetNumZeroed(NumGuards);
+			TArray<FTimerHandle> CooldownHandles;
+			TArray<FTimerHandle> AnimHandles;
+			CooldownHandles.SetNum(NumGuards);
+			AnimHandles.SetNum(NumGuards);
+			TArray<FGameplayTimerHandle> WheelAnimHandles;
+			WheelAnimHandles.SetNum(NumGuards);
+			FTimerManager Timers;
+			FGameplayTimerWheel TimerWheel;
+
+			int32 Shots = 0;
+			int32 AnimsFinished = 0;
+			int32 MaxTimers = 0;
+			float Time = 0.f;
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Frame = 0; Frame < Args.Iterations; Frame++)
+			{
+				Time += DeltaTime;
+				const uint64 Tick = uint64(Time / TickSeconds);
+				for (int32 i = 0; i < NumGuards; i++)
+				{
+					const bool bCanShoot = Mode == Timestamps ? Time >= CooldownEndTimes[i] : !CoolingDown[i];
+					if (!bCanShoot)
+					{
+						continue;
+					}
+					Shots++;
+					if (Mode == TimerManager)
+					{
+						CoolingDown[i] = true;
+						Timers.SetTimer(CooldownHandles[i], FTimerDelegate::CreateLambda([&CoolingDown, i]() { CoolingDown[i] = false; }), Cooldowns[i], false);
+						Timers.SetTimer(AnimHandles[i], FTimerDelegate::CreateLambda([&AnimsFinished]() { AnimsFinished++; }), AttackAnimSeconds, false);
+						continue;
+					}
+					if (Mode == Wheel)
+					{
+						CoolingDown[i] = true;
+						TimerWheel.Schedule(Tick + FMath::CeilToInt(Cooldowns[i] / TickSeconds), FSimpleDelegate::CreateLambda([&CoolingDown, i]() { CoolingDown[i] = false; }));
+					}
+					else
+					{
+						CooldownEndTimes[i] = Time + Cooldowns[i];
+					}
+					TimerWheel.Cancel(WheelAnimHandles[i]);
+					WheelAnimHandles[i] = TimerWheel.Schedule(Tick + FMath::CeilToInt(AttackAnimSeconds / TickSeconds), FSimpleDelegate::CreateLambda([&AnimsFinished]() { AnimsFinished++; }));
+				}
+
+				if (Mode == TimerManager)
+				{
+					Timers.Tick(DeltaTime);
+				}
+				else
+				{
+					MaxTimers = FMath::Max(MaxTimers, TimerWheel.Num());
+					TimerWheel.Advance(Tick);
+				}
+				GFrameCounter++;
+			}
+			const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+			const FString Prefix = FString(ModeNames[Mode]) + TEXT("_");
+			Report.Add(Prefix + TEXT("frame_us"), Seconds * 1e6 / FMath::Max(Args.Iterations, 1));
+			Report.Add(Prefix + TEXT("ns_per_shot"), Seconds * 1e9 / FMath::Max(Shots, 1));
+			Report.Add(Prefix + TEXT("shots"), Shots);
+			Report.Add(Prefix + TEXT("anims_finished"), AnimsFinished);
+			if (Mode != TimerManager)
+			{
+				Report.Add(Prefix + TEXT("max_timers"), MaxTimers);
+				Report.Add(Prefix + TEXT("kb"), TimerWheel.GetAllocatedSize() / 1024.0);
+			}
+		}
+		Report.Add(TEXT("guards"), NumGuards);
+	}
+
+	static const FScenario Scenarios[] =
+	{
+		{ TEXT("PossessionPick"), 500, 100000, &RunPossessionPick },
+		{ TEXT("Perception"), 1000, 100, &RunPerception },
+		{ TEXT("LightField"), 500, 1000, &RunLightField },
+		{ TEXT("Projectiles"), 5000, 600, &RunProjectiles },
+		{ TEXT("Gameplay"), 100, 3000, &RunGameplay },
+		{ TEXT("CrowdSprites"), 2000, 300, &RunCrowdSprites },
+		{ TEXT("WallGrab"), 20, 1800, &RunWallGrab },
+		{ TEXT("PlaneMovement"), 200, 1800, &RunPlaneMovement },
+		{ TEXT("ChunkStreaming"), 900, 7200, &RunChunkStreaming },
+		{ TEXT("AnimationBundles"), 64, 1200, &RunAnimationBundles },
+		{ TEXT("GuardAI"), 500, 600, &RunGuardAI },
+		{ TEXT("PlatformNav"), 64, 4000, &RunPlatformNav },
+		{ TEXT("MassExplosion"), 1000, 200, &RunMassExplosion },
+		{ TEXT("GameplayTimers"), 5000, 3600, &RunGameplayTimers },
+	};
+}
+
+UVictorBenchmarkCommandlet::UVictorBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UVictorBenchmarkCommandlet::Main(const FString& Params)
+{
+	using namespace VictorBenchmark;
+
+	FString ScenarioName;
+	FParse::Value(*Params, TEXT("Scenario="), ScenarioName);
+	FString ReportPath;
+	FParse::Value(*Params, TEXT("Report="), ReportPath);
+
+	TArray<FString> JsonReports;
+	bool bRanAny = false;
+	for (const FScenario& Scenario : Scenarios)
+	{
+		if (!ScenarioName.IsEmpty() && ScenarioName != Scenario.Name)
+		{
+			continue;
+		}
+
+		FArgs Args;
+		Args.Count = Scenario.DefaultCount;
+		Args.Iterations = Scenario.DefaultIterations;
+		Args.Params = Params;
+		FParse::Value(*Params, TEXT("Count="), Args.Count);
+		FParse::Value(*Params, TEXT("Iterations="), Args.Iterations);
+		FParse::Value(*Params, TEXT("Seed="), Args.Seed);
+
+		UE_LOG(LogVictorBenchmark, Display, TEXT("Running %s (Count=%d, Iterations=%d)"), Scenario.Name, Args.Count, Args.Iterations);
+		FReport Report;
+		Report.Scenario = Scenario.Name;
+		Scenario.Run(Args, Report);
+		JsonReports.Add(Report.ToJson());
+		bRanAny = true;
+	}
+
+	if (!bRanAny)
+	{
+		UE_LOG(LogVictorBenchmark, Error, TEXT("Unknown scenario '%s'"), *ScenarioName);
+		return 1;
+	}
+
+	if (!ReportPath.IsEmpty())
+	{
+		const FString Json = TEXT("[") + FString::Join(JsonReports, TEXT(",")) + TEXT("]");
+		if (!FFileHelper::SaveStringToFile(Json, *ReportPath))
+		{
+			UE_LOG(LogVictorBenchmark, Error, TEXT("Could not write report to %s"), *ReportPath);
+			return 1;
+		}
+	}
+	return 0;
+}
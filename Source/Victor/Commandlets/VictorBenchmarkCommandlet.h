@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "VictorBenchmarkCommandlet.generated.h"
+
+/**
+ * Headless benchmarks for the Victor gameplay systems, meant to run on a build machine without a GPU.
+ *
+ * UE4Editor-Cmd Victor.uproject -run=VictorBenchmark [-Scenario=Name] [-Count=N] [-Iterations=N] [-Seed=N] [-Report=File.json] -nullrhi -unattended
+ *
+ * Without -Scenario every scenario runs. Results are logged and, with -Report, written as JSON.
+ */
+UCLASS()
+class UVictorBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UVictorBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VictorNavGraphCommandlet.h"
+
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/LevelStreaming.h"
+#include "Engine/World.h"
+#include "HAL/PlatformTime.h"
+#include "Navigation/PlatformNavGraph.h"
+#include "Navigation/PlatformNavSubsystem.h"
+#include "World/LevelCollisionGrid.h"
+#include "World/LevelGridSubsystem.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogVictorNavGraph, Log, All);
+
+UVictorNavGraphCommandlet::UVictorNavGraphCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UVictorNavGraphCommandlet::Main(const FString& Params)
+{
+	FString MapName = TEXT("/Game/2DSideScrollerCPP/Maps/2DSideScrollerExampleMap");
+	FParse::Value(*Params, TEXT("Map="), MapName);
+
+	UGameInstance* GameInstance = NewObject<UGameInstance>(GEngine);
+	GameInstance->AddToRoot();
+	GameInstance->InitializeStandalone();
+	FWorldContext* WorldContext = GameInstance->GetWorldContext();
+
+	FString Error;
+	if (!GEngine->LoadMap(*WorldContext, FURL(nullptr, *MapName, TRAVEL_Absolute), nullptr, Error))
+	{
+		UE_LOG(LogVictorNavGraph, Error, TEXT("Could not load %s: %s"), *MapName, *Error);
+		GameInstance->Shutdown();
+		GameInstance->RemoveFromRoot();
+		return 1;
+	}
+	UWorld* World = WorldContext->World();
+
+	//the graph covers the whole map, not just the chunks streamed in around the start
+	for (ULevelStreaming* StreamingLevel : World->GetStreamingLevels())
+	{
+		if (StreamingLevel != nullptr)
+		{
+			StreamingLevel->SetShouldBeLoaded(true);
+			StreamingLevel->SetShouldBeVisible(true);
+		}
+	}
+	World->FlushLevelStreaming(EFlushLevelStreamingType::Full);
+
+	UPlatformNavSubsystem* Navigation = World->GetSubsystem<UPlatformNavSubsystem>();
+	ULevelGridSubsystem* LevelGrid = World->GetSubsystem<ULevelGridSubsystem>();
+	LevelGrid->MarkCollisionGridDirty();
+	const FLevelCollisionGrid& Grid = LevelGrid->GetCollisionGrid();
+
+	const double StartTime = FPlatformTime::Seconds();
+	FPlatformNavGraph Graph;
+	Graph.Build(Grid, Navigation->GetBuildSettings());
+	const double BuildSeconds = FPlatformTime::Seconds() - StartTime;
+
+	//the game checks these against the levels it loads, and builds its own graph if one of them changed since
+	TMap<FString, uint32> LevelHashes;
+	Navigation->GetLevelContentHashes(LevelHashes);
+	Graph.SetLevelHashes(LevelHashes);
+
+	FString OutputPath = Navigation->GetBakedGraphPath();
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	const bool bSaved = Graph.IsBuilt() && Graph.SaveToFile(OutputPath);
+	if (bSaved)
+	{
+		UE_LOG(LogVictorNavGraph, Display, TEXT("Baked %s from %d levels in %.2f s: %d floor and %d wall nodes, %d walk, %d drop, %d jump and %d wall grab edges, %.1f KB"),
+			*OutputPath, LevelHashes.Num(), BuildSeconds, Graph.GetNumFloorNodes(), Graph.GetNodes().Num() - Graph.GetNumFloorNodes(),
+			Graph.GetNumEdges(EPlatformNavEdge::Walk), Graph.GetNumEdges(EPlatformNavEdge::Drop), Graph.GetNumEdges(EPlatformNavEdge::Jump),
+			Graph.GetNumEdges(EPlatformNavEdge::WallGrab), Graph.GetAllocatedSize() / 1024.0);
+	}
+	else
+	{
+		UE_LOG(LogVictorNavGraph, Error, TEXT("Could not bake the nav graph of %s to %s"), *MapName, *OutputPath);
+	}
+
+	World->BeginTearingDown();
+	GameInstance->Shutdown();
+	World->DestroyWorld(false);
+	GameInstance->RemoveFromRoot();
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	return bSaved ? 0 : 1;
+}
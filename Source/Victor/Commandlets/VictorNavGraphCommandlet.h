@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "VictorNavGraphCommandlet.generated.h"
+
+/**
+ * Bakes the platform nav graph of a map from its collision, with every streamed level loaded.
+ *
+ * UE4Editor-Cmd Victor.uproject -run=VictorNavGraph [-Map=/Game/Path/Map] [-Output=File.vnav] -nullrhi -unattended
+ *
+ * The graph goes to Content/<UPlatformNavSubsystem::BakedGraphDirectory>/<Map>.vnav unless -Output= says otherwise.
+ * It records a content hash of every level it was made from; the game builds its own graph once one of them differs.
+ */
+UCLASS()
+class UVictorNavGraphCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UVictorNavGraphCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InteractionSubsystem.h"
+
+#include "Interactions.h"
+#include "VictorStats.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/Level.h"
+
+DECLARE_CYCLE_STAT(TEXT("Interact query"), STAT_VictorInteractQuery, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Interaction candidates examined"), STAT_VictorInteractionCandidates, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Interactions"), STAT_VictorInteractions, STATGROUP_Victor);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Registered interactables"), STAT_VictorRegisteredInteractables, STATGROUP_Victor);
+
+//roughly one door or vent wide
+static const float InteractionHashCellSize = 128.f;
+
+UInteractionSubsystem::UInteractionSubsystem()
+	: Hash(InteractionHashCellSize)
+{
+}
+
+void UInteractionSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	ActorsInitializedHandle = FWorldDelegates::OnWorldInitializedActors.AddUObject(this, &UInteractionSubsystem::OnActorsInitialized);
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UInteractionSubsystem::OnLevelAdded);
+	ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UInteractionSubsystem::OnActorSpawned));
+}
+
+void UInteractionSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldInitializedActors.Remove(ActorsInitializedHandle);
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+
+	SET_DWORD_STAT(STAT_VictorRegisteredInteractables, 0);
+	Hash.Reset();
+	Interactables.Empty();
+	InteractableIds.Empty();
+
+	Super::Deinitialize();
+}
+
+void UInteractionSubsystem::RegisterInteractable(AActor* Actor)
+{
+	if (Actor == nullptr || InteractableIds.Contains(Actor) || !Actor->Implements<UInteractions>())
+	{
+		return;
+	}
+
+	FInteractable Interactable;
+	Interactable.Actor = Actor;
+	const int32 Id = Interactables.Add(Interactable);
+	InteractableIds.Add(Actor, Id);
+
+	FVector Origin;
+	FVector Extent;
+	Actor->GetActorBounds(true, Origin, Extent);
+	Hash.Add(Id, ToPlane2D(Origin), FVector2D(Extent.X, Extent.Z));
+
+	//also covers destruction and the actor's level streaming out
+	Actor->OnEndPlay.AddUniqueDynamic(this, &UInteractionSubsystem::OnInteractableEndPlay);
+	INC_DWORD_STAT(STAT_VictorRegisteredInteractables);
+}
+
+void UInteractionSubsystem::UnregisterInteractable(AActor* Actor)
+{
+	int32 Id = INDEX_NONE;
+	if (!InteractableIds.RemoveAndCopyValue(Actor, Id))
+	{
+		return;
+	}
+	Hash.Remove(Id);
+	Interactables.RemoveAt(Id);
+	if (Actor != nullptr)
+	{
+		Actor->OnEndPlay.RemoveDynamic(this, &UInteractionSubsystem::OnInteractableEndPlay);
+	}
+	DEC_DWORD_STAT(STAT_VictorRegisteredInteractables);
+}
+
+void UInteractionSubsystem::UpdateInteractable(AActor* Actor)
+{
+	const int32* Id = InteractableIds.Find(Actor);
+	if (Id == nullptr)
+	{
+		RegisterInteractable(Actor);
+		return;
+	}
+
+	//the extent may have changed too, so re-add rather than move
+	FVector Origin;
+	FVector Extent;
+	Actor->GetActorBounds(true, Origin, Extent);
+	Hash.Remove(*Id);
+	Hash.Add(*Id, ToPlane2D(Origin), FVector2D(Extent.X, Extent.Z));
+}
+
+int32 UInteractionSubsystem::InteractInBox(const FBox2D& Box, AActor* Interactor, const UPrimitiveComponent* OverlapComponent)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorInteractQuery);
+
+	int32 NumInteracted = 0;
+	const int32 NumExamined = Hash.ForEachInBox(Box, [this, Interactor, OverlapComponent, &NumInteracted](int32 Id, const FVector2D&, const FVector2D&)
+	{
+		const FInteractable& Interactable = Interactables[Id];
+		AActor* Actor = Interactable.Actor.Get();
+		if (Actor == nullptr || Actor == Interactor)
+		{
+			return;
+		}
+		//the bounds are boxes, only a real overlap counts, like the capsule overlap query this replaced
+		if (OverlapComponent != nullptr && !OverlapComponent->IsOverlappingActor(Actor))
+		{
+			return;
+		}
+		//the generated thunk, so the parameters always match the interface's signature
+		IInteractions::Execute_Interact(Actor, Interactor);
+		NumInteracted++;
+	});
+
+	INC_DWORD_STAT_BY(STAT_VictorInteractionCandidates, NumExamined);
+	INC_DWORD_STAT_BY(STAT_VictorInteractions, NumInteracted);
+	return NumInteracted;
+}
+
+void UInteractionSubsystem::RegisterLevelActors(const TArray<AActor*>& Actors)
+{
+	for (AActor* Actor : Actors)
+	{
+		RegisterInteractable(Actor);
+	}
+}
+
+void UInteractionSubsystem::OnActorsInitialized(const UWorld::FActorsInitializedParams& Params)
+{
+	if (Params.World != GetWorld())
+	{
+		return;
+	}
+	for (ULevel* Level : Params.World->GetLevels())
+	{
+		RegisterLevelActors(Level->Actors);
+	}
+}
+
+void UInteractionSubsystem::OnLevelAdded(ULevel* Level, UWorld* World)
+{
+	if (World == GetWorld() && Level != nullptr)
+	{
+		RegisterLevelActors(Level->Actors);
+	}
+}
+
+void UInteractionSubsystem::OnActorSpawned(AActor* Actor)
+{
+	RegisterInteractable(Actor);
+}
+
+void UInteractionSubsystem::OnInteractableEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterInteractable(Actor);
+}
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/World.h"
+#include "World/SpatialHash2D.h"
+#include "InteractionSubsystem.generated.h"
+
+/**
+ * Registry of actors implementing IInteractions, kept in a 2D grid so AVictorCharacter::Interact only looks at
+ * interactables next to it. Level actors are registered when the world initializes actors or a streamed level is added,
+ * spawned ones when they are spawned; moving interactables should call UpdateInteractable.
+ * Interactables are removed when they end play, which includes their level streaming out.
+ */
+UCLASS()
+class VICTOR_API UInteractionSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UInteractionSubsystem();
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/** Adds the actor if it implements IInteractions. Safe to call more than once */
+	UFUNCTION(BlueprintCallable, Category = Interaction)
+	void RegisterInteractable(AActor* Actor);
+
+	UFUNCTION(BlueprintCallable, Category = Interaction)
+	void UnregisterInteractable(AActor* Actor);
+
+	/** Re-reads the bounds of an interactable that moved */
+	UFUNCTION(BlueprintCallable, Category = Interaction)
+	void UpdateInteractable(AActor* Actor);
+
+	/**
+	 * Calls IInteractions::Interact on every interactable whose bounds overlap the box, returns how many it interacted with.
+	 * With OverlapComponent set, the box only picks candidates and they must also overlap that component, so nothing
+	 * is reached through a wall the box pokes past. Doesn't allocate.
+	 */
+	int32 InteractInBox(const FBox2D& Box, AActor* Interactor, const UPrimitiveComponent* OverlapComponent = nullptr);
+
+	int32 NumInteractables() const { return Interactables.Num(); }
+
+protected:
+	struct FInteractable
+	{
+		TWeakObjectPtr<AActor> Actor;
+	};
+
+	void RegisterLevelActors(const TArray<AActor*>& Actors);
+
+	void OnActorsInitialized(const UWorld::FActorsInitializedParams& Params);
+
+	void OnLevelAdded(ULevel* Level, UWorld* World);
+
+	void OnActorSpawned(AActor* Actor);
+
+	UFUNCTION()
+	void OnInteractableEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+
+	TSpatialHash2D<int32> Hash;
+
+	//Sparse so handles stay valid as interactables come and go
+	TSparseArray<FInteractable> Interactables;
+
+	TMap<TWeakObjectPtr<AActor>, int32> InteractableIds;
+
+	FDelegateHandle ActorsInitializedHandle;
+
+	FDelegateHandle ActorSpawnedHandle;
+
+	FDelegateHandle LevelAddedHandle;
+};
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LevelLightField.h"
+
+#include "World/LevelCollisionGrid.h"
+
+void FLevelLightField::Init(const FVector2D& InOrigin, float InCellSize, int32 InSizeX, int32 InSizeZ)
+{
+	Origin = InOrigin;
+	CellSize = InCellSize;
+	SizeX = InSizeX;
+	SizeZ = InSizeZ;
+	NumLights = 0;
+	Levels.Init(0, SizeX * SizeZ);
+}
+
+void FLevelLightField::Reset()
+{
+	Origin = FVector2D::ZeroVector;
+	SizeX = 0;
+	SizeZ = 0;
+	NumLights = 0;
+	Levels.Empty();
+}
+
+void FLevelLightField::AddLitBox(const FBox2D& Box, float Level)
+{
+	FIntPoint Min, Max;
+	GetCellRange(Box, Min, Max);
+	for (int32 Z = Min.Y; Z <= Max.Y; Z++)
+	{
+		for (int32 X = Min.X; X <= Max.X; X++)
+		{
+			if (Box.IsInside(GetCellCenter(X, Z)))
+			{
+				AddLevel(X, Z, Level);
+			}
+		}
+	}
+	NumLights++;
+}
+
+void FLevelLightField::AddLitCircle(const FVector2D& Center, float Radius, float Level)
+{
+	FIntPoint Min, Max;
+	GetCellRange(FBox2D(Center - FVector2D(Radius, Radius), Center + FVector2D(Radius, Radius)), Min, Max);
+	const float RadiusSquared = FMath::Square(Radius);
+	for (int32 Z = Min.Y; Z <= Max.Y; Z++)
+	{
+		for (int32 X = Min.X; X <= Max.X; X++)
+		{
+			if (FVector2D::DistSquared(GetCellCenter(X, Z), Center) <= RadiusSquared)
+			{
+				AddLevel(X, Z, Level);
+			}
+		}
+	}
+	NumLights++;
+}
+
+void FLevelLightField::AddPointLight(const FVector2D& Center, float Radius, float Intensity, const FLevelCollisionGrid* Occluders)
+{
+	FIntPoint Min, Max;
+	GetCellRange(FBox2D(Center - FVector2D(Radius, Radius), Center + FVector2D(Radius, Radius)), Min, Max);
+	const float RadiusSquared = FMath::Square(Radius);
+	//lamps are usually mounted in a wall or ceiling, a light inside solid cells would otherwise light nothing
+	const bool bTestOcclusion = Occluders != nullptr && Occluders->IsBuilt() && !Occluders->IsSolidAt(Center);
+	for (int32 Z = Min.Y; Z <= Max.Y; Z++)
+	{
+		for (int32 X = Min.X; X <= Max.X; X++)
+		{
+			const FVector2D CellCenter = GetCellCenter(X, Z);
+			const float DistanceSquared = FVector2D::DistSquared(CellCenter, Center);
+			if (DistanceSquared > RadiusSquared)
+			{
+				continue;
+			}
+			if (bTestOcclusion && !Occluders->HasLineOfSight(Center, CellCenter))
+			{
+				continue;
+			}
+			//same shape as the engine's inverse squared falloff window
+			AddLevel(X, Z, Intensity * FMath::Square(1.f - DistanceSquared / RadiusSquared));
+		}
+	}
+	NumLights++;
+}
+
+void FLevelLightField::GetCellRange(const FBox2D& Box, FIntPoint& OutMin, FIntPoint& OutMax) const
+{
+	OutMin.X = FMath::Max(FMath::FloorToInt((Box.Min.X - Origin.X) / CellSize), 0);
+	OutMin.Y = FMath::Max(FMath::FloorToInt((Box.Min.Y - Origin.Y) / CellSize), 0);
+	OutMax.X = FMath::Min(FMath::FloorToInt((Box.Max.X - Origin.X) / CellSize), SizeX - 1);
+	OutMax.Y = FMath::Min(FMath::FloorToInt((Box.Max.Y - Origin.Y) / CellSize), SizeZ - 1);
+}
+
+void FLevelLightField::AddLevel(int32 X, int32 Z, float Level)
+{
+	uint8& Cell = Levels[Z * SizeX + X];
+	Cell = (uint8)FMath::Min(Cell + FMath::RoundToInt(FMath::Clamp(Level, 0.f, 1.f) * 255.f), 255);
+}
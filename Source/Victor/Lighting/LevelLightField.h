@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FLevelCollisionGrid;
+
+/**
+ * Low resolution light level of the level on the XZ plane, 0 is dark and 1 fully lit.
+ * Baked once from the level's lights; a lookup is a single array read, however many lights there are.
+ * Cells outside the field are dark.
+ */
+class VICTOR_API FLevelLightField
+{
+public:
+	/** Sets up a dark field */
+	void Init(const FVector2D& InOrigin, float InCellSize, int32 InSizeX, int32 InSizeZ);
+
+	void Reset();
+
+	bool IsBuilt() const { return SizeX > 0 && SizeZ > 0; }
+
+	/** Adds Level to every cell whose center is inside the box, the way a light volume would */
+	void AddLitBox(const FBox2D& Box, float Level);
+
+	/** Adds Level to every cell whose center is inside the circle */
+	void AddLitCircle(const FVector2D& Center, float Radius, float Level);
+
+	/**
+	 * Adds a light fading out towards Radius.
+	 * Cells that have no line of sight to Center through Occluders get nothing.
+	 */
+	void AddPointLight(const FVector2D& Center, float Radius, float Intensity, const FLevelCollisionGrid* Occluders);
+
+	int32 GetNumLights() const { return NumLights; }
+
+	float GetCellSize() const { return CellSize; }
+
+	float GetLightLevel(const FVector2D& Location) const
+	{
+		const int32 X = FMath::FloorToInt((Location.X - Origin.X) / CellSize);
+		const int32 Z = FMath::FloorToInt((Location.Y - Origin.Y) / CellSize);
+		return X >= 0 && Z >= 0 && X < SizeX && Z < SizeZ ? Levels[Z * SizeX + X] / 255.f : 0.f;
+	}
+
+private:
+	FVector2D GetCellCenter(int32 X, int32 Z) const
+	{
+		return Origin + FVector2D((X + 0.5f) * CellSize, (Z + 0.5f) * CellSize);
+	}
+
+	//cells whose centers may lie inside the box, clamped to the field
+	void GetCellRange(const FBox2D& Box, FIntPoint& OutMin, FIntPoint& OutMax) const;
+
+	void AddLevel(int32 X, int32 Z, float Level);
+
+	FVector2D Origin = FVector2D::ZeroVector;
+
+	float CellSize = 64.f;
+
+	int32 SizeX = 0;
+
+	int32 SizeZ = 0;
+
+	int32 NumLights = 0;
+
+	TArray<uint8> Levels;
+};
@@ -0,0 +1,219 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LightFieldSubsystem.h"
+
+#include "VictorCharacter.h"
+#include "VictorStats.h"
+#include "EngineUtils.h"
+#include "PaperSprite.h"
+#include "PaperSpriteComponent.h"
+#include "Characters/CharacterUpdateSubsystem.h"
+#include "Components/BoxComponent.h"
+#include "Components/LocalLightComponent.h"
+#include "Components/SphereComponent.h"
+#include "World/LevelGridSubsystem.h"
+#include "World/SpatialHash2D.h"
+
+DECLARE_CYCLE_STAT(TEXT("Bake light field"), STAT_VictorBakeLightField, STATGROUP_Victor);
+DECLARE_CYCLE_STAT(TEXT("Light field shadow update"), STAT_VictorLightFieldShadowUpdate, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shadow state changes"), STAT_VictorShadowStateChanges, STATGROUP_Victor);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Baked lights"), STAT_VictorBakedLights, STATGROUP_Victor);
+
+namespace
+{
+	struct FBakedLight
+	{
+		enum EShape { Box, Circle, Point };
+
+		EShape Shape;
+		FBox2D Bounds;
+		float Level;
+	};
+
+	FBox2D ToPlaneBox(const FBox& Box)
+	{
+		return FBox2D(ToPlane2D(Box.Min), ToPlane2D(Box.Max));
+	}
+}
+
+void ULightFieldSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Collection.InitializeDependency(ULevelGridSubsystem::StaticClass());
+	Super::Initialize(Collection);
+
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &ULightFieldSubsystem::OnLevelsChanged);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &ULightFieldSubsystem::OnLevelsChanged);
+}
+
+void ULightFieldSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+	LightField.Reset();
+
+	Super::Deinitialize();
+}
+
+float ULightFieldSubsystem::GetLightLevelAt(const FVector& Location)
+{
+	return GetLightField().GetLightLevel(ToPlane2D(Location));
+}
+
+const FLevelLightField& ULightFieldSubsystem::GetLightField()
+{
+	check(IsInGameThread());
+	if (bLightFieldDirty)
+	{
+		BuildLightField();
+		bLightFieldDirty = false;
+	}
+	return LightField;
+}
+
+void ULightFieldSubsystem::BuildLightField()
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorBakeLightField);
+	LightField.Reset();
+
+	TArray<FBakedLight> Lights;
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		const bool bTaggedLight = It->ActorHasTag(LightActorTag);
+		for (UActorComponent* Component : It->GetComponents())
+		{
+			if (bTaggedLight && Component->IsA<UShapeComponent>())
+			{
+				const UShapeComponent* Shape = CastChecked<UShapeComponent>(Component);
+				if (const USphereComponent* Sphere = Cast<USphereComponent>(Shape))
+				{
+					const FVector2D Center = ToPlane2D(Sphere->GetComponentLocation());
+					const FVector2D Extent(Sphere->GetScaledSphereRadius(), Sphere->GetScaledSphereRadius());
+					Lights.Add({ FBakedLight::Circle, FBox2D(Center - Extent, Center + Extent), 1.f });
+				}
+				else
+				{
+					Lights.Add({ FBakedLight::Box, ToPlaneBox(Shape->Bounds.GetBox()), 1.f });
+				}
+			}
+			else if (const UPaperSpriteComponent* SpriteComponent = Cast<UPaperSpriteComponent>(Component))
+			{
+				const UPaperSprite* Sprite = SpriteComponent->GetSprite();
+				if (Sprite != nullptr && SpriteComponent->IsVisible() && LightSprites.Contains(FSoftObjectPath(Sprite)))
+				{
+					Lights.Add({ FBakedLight::Box, ToPlaneBox(SpriteComponent->Bounds.GetBox()), 1.f });
+				}
+			}
+			else if (const ULocalLightComponent* Light = Cast<ULocalLightComponent>(Component))
+			{
+				if (Light->IsVisible() && Light->bAffectsWorld && FullLightIntensity > 0.f)
+				{
+					const FVector2D Center = ToPlane2D(Light->GetComponentLocation());
+					const FVector2D Extent(Light->AttenuationRadius, Light->AttenuationRadius);
+					Lights.Add({ FBakedLight::Point, FBox2D(Center - Extent, Center + Extent), Light->Intensity / FullLightIntensity });
+				}
+			}
+		}
+	}
+
+	SET_DWORD_STAT(STAT_VictorBakedLights, Lights.Num());
+	if (Lights.Num() == 0)
+	{
+		return;
+	}
+
+	//the field covers the level geometry and everything the lights reach
+	const FLevelCollisionGrid& CollisionGrid = GetWorld()->GetSubsystem<ULevelGridSubsystem>()->GetCollisionGrid();
+	FBox2D FieldBounds(ForceInit);
+	if (CollisionGrid.IsBuilt())
+	{
+		FieldBounds += CollisionGrid.GetOrigin();
+		FieldBounds += CollisionGrid.GetOrigin() + FVector2D(CollisionGrid.GetSize()) * CollisionGrid.GetCellSize();
+	}
+	for (const FBakedLight& Light : Lights)
+	{
+		FieldBounds += Light.Bounds;
+	}
+	const FVector2D FieldSize = FieldBounds.GetSize();
+	LightField.Init(FieldBounds.Min, CellSize, FMath::CeilToInt(FieldSize.X / CellSize) + 1, FMath::CeilToInt(FieldSize.Y / CellSize) + 1);
+
+	for (const FBakedLight& Light : Lights)
+	{
+		switch (Light.Shape)
+		{
+		case FBakedLight::Box:
+			LightField.AddLitBox(Light.Bounds, Light.Level);
+			break;
+		case FBakedLight::Circle:
+			LightField.AddLitCircle(Light.Bounds.GetCenter(), Light.Bounds.GetExtent().X, Light.Level);
+			break;
+		case FBakedLight::Point:
+			LightField.AddPointLight(Light.Bounds.GetCenter(), Light.Bounds.GetExtent().X, Light.Level, &CollisionGrid);
+			break;
+		}
+	}
+}
+
+void ULightFieldSubsystem::UpdateCharacterShadows()
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorLightFieldShadowUpdate);
+
+	const UCharacterUpdateSubsystem* Characters = GetWorld()->GetSubsystem<UCharacterUpdateSubsystem>();
+	if (Characters == nullptr)
+	{
+		return;
+	}
+
+	int32 Changes = 0;
+	for (AVictorCharacter* Character : Characters->GetCharacters())
+	{
+		if (!Character->bShadowFromLightField || Character->bDead)
+		{
+			continue;
+		}
+
+		const float Level = LightField.GetLightLevel(ToPlane2D(Character->GetActorLocation()));
+		const bool bDark = Character->bInDarkness
+			? Level < ShadowThreshold + ShadowHysteresis
+			: Level < ShadowThreshold;
+		if (bDark != Character->bInDarkness)
+		{
+			//only visibility, bHiddenInShadow would also stop the character from moving
+			Character->SetInDarkness(bDark);
+			Changes++;
+		}
+	}
+	SET_DWORD_STAT(STAT_VictorShadowStateChanges, Changes);
+}
+
+void ULightFieldSubsystem::OnLevelsChanged(ULevel* Level, UWorld* World)
+{
+	if (World == GetWorld())
+	{
+		bLightFieldDirty = true;
+	}
+}
+
+void ULightFieldSubsystem::Tick(float DeltaTime)
+{
+	GetLightField();
+	if (LightField.IsBuilt())
+	{
+		UpdateCharacterShadows();
+	}
+}
+
+bool ULightFieldSubsystem::IsTickable() const
+{
+	return bLightFieldDirty || LightField.IsBuilt();
+}
+
+TStatId ULightFieldSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULightFieldSubsystem, STATGROUP_Tickables);
+}
+
+ETickableTickType ULightFieldSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Lighting/LevelLightField.h"
+#include "LightFieldSubsystem.generated.h"
+
+/**
+ * Bakes the level's lights into a FLevelLightField and hides characters that stand in the dark.
+ * Lights are actors tagged LightActorTag (their shape components are the lit area), sprites listed in LightSprites
+ * and point/spot light components.
+ * Characters with bShadowFromLightField only get SetInDarkness() called when their light level
+ * crosses ShadowThreshold, instead of on every overlap with a light volume. That only decides whether they can be
+ * seen; the bHiddenInShadow state shadow volumes and input set, which also blocks movement, is left alone.
+ */
+UCLASS(config=Game)
+class VICTOR_API ULightFieldSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/** Light level at the location, 0 dark to 1 fully lit */
+	UFUNCTION(BlueprintPure, Category = LightField)
+	float GetLightLevelAt(const FVector& Location);
+
+	/** Rebakes on the next tick, e.g. after a lamp was switched */
+	UFUNCTION(BlueprintCallable, Category = LightField)
+	void MarkLightFieldDirty() { bLightFieldDirty = true; }
+
+	/** Game thread only */
+	const FLevelLightField& GetLightField();
+
+	/** Actors with this tag are lights, their shape components are what they light */
+	UPROPERTY(Config, EditAnywhere, Category = LightField)
+	FName LightActorTag = TEXT("Light");
+
+	/** Sprites that draw a light cone, the sprite's bounds are the lit area */
+	UPROPERTY(Config, EditAnywhere, Category = LightField)
+	TArray<FSoftObjectPath> LightSprites;
+
+	/** Point light intensity that lights a cell fully */
+	UPROPERTY(Config, EditAnywhere, Category = LightField)
+	float FullLightIntensity = 5000.f;
+
+	UPROPERTY(Config, EditAnywhere, Category = LightField)
+	float CellSize = 32.f;
+
+	/** Characters below this light level are in darkness and can't be seen */
+	UPROPERTY(Config, EditAnywhere, Category = LightField, meta = (ClampMin = "0", ClampMax = "1"))
+	float ShadowThreshold = 0.5f;
+
+	/** How far over the threshold a hidden character has to get before it is visible again, stops flicker on the edge */
+	UPROPERTY(Config, EditAnywhere, Category = LightField, meta = (ClampMin = "0", ClampMax = "1"))
+	float ShadowHysteresis = 0.05f;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual ETickableTickType GetTickableTickType() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	void BuildLightField();
+
+	void UpdateCharacterShadows();
+
+	void OnLevelsChanged(ULevel* Level, UWorld* World);
+
+	FLevelLightField LightField;
+
+	bool bLightFieldDirty = true;
+
+	FDelegateHandle LevelAddedHandle;
+
+	FDelegateHandle LevelRemovedHandle;
+};
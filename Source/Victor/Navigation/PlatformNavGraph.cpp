@@ -0,0 +1,671 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlatformNavGraph.h"
+
+#include "VictorStats.h"
+#include "Algo/Reverse.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "World/LevelCollisionGrid.h"
+
+DECLARE_CYCLE_STAT(TEXT("Build platform nav graph"), STAT_VictorBuildNavGraph, STATGROUP_Victor);
+DECLARE_CYCLE_STAT(TEXT("Platform path search"), STAT_VictorFindPlatformPath, STATGROUP_Victor);
+
+namespace
+{
+	const uint32 NavGraphMagic = 0x56414E56; //"VNAV"
+
+	const uint32 NavGraphVersion = 2;
+
+	/** A jump or drop to simulate */
+	struct FAirMove
+	{
+		FVector2D Location;
+		FVector2D Velocity;
+		float MoveInput;
+		//walks at Velocity until the floor is gone before falling
+		bool bWalkOffLedge;
+		//starts holding the wall it faces, without gravity until the wall grab box clears it
+		bool bHoldingWall;
+		bool bCanGrabWall;
+	};
+
+	/** Where a simulated jump or drop ended */
+	struct FAirMoveEnd
+	{
+		FVector2D Location;
+		float Time;
+		float MoveInput;
+		//-1 or 1 if it ended holding a wall on that side, 0 if it landed
+		int8 WallSide;
+		EPlatformNavEdge Type;
+	};
+
+	FBox2D GetCapsuleBox(const FPlatformNavMovement& Movement, const FVector2D& Location)
+	{
+		return FBox2D(Location - Movement.HalfExtent, Location + Movement.HalfExtent);
+	}
+
+	FBox2D GetWallGrabBox(const FPlatformNavMovement& Movement, const FVector2D& Location, float Facing)
+	{
+		const FVector2D Center = Location + FVector2D(Movement.WallGrabOffset.X * Facing, Movement.WallGrabOffset.Y);
+		return FBox2D(Center - Movement.WallGrabHalfExtent, Center + Movement.WallGrabHalfExtent);
+	}
+
+	//true while any floor cell is under the capsule's flat base
+	bool IsOnFloor(const FLevelCollisionGrid& Grid, const FPlatformNavMovement& Movement, const FVector2D& Location)
+	{
+		const float Feet = Location.Y - Movement.HalfExtent.Y;
+		return Grid.IsBoxBlocked(FBox2D(FVector2D(Location.X - Movement.HalfExtent.X, Feet - 1.f), FVector2D(Location.X + Movement.HalfExtent.X, Feet)));
+	}
+
+	/**
+	 * Moves the capsule the way CharacterMovement does while falling, X then Z each step, until it lands or grabs a wall.
+	 * Like AVictorCharacter::UpdateWallGrab, a wall the grab box touched at the start isn't grabbed.
+	 */
+	bool SimulateAirMove(const FLevelCollisionGrid& Grid, const FPlatformNavBuildSettings& Settings, const FAirMove& Move, FAirMoveEnd& OutEnd)
+	{
+		const FPlatformNavMovement& Movement = Settings.Movement;
+		const float Step = Settings.SimulationStep;
+		const float Facing = Move.MoveInput < 0.f ? -1.f : 1.f;
+		const float TargetSpeed = Move.MoveInput * Movement.MaxWalkSpeed;
+		const float AirAcceleration = Movement.MaxAcceleration * Movement.AirControl;
+		FVector2D Location = Move.Location;
+		FVector2D Velocity = Move.Velocity;
+		bool bHoldingWall = Move.bHoldingWall;
+		bool bGrabBoxTouching = Grid.IsBoxBlocked(GetWallGrabBox(Movement, Location, Facing));
+		float Time = 0.f;
+
+		if (Move.bWalkOffLedge)
+		{
+			while (IsOnFloor(Grid, Movement, Location))
+			{
+				const float DeltaX = Velocity.X * Step;
+				const float MovedX = Grid.SweepBox(GetCapsuleBox(Movement, Location), 0, DeltaX);
+				Location.X += MovedX;
+				Time += Step;
+				if (MovedX != DeltaX || Time > Settings.MaxAirTime)
+				{
+					return false;
+				}
+			}
+		}
+
+		const float StartTime = Time;
+		while (Time - StartTime < Settings.MaxAirTime)
+		{
+			Time += Step;
+			Velocity.X = FMath::FInterpConstantTo(Velocity.X, TargetSpeed, Step, AirAcceleration);
+			const float DeltaX = Velocity.X * Step;
+			const float MovedX = Grid.SweepBox(GetCapsuleBox(Movement, Location), 0, DeltaX);
+			Location.X += MovedX;
+			if (MovedX != DeltaX)
+			{
+				Velocity.X = 0.f;
+			}
+
+			if (!bHoldingWall)
+			{
+				Velocity.Y -= Movement.Gravity * Step;
+			}
+			const float DeltaZ = Velocity.Y * Step;
+			const float MovedZ = Grid.SweepBox(GetCapsuleBox(Movement, Location), 1, DeltaZ);
+			Location.Y += MovedZ;
+			if (MovedZ != DeltaZ)
+			{
+				if (DeltaZ < 0.f)
+				{
+					OutEnd.Location = Location;
+					OutEnd.Time = Time;
+					OutEnd.WallSide = 0;
+					return true;
+				}
+				//head against a ceiling
+				Velocity.Y = 0.f;
+			}
+			if (Location.Y < Grid.GetOrigin().Y)
+			{
+				return false;
+			}
+
+			const bool bTouching = Grid.IsBoxBlocked(GetWallGrabBox(Movement, Location, Facing));
+			if (bHoldingWall)
+			{
+				//climbed past the top of the held wall, gravity is back
+				bHoldingWall = bTouching;
+			}
+			else if (Move.bCanGrabWall && bTouching && !bGrabBoxTouching)
+			{
+				OutEnd.Location = Location;
+				OutEnd.Time = Time;
+				OutEnd.WallSide = static_cast<int8>(Facing);
+				return true;
+			}
+			bGrabBoxTouching = bTouching;
+		}
+		return false;
+	}
+
+	void AddAirMove(const FLevelCollisionGrid& Grid, const FPlatformNavBuildSettings& Settings, const FAirMove& Move, EPlatformNavEdge Type, TArray<FAirMoveEnd>& OutEnds)
+	{
+		FAirMoveEnd End;
+		if (SimulateAirMove(Grid, Settings, Move, End))
+		{
+			End.MoveInput = Move.MoveInput;
+			End.Type = End.WallSide != 0 ? EPlatformNavEdge::WallGrab : Type;
+			OutEnds.Add(End);
+		}
+	}
+
+	//keeps the cheapest edge to each node
+	void AddEdge(TArray<FPlatformNavEdge>& NodeEdges, const FPlatformNavEdge& NewEdge)
+	{
+		for (FPlatformNavEdge& Edge : NodeEdges)
+		{
+			if (Edge.To == NewEdge.To)
+			{
+				if (NewEdge.Cost < Edge.Cost)
+				{
+					Edge = NewEdge;
+				}
+				return;
+			}
+		}
+		NodeEdges.Add(NewEdge);
+	}
+
+	//counts read from a file can't be larger than the bytes left in it
+	bool SerializeCount(FArchive& Ar, int32& Count)
+	{
+		Ar << Count;
+		if (Ar.IsLoading() && (Count < 0 || Count > Ar.TotalSize() - Ar.Tell()))
+		{
+			Ar.SetError();
+			return false;
+		}
+		return true;
+	}
+}
+
+void FPlatformNavGraph::Build(const FLevelCollisionGrid& Grid, const FPlatformNavBuildSettings& Settings)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorBuildNavGraph);
+	Reset();
+	if (!Grid.IsBuilt())
+	{
+		return;
+	}
+
+	const FPlatformNavMovement& Movement = Settings.Movement;
+	const FIntPoint Size = Grid.GetSize();
+	const int32 NumAirInputs = FMath::Max(Settings.NumAirInputs, 1);
+	Origin = Grid.GetOrigin();
+	CellSize = Grid.GetCellSize();
+	HalfHeight = Movement.HalfExtent.Y;
+	MaxSpeed = FMath::Max(Movement.MaxWalkSpeed, 1.f);
+
+	//floors: an empty cell over a solid one with room for the capsule
+	ColumnFirstNodes.SetNumUninitialized(Size.X + 1);
+	for (int32 X = 0; X < Size.X; X++)
+	{
+		ColumnFirstNodes[X] = Nodes.Num();
+		for (int32 Z = 1; Z < Size.Y; Z++)
+		{
+			if (Grid.IsSolid(X, Z) || !Grid.IsSolid(X, Z - 1))
+			{
+				continue;
+			}
+			const FVector2D Location = Origin + FVector2D((X + 0.5f) * CellSize, Z * CellSize + HalfHeight);
+			if (!Grid.IsBoxBlocked(GetCapsuleBox(Movement, Location)))
+			{
+				Nodes.Add({ Location, 0, 0, 0 });
+			}
+		}
+	}
+	ColumnFirstNodes[Size.X] = Nodes.Num();
+	NumFloorNodes = Nodes.Num();
+
+	TArray<TArray<FPlatformNavEdge>> NodeEdges;
+	NodeEdges.SetNum(NumFloorNodes);
+	const int32 MaxStepCells = FMath::FloorToInt(Movement.MaxStepHeight / CellSize);
+	for (int32 X = 0; X < Size.X; X++)
+	{
+		for (int32 Node = ColumnFirstNodes[X]; Node < ColumnFirstNodes[X + 1]; Node++)
+		{
+			const int32 Z = GetFloorRow(Nodes[Node].Location);
+			for (int32 Direction = -1; Direction <= 1; Direction += 2)
+			{
+				for (int32 Step = -MaxStepCells; Step <= MaxStepCells; Step++)
+				{
+					const int32 Neighbor = FindFloorNodeInColumn(X + Direction, Z + Step);
+					if (Neighbor != INDEX_NONE)
+					{
+						const float Cost = FVector2D::Distance(Nodes[Node].Location, Nodes[Neighbor].Location) / MaxSpeed;
+						NodeEdges[Node].Add({ Neighbor, Cost, static_cast<float>(Direction), EPlatformNavEdge::Walk });
+					}
+				}
+			}
+		}
+	}
+
+	//floors connected by walking; jumps and drops between them are left out, walking does the same
+	TArray<int32> Spans;
+	Spans.Init(INDEX_NONE, NumFloorNodes);
+	TArray<int32> SpanStack;
+	for (int32 First = 0; First < NumFloorNodes; First++)
+	{
+		if (Spans[First] != INDEX_NONE)
+		{
+			continue;
+		}
+		Spans[First] = First;
+		SpanStack.Add(First);
+		while (SpanStack.Num() > 0)
+		{
+			for (const FPlatformNavEdge& Edge : NodeEdges[SpanStack.Pop(false)])
+			{
+				if (Spans[Edge.To] == INDEX_NONE)
+				{
+					Spans[Edge.To] = First;
+					SpanStack.Add(Edge.To);
+				}
+			}
+		}
+	}
+
+	TArray<TArray<FAirMoveEnd>> FloorMoves;
+	FloorMoves.SetNum(NumFloorNodes);
+	ParallelFor(NumFloorNodes, [&](int32 Node)
+	{
+		const FVector2D Location = Nodes[Node].Location;
+		for (int32 Direction = -1; Direction <= 1; Direction += 2)
+		{
+			bool bLedge = true;
+			for (const FPlatformNavEdge& Edge : NodeEdges[Node])
+			{
+				bLedge &= Edge.MoveInput != Direction;
+			}
+			for (int32 Input = 1; Input <= NumAirInputs; Input++)
+			{
+				const float MoveInput = Direction * float(Input) / NumAirInputs;
+				const float Speed = MoveInput * Movement.MaxWalkSpeed;
+				AddAirMove(Grid, Settings, { Location, FVector2D(Speed, Movement.JumpZVelocity), MoveInput, false, false, Movement.bCanHoldWalls }, EPlatformNavEdge::Jump, FloorMoves[Node]);
+				if (bLedge)
+				{
+					AddAirMove(Grid, Settings, { Location, FVector2D(Speed, 0.f), MoveInput, true, false, Movement.bCanHoldWalls }, EPlatformNavEdge::Drop, FloorMoves[Node]);
+				}
+			}
+			//standing jump, steering all the way
+			AddAirMove(Grid, Settings, { Location, FVector2D(0.f, Movement.JumpZVelocity), float(Direction), false, false, Movement.bCanHoldWalls }, EPlatformNavEdge::Jump, FloorMoves[Node]);
+		}
+	});
+
+	//wall nodes in floor order, so the graph is the same however the moves were spread over threads
+	TMap<FIntVector, int32> WallNodes;
+	TArray<TArray<FAirMoveEnd>> WallMoves;
+	for (int32 Node = 0; Node < NumFloorNodes; Node++)
+	{
+		for (const FAirMoveEnd& End : FloorMoves[Node])
+		{
+			int32 Target = INDEX_NONE;
+			if (End.WallSide != 0)
+			{
+				const FIntPoint Cell = Grid.ToCell(End.Location);
+				const FIntVector Key(Cell.X, Cell.Y, End.WallSide);
+				if (const int32* WallNode = WallNodes.Find(Key))
+				{
+					Target = *WallNode;
+				}
+				else
+				{
+					Target = Nodes.Add({ End.Location, 0, 0, End.WallSide });
+					WallNodes.Add(Key, Target);
+					NodeEdges.AddDefaulted();
+				}
+			}
+			else
+			{
+				Target = FindLandingNode(End.Location);
+				if (Target == INDEX_NONE || Spans[Target] == Spans[Node])
+				{
+					continue;
+				}
+			}
+			AddEdge(NodeEdges[Node], { Target, End.Time, End.MoveInput, End.Type });
+		}
+	}
+	FloorMoves.Empty();
+
+	//climbing up the held wall, jumping off it or letting go. Moves from walls don't grab other walls
+	const int32 NumWallNodes = Nodes.Num() - NumFloorNodes;
+	WallMoves.SetNum(NumWallNodes);
+	ParallelFor(NumWallNodes, [&](int32 Index)
+	{
+		const FPlatformNavNode& Node = Nodes[NumFloorNodes + Index];
+		for (int32 Input = 1; Input <= NumAirInputs; Input++)
+		{
+			const float MoveInput = Node.WallSide * float(Input) / NumAirInputs;
+			AddAirMove(Grid, Settings, { Node.Location, FVector2D(0.f, Movement.JumpZVelocity), MoveInput, false, true, false }, EPlatformNavEdge::Jump, WallMoves[Index]);
+			AddAirMove(Grid, Settings, { Node.Location, FVector2D(0.f, Movement.JumpZVelocity), -MoveInput, false, false, false }, EPlatformNavEdge::Jump, WallMoves[Index]);
+			AddAirMove(Grid, Settings, { Node.Location, FVector2D::ZeroVector, -MoveInput, false, false, false }, EPlatformNavEdge::Drop, WallMoves[Index]);
+		}
+	});
+	for (int32 Index = 0; Index < NumWallNodes; Index++)
+	{
+		for (const FAirMoveEnd& End : WallMoves[Index])
+		{
+			const int32 Target = FindLandingNode(End.Location);
+			if (Target != INDEX_NONE)
+			{
+				AddEdge(NodeEdges[NumFloorNodes + Index], { Target, End.Time, End.MoveInput, End.Type });
+			}
+		}
+	}
+
+	int32 NumEdges = 0;
+	for (const TArray<FPlatformNavEdge>& Outgoing : NodeEdges)
+	{
+		NumEdges += FMath::Min(Outgoing.Num(), int32(MAX_uint16));
+	}
+	Edges.Reserve(NumEdges);
+	for (int32 Node = 0; Node < Nodes.Num(); Node++)
+	{
+		Nodes[Node].FirstEdge = Edges.Num();
+		Nodes[Node].NumEdges = static_cast<uint16>(FMath::Min(NodeEdges[Node].Num(), int32(MAX_uint16)));
+		Edges.Append(NodeEdges[Node].GetData(), Nodes[Node].NumEdges);
+	}
+}
+
+void FPlatformNavGraph::Reset()
+{
+	Origin = FVector2D::ZeroVector;
+	ColumnFirstNodes.Empty();
+	Nodes.Empty();
+	Edges.Empty();
+	NumFloorNodes = 0;
+	LevelHashes.Empty();
+}
+
+int32 FPlatformNavGraph::FindFloorNode(const FVector2D& Location) const
+{
+	const int32 X = FMath::FloorToInt((Location.X - Origin.X) / CellSize);
+	const int32 Z = GetFloorRow(Location);
+	//the highest floor at most a cell above the feet, in the character's column or, standing on an edge, next to it
+	for (int32 Offset : { 0, -1, 1 })
+	{
+		const int32 Column = X + Offset;
+		if (Column < 0 || Column + 1 >= ColumnFirstNodes.Num())
+		{
+			continue;
+		}
+		for (int32 Node = ColumnFirstNodes[Column + 1] - 1; Node >= ColumnFirstNodes[Column]; Node--)
+		{
+			if (GetFloorRow(Nodes[Node].Location) <= Z + 1)
+			{
+				return Node;
+			}
+		}
+	}
+	return INDEX_NONE;
+}
+
+int32 FPlatformNavGraph::FindFloorNodeInColumn(int32 X, int32 Z) const
+{
+	if (X < 0 || X + 1 >= ColumnFirstNodes.Num())
+	{
+		return INDEX_NONE;
+	}
+	for (int32 Node = ColumnFirstNodes[X]; Node < ColumnFirstNodes[X + 1]; Node++)
+	{
+		const int32 Row = GetFloorRow(Nodes[Node].Location);
+		if (Row >= Z)
+		{
+			return Row == Z ? Node : INDEX_NONE;
+		}
+	}
+	return INDEX_NONE;
+}
+
+int32 FPlatformNavGraph::FindLandingNode(const FVector2D& Location) const
+{
+	const int32 X = FMath::FloorToInt((Location.X - Origin.X) / CellSize);
+	const int32 Z = GetFloorRow(Location);
+	for (int32 Offset : { 0, -1, 1 })
+	{
+		const int32 Node = FindFloorNodeInColumn(X + Offset, Z);
+		if (Node != INDEX_NONE)
+		{
+			return Node;
+		}
+	}
+	return INDEX_NONE;
+}
+
+bool FPlatformNavGraph::FindPath(int32 Start, int32 Goal, FPlatformNavSearch& Search, FPlatformPath& OutPath) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorFindPlatformPath);
+	OutPath.Points.Reset();
+	OutPath.Cost = 0.f;
+	if (!Nodes.IsValidIndex(Start) || !Nodes.IsValidIndex(Goal))
+	{
+		return false;
+	}
+
+	const int32 NumNodes = Nodes.Num();
+	if (Search.Stamps.Num() != NumNodes || Search.Stamp == MAX_uint32)
+	{
+		Search.Costs.SetNumUninitialized(NumNodes);
+		Search.ParentNodes.SetNumUninitialized(NumNodes);
+		Search.ParentEdges.SetNumUninitialized(NumNodes);
+		Search.Stamps.Init(0, NumNodes);
+		Search.Stamp = 0;
+	}
+	const uint32 Stamp = ++Search.Stamp;
+	auto CompareEstimates = [](const FPlatformNavSearch::FOpenNode& A, const FPlatformNavSearch::FOpenNode& B)
+	{
+		return A.Estimate < B.Estimate;
+	};
+
+	Search.Open.Reset();
+	Search.Stamps[Start] = Stamp;
+	Search.Costs[Start] = 0.f;
+	Search.ParentNodes[Start] = INDEX_NONE;
+	Search.ParentEdges[Start] = INDEX_NONE;
+	Search.Open.HeapPush({ GetHeuristic(Start, Goal), 0.f, Start }, CompareEstimates);
+
+	bool bFound = false;
+	while (Search.Open.Num() > 0)
+	{
+		FPlatformNavSearch::FOpenNode Current;
+		Search.Open.HeapPop(Current, CompareEstimates, false);
+		//a cheaper way to the node was pushed after this one
+		if (Current.Cost > Search.Costs[Current.Node])
+		{
+			continue;
+		}
+		if (Current.Node == Goal)
+		{
+			bFound = true;
+			break;
+		}
+		Search.NodesExpanded++;
+
+		const FPlatformNavNode& Node = Nodes[Current.Node];
+		for (int32 EdgeIndex = Node.FirstEdge; EdgeIndex < Node.FirstEdge + Node.NumEdges; EdgeIndex++)
+		{
+			const FPlatformNavEdge& Edge = Edges[EdgeIndex];
+			const float Cost = Current.Cost + Edge.Cost;
+			if (Search.Stamps[Edge.To] != Stamp || Cost < Search.Costs[Edge.To])
+			{
+				Search.Stamps[Edge.To] = Stamp;
+				Search.Costs[Edge.To] = Cost;
+				Search.ParentNodes[Edge.To] = Current.Node;
+				Search.ParentEdges[Edge.To] = EdgeIndex;
+				Search.Open.HeapPush({ Cost + GetHeuristic(Edge.To, Goal), Cost, Edge.To }, CompareEstimates);
+			}
+		}
+	}
+	if (!bFound)
+	{
+		return false;
+	}
+
+	for (int32 Node = Goal; Node != INDEX_NONE; Node = Search.ParentNodes[Node])
+	{
+		const int32 EdgeIndex = Search.ParentEdges[Node];
+		FPlatformPathPoint& Point = OutPath.Points.AddDefaulted_GetRef();
+		Point.Location = Nodes[Node].Location;
+		Point.Node = Node;
+		Point.Edge = EdgeIndex != INDEX_NONE ? Edges[EdgeIndex].Type : EPlatformNavEdge::Walk;
+		Point.MoveInput = EdgeIndex != INDEX_NONE ? Edges[EdgeIndex].MoveInput : 0.f;
+	}
+	Algo::Reverse(OutPath.Points);
+	OutPath.Cost = Search.Costs[Goal];
+	return true;
+}
+
+void FPlatformNavGraph::FindPaths(const TArray<FIntPoint>& Queries, TArray<FPlatformPath>& OutPaths, bool bParallel, int64* OutNodesExpanded) const
+{
+	OutPaths.SetNum(Queries.Num());
+	if (Queries.Num() == 0)
+	{
+		return;
+	}
+
+	//one task per thread, each with its own search scratch and a run of the queries
+	const int32 NumTasks = bParallel ? FMath::Min(Queries.Num(), FTaskGraphInterface::Get().GetNumWorkerThreads() + 1) : 1;
+	TArray<int64> NodesExpanded;
+	NodesExpanded.SetNumZeroed(NumTasks);
+	ParallelFor(NumTasks, [&](int32 Task)
+	{
+		FPlatformNavSearch Search;
+		const int32 First = Queries.Num() * Task / NumTasks;
+		const int32 Last = Queries.Num() * (Task + 1) / NumTasks;
+		for (int32 Index = First; Index < Last; Index++)
+		{
+			FindPath(Queries[Index].X, Queries[Index].Y, Search, OutPaths[Index]);
+		}
+		NodesExpanded[Task] = Search.NodesExpanded;
+	}, !bParallel);
+
+	if (OutNodesExpanded != nullptr)
+	{
+		for (int64 Count : NodesExpanded)
+		{
+			*OutNodesExpanded += Count;
+		}
+	}
+}
+
+int32 FPlatformNavGraph::GetNumEdges(EPlatformNavEdge Type) const
+{
+	int32 Count = 0;
+	for (const FPlatformNavEdge& Edge : Edges)
+	{
+		Count += Edge.Type == Type ? 1 : 0;
+	}
+	return Count;
+}
+
+SIZE_T FPlatformNavGraph::GetAllocatedSize() const
+{
+	return ColumnFirstNodes.GetAllocatedSize() + Nodes.GetAllocatedSize() + Edges.GetAllocatedSize() + LevelHashes.GetAllocatedSize();
+}
+
+bool FPlatformNavGraph::SaveToFile(const FString& FileName) const
+{
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+	uint32 Magic = NavGraphMagic;
+	uint32 Version = NavGraphVersion;
+	Writer << Magic << Version;
+	Writer << const_cast<FPlatformNavGraph&>(*this);
+	return FFileHelper::SaveArrayToFile(Data, *FileName);
+}
+
+bool FPlatformNavGraph::LoadFromFile(const FString& FileName)
+{
+	Reset();
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *FileName, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(FileData);
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	Reader << Magic << Version;
+	if (Magic != NavGraphMagic || Version != NavGraphVersion)
+	{
+		return false;
+	}
+	Reader << *this;
+
+	//searches trust the indices, so a damaged file must not get through
+	bool bValid = !Reader.IsError() && NumFloorNodes >= 0 && NumFloorNodes <= Nodes.Num() && ColumnFirstNodes.Num() > 0 && CellSize > 0.f && MaxSpeed > 0.f;
+	for (int32 Index = 0; bValid && Index < ColumnFirstNodes.Num(); Index++)
+	{
+		bValid = ColumnFirstNodes[Index] >= (Index > 0 ? ColumnFirstNodes[Index - 1] : 0) && ColumnFirstNodes[Index] <= NumFloorNodes;
+	}
+	for (int32 Index = 0; bValid && Index < Nodes.Num(); Index++)
+	{
+		bValid = Nodes[Index].FirstEdge >= 0 && Nodes[Index].FirstEdge + Nodes[Index].NumEdges <= Edges.Num();
+	}
+	for (int32 Index = 0; bValid && Index < Edges.Num(); Index++)
+	{
+		bValid = Nodes.IsValidIndex(Edges[Index].To);
+	}
+	if (!bValid)
+	{
+		Reset();
+	}
+	return bValid;
+}
+
+FArchive& operator<<(FArchive& Ar, FPlatformNavGraph& Graph)
+{
+	Ar << Graph.Origin << Graph.CellSize << Graph.HalfHeight << Graph.MaxSpeed << Graph.NumFloorNodes;
+
+	int32 NumColumns = Graph.ColumnFirstNodes.Num();
+	if (!SerializeCount(Ar, NumColumns))
+	{
+		return Ar;
+	}
+	Graph.ColumnFirstNodes.SetNumUninitialized(NumColumns);
+	for (int32& FirstNode : Graph.ColumnFirstNodes)
+	{
+		Ar << FirstNode;
+	}
+
+	int32 NumNodes = Graph.Nodes.Num();
+	if (!SerializeCount(Ar, NumNodes))
+	{
+		return Ar;
+	}
+	Graph.Nodes.SetNumUninitialized(NumNodes);
+	for (FPlatformNavNode& Node : Graph.Nodes)
+	{
+		Ar << Node.Location << Node.FirstEdge << Node.NumEdges << Node.WallSide;
+	}
+
+	int32 NumEdges = Graph.Edges.Num();
+	if (!SerializeCount(Ar, NumEdges))
+	{
+		return Ar;
+	}
+	Graph.Edges.SetNumUninitialized(NumEdges);
+	for (FPlatformNavEdge& Edge : Graph.Edges)
+	{
+		uint8 Type = static_cast<uint8>(Edge.Type);
+		Ar << Edge.To << Edge.Cost << Edge.MoveInput << Type;
+		Edge.Type = static_cast<EPlatformNavEdge>(FMath::Min<uint8>(Type, static_cast<uint8>(EPlatformNavEdge::WallGrab)));
+	}
+
+	Ar << Graph.LevelHashes;
+	return Ar;
+}
@@ -0,0 +1,227 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FLevelCollisionGrid;
+
+/** How the character gets from one nav node to the next */
+enum class EPlatformNavEdge : uint8
+{
+	//along a floor, including steps up or down of at most MaxStepHeight
+	Walk,
+	//walking off a ledge, or letting go of a held wall
+	Drop,
+	//a jump that lands on a floor, also from a held wall
+	Jump,
+	//a jump that ends holding a wall
+	WallGrab
+};
+
+/** What the character can do, in the units of its CharacterMovement. The defaults are AVictorCharacter's */
+struct FPlatformNavMovement
+{
+	/** Capsule radius and half height */
+	FVector2D HalfExtent = FVector2D(40.f, 96.f);
+
+	float MaxWalkSpeed = 600.f;
+
+	float MaxAcceleration = 2048.f;
+
+	float AirControl = 0.8f;
+
+	float MaxStepHeight = 45.f;
+
+	float JumpZVelocity = 800.f;
+
+	/** World gravity times GravityScale, positive */
+	float Gravity = 1960.f;
+
+	/** WallGrabBox relative to the capsule center of a character facing +X */
+	FVector2D WallGrabOffset = FVector2D(50.f, 20.f);
+
+	FVector2D WallGrabHalfExtent = FVector2D(24.f, 8.f);
+
+	bool bCanHoldWalls = true;
+};
+
+struct FPlatformNavBuildSettings
+{
+	FPlatformNavMovement Movement;
+
+	/** Jumps and drops are simulated holding MoveRight at 1/NumAirInputs, 2/NumAirInputs ... 1 either way */
+	int32 NumAirInputs = 4;
+
+	float SimulationStep = 1.f / 60.f;
+
+	/** Jumps and drops still in the air after this long are left out */
+	float MaxAirTime = 3.f;
+};
+
+struct FPlatformNavNode
+{
+	/** Capsule center of a character standing on the floor or holding the wall */
+	FVector2D Location;
+
+	int32 FirstEdge;
+
+	uint16 NumEdges;
+
+	/** -1 or 1 for a character holding a wall on that side, 0 for floors */
+	int8 WallSide;
+};
+
+struct FPlatformNavEdge
+{
+	int32 To;
+
+	/** Seconds the move takes */
+	float Cost;
+
+	/** MoveRight input to hold for the move, the jump pressed with it for Jump and WallGrab */
+	float MoveInput;
+
+	EPlatformNavEdge Type;
+};
+
+/** One step of a path: where to get, and how */
+struct FPlatformPathPoint
+{
+	FVector2D Location;
+
+	int32 Node;
+
+	/** How the character gets here from the previous point, Walk for the first one */
+	EPlatformNavEdge Edge;
+
+	float MoveInput;
+};
+
+/** Path between two nav nodes, empty if the goal can't be reached */
+struct FPlatformPath
+{
+	TArray<FPlatformPathPoint> Points;
+
+	float Cost = 0.f;
+
+	bool IsValid() const { return Points.Num() > 0; }
+};
+
+/** Scratch of one A* search at a time; reused so searches don't allocate */
+struct FPlatformNavSearch
+{
+	struct FOpenNode
+	{
+		float Estimate;
+		float Cost;
+		int32 Node;
+	};
+
+	TArray<float> Costs;
+
+	TArray<int32> ParentNodes;
+
+	TArray<int32> ParentEdges;
+
+	//Costs and parents of a node are only set if its stamp is the current search's
+	TArray<uint32> Stamps;
+
+	TArray<FOpenNode> Open;
+
+	uint32 Stamp = 0;
+
+	int32 NodesExpanded = 0;
+};
+
+/**
+ * Where a character following the platformer rules can stand or hold a wall, and how it gets between those places.
+ * Floor nodes are the grid cells a capsule can stand in, wall nodes are where a jump ends holding a wall.
+ * Jumps, drops and wall grabs are found by simulating the character's air movement through the collision grid,
+ * so the graph only has moves the character can actually make.
+ * Built offline by the VictorNavGraph commandlet or on first use; read-only afterwards, so worker threads can search it.
+ */
+class VICTOR_API FPlatformNavGraph
+{
+public:
+	void Build(const FLevelCollisionGrid& Grid, const FPlatformNavBuildSettings& Settings);
+
+	void Reset();
+
+	bool IsBuilt() const { return Nodes.Num() > 0; }
+
+	/** Floor node of a character standing at Location, INDEX_NONE if there is no floor under it */
+	int32 FindFloorNode(const FVector2D& Location) const;
+
+	/** A* from Start to Goal, cheapest in seconds. False if Goal can't be reached */
+	bool FindPath(int32 Start, int32 Goal, FPlatformNavSearch& Search, FPlatformPath& OutPath) const;
+
+	/**
+	 * Searches every (start node, goal node) pair of Queries, spread over the worker threads if bParallel.
+	 * Adds the nodes the searches expanded to OutNodesExpanded.
+	 */
+	void FindPaths(const TArray<FIntPoint>& Queries, TArray<FPlatformPath>& OutPaths, bool bParallel, int64* OutNodesExpanded = nullptr) const;
+
+	const TArray<FPlatformNavNode>& GetNodes() const { return Nodes; }
+
+	const TArray<FPlatformNavEdge>& GetEdges() const { return Edges; }
+
+	int32 GetNumFloorNodes() const { return NumFloorNodes; }
+
+	int32 GetNumEdges(EPlatformNavEdge Type) const;
+
+	SIZE_T GetAllocatedSize() const;
+
+	/** Content hash of each level the graph was built from, by package name, see ULevelGridSubsystem::GetLevelContentHash */
+	void SetLevelHashes(const TMap<FString, uint32>& InLevelHashes) { LevelHashes = InLevelHashes; }
+
+	/** nullptr if the level was not part of the graph's build */
+	const uint32* FindLevelHash(const FString& LevelName) const { return LevelHashes.Find(LevelName); }
+
+	/** Writes the graph with a version header */
+	bool SaveToFile(const FString& FileName) const;
+
+	/** False if the file is missing, of another version or damaged */
+	bool LoadFromFile(const FString& FileName);
+
+	friend FArchive& operator<<(FArchive& Ar, FPlatformNavGraph& Graph);
+
+private:
+	float GetHeuristic(int32 From, int32 To) const
+	{
+		return FMath::Abs(Nodes[To].Location.X - Nodes[From].Location.X) / MaxSpeed;
+	}
+
+	//grid row a floor node stands in, the one above the solid cell
+	int32 GetFloorRow(const FVector2D& Location) const
+	{
+		return FMath::RoundToInt((Location.Y - HalfHeight - Origin.Y) / CellSize);
+	}
+
+	//floor node of column X whose floor is row Z
+	int32 FindFloorNodeInColumn(int32 X, int32 Z) const;
+
+	//floor node a simulated jump or drop ended on, also when only the edge of the capsule's base is on the floor
+	int32 FindLandingNode(const FVector2D& Location) const;
+
+	FVector2D Origin = FVector2D::ZeroVector;
+
+	float CellSize = 32.f;
+
+	float HalfHeight = 96.f;
+
+	/** Horizontal speed the character never goes above, for the A* estimate */
+	float MaxSpeed = 600.f;
+
+	/** First floor node of each grid column, and the node count at the end. Floors of a column go bottom to top */
+	TArray<int32> ColumnFirstNodes;
+
+	/** Floor nodes first, then wall nodes */
+	TArray<FPlatformNavNode> Nodes;
+
+	TArray<FPlatformNavEdge> Edges;
+
+	int32 NumFloorNodes = 0;
+
+	TMap<FString, uint32> LevelHashes;
+};
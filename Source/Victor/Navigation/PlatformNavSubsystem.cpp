@@ -0,0 +1,525 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlatformNavSubsystem.h"
+
+#include "VictorCharacter.h"
+#include "VictorStats.h"
+#include "Async/Async.h"
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/GameModeBase.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Paths.h"
+#include "World/LevelGridSubsystem.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogVictorNavigation, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("Load platform nav graph"), STAT_VictorLoadNavGraph, STATGROUP_Victor);
+DECLARE_CYCLE_STAT(TEXT("Platform path queries"), STAT_VictorPlatformPathQueries, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Platform path cache hits"), STAT_VictorPlatformPathCacheHits, STATGROUP_Victor);
+
+void FPlatformPathCache::SetCapacity(int32 InCapacity)
+{
+	Capacity = FMath::Max(InCapacity, 1);
+	Empty();
+}
+
+void FPlatformPathCache::Add(int32 Start, int32 Goal, const FPlatformPathPtr& Path)
+{
+	const uint64 Key = MakeKey(Start, Goal);
+	if (FPlatformPathPtr* Existing = Paths.Find(Key))
+	{
+		*Existing = Path;
+		return;
+	}
+	if (Order.Num() < Capacity)
+	{
+		Order.Add(Key);
+	}
+	else
+	{
+		Paths.Remove(Order[NextEviction]);
+		Order[NextEviction] = Key;
+		NextEviction = (NextEviction + 1) % Capacity;
+	}
+	Paths.Add(Key, Path);
+}
+
+void FPlatformPathCache::Empty()
+{
+	Paths.Empty();
+	Order.Empty();
+	NextEviction = 0;
+}
+
+SIZE_T FPlatformPathCache::GetAllocatedSize() const
+{
+	SIZE_T Size = Paths.GetAllocatedSize() + Order.GetAllocatedSize();
+	for (const TPair<uint64, FPlatformPathPtr>& Pair : Paths)
+	{
+		Size += sizeof(FPlatformPath) + Pair.Value->Points.GetAllocatedSize();
+	}
+	return Size;
+}
+
+void UPlatformNavSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	Collection.InitializeDependency(ULevelGridSubsystem::StaticClass());
+
+	PathCache.SetCapacity(MaxCachedPaths);
+	ActorsInitializedHandle = FWorldDelegates::OnWorldInitializedActors.AddUObject(this, &UPlatformNavSubsystem::OnActorsInitialized);
+}
+
+void UPlatformNavSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldInitializedActors.Remove(ActorsInitializedHandle);
+	CancelBatch();
+	if (GraphBuildDone.IsValid())
+	{
+		GraphBuildDone.Wait();
+		GraphBuildDone = TFuture<void>();
+	}
+	BuildingGraph.Reset();
+	SeenLevels.Empty();
+	BatchQueries.Empty();
+	PendingQueries.Empty();
+	PathCache.Empty();
+	Graph.Reset();
+
+	Super::Deinitialize();
+}
+
+void UPlatformNavSubsystem::OnActorsInitialized(const UWorld::FActorsInitializedParams& Params)
+{
+	//have the graph ready by the time the first guard asks for a path
+	if (Params.World == GetWorld() && GetWorld()->IsGameWorld() && !Graph.IsValid() && !GraphBuildDone.IsValid())
+	{
+		LoadOrBuildGraph();
+	}
+}
+
+bool UPlatformNavSubsystem::RequestPath(const FVector2D& Start, const FVector2D& Goal, FOnPlatformPathFound OnFound)
+{
+	FPathQuery Query = { Start, Goal, INDEX_NONE, INDEX_NONE, MoveTemp(OnFound), INDEX_NONE };
+	if (GetGraph() != nullptr)
+	{
+		if (!ResolveQuery(Query))
+		{
+			return false;
+		}
+		if (FPlatformPathPtr Path = PathCache.Find(Query.Start, Query.Goal))
+		{
+			Stats.Queries++;
+			Stats.CacheHits++;
+			INC_DWORD_STAT(STAT_VictorPlatformPathCacheHits);
+			Query.OnFound.ExecuteIfBound(Path);
+			return true;
+		}
+	}
+	Stats.Queries++;
+	PendingQueries.Add(MoveTemp(Query));
+	return true;
+}
+
+const FPlatformNavGraph* UPlatformNavSubsystem::GetGraph()
+{
+	check(IsInGameThread());
+	if (!Graph.IsValid() && !GraphBuildDone.IsValid())
+	{
+		LoadOrBuildGraph();
+	}
+	return Graph.Get();
+}
+
+void UPlatformNavSubsystem::LoadOrBuildGraph()
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorLoadNavGraph);
+	const FString BakedPath = GetBakedGraphPath();
+	if (bUseBakedGraph)
+	{
+		TSharedRef<FPlatformNavGraph, ESPMode::ThreadSafe> BakedGraph = MakeShared<FPlatformNavGraph, ESPMode::ThreadSafe>();
+		if (BakedGraph->LoadFromFile(BakedPath))
+		{
+			if (MatchesLoadedLevels(*BakedGraph))
+			{
+				UE_LOG(LogVictorNavigation, Log, TEXT("Loaded nav graph %s, %d nodes"), *BakedPath, BakedGraph->GetNodes().Num());
+				GraphGridRevision = GetWorld()->GetSubsystem<ULevelGridSubsystem>()->GetGridRevision();
+				SetGraph(BakedGraph, true);
+				return;
+			}
+			UE_LOG(LogVictorNavigation, Warning, TEXT("Nav graph %s was baked from other level content. Run the VictorNavGraph commandlet"), *BakedPath);
+		}
+	}
+	if (bBuildMissingGraph)
+	{
+		//covers the chunks streamed in so far and grows as more stream in, bake the graph to have all of them from the start
+		UE_LOG(LogVictorNavigation, Warning, TEXT("No usable nav graph baked at %s, building one from the levels streamed in. Run the VictorNavGraph commandlet"), *BakedPath);
+		StartGraphBuild();
+	}
+	else
+	{
+		GraphGridRevision = GetWorld()->GetSubsystem<ULevelGridSubsystem>()->GetGridRevision();
+		SetGraph(MakeShared<FPlatformNavGraph, ESPMode::ThreadSafe>(), false);
+	}
+}
+
+void UPlatformNavSubsystem::StartGraphBuild()
+{
+	if (GraphBuildDone.IsValid())
+	{
+		bRebuildGraph = true;
+		return;
+	}
+	bRebuildGraph = false;
+
+	//the level grid only has the chunks streamed in now, the graph keeps the ones that streamed out too
+	ULevelGridSubsystem* LevelGrid = GetWorld()->GetSubsystem<ULevelGridSubsystem>();
+	GatherSeenLevels();
+	GraphGridRevision = LevelGrid->GetGridRevision();
+	TArray<FBox2D> Boxes;
+	for (const TPair<FString, FSeenLevel>& Level : SeenLevels)
+	{
+		Boxes.Append(Level.Value.Boxes);
+	}
+	BuildingGraph = MakeShared<FPlatformNavGraph, ESPMode::ThreadSafe>();
+
+	auto Build = [NewGraph = BuildingGraph, Boxes = MoveTemp(Boxes), CellSize = LevelGrid->CellSize, Settings = GetBuildSettings()]()
+	{
+		FLevelCollisionGrid Grid;
+		Grid.Build(Boxes, CellSize);
+		NewGraph->Build(Grid, Settings);
+	};
+	if (bRunOnWorkerThreads)
+	{
+		GraphBuildDone = Async(EAsyncExecution::ThreadPool, MoveTemp(Build));
+	}
+	else
+	{
+		Build();
+		FinishGraphBuild();
+	}
+}
+
+void UPlatformNavSubsystem::FinishGraphBuild()
+{
+	GraphBuildDone = TFuture<void>();
+	const TSharedPtr<FPlatformNavGraph, ESPMode::ThreadSafe> Built = MoveTemp(BuildingGraph);
+	UE_LOG(LogVictorNavigation, Log, TEXT("Built nav graph with %d nodes from %d levels"), Built->GetNodes().Num(), SeenLevels.Num());
+	SetGraph(Built, false);
+	if (bRebuildGraph)
+	{
+		StartGraphBuild();
+	}
+}
+
+void UPlatformNavSubsystem::SetGraph(const TSharedPtr<const FPlatformNavGraph, ESPMode::ThreadSafe>& NewGraph, bool bBaked)
+{
+	//the nodes of the cached paths and of the queries are the old graph's
+	CancelBatch();
+	TArray<FPathQuery> Requeued = MoveTemp(BatchQueries);
+	Requeued.Append(MoveTemp(PendingQueries));
+	BatchQueries.Reset();
+	for (FPathQuery& Query : Requeued)
+	{
+		Query.Start = INDEX_NONE;
+		Query.Goal = INDEX_NONE;
+	}
+	PendingQueries = MoveTemp(Requeued);
+	PathCache.Empty();
+	Graph = NewGraph;
+	bGraphBaked = bBaked;
+}
+
+void UPlatformNavSubsystem::CheckLevelChanges()
+{
+	ULevelGridSubsystem* LevelGrid = GetWorld()->GetSubsystem<ULevelGridSubsystem>();
+	LevelGrid->GetCollisionGrid();
+	if (LevelGrid->GetGridRevision() == GraphGridRevision)
+	{
+		return;
+	}
+	GraphGridRevision = LevelGrid->GetGridRevision();
+	//the baked graph covers every chunk of the map, streaming them in or out doesn't change it
+	if (bGraphBaked && !GraphBuildDone.IsValid() && MatchesLoadedLevels(*Graph))
+	{
+		return;
+	}
+	//a chunk streaming out stays in the built graph, and one streaming back in only rebuilds if its content changed
+	if (bBuildMissingGraph && GatherSeenLevels())
+	{
+		StartGraphBuild();
+	}
+}
+
+bool UPlatformNavSubsystem::GatherSeenLevels()
+{
+	ULevelGridSubsystem* LevelGrid = GetWorld()->GetSubsystem<ULevelGridSubsystem>();
+	LevelGrid->GetCollisionGrid();
+	bool bChanged = false;
+	for (const ULevel* Level : GetWorld()->GetLevels())
+	{
+		const TArray<FBox2D>* Boxes = Level != nullptr ? LevelGrid->FindLevelBoxes(Level) : nullptr;
+		if (Boxes == nullptr)
+		{
+			continue;
+		}
+		const FString Name = UWorld::RemovePIEPrefix(Level->GetOutermost()->GetName());
+		const uint32 Hash = FLevelCollisionGrid::HashBoxes(*Boxes);
+		FSeenLevel* Seen = SeenLevels.Find(Name);
+		if (Seen == nullptr || Seen->Hash != Hash)
+		{
+			FSeenLevel& Added = SeenLevels.Add(Name);
+			Added.Hash = Hash;
+			Added.Boxes = *Boxes;
+			bChanged = true;
+		}
+	}
+	return bChanged;
+}
+
+bool UPlatformNavSubsystem::MatchesLoadedLevels(const FPlatformNavGraph& NavGraph) const
+{
+	TMap<FString, uint32> LevelHashes;
+	GetLevelContentHashes(LevelHashes);
+	for (const TPair<FString, uint32>& Level : LevelHashes)
+	{
+		const uint32* GraphHash = NavGraph.FindLevelHash(Level.Key);
+		if (GraphHash == nullptr || *GraphHash != Level.Value)
+		{
+			UE_LOG(LogVictorNavigation, Log, TEXT("Level %s is not in the nav graph as it is now"), *Level.Key);
+			return false;
+		}
+	}
+	return true;
+}
+
+void UPlatformNavSubsystem::GetLevelContentHashes(TMap<FString, uint32>& OutHashes) const
+{
+	ULevelGridSubsystem* LevelGrid = GetWorld()->GetSubsystem<ULevelGridSubsystem>();
+	//gathers the levels streamed in since the grid was last asked for
+	LevelGrid->GetCollisionGrid();
+	for (const ULevel* Level : GetWorld()->GetLevels())
+	{
+		if (Level != nullptr)
+		{
+			OutHashes.Add(UWorld::RemovePIEPrefix(Level->GetOutermost()->GetName()), LevelGrid->GetLevelContentHash(Level));
+		}
+	}
+}
+
+bool UPlatformNavSubsystem::ResolveQuery(FPathQuery& Query) const
+{
+	Query.Start = Graph->FindFloorNode(Query.StartLocation);
+	Query.Goal = Graph->FindFloorNode(Query.GoalLocation);
+	return Query.Start != INDEX_NONE && Query.Goal != INDEX_NONE;
+}
+
+void UPlatformNavSubsystem::MarkGraphDirty()
+{
+	SetGraph(nullptr, false);
+	SeenLevels.Reset();
+	StartGraphBuild();
+}
+
+FPlatformNavBuildSettings UPlatformNavSubsystem::GetBuildSettings() const
+{
+	FPlatformNavBuildSettings Settings;
+	Settings.NumAirInputs = NumAirInputs;
+	Settings.MaxAirTime = MaxAirTime;
+
+	//the default pawn's capsule and movement, Blueprint defaults included
+	UWorld* World = GetWorld();
+	const AGameModeBase* GameMode = World->GetAuthGameMode();
+	TSubclassOf<AVictorCharacter> PawnClass = AVictorCharacter::StaticClass();
+	if (GameMode != nullptr && GameMode->DefaultPawnClass != nullptr && GameMode->DefaultPawnClass->IsChildOf<AVictorCharacter>())
+	{
+		PawnClass = *GameMode->DefaultPawnClass;
+	}
+	const AVictorCharacter* Character = PawnClass->GetDefaultObject<AVictorCharacter>();
+	const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+	const UCharacterMovementComponent* CharacterMovement = Character->GetCharacterMovement();
+
+	FPlatformNavMovement& Movement = Settings.Movement;
+	Movement.HalfExtent = FVector2D(Capsule->GetUnscaledCapsuleRadius(), Capsule->GetUnscaledCapsuleHalfHeight());
+	Movement.MaxWalkSpeed = CharacterMovement->MaxWalkSpeed;
+	Movement.MaxAcceleration = CharacterMovement->MaxAcceleration;
+	Movement.AirControl = CharacterMovement->AirControl;
+	Movement.MaxStepHeight = CharacterMovement->MaxStepHeight;
+	Movement.JumpZVelocity = CharacterMovement->JumpZVelocity;
+	Movement.Gravity = -World->GetGravityZ() * CharacterMovement->GravityScale;
+	if (const UBoxComponent* WallGrabBox = Character->GetWallGrabBox())
+	{
+		const FVector Offset = WallGrabBox->GetRelativeLocation();
+		const FVector Extent = WallGrabBox->GetUnscaledBoxExtent() * WallGrabBox->GetRelativeScale3D();
+		Movement.WallGrabOffset = FVector2D(Offset.X, Offset.Z);
+		Movement.WallGrabHalfExtent = FVector2D(Extent.X, Extent.Z);
+	}
+	else
+	{
+		Movement.bCanHoldWalls = false;
+	}
+	return Settings;
+}
+
+FString UPlatformNavSubsystem::GetBakedGraphPath() const
+{
+	return FPaths::ProjectContentDir() / BakedGraphDirectory / UWorld::RemovePIEPrefix(GetWorld()->GetMapName()) + TEXT(".vnav");
+}
+
+void UPlatformNavSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorPlatformPathQueries);
+	if (GraphBuildDone.IsValid() && GraphBuildDone.IsReady())
+	{
+		FinishGraphBuild();
+	}
+	if (Graph.IsValid() || GraphBuildDone.IsValid())
+	{
+		CheckLevelChanges();
+	}
+	if (BatchDone.IsValid() && BatchDone.IsReady())
+	{
+		FinishBatch();
+	}
+	if (!BatchDone.IsValid() && Graph.IsValid() && PendingQueries.Num() > 0)
+	{
+		StartBatch();
+	}
+}
+
+bool UPlatformNavSubsystem::IsTickable() const
+{
+	if (PendingQueries.Num() > 0 || BatchDone.IsValid() || GraphBuildDone.IsValid())
+	{
+		return true;
+	}
+	const ULevelGridSubsystem* LevelGrid = GetWorld()->GetSubsystem<ULevelGridSubsystem>();
+	return Graph.IsValid() && LevelGrid != nullptr && (LevelGrid->HasPendingLevelChanges() || LevelGrid->GetGridRevision() != GraphGridRevision);
+}
+
+void UPlatformNavSubsystem::StartBatch()
+{
+	check(Graph.IsValid());
+	Batch = MakeShared<FPathBatch, ESPMode::ThreadSafe>();
+	BatchQueries.Reset();
+
+	//queries waiting since an earlier batch searched their pair are answered from the cache, the same pair asked twice is searched once
+	TArray<FPathQuery> Cached;
+	TArray<FPlatformPathPtr> CachedPaths;
+	TArray<FPathQuery> NoFloor;
+	TMap<FIntPoint, int32> PairIndices;
+	const int32 MaxQueries = FMath::Max(MaxQueriesPerBatch, 1);
+	int32 NumTaken = 0;
+	for (; NumTaken < PendingQueries.Num() && BatchQueries.Num() < MaxQueries; NumTaken++)
+	{
+		FPathQuery& Query = PendingQueries[NumTaken];
+		//asked before the graph was ready
+		if (Query.Start == INDEX_NONE && !ResolveQuery(Query))
+		{
+			NoFloor.Add(MoveTemp(Query));
+			continue;
+		}
+		if (FPlatformPathPtr Path = PathCache.Find(Query.Start, Query.Goal))
+		{
+			Cached.Add(MoveTemp(Query));
+			CachedPaths.Add(Path);
+			continue;
+		}
+		const FIntPoint Pair(Query.Start, Query.Goal);
+		if (const int32* PairIndex = PairIndices.Find(Pair))
+		{
+			Query.Pair = *PairIndex;
+		}
+		else
+		{
+			Query.Pair = Batch->Pairs.Add(Pair);
+			PairIndices.Add(Pair, Query.Pair);
+		}
+		BatchQueries.Add(MoveTemp(Query));
+	}
+	PendingQueries.RemoveAt(0, NumTaken, false);
+
+	auto Search = [NavGraph = Graph, PathBatch = Batch, bParallel = bRunOnWorkerThreads]()
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		TArray<FPlatformPath> Paths;
+		NavGraph->FindPaths(PathBatch->Pairs, Paths, bParallel, &PathBatch->NodesExpanded);
+		PathBatch->Paths.Reserve(Paths.Num());
+		for (FPlatformPath& Path : Paths)
+		{
+			PathBatch->Paths.Add(MakeShared<FPlatformPath, ESPMode::ThreadSafe>(MoveTemp(Path)));
+		}
+		PathBatch->Seconds = FPlatformTime::Seconds() - StartTime;
+	};
+	if (Batch->Pairs.Num() == 0)
+	{
+		Batch.Reset();
+	}
+	else if (bRunOnWorkerThreads)
+	{
+		BatchDone = Async(EAsyncExecution::ThreadPool, MoveTemp(Search));
+	}
+	else
+	{
+		Search();
+		FinishBatch();
+	}
+
+	for (int32 Index = 0; Index < Cached.Num(); Index++)
+	{
+		Stats.CacheHits++;
+		INC_DWORD_STAT(STAT_VictorPlatformPathCacheHits);
+		Cached[Index].OnFound.ExecuteIfBound(CachedPaths[Index]);
+	}
+	for (FPathQuery& Query : NoFloor)
+	{
+		Query.OnFound.ExecuteIfBound(MakeShared<FPlatformPath, ESPMode::ThreadSafe>());
+	}
+}
+
+void UPlatformNavSubsystem::FinishBatch()
+{
+	BatchDone = TFuture<void>();
+	const TSharedPtr<FPathBatch, ESPMode::ThreadSafe> Finished = MoveTemp(Batch);
+	Stats.Batches++;
+	Stats.Searches += Finished->Pairs.Num();
+	Stats.NodesExpanded += Finished->NodesExpanded;
+	Stats.SearchSeconds += Finished->Seconds;
+	for (int32 Index = 0; Index < Finished->Pairs.Num(); Index++)
+	{
+		PathCache.Add(Finished->Pairs[Index].X, Finished->Pairs[Index].Y, Finished->Paths[Index]);
+	}
+
+	//callbacks may ask for more paths, those wait for the next batch
+	TArray<FPathQuery> Answered = MoveTemp(BatchQueries);
+	BatchQueries.Reset();
+	for (FPathQuery& Query : Answered)
+	{
+		Query.OnFound.ExecuteIfBound(Finished->Paths[Query.Pair]);
+	}
+}
+
+void UPlatformNavSubsystem::CancelBatch()
+{
+	if (BatchDone.IsValid())
+	{
+		BatchDone.Wait();
+		BatchDone = TFuture<void>();
+	}
+	Batch.Reset();
+}
+
+TStatId UPlatformNavSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPlatformNavSubsystem, STATGROUP_Tickables);
+}
+
+ETickableTickType UPlatformNavSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
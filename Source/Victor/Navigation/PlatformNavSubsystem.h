@@ -0,0 +1,258 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Async/Future.h"
+#include "Engine/World.h"
+#include "Navigation/PlatformNavGraph.h"
+#include "PlatformNavSubsystem.generated.h"
+
+typedef TSharedPtr<const FPlatformPath, ESPMode::ThreadSafe> FPlatformPathPtr;
+
+DECLARE_DELEGATE_OneParam(FOnPlatformPathFound, FPlatformPathPtr);
+
+/** Paths by (start node, goal node), unreachable goals included. Once full the oldest path makes room */
+class VICTOR_API FPlatformPathCache
+{
+public:
+	void SetCapacity(int32 InCapacity);
+
+	/** nullptr if the pair was never searched or has been thrown out */
+	FPlatformPathPtr Find(int32 Start, int32 Goal) const
+	{
+		const FPlatformPathPtr* Path = Paths.Find(MakeKey(Start, Goal));
+		return Path != nullptr ? *Path : FPlatformPathPtr();
+	}
+
+	void Add(int32 Start, int32 Goal, const FPlatformPathPtr& Path);
+
+	void Empty();
+
+	int32 Num() const { return Paths.Num(); }
+
+	/** The map, the eviction order and the paths themselves */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	static uint64 MakeKey(int32 Start, int32 Goal)
+	{
+		return (uint64(uint32(Start)) << 32) | uint32(Goal);
+	}
+
+	TMap<uint64, FPlatformPathPtr> Paths;
+
+	//keys in the order they were added, a ring once the cache is full
+	TArray<uint64> Order;
+
+	int32 NextEviction = 0;
+
+	int32 Capacity = 4096;
+};
+
+/** Path queries since ResetStats */
+struct FPlatformNavStats
+{
+	int32 Queries = 0;
+
+	int32 CacheHits = 0;
+
+	int32 Searches = 0;
+
+	int32 Batches = 0;
+
+	int64 NodesExpanded = 0;
+
+	/** Wall time of the batches on the worker threads */
+	double SearchSeconds = 0.0;
+};
+
+/**
+ * Path finding for characters that walk, jump, drop and hold walls, over a FPlatformNavGraph of the level.
+ * The graph is the one the VictorNavGraph commandlet baked for the map, as long as the content hash of every loaded level
+ * matches the one it was baked from. Otherwise it is built on the worker threads once the world's actors are initialized,
+ * from the boxes ULevelGridSubsystem gathered for every level streamed in so far. Levels streaming out stay in it; it is
+ * built again only when a level streams in that it doesn't have yet, or one it has comes back with other content.
+ * Queries are searched in batches on worker threads and answered on the game thread a frame or more later;
+ * every (start node, goal node) result is cached, so repeated queries answer at once.
+ */
+UCLASS(config=Game)
+class VICTOR_API UPlatformNavSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/**
+	 * Finds a path from the floor under Start to the floor under Goal. OnFound runs on the game thread, right away for
+	 * cached paths, and gets an empty path if the goal can't be reached. False if either point has no floor under it.
+	 * Queries made while the graph is still being built wait for it, and get an empty path if there is no floor.
+	 */
+	bool RequestPath(const FVector2D& Start, const FVector2D& Goal, FOnPlatformPathFound OnFound);
+
+	/** Game thread only; starts loading or building the graph if there is none. nullptr until it is ready */
+	const FPlatformNavGraph* GetGraph();
+
+	/** True while a graph is built on the worker threads. A graph from before keeps answering until it is done */
+	bool IsBuildingGraph() const { return GraphBuildDone.IsValid(); }
+
+	/** True if the graph is the baked one */
+	bool IsGraphBaked() const { return bGraphBaked; }
+
+	/**
+	 * Drops the graph and the cached paths and builds it again, e.g. after level geometry moved; mark the level grid dirty too.
+	 * Queries still waiting for an answer are searched on the new graph.
+	 */
+	UFUNCTION(BlueprintCallable, Category = Navigation)
+	void MarkGraphDirty();
+
+	/** Content hash of each loaded level by package name, what a graph built now would be made from */
+	void GetLevelContentHashes(TMap<FString, uint32>& OutHashes) const;
+
+	/** How the graph is built for this world: the default pawn's movement and these settings */
+	FPlatformNavBuildSettings GetBuildSettings() const;
+
+	/** Where the VictorNavGraph commandlet writes the graph of this world's map */
+	FString GetBakedGraphPath() const;
+
+	const FPlatformNavStats& GetStats() const { return Stats; }
+
+	void ResetStats() { Stats = FPlatformNavStats(); }
+
+	int32 GetNumCachedPaths() const { return PathCache.Num(); }
+
+	/** Load the graph baked for the map when there is one */
+	UPROPERTY(Config, EditAnywhere, Category = Navigation)
+	bool bUseBakedGraph = true;
+
+	/** Build the graph from the level collision grid when no baked graph was loaded */
+	UPROPERTY(Config, EditAnywhere, Category = Navigation)
+	bool bBuildMissingGraph = true;
+
+	/** Directory under Content the baked graphs are in, staged with the game */
+	UPROPERTY(Config, EditAnywhere, Category = Navigation)
+	FString BakedGraphDirectory = TEXT("NavGraphs");
+
+	/** Held MoveRight inputs each jump and drop is tried with, either way. More finds more moves and builds slower */
+	UPROPERTY(Config, EditAnywhere, Category = Navigation, meta = (ClampMin = "1"))
+	int32 NumAirInputs = 4;
+
+	/** Jumps and drops still in the air after this long are not moves */
+	UPROPERTY(Config, EditAnywhere, Category = Navigation)
+	float MaxAirTime = 3.f;
+
+	UPROPERTY(Config, EditAnywhere, Category = Navigation)
+	int32 MaxCachedPaths = 4096;
+
+	/** Queries searched together on the worker threads, the rest wait for the next batch */
+	UPROPERTY(Config, EditAnywhere, Category = Navigation)
+	int32 MaxQueriesPerBatch = 256;
+
+	UPROPERTY(Config, EditAnywhere, Category = Navigation)
+	bool bRunOnWorkerThreads = true;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual ETickableTickType GetTickableTickType() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	struct FPathQuery
+	{
+		FVector2D StartLocation;
+		FVector2D GoalLocation;
+		//nodes of the current graph, INDEX_NONE until the query is resolved on it
+		int32 Start;
+		int32 Goal;
+		FOnPlatformPathFound OnFound;
+		//index in the batch's unique pairs
+		int32 Pair;
+	};
+
+	/** Searched on the worker threads; the game thread doesn't touch it until BatchDone is ready */
+	struct FPathBatch
+	{
+		TArray<FIntPoint> Pairs;
+		TArray<FPlatformPathPtr> Paths;
+		int64 NodesExpanded = 0;
+		double Seconds = 0.0;
+	};
+
+	void OnActorsInitialized(const UWorld::FActorsInitializedParams& Params);
+
+	/** Loads the baked graph if it matches the loaded levels, otherwise starts building one */
+	void LoadOrBuildGraph();
+
+	/** Starts building a graph from the level grid, or another one once the build running now is done */
+	void StartGraphBuild();
+
+	void FinishGraphBuild();
+
+	/** Puts the graph in place of the one before. The queries are resolved again on it */
+	void SetGraph(const TSharedPtr<const FPlatformNavGraph, ESPMode::ThreadSafe>& NewGraph, bool bBaked);
+
+	/** Builds again when a level streamed in that the built graph doesn't have, or a baked graph doesn't match a level streamed in */
+	void CheckLevelChanges();
+
+	/** Adds the loaded levels to SeenLevels, true if one wasn't in it or its content changed */
+	bool GatherSeenLevels();
+
+	/** False if a loaded level isn't in the graph or differs from what the graph was made from */
+	bool MatchesLoadedLevels(const FPlatformNavGraph& NavGraph) const;
+
+	/** Finds the query's nodes on the graph, false if either point has no floor under it */
+	bool ResolveQuery(FPathQuery& Query) const;
+
+	void StartBatch();
+
+	void FinishBatch();
+
+	/** Waits for the batch on the worker threads and drops it unanswered */
+	void CancelBatch();
+
+	TSharedPtr<const FPlatformNavGraph, ESPMode::ThreadSafe> Graph;
+
+	bool bGraphBaked = false;
+
+	/** Built on the worker threads from the boxes of SeenLevels; the game thread doesn't touch it until GraphBuildDone is ready */
+	TSharedPtr<FPlatformNavGraph, ESPMode::ThreadSafe> BuildingGraph;
+
+	TFuture<void> GraphBuildDone;
+
+	/** Levels changed while the graph was being built */
+	bool bRebuildGraph = false;
+
+	/** Level grid revision the graph, or the one being built, was checked against */
+	int32 GraphGridRevision = INDEX_NONE;
+
+	struct FSeenLevel
+	{
+		uint32 Hash = 0;
+		TArray<FBox2D> Boxes;
+	};
+
+	/** Every level streamed in since the graph was last marked dirty by package name, what a built graph is made from */
+	TMap<FString, FSeenLevel> SeenLevels;
+
+	FDelegateHandle ActorsInitializedHandle;
+
+	FPlatformPathCache PathCache;
+
+	TArray<FPathQuery> PendingQueries;
+
+	TArray<FPathQuery> BatchQueries;
+
+	TSharedPtr<FPathBatch, ESPMode::ThreadSafe> Batch;
+
+	TFuture<void> BatchDone;
+
+	FPlatformNavStats Stats;
+};
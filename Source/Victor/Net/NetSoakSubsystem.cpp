@@ -0,0 +1,222 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetSoakSubsystem.h"
+
+#include "VictorCharacter.h"
+#include "CoreGlobals.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogVictorNetSoak, Log, All);
+
+static void StartNetSoak(const TArray<FString>& Args, UWorld* World)
+{
+	UNetSoakSubsystem* Soak = World != nullptr ? World->GetSubsystem<UNetSoakSubsystem>() : nullptr;
+	if (Soak == nullptr || World->GetNetMode() != NM_ListenServer)
+	{
+		UE_LOG(LogVictorNetSoak, Error, TEXT("victor.NetSoak needs a listen server, open the map with ?listen"));
+		return;
+	}
+	const int32 StartGuards = Args.IsValidIndex(0) ? FCString::Atoi(*Args[0]) : 50;
+	const int32 GuardStep = Args.IsValidIndex(1) ? FCString::Atoi(*Args[1]) : 50;
+	const int32 MaxGuards = Args.IsValidIndex(2) ? FCString::Atoi(*Args[2]) : 500;
+	const float StepSeconds = Args.IsValidIndex(3) ? FCString::Atof(*Args[3]) : 10.f;
+	const TSubclassOf<AVictorCharacter> PawnClass = Args.IsValidIndex(4) ? LoadClass<AVictorCharacter>(nullptr, *Args[4]) : nullptr;
+	Soak->StartSoak(StartGuards, GuardStep, MaxGuards, StepSeconds, PawnClass);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs NetSoakCommand(
+	TEXT("victor.NetSoak"),
+	TEXT("victor.NetSoak [StartGuards=50] [GuardStep=50] [MaxGuards=500] [StepSeconds=10] [PawnClass]\n")
+	TEXT("On a listen server, adds guards in steps and records bytes per second and server frame time for each step."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&StartNetSoak));
+
+void UNetSoakSubsystem::Deinitialize()
+{
+	if (bRunning)
+	{
+		StopSoak();
+	}
+	Super::Deinitialize();
+}
+
+void UNetSoakSubsystem::StartSoak(int32 StartGuards, int32 InGuardStep, int32 InMaxGuards, float InStepSeconds, TSubclassOf<AVictorCharacter> PawnClass)
+{
+	if (bRunning)
+	{
+		StopSoak();
+	}
+
+	UWorld* World = GetWorld();
+	AGameModeBase* GameMode = World->GetAuthGameMode();
+	GuardClass = PawnClass;
+	if (GuardClass == nullptr && GameMode != nullptr && GameMode->DefaultPawnClass != nullptr && GameMode->DefaultPawnClass->IsChildOf<AVictorCharacter>())
+	{
+		GuardClass = *GameMode->DefaultPawnClass;
+	}
+	if (GuardClass == nullptr)
+	{
+		GuardClass = AVictorCharacter::StaticClass();
+	}
+	const AActor* PlayerStart = GameMode != nullptr ? GameMode->FindPlayerStart(nullptr) : nullptr;
+	Origin = PlayerStart != nullptr ? PlayerStart->GetActorLocation() : FVector::ZeroVector;
+
+	GuardStep = FMath::Max(InGuardStep, 1);
+	MaxGuards = FMath::Max(InMaxGuards, StartGuards);
+	StepSeconds = FMath::Max(InStepSeconds, 1.f);
+	Results.Reset();
+	Frame = 0;
+	bRunning = true;
+
+	//clears what a stopped soak left in the step sums
+	StepFrames = 0;
+	FinishStep();
+	SpawnGuards(StartGuards);
+	UE_LOG(LogVictorNetSoak, Display, TEXT("Soak started with %d %s guards, +%d every %.0fs up to %d"), Guards.Num(), *GuardClass->GetName(), GuardStep, StepSeconds, MaxGuards);
+}
+
+void UNetSoakSubsystem::StopSoak()
+{
+	WriteReport();
+	for (AVictorCharacter* Guard : Guards)
+	{
+		if (Guard != nullptr)
+		{
+			Guard->Destroy();
+		}
+	}
+	Guards.Empty();
+	bRunning = false;
+}
+
+void UNetSoakSubsystem::SpawnGuards(int32 Num)
+{
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	for (int32 i = 0; i < Num; i++)
+	{
+		//alternate sides of the start so some guards are always outside a client's relevancy box
+		const int32 Index = Guards.Num();
+		const float Offset = (Index / 2 + 1) * 120.f * (Index % 2 == 0 ? 1.f : -1.f);
+		AVictorCharacter* Guard = GetWorld()->SpawnActor<AVictorCharacter>(GuardClass, Origin + FVector(Offset, 0.f, 0.f), FRotator::ZeroRotator, SpawnParameters);
+		if (Guard == nullptr)
+		{
+			continue;
+		}
+		Guard->SpawnDefaultController();
+		Guards.Add(Guard);
+	}
+}
+
+void UNetSoakSubsystem::DriveGuards()
+{
+	for (int32 i = 0; i < Guards.Num(); i++)
+	{
+		AVictorCharacter* Guard = Guards[i];
+		if (Guard == nullptr || Guard->bDead)
+		{
+			continue;
+		}
+		//a third of the guards stand still, the way idle guards do in a level
+		if (i % 3 == 0)
+		{
+			continue;
+		}
+		Guard->MoveRight(((Frame + i * 37) / 120) % 2 == 0 ? 1.f : -1.f);
+		if ((Frame + i * 11) % 150 == 0)
+		{
+			Guard->Jump();
+		}
+		else if ((Frame + i * 11) % 150 == 20)
+		{
+			Guard->StopJumping();
+		}
+	}
+}
+
+void UNetSoakSubsystem::FinishStep()
+{
+	if (StepFrames > 0)
+	{
+		const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+		FStepResult Result;
+		Result.Guards = Guards.Num();
+		Result.Clients = NetDriver != nullptr ? NetDriver->ClientConnections.Num() : 0;
+		Result.OutBytesPerSecond = StepOutBytes / StepTime;
+		Result.InBytesPerSecond = StepInBytes / StepTime;
+		Result.ServerFrameMs = StepServerFrameMs / StepFrames;
+		Result.MaxServerFrameMs = StepMaxServerFrameMs;
+		Results.Add(Result);
+		UE_LOG(LogVictorNetSoak, Display, TEXT("%d guards, %d clients: %.0f bytes/s out (%.0f per client), %.0f bytes/s in, server frame %.2f ms (max %.2f ms)"),
+			Result.Guards, Result.Clients, Result.OutBytesPerSecond, Result.OutBytesPerSecond / FMath::Max(Result.Clients, 1),
+			Result.InBytesPerSecond, Result.ServerFrameMs, Result.MaxServerFrameMs);
+	}
+	StepTime = 0.f;
+	StepFrames = 0;
+	StepOutBytes = 0.0;
+	StepInBytes = 0.0;
+	StepServerFrameMs = 0.0;
+	StepMaxServerFrameMs = 0.0;
+}
+
+void UNetSoakSubsystem::WriteReport() const
+{
+	TArray<FString> JsonSteps;
+	for (const FStepResult& Result : Results)
+	{
+		JsonSteps.Add(FString::Printf(TEXT("{\"scenario\":\"NetSoak\",\"guards\":%d,\"clients\":%d,\"out_bytes_per_second\":%f,\"in_bytes_per_second\":%f,\"server_frame_ms\":%f,\"max_server_frame_ms\":%f}"),
+			Result.Guards, Result.Clients, Result.OutBytesPerSecond, Result.InBytesPerSecond, Result.ServerFrameMs, Result.MaxServerFrameMs));
+	}
+	const FString ReportPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks") / TEXT("NetSoak.json");
+	if (!FFileHelper::SaveStringToFile(TEXT("[") + FString::Join(JsonSteps, TEXT(",")) + TEXT("]"), *ReportPath))
+	{
+		UE_LOG(LogVictorNetSoak, Error, TEXT("Could not write report to %s"), *ReportPath);
+	}
+}
+
+void UNetSoakSubsystem::Tick(float DeltaTime)
+{
+	DriveGuards();
+	Frame++;
+
+	//the driver updates its byte rates once per second, so they are weighted by frame time over the step
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (NetDriver != nullptr)
+	{
+		StepOutBytes += NetDriver->OutBytesPerSecond * DeltaTime;
+		StepInBytes += NetDriver->InBytesPerSecond * DeltaTime;
+	}
+	const double ServerFrameMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	StepServerFrameMs += ServerFrameMs;
+	StepMaxServerFrameMs = FMath::Max(StepMaxServerFrameMs, ServerFrameMs);
+	StepFrames++;
+	StepTime += DeltaTime;
+
+	if (StepTime < StepSeconds)
+	{
+		return;
+	}
+	FinishStep();
+	if (Guards.Num() >= MaxGuards)
+	{
+		UE_LOG(LogVictorNetSoak, Display, TEXT("Soak finished"));
+		StopSoak();
+		return;
+	}
+	SpawnGuards(FMath::Min(GuardStep, MaxGuards - Guards.Num()));
+}
+
+TStatId UNetSoakSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNetSoakSubsystem, STATGROUP_Tickables);
+}
+
+ETickableTickType UNetSoakSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
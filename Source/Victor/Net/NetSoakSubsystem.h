@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "NetSoakSubsystem.generated.h"
+
+class AVictorCharacter;
+
+/**
+ * Replication soak test: a listen server adds guards in steps and measures what each step costs.
+ *
+ * UE4Editor Victor.uproject /Game/2DSideScrollerCPP/Maps/2DSideScrollerExampleMap?listen -game -log -ExecCmds="victor.NetSoak 50 50 500 10"
+ * UE4Editor Victor.uproject 127.0.0.1 -game -log -windowed -resx=640 -resy=360     (once per local client)
+ *
+ * Guards walk and jump along the level around the player start. Every StepSeconds the bytes per second the server
+ * sent and received, the connected clients and the server's game thread time are recorded for the current guard count,
+ * then GuardStep guards are added until MaxGuards. Results are logged and written to Saved/Benchmarks/NetSoak.json.
+ */
+UCLASS()
+class VICTOR_API UNetSoakSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	/** Spawns StartGuards guards of PawnClass, or of the game mode's default pawn class if unset, and starts measuring */
+	UFUNCTION(BlueprintCallable, Category = NetSoak)
+	void StartSoak(int32 StartGuards, int32 InGuardStep, int32 InMaxGuards, float InStepSeconds, TSubclassOf<AVictorCharacter> PawnClass = nullptr);
+
+	/** Writes the results so far and destroys the guards */
+	UFUNCTION(BlueprintCallable, Category = NetSoak)
+	void StopSoak();
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return bRunning; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual ETickableTickType GetTickableTickType() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	struct FStepResult
+	{
+		int32 Guards;
+		int32 Clients;
+		double OutBytesPerSecond;
+		double InBytesPerSecond;
+		double ServerFrameMs;
+		double MaxServerFrameMs;
+	};
+
+	void SpawnGuards(int32 Num);
+
+	/** Walks every guard back and forth and lets it jump now and then */
+	void DriveGuards();
+
+	void FinishStep();
+
+	void WriteReport() const;
+
+	UPROPERTY(Transient)
+	TArray<AVictorCharacter*> Guards;
+
+	UPROPERTY(Transient)
+	TSubclassOf<AVictorCharacter> GuardClass;
+
+	TArray<FStepResult> Results;
+
+	FVector Origin = FVector::ZeroVector;
+
+	int32 GuardStep = 0;
+
+	int32 MaxGuards = 0;
+
+	float StepSeconds = 0.f;
+
+	//sums over the current step, weighted by frame time where the value is a rate
+	float StepTime = 0.f;
+
+	int32 StepFrames = 0;
+
+	double StepOutBytes = 0.0;
+
+	double StepInBytes = 0.0;
+
+	double StepServerFrameMs = 0.0;
+
+	double StepMaxServerFrameMs = 0.0;
+
+	int32 Frame = 0;
+
+	bool bRunning = false;
+};
@@ -0,0 +1,243 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GuardPerceptionSubsystem.h"
+
+#include "VictorCharacter.h"
+#include "VictorStats.h"
+#include "Async/ParallelFor.h"
+#include "Characters/CharacterUpdateSubsystem.h"
+#include "World/LevelGridSubsystem.h"
+#include "World/SpatialHash2D.h"
+
+DECLARE_CYCLE_STAT(TEXT("Guard perception"), STAT_VictorGuardPerception, STATGROUP_Victor);
+DECLARE_CYCLE_STAT(TEXT("Guard perception checks"), STAT_VictorGuardPerceptionChecks, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Perception viewers"), STAT_VictorPerceptionViewers, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Perception checks"), STAT_VictorPerceptionChecks, STATGROUP_Victor);
+
+void FGuardPerceptionKernel::Run(const FLevelCollisionGrid& Grid, const TArray<FVector2D>& ViewerEyes, const TArray<float>& ViewerFacing,
+	const TArray<FVector2D>& TargetLocations, const TArray<FPerceptionCheck>& Checks, TArray<uint8>& OutVisible, bool bParallel) const
+{
+	OutVisible.SetNumUninitialized(Checks.Num());
+	const float ViewDistanceSquared = FMath::Square(ViewDistance);
+
+	ParallelFor(Checks.Num(), [&](int32 Index)
+	{
+		const FPerceptionCheck& Check = Checks[Index];
+		const FVector2D Eye = ViewerEyes[Check.Viewer];
+		const FVector2D ToTarget = TargetLocations[Check.Target] - Eye;
+		const float DistanceSquared = ToTarget.SizeSquared();
+
+		//cone test without a sqrt: facing is +-1 along X so the dot product is just ToTarget.X * facing
+		const float ForwardDistance = ToTarget.X * ViewerFacing[Check.Viewer];
+		const bool bInCone = DistanceSquared <= ViewDistanceSquared
+			&& ForwardDistance >= 0.f
+			&& FMath::Square(ForwardDistance) >= FMath::Square(CosHalfAngle) * DistanceSquared;
+
+		OutVisible[Index] = bInCone && Grid.HasLineOfSight(Eye, TargetLocations[Check.Target]) ? 1 : 0;
+	}, !bParallel);
+}
+
+void UGuardPerceptionSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	CharacterUpdates = Cast<UCharacterUpdateSubsystem>(Collection.InitializeDependency(UCharacterUpdateSubsystem::StaticClass()));
+}
+
+void UGuardPerceptionSubsystem::Deinitialize()
+{
+	Viewers.Empty();
+	Targets.Empty();
+	VisibleTargets.Empty();
+	RoundViewers.Empty();
+	ViewerIndices.Empty();
+	TargetSet.Empty();
+	CharacterUpdates = nullptr;
+
+	Super::Deinitialize();
+}
+
+AVictorCharacter* UGuardPerceptionSubsystem::GetVisibleTarget(AVictorCharacter* Guard) const
+{
+	const TWeakObjectPtr<AVictorCharacter>* Target = VisibleTargets.Find(Guard);
+	return Target != nullptr ? Target->Get() : nullptr;
+}
+
+void UGuardPerceptionSubsystem::GatherViewersAndTargets()
+{
+	Viewers.Reset();
+	Targets.Reset();
+	ViewerEyes.Reset();
+	ViewerFacing.Reset();
+	TargetLocations.Reset();
+	ViewerIndices.Reset();
+	TargetSet.Reset();
+
+	if (CharacterUpdates == nullptr)
+	{
+		return;
+	}
+
+	for (AVictorCharacter* Character : CharacterUpdates->GetCharacters())
+	{
+		if (Character->GetTeam() == ETeam::ET_Guards)
+		{
+			if (!Character->bDead)
+			{
+				const FVector Location = Character->GetActorLocation();
+				ViewerIndices.Add(Character, Viewers.Add(Character));
+				ViewerEyes.Add(ToPlane2D(Location) + FVector2D(0.f, EyeHeight));
+				ViewerFacing.Add(Character->GetActorForwardVector().X >= 0.f ? 1.f : -1.f);
+			}
+		}
+		else if (Character->IsPlayerControlled() && Character->CanBeSeen())
+		{
+			Targets.Add(Character);
+			TargetLocations.Add(ToPlane2D(Character->GetActorLocation()));
+			TargetSet.Add(Character);
+		}
+	}
+
+	//guards that died and targets that were hidden or possessed away lose their pairing right now,
+	//they would not be checked again otherwise
+	for (auto It = VisibleTargets.CreateIterator(); It; ++It)
+	{
+		AVictorCharacter* Guard = It.Key().Get();
+		AVictorCharacter* Target = It.Value().Get();
+		if (Guard == nullptr || Target == nullptr || !ViewerIndices.Contains(Guard) || !TargetSet.Contains(Target))
+		{
+			It.RemoveCurrent();
+			if (Guard != nullptr && !Guard->IsPendingKill())
+			{
+				OnTargetLost.Broadcast(Guard, Target);
+			}
+		}
+	}
+
+	SET_DWORD_STAT(STAT_VictorPerceptionViewers, Viewers.Num());
+}
+
+void UGuardPerceptionSubsystem::BuildChecks()
+{
+	Checks.Reset();
+	const int32 NumTargets = Targets.Num();
+	if (Viewers.Num() == 0 || NumTargets == 0)
+	{
+		RoundViewers.Reset();
+		RoundCursor = 0;
+		return;
+	}
+
+	if (RoundCursor >= RoundViewers.Num())
+	{
+		//a new round with the viewers there are now; ones added later wait for the next round
+		RoundViewers.Reset(Viewers.Num());
+		for (AVictorCharacter* Viewer : Viewers)
+		{
+			RoundViewers.Add(Viewer);
+		}
+		RoundCursor = 0;
+	}
+
+	//a viewer is checked against every target at once, so the budget fits at least one viewer
+	const int32 Budget = MaxChecksPerFrame > 0 ? FMath::Max(MaxChecksPerFrame, NumTargets) : MAX_int32;
+	while (RoundCursor < RoundViewers.Num() && Checks.Num() + NumTargets <= Budget)
+	{
+		//viewers that died or were possessed since the round started are dropped
+		const int32* Viewer = ViewerIndices.Find(RoundViewers[RoundCursor++].Get());
+		if (Viewer == nullptr)
+		{
+			continue;
+		}
+		for (int32 Target = 0; Target < NumTargets; Target++)
+		{
+			Checks.Add({ *Viewer, Target });
+		}
+	}
+
+	SET_DWORD_STAT(STAT_VictorPerceptionChecks, Checks.Num());
+}
+
+void UGuardPerceptionSubsystem::PublishResults()
+{
+	for (int32 i = 0; i < Checks.Num(); i++)
+	{
+		AVictorCharacter* Guard = Viewers[Checks[i].Viewer];
+		AVictorCharacter* Target = Targets[Checks[i].Target];
+		AVictorCharacter* Current = GetVisibleTarget(Guard);
+		if (CheckResults[i] != 0)
+		{
+			//a guard keeps tracking the target it saw first
+			if (Current == nullptr)
+			{
+				SetVisibleTarget(Guard, Target);
+			}
+		}
+		else if (Current == Target)
+		{
+			SetVisibleTarget(Guard, nullptr);
+		}
+	}
+}
+
+void UGuardPerceptionSubsystem::SetVisibleTarget(AVictorCharacter* Guard, AVictorCharacter* Target)
+{
+	if (Target != nullptr)
+	{
+		VisibleTargets.Add(Guard, Target);
+		OnTargetSpotted.Broadcast(Guard, Target);
+	}
+	else
+	{
+		TWeakObjectPtr<AVictorCharacter> Lost;
+		if (VisibleTargets.RemoveAndCopyValue(Guard, Lost))
+		{
+			OnTargetLost.Broadcast(Guard, Lost.Get());
+		}
+	}
+}
+
+void UGuardPerceptionSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorGuardPerception);
+
+	GatherViewersAndTargets();
+	BuildChecks();
+	if (Checks.Num() == 0)
+	{
+		return;
+	}
+
+	ULevelGridSubsystem* LevelGrid = GetWorld()->GetSubsystem<ULevelGridSubsystem>();
+	if (LevelGrid == nullptr)
+	{
+		return;
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_VictorGuardPerceptionChecks);
+		FGuardPerceptionKernel Kernel;
+		Kernel.ViewDistance = ViewDistance;
+		Kernel.CosHalfAngle = FMath::Cos(FMath::DegreesToRadians(ViewHalfAngle));
+		Kernel.Run(LevelGrid->GetCollisionGrid(), ViewerEyes, ViewerFacing, TargetLocations, Checks, CheckResults, bRunOnWorkerThreads);
+	}
+
+	PublishResults();
+}
+
+bool UGuardPerceptionSubsystem::IsTickable() const
+{
+	//with no characters there is nothing to see, but pairings left over still have to be lost
+	return (CharacterUpdates != nullptr && CharacterUpdates->Num() > 0) || VisibleTargets.Num() > 0;
+}
+
+TStatId UGuardPerceptionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGuardPerceptionSubsystem, STATGROUP_Tickables);
+}
+
+ETickableTickType UGuardPerceptionSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "GuardPerceptionSubsystem.generated.h"
+
+class AVictorCharacter;
+class FLevelCollisionGrid;
+class UCharacterUpdateSubsystem;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnGuardPerceptionChanged, AVictorCharacter*, Guard, AVictorCharacter*, Target);
+
+/** One viewer/target pair to test this frame */
+struct FPerceptionCheck
+{
+	int32 Viewer;
+	int32 Target;
+};
+
+/**
+ * View cone and line of sight tests against the level collision grid.
+ * Only reads its inputs, so checks run on worker threads.
+ */
+struct VICTOR_API FGuardPerceptionKernel
+{
+	float ViewDistance = 1200.f;
+
+	float CosHalfAngle = 0.5f;
+
+	/** Writes 1 to OutVisible for every check whose target is inside the viewer's cone and not occluded */
+	void Run(const FLevelCollisionGrid& Grid, const TArray<FVector2D>& ViewerEyes, const TArray<float>& ViewerFacing,
+		const TArray<FVector2D>& TargetLocations, const TArray<FPerceptionCheck>& Checks, TArray<uint8>& OutVisible, bool bParallel) const;
+};
+
+/**
+ * Decides which guards can see the player.
+ * Once per frame every living character whose GetTeam() is ET_Guards is gathered as a viewer and every player
+ * controlled character that CanBeSeen() as a target. Viewers are checked against every target in rounds: a round
+ * starts with the viewers there are and spends up to MaxChecksPerFrame pairs a frame until each of them was checked,
+ * so viewers and targets coming and going don't make the round skip anyone. Checks run in parallel and the results
+ * are applied on the game thread in one batch.
+ */
+UCLASS(config=Game)
+class VICTOR_API UGuardPerceptionSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/** Target the guard currently sees, nullptr if none */
+	UFUNCTION(BlueprintPure, Category = Perception)
+	AVictorCharacter* GetVisibleTarget(AVictorCharacter* Guard) const;
+
+	UFUNCTION(BlueprintPure, Category = Perception)
+	bool CanGuardSee(AVictorCharacter* Guard, AVictorCharacter* Target) const { return Guard != nullptr && GetVisibleTarget(Guard) == Target; }
+
+	UPROPERTY(BlueprintAssignable, Category = Perception)
+	FOnGuardPerceptionChanged OnTargetSpotted;
+
+	UPROPERTY(BlueprintAssignable, Category = Perception)
+	FOnGuardPerceptionChanged OnTargetLost;
+
+	UPROPERTY(Config, EditAnywhere, Category = Perception)
+	float ViewDistance = 1200.f;
+
+	/** Half of the view cone angle in degrees */
+	UPROPERTY(Config, EditAnywhere, Category = Perception, meta = (ClampMin = "0", ClampMax = "90"))
+	float ViewHalfAngle = 60.f;
+
+	/** Height of the guard's eyes above the actor location */
+	UPROPERTY(Config, EditAnywhere, Category = Perception)
+	float EyeHeight = 60.f;
+
+	/** Budget of viewer/target pairs tested per frame. Pairs over budget are tested on the following frames */
+	UPROPERTY(Config, EditAnywhere, Category = Perception)
+	int32 MaxChecksPerFrame = 1024;
+
+	UPROPERTY(Config, EditAnywhere, Category = Perception)
+	bool bRunOnWorkerThreads = true;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual ETickableTickType GetTickableTickType() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	void GatherViewersAndTargets();
+
+	void BuildChecks();
+
+	void PublishResults();
+
+	void SetVisibleTarget(AVictorCharacter* Guard, AVictorCharacter* Target);
+
+	UPROPERTY(Transient)
+	TArray<AVictorCharacter*> Viewers;
+
+	UPROPERTY(Transient)
+	TArray<AVictorCharacter*> Targets;
+
+	TArray<FVector2D> ViewerEyes;
+
+	TArray<float> ViewerFacing;
+
+	TArray<FVector2D> TargetLocations;
+
+	TArray<FPerceptionCheck> Checks;
+
+	TArray<uint8> CheckResults;
+
+	//viewers of the current round, checked from RoundCursor on. Weak, they may be destroyed before their turn
+	TArray<TWeakObjectPtr<AVictorCharacter>> RoundViewers;
+
+	int32 RoundCursor = 0;
+
+	//guard -> target it currently sees. Weak so destroyed characters neither stay alive nor corrupt the map
+	TMap<TWeakObjectPtr<AVictorCharacter>, TWeakObjectPtr<AVictorCharacter>> VisibleTargets;
+
+	//this frame's viewers -> index in Viewers, only valid during Tick
+	TMap<AVictorCharacter*, int32> ViewerIndices;
+
+	TSet<AVictorCharacter*> TargetSet;
+
+	UPROPERTY(Transient)
+	UCharacterUpdateSubsystem* CharacterUpdates = nullptr;
+};
@@ -0,0 +1,200 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InputRecording.h"
+
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/VictorVarInt.h"
+
+namespace
+{
+	const uint32 RecordingMagic = 0x504E4956; //"VINP"
+
+	const uint32 RecordingVersion = 1;
+
+	//event codes after EVictorInputEvent
+	const uint8 CursorCode = 0xFD;
+
+	const uint8 CheckpointCode = 0xFE;
+
+	const uint8 EndFrameCode = 0xFF;
+
+	int8 QuantizeAxis(float Value)
+	{
+		return (int8)FMath::RoundToInt(FMath::Clamp(Value, -1.f, 1.f) * 127.f);
+	}
+}
+
+void FInputRecording::Reset()
+{
+	Data.Reset();
+	NumFrames = 0;
+	LastDeltaMicroseconds = 0;
+	LastMoveRight = 0;
+	LastCursor = FIntPoint::ZeroValue;
+	LastCheckpoint = FIntPoint::ZeroValue;
+}
+
+void FInputRecording::BeginFrame(float DeltaTime)
+{
+	const int32 DeltaMicroseconds = FMath::RoundToInt(DeltaTime * 1000000.f);
+	WriteVarInt(DeltaMicroseconds - LastDeltaMicroseconds);
+	LastDeltaMicroseconds = DeltaMicroseconds;
+	NumFrames++;
+}
+
+void FInputRecording::AddEvent(EVictorInputEvent Event, float Value)
+{
+	if (Event == EVictorInputEvent::MoveRight)
+	{
+		const int8 Quantized = QuantizeAxis(Value);
+		if (Quantized == LastMoveRight)
+		{
+			return;
+		}
+		LastMoveRight = Quantized;
+		Data.Add((uint8)Event);
+		Data.Add((uint8)Quantized);
+	}
+	else
+	{
+		Data.Add((uint8)Event);
+	}
+}
+
+void FInputRecording::AddCursor(const FVector2D& Location)
+{
+	const FIntPoint Cursor(FMath::RoundToInt(Location.X), FMath::RoundToInt(Location.Y));
+	if (Cursor == LastCursor)
+	{
+		return;
+	}
+	Data.Add(CursorCode);
+	WriteVarInt(Cursor.X - LastCursor.X);
+	WriteVarInt(Cursor.Y - LastCursor.Y);
+	LastCursor = Cursor;
+}
+
+void FInputRecording::AddCheckpoint(const FVector& Location)
+{
+	const FIntPoint Checkpoint = ToCheckpoint(Location);
+	Data.Add(CheckpointCode);
+	WriteVarInt(Checkpoint.X - LastCheckpoint.X);
+	WriteVarInt(Checkpoint.Y - LastCheckpoint.Y);
+	LastCheckpoint = Checkpoint;
+}
+
+void FInputRecording::EndFrame()
+{
+	Data.Add(EndFrameCode);
+}
+
+bool FInputRecording::ReadFrame(int32& Cursor, FInputFrame& OutFrame) const
+{
+	int32 DeltaDifference = 0;
+	if (!ReadVarInt(Cursor, DeltaDifference))
+	{
+		return false;
+	}
+	OutFrame.DeltaMicroseconds += DeltaDifference;
+	OutFrame.DeltaTime = FMath::Max(OutFrame.DeltaMicroseconds, 0) / 1000000.f;
+	OutFrame.Events.Reset();
+	OutFrame.bHasCheckpoint = false;
+
+	while (Data.IsValidIndex(Cursor))
+	{
+		const uint8 Code = Data[Cursor++];
+		if (Code == EndFrameCode)
+		{
+			return true;
+		}
+		if (Code == CursorCode || Code == CheckpointCode)
+		{
+			int32 DeltaX = 0;
+			int32 DeltaZ = 0;
+			if (!ReadVarInt(Cursor, DeltaX) || !ReadVarInt(Cursor, DeltaZ))
+			{
+				return false;
+			}
+			if (Code == CursorCode)
+			{
+				OutFrame.Cursor += FIntPoint(DeltaX, DeltaZ);
+			}
+			else
+			{
+				OutFrame.Checkpoint += FIntPoint(DeltaX, DeltaZ);
+				OutFrame.bHasCheckpoint = true;
+			}
+		}
+		else if (Code == (uint8)EVictorInputEvent::MoveRight)
+		{
+			if (!Data.IsValidIndex(Cursor))
+			{
+				return false;
+			}
+			OutFrame.Events.Emplace(EVictorInputEvent::MoveRight, (int8)Data[Cursor++] / 127.f);
+		}
+		else if (Code < (uint8)EVictorInputEvent::Num)
+		{
+			OutFrame.Events.Emplace((EVictorInputEvent)Code, 0.f);
+		}
+		else
+		{
+			return false;
+		}
+	}
+	return false;
+}
+
+bool FInputRecording::SaveToFile(const FString& FileName) const
+{
+	TArray<uint8> FileData;
+	FMemoryWriter Writer(FileData);
+	uint32 Magic = RecordingMagic;
+	uint32 Version = RecordingVersion;
+	int32 FrameCount = NumFrames;
+	Writer << Magic << Version << FrameCount;
+	FileData.Append(Data);
+	return FFileHelper::SaveArrayToFile(FileData, *FileName);
+}
+
+bool FInputRecording::LoadFromFile(const FString& FileName)
+{
+	Reset();
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *FileName))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(FileData);
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	int32 FrameCount = 0;
+	Reader << Magic << Version << FrameCount;
+	if (Reader.IsError() || Magic != RecordingMagic || Version != RecordingVersion)
+	{
+		return false;
+	}
+	NumFrames = FrameCount;
+	Data.Append(FileData.GetData() + Reader.Tell(), FileData.Num() - Reader.Tell());
+	return true;
+}
+
+FString FInputRecording::GetRecordingPath(const FString& Name)
+{
+	return FPaths::ProjectSavedDir() / TEXT("InputRecordings") / Name + TEXT(".vinput");
+}
+
+void FInputRecording::WriteVarInt(int32 Value)
+{
+	VictorVarInt::Write(Data, Value);
+}
+
+bool FInputRecording::ReadVarInt(int32& Cursor, int32& OutValue) const
+{
+	return VictorVarInt::Read(Data, Cursor, OutValue);
+}
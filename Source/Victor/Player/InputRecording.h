@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Player inputs bound in AVictorCharacter::SetupPlayerInputComponent */
+enum class EVictorInputEvent : uint8
+{
+	MoveRight,
+	JumpPressed,
+	JumpReleased,
+	Interact,
+	PossessPressed,
+	PossessReleased,
+	Attack,
+	Num
+};
+
+/** Everything recorded for one frame. Reuse the same frame when reading, values are delta encoded against the previous one */
+struct FInputFrame
+{
+	float DeltaTime = 0.f;
+
+	int32 DeltaMicroseconds = 0;
+
+	TArray<TPair<EVictorInputEvent, float>, TInlineAllocator<4>> Events;
+
+	//mouse cursor on the character plane in whole units, kept from earlier frames when it didn't move
+	FIntPoint Cursor = FIntPoint::ZeroValue;
+
+	bool bHasCheckpoint = false;
+
+	//pawn location on the XZ plane in whole units, compared on replay to find divergence
+	FIntPoint Checkpoint = FIntPoint::ZeroValue;
+};
+
+/**
+ * Compact binary stream of player input, one record per frame.
+ * A frame is its delta time in microseconds (as a zigzag varint difference to the previous frame), its input
+ * events and an end marker, so a frame without input is usually two bytes. The MoveRight axis is only written
+ * when its quantized value changes; replay holds the last value. The cursor on the character plane, which picks
+ * the body to possess, is written the same way. Every CheckpointInterval frames the pawn location is written too,
+ * delta encoded against the previous checkpoint.
+ */
+class VICTOR_API FInputRecording
+{
+public:
+	static constexpr int32 CheckpointInterval = 30;
+
+	void Reset();
+
+	/** Starts a new frame, events added until EndFrame belong to it */
+	void BeginFrame(float DeltaTime);
+
+	void AddEvent(EVictorInputEvent Event, float Value = 0.f);
+
+	/** Writes the cursor location if it moved by at least a unit */
+	void AddCursor(const FVector2D& Location);
+
+	void AddCheckpoint(const FVector& Location);
+
+	void EndFrame();
+
+	/** Reads the frame at Cursor and advances it, false at the end of the recording */
+	bool ReadFrame(int32& Cursor, FInputFrame& OutFrame) const;
+
+	int32 GetNumFrames() const { return NumFrames; }
+
+	int32 GetNumBytes() const { return Data.Num(); }
+
+	bool SaveToFile(const FString& FileName) const;
+
+	bool LoadFromFile(const FString& FileName);
+
+	/** Saved/InputRecordings/<Name>.vinput */
+	static FString GetRecordingPath(const FString& Name);
+
+	static FIntPoint ToCheckpoint(const FVector& Location)
+	{
+		return FIntPoint(FMath::RoundToInt(Location.X), FMath::RoundToInt(Location.Z));
+	}
+
+private:
+	void WriteVarInt(int32 Value);
+
+	bool ReadVarInt(int32& Cursor, int32& OutValue) const;
+
+	TArray<uint8> Data;
+
+	int32 NumFrames = 0;
+
+	//state of the delta encoding while writing
+	int32 LastDeltaMicroseconds = 0;
+
+	int8 LastMoveRight = 0;
+
+	FIntPoint LastCursor = FIntPoint::ZeroValue;
+
+	FIntPoint LastCheckpoint = FIntPoint::ZeroValue;
+};
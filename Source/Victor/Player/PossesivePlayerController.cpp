@@ -3,14 +3,16 @@
 
 #include "PossesivePlayerController.h"
 
-#include "Kismet/GameplayStatics.h"
+#include "VictorCharacter.h"
+#include "Audio/GameplayAudioSubsystem.h"
+#include "Possession/PossessionTargetSubsystem.h"
+#include "Misc/App.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogInputRecording, Log, All);
 
 void APossesivePlayerController::OnChangedBodies()
 {
-    if (PossesSound != nullptr)
-    {
-        UGameplayStatics::PlaySound2D(GetWorld(), PossesSound);
-    }
+    GetWorld()->GetSubsystem<UGameplayAudioSubsystem>()->PlaySound2D(PossesSound, EGameplaySoundCategory::UI);
 }
 
 void APossesivePlayerController::BeginPlay()
@@ -22,4 +24,188 @@ void APossesivePlayerController::BeginPlay()
     SetInputMode(FInputModeGameAndUI());
 
     bShowMouseCursor = true;
-}
\ No newline at end of file
+}
+
+void APossesivePlayerController::PlayerTick(float DeltaTime)
+{
+    if (bRecordingInput)
+    {
+        InputRecording.BeginFrame(DeltaTime);
+    }
+
+    //live input reaches the pawn in here, through HandleLiveInput
+    Super::PlayerTick(DeltaTime);
+
+    if (bRecordingInput)
+    {
+        FVector2D CursorLocation;
+        if (GetPawn() != nullptr && UPossessionTargetSubsystem::DeprojectCursorToPlane(this, GetPawn()->GetActorLocation().Y, CursorLocation))
+        {
+            InputRecording.AddCursor(CursorLocation);
+        }
+        if (GetPawn() != nullptr && InputRecording.GetNumFrames() % FInputRecording::CheckpointInterval == 0)
+        {
+            InputRecording.AddCheckpoint(GetPawn()->GetActorLocation());
+        }
+        InputRecording.EndFrame();
+    }
+    else if (bReplayingInput)
+    {
+        StepInputReplay();
+    }
+}
+
+void APossesivePlayerController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    StopInputReplay();
+    bRecordingInput = false;
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void APossesivePlayerController::StartInputRecording()
+{
+    StopInputReplay();
+    InputRecording.Reset();
+    bRecordingInput = true;
+}
+
+void APossesivePlayerController::StopInputRecording(const FString& Name)
+{
+    if (!bRecordingInput)
+    {
+        return;
+    }
+    bRecordingInput = false;
+
+    const FString FileName = FInputRecording::GetRecordingPath(Name);
+    if (InputRecording.SaveToFile(FileName))
+    {
+        UE_LOG(LogInputRecording, Display, TEXT("Saved %d frames of input (%d bytes) to %s"), InputRecording.GetNumFrames(), InputRecording.GetNumBytes(), *FileName);
+    }
+    else
+    {
+        UE_LOG(LogInputRecording, Error, TEXT("Could not save input recording to %s"), *FileName);
+    }
+}
+
+bool APossesivePlayerController::StartInputReplay(const FString& Name)
+{
+    StopInputReplay();
+    bRecordingInput = false;
+
+    const FString FileName = FInputRecording::GetRecordingPath(Name);
+    if (!InputRecording.LoadFromFile(FileName))
+    {
+        UE_LOG(LogInputRecording, Error, TEXT("Could not load input recording %s"), *FileName);
+        return false;
+    }
+
+    ReplayCursor = 0;
+    ReplayedFrame = FInputFrame();
+    ReplayedMoveRight = 0.f;
+    ReplayedFrames = 0;
+    ReplayDivergences = 0;
+    bReplayingInput = true;
+
+    //the engine steps by the recorded frame times, set one frame ahead in StepInputReplay
+    bUsedFixedTimeStep = FApp::UseFixedTimeStep();
+    PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+    FInputFrame FirstFrame;
+    int32 PeekCursor = 0;
+    if (InputRecording.ReadFrame(PeekCursor, FirstFrame))
+    {
+        NextReplayDeltaTime = FirstFrame.DeltaTime;
+        FApp::SetUseFixedTimeStep(true);
+        FApp::SetFixedDeltaTime(NextReplayDeltaTime);
+    }
+    return true;
+}
+
+void APossesivePlayerController::StopInputReplay()
+{
+    if (!bReplayingInput)
+    {
+        return;
+    }
+    bReplayingInput = false;
+    FApp::SetUseFixedTimeStep(bUsedFixedTimeStep);
+    FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+
+    UE_LOG(LogInputRecording, Display, TEXT("Replayed %d of %d frames, %d diverged"), ReplayedFrames, InputRecording.GetNumFrames(), ReplayDivergences);
+}
+
+bool APossesivePlayerController::HandleLiveInput(EVictorInputEvent Event, float Value)
+{
+    if (bReplayingInput)
+    {
+        return false;
+    }
+    if (bRecordingInput)
+    {
+        InputRecording.AddEvent(Event, Value);
+    }
+    return true;
+}
+
+bool APossesivePlayerController::GetCursorPlaneLocation(float PlaneY, FVector2D& OutLocation) const
+{
+    if (bReplayingInput)
+    {
+        OutLocation = FVector2D(ReplayedFrame.Cursor);
+        return true;
+    }
+    return UPossessionTargetSubsystem::DeprojectCursorToPlane(this, PlaneY, OutLocation);
+}
+
+bool APossesivePlayerController::StepInputReplay()
+{
+    if (!bReplayingInput)
+    {
+        return false;
+    }
+    if (!InputRecording.ReadFrame(ReplayCursor, ReplayedFrame))
+    {
+        StopInputReplay();
+        return false;
+    }
+    ReplayedFrames++;
+
+    AVictorCharacter* Character = Cast<AVictorCharacter>(GetPawn());
+    if (Character != nullptr)
+    {
+        for (const TPair<EVictorInputEvent, float>& Event : ReplayedFrame.Events)
+        {
+            if (Event.Key == EVictorInputEvent::MoveRight)
+            {
+                ReplayedMoveRight = Event.Value;
+            }
+            else
+            {
+                Character->ApplyInputEvent(Event.Key, Event.Value);
+            }
+        }
+        Character->ApplyInputEvent(EVictorInputEvent::MoveRight, ReplayedMoveRight);
+    }
+
+    if (ReplayedFrame.bHasCheckpoint && GetPawn() != nullptr)
+    {
+        const FIntPoint Location = FInputRecording::ToCheckpoint(GetPawn()->GetActorLocation());
+        const float Distance = FVector2D(Location - ReplayedFrame.Checkpoint).Size();
+        if (Distance > DivergenceTolerance)
+        {
+            ReplayDivergences++;
+            UE_LOG(LogInputRecording, Warning, TEXT("Replay diverged at frame %d: pawn is %.0f units from the recording"), ReplayedFrames, Distance);
+            OnInputReplayDiverged.Broadcast(ReplayedFrames, Distance);
+        }
+    }
+
+    FInputFrame NextFrame = ReplayedFrame;
+    int32 PeekCursor = ReplayCursor;
+    if (InputRecording.ReadFrame(PeekCursor, NextFrame))
+    {
+        NextReplayDeltaTime = NextFrame.DeltaTime;
+        FApp::SetFixedDeltaTime(NextReplayDeltaTime);
+    }
+    return true;
+}
@@ -4,8 +4,11 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerController.h"
+#include "Player/InputRecording.h"
 #include "PossesivePlayerController.generated.h"
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnInputReplayDiverged, int32, Frame, float, Distance);
+
 /**
  * 
  */
@@ -22,4 +25,77 @@ public:
 	virtual void OnChangedBodies();
 	
 	virtual void BeginPlay() override;
-};
\ No newline at end of file
+
+	virtual void PlayerTick(float DeltaTime) override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Records the player's input from the next frame on */
+	UFUNCTION(Exec, BlueprintCallable, Category = InputRecording)
+	void StartInputRecording();
+
+	/** Writes the recording to Saved/InputRecordings/<Name>.vinput */
+	UFUNCTION(Exec, BlueprintCallable, Category = InputRecording)
+	void StopInputRecording(const FString& Name);
+
+	/** Plays Saved/InputRecordings/<Name>.vinput back with the recorded frame times, live input is ignored meanwhile */
+	UFUNCTION(Exec, BlueprintCallable, Category = InputRecording)
+	bool StartInputReplay(const FString& Name);
+
+	UFUNCTION(Exec, BlueprintCallable, Category = InputRecording)
+	void StopInputReplay();
+
+	UFUNCTION(BlueprintPure, Category = InputRecording)
+	bool IsReplayingInput() const { return bReplayingInput; }
+
+	/**
+	 * Feeds the next recorded frame to the pawn, false once the recording is over.
+	 * Called from PlayerTick; a world ticked by hand, like the benchmark commandlet's, calls it itself before each tick.
+	 */
+	bool StepInputReplay();
+
+	/** Delta time of the frame StepInputReplay plays next */
+	float GetReplayDeltaTime() const { return NextReplayDeltaTime; }
+
+	int32 GetReplayDivergences() const { return ReplayDivergences; }
+
+	/**
+	 * Called by the pawn for every live input before it acts on it.
+	 * Records the input while recording; returns false while replaying, the pawn must then ignore the input.
+	 */
+	bool HandleLiveInput(EVictorInputEvent Event, float Value);
+
+	/** Mouse cursor on the plane Y = PlaneY, the recorded one while replaying */
+	bool GetCursorPlaneLocation(float PlaneY, FVector2D& OutLocation) const;
+
+	/** Broadcast when the pawn is further than DivergenceTolerance from where it was at a recorded checkpoint */
+	UPROPERTY(BlueprintAssignable, Category = InputRecording)
+	FOnInputReplayDiverged OnInputReplayDiverged;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = InputRecording)
+	float DivergenceTolerance = 16.f;
+
+protected:
+	FInputRecording InputRecording;
+
+	bool bRecordingInput = false;
+
+	bool bReplayingInput = false;
+
+	int32 ReplayCursor = 0;
+
+	FInputFrame ReplayedFrame;
+
+	//MoveRight is only recorded when it changes, replay holds it
+	float ReplayedMoveRight = 0.f;
+
+	int32 ReplayedFrames = 0;
+
+	int32 ReplayDivergences = 0;
+
+	float NextReplayDeltaTime = 0.f;
+
+	bool bUsedFixedTimeStep = false;
+
+	double PreviousFixedDeltaTime = 0.0;
+};
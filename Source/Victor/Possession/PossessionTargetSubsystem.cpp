@@ -0,0 +1,170 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PossessionTargetSubsystem.h"
+
+#include "VictorCharacter.h"
+#include "VictorStats.h"
+#include "Characters/CharacterUpdateSubsystem.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "Player/PossesivePlayerController.h"
+#include "World/LevelCollisionGrid.h"
+#include "World/LevelGridSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Possession target update"), STAT_VictorPossessionTargetUpdate, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Possession candidates"), STAT_VictorPossessionCandidates, STATGROUP_Victor);
+
+//a bit wider than the tallest capsule so most characters stay within one cell column
+static const float PossessionHashCellSize = 256.f;
+
+static FVector2D GetCapsuleHalfExtent(const AVictorCharacter* Character)
+{
+	const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+	return FVector2D(Capsule->GetScaledCapsuleRadius(), Capsule->GetScaledCapsuleHalfHeight());
+}
+
+UPossessionTargetSubsystem::UPossessionTargetSubsystem()
+	: Hash(PossessionHashCellSize)
+{
+}
+
+void UPossessionTargetSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	UCharacterUpdateSubsystem* Characters = Cast<UCharacterUpdateSubsystem>(Collection.InitializeDependency(UCharacterUpdateSubsystem::StaticClass()));
+	if (Characters != nullptr)
+	{
+		RegisteredHandle = Characters->OnCharacterRegistered.AddUObject(this, &UPossessionTargetSubsystem::AddCharacter);
+		UnregisteredHandle = Characters->OnCharacterUnregistered.AddUObject(this, &UPossessionTargetSubsystem::RemoveCharacter);
+		for (AVictorCharacter* Character : Characters->GetCharacters())
+		{
+			AddCharacter(Character);
+		}
+	}
+}
+
+void UPossessionTargetSubsystem::Deinitialize()
+{
+	if (UCharacterUpdateSubsystem* Characters = GetWorld()->GetSubsystem<UCharacterUpdateSubsystem>())
+	{
+		Characters->OnCharacterRegistered.Remove(RegisteredHandle);
+		Characters->OnCharacterUnregistered.Remove(UnregisteredHandle);
+	}
+	Hash.Reset();
+	TrackedCharacters.Empty();
+	Possessors.Empty();
+
+	Super::Deinitialize();
+}
+
+AVictorCharacter* UPossessionTargetSubsystem::PickAtLocation(const FVector2D& Location, const AVictorCharacter* Ignore) const
+{
+	//the cursor trace this replaces stopped at walls, so a body the possessor can't see past the level is not picked
+	const FLevelCollisionGrid* Grid = nullptr;
+	FVector2D ViewLocation = FVector2D::ZeroVector;
+	if (Ignore != nullptr)
+	{
+		const FLevelCollisionGrid& CollisionGrid = GetWorld()->GetSubsystem<ULevelGridSubsystem>()->GetCollisionGrid();
+		Grid = CollisionGrid.IsBuilt() ? &CollisionGrid : nullptr;
+		ViewLocation = ToPlane2D(Ignore->GetActorLocation());
+	}
+
+	AVictorCharacter* Target = nullptr;
+	Hash.FindAtPoint(Location, [Ignore, Grid, &ViewLocation](AVictorCharacter* Candidate)
+	{
+		INC_DWORD_STAT(STAT_VictorPossessionCandidates);
+		return Candidate != Ignore && Candidate->CanBePossesed()
+			&& (Grid == nullptr || Grid->HasLineOfSight(ViewLocation, ToPlane2D(Candidate->GetActorLocation())));
+	}, Target);
+	return Target;
+}
+
+AVictorCharacter* UPossessionTargetSubsystem::PickUnderCursor(APlayerController* PlayerController, const AVictorCharacter* Ignore) const
+{
+	const float PlaneY = Ignore != nullptr ? Ignore->GetActorLocation().Y : 0.f;
+	FVector2D CursorLocation;
+	//a replaying controller answers with the recorded cursor
+	const APossesivePlayerController* PossesivePlayerController = Cast<APossesivePlayerController>(PlayerController);
+	const bool bHasCursor = PossesivePlayerController != nullptr
+		? PossesivePlayerController->GetCursorPlaneLocation(PlaneY, CursorLocation)
+		: DeprojectCursorToPlane(PlayerController, PlaneY, CursorLocation);
+	return bHasCursor ? PickAtLocation(CursorLocation, Ignore) : nullptr;
+}
+
+bool UPossessionTargetSubsystem::DeprojectCursorToPlane(const APlayerController* PlayerController, float PlaneY, FVector2D& OutLocation)
+{
+	FVector WorldLocation;
+	FVector WorldDirection;
+	if (PlayerController == nullptr || !PlayerController->DeprojectMousePositionToWorld(WorldLocation, WorldDirection))
+	{
+		return false;
+	}
+
+	// The side view camera looks along Y, so intersect the cursor ray with the plane the characters are on
+	if (!FMath::IsNearlyZero(WorldDirection.Y))
+	{
+		WorldLocation += WorldDirection * ((PlaneY - WorldLocation.Y) / WorldDirection.Y);
+	}
+	OutLocation = ToPlane2D(WorldLocation);
+	return true;
+}
+
+void UPossessionTargetSubsystem::BeginTargeting(AVictorCharacter* Possessor)
+{
+	Possessors.AddUnique(Possessor);
+}
+
+void UPossessionTargetSubsystem::EndTargeting(AVictorCharacter* Possessor)
+{
+	Possessors.RemoveSingleSwap(Possessor);
+}
+
+void UPossessionTargetSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorPossessionTargetUpdate);
+
+	UpdateHash();
+
+	for (AVictorCharacter* Possessor : Possessors)
+	{
+		Possessor->PossessTarget = PickUnderCursor(Cast<APlayerController>(Possessor->GetController()), Possessor);
+	}
+}
+
+bool UPossessionTargetSubsystem::IsTickable() const
+{
+	return TrackedCharacters.Num() > 0;
+}
+
+TStatId UPossessionTargetSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPossessionTargetSubsystem, STATGROUP_Tickables);
+}
+
+ETickableTickType UPossessionTargetSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
+
+void UPossessionTargetSubsystem::AddCharacter(AVictorCharacter* Character)
+{
+	TrackedCharacters.Add(Character);
+	Hash.Add(Character, ToPlane2D(Character->GetActorLocation()), GetCapsuleHalfExtent(Character));
+}
+
+void UPossessionTargetSubsystem::RemoveCharacter(AVictorCharacter* Character)
+{
+	TrackedCharacters.RemoveSingleSwap(Character);
+	Possessors.RemoveSingleSwap(Character);
+	Hash.Remove(Character);
+}
+
+void UPossessionTargetSubsystem::UpdateHash()
+{
+	for (AVictorCharacter* Character : TrackedCharacters)
+	{
+		Hash.Move(Character, ToPlane2D(Character->GetActorLocation()));
+	}
+}
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "World/SpatialHash2D.h"
+#include "PossessionTargetSubsystem.generated.h"
+
+class AVictorCharacter;
+class APlayerController;
+
+/**
+ * Keeps possessable characters in a 2D spatial hash so the body under the cursor can be picked without a physics trace.
+ * While a character holds the Possess key its target is re-picked every frame, so Possess() can swap bodies
+ * on the frame the timer fires.
+ */
+UCLASS()
+class VICTOR_API UPossessionTargetSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	UPossessionTargetSubsystem();
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/**
+	 * Possessable character whose capsule contains the point on the XZ plane, closest to the capsule center wins.
+	 * With Ignore, the possessor, only characters it has line of sight to through the level collision grid count.
+	 */
+	AVictorCharacter* PickAtLocation(const FVector2D& Location, const AVictorCharacter* Ignore) const;
+
+	/** Possessable character under the controller's mouse cursor */
+	AVictorCharacter* PickUnderCursor(APlayerController* PlayerController, const AVictorCharacter* Ignore) const;
+
+	/** Where the mouse cursor ray meets the plane Y = PlaneY, as a point on the XZ plane */
+	static bool DeprojectCursorToPlane(const APlayerController* PlayerController, float PlaneY, FVector2D& OutLocation);
+
+	/** Starts re-picking Possessor's target every frame until EndTargeting */
+	void BeginTargeting(AVictorCharacter* Possessor);
+
+	void EndTargeting(AVictorCharacter* Possessor);
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual ETickableTickType GetTickableTickType() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	void AddCharacter(AVictorCharacter* Character);
+
+	void RemoveCharacter(AVictorCharacter* Character);
+
+	/** Moves every tracked character to its current cell */
+	void UpdateHash();
+
+	TSpatialHash2D<AVictorCharacter*> Hash;
+
+	UPROPERTY(Transient)
+	TArray<AVictorCharacter*> TrackedCharacters;
+
+	UPROPERTY(Transient)
+	TArray<AVictorCharacter*> Possessors;
+
+	FDelegateHandle RegisteredHandle;
+
+	FDelegateHandle UnregisteredHandle;
+};
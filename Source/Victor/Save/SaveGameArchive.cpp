@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SaveGameArchive.h"
+
+#include "Serialization/VictorVarInt.h"
+#include "UObject/SoftObjectPtr.h"
+#include "UObject/LazyObjectPtr.h"
+
+int32 FSaveGameIdTable::GetId(const UObject* Object)
+{
+	if (Object == nullptr)
+	{
+		return INDEX_NONE;
+	}
+	if (const int32* Id = ObjectIds.Find(FObjectKey(Object)))
+	{
+		return *Id;
+	}
+
+	const FString Path = Object->GetPathName();
+	int32 Id = INDEX_NONE;
+	if (const int32* ExistingId = Ids.Find(Path))
+	{
+		Id = *ExistingId;
+	}
+	else
+	{
+		Id = Paths.Add(Path);
+		Ids.Add(Path, Id);
+	}
+	ObjectIds.Add(FObjectKey(Object), Id);
+	return Id;
+}
+
+UObject* FSaveGameIdTable::Resolve(int32 Id) const
+{
+	if (!Paths.IsValidIndex(Id))
+	{
+		return nullptr;
+	}
+	if (const TWeakObjectPtr<UObject>* Object = Remapped.Find(Id))
+	{
+		if (Object->IsValid())
+		{
+			return Object->Get();
+		}
+	}
+	UObject* Object = StaticFindObject(UObject::StaticClass(), nullptr, *Paths[Id]);
+	if (Object == nullptr && !Paths[Id].Contains(TEXT(":")))
+	{
+		//assets that aren't loaded yet; actors and components are always found above if they exist
+		Object = StaticLoadObject(UObject::StaticClass(), nullptr, *Paths[Id], nullptr, LOAD_NoWarn | LOAD_Quiet);
+	}
+	return Object != nullptr && !Object->IsPendingKill() ? Object : nullptr;
+}
+
+void FSaveGameIdTable::Remap(int32 Id, UObject* Object)
+{
+	Remapped.Add(Id, Object);
+	ObjectIds.Add(FObjectKey(Object), Id);
+}
+
+void FSaveGameIdTable::Reset()
+{
+	Paths.Reset();
+	Ids.Reset();
+	ObjectIds.Reset();
+	Remapped.Reset();
+}
+
+FSaveGameArchive::FSaveGameArchive(FArchive& InInnerArchive, FSaveGameIdTable& InIds)
+	: FArchiveProxy(InInnerArchive)
+	, Ids(InIds)
+{
+	ArIsSaveGame = true;
+	ArNoDelta = true;
+}
+
+FArchive& FSaveGameArchive::operator<<(UObject*& Object)
+{
+	int32 Id = IsSaving() ? Ids.GetId(Object) : INDEX_NONE;
+	VictorVarInt::Serialize(*this, Id);
+	if (IsLoading())
+	{
+		UObject* Resolved = Ids.Resolve(Id);
+		if (Resolved != nullptr || Id == INDEX_NONE)
+		{
+			Object = Resolved;
+		}
+	}
+	return *this;
+}
+
+FArchive& FSaveGameArchive::operator<<(FWeakObjectPtr& Value)
+{
+	UObject* Object = Value.Get();
+	*this << Object;
+	if (IsLoading())
+	{
+		Value = Object;
+	}
+	return *this;
+}
+
+FArchive& FSaveGameArchive::operator<<(FSoftObjectPtr& Value)
+{
+	FSoftObjectPath Path = Value.ToSoftObjectPath();
+	*this << Path;
+	if (IsLoading())
+	{
+		Value = Path;
+	}
+	return *this;
+}
+
+FArchive& FSaveGameArchive::operator<<(FSoftObjectPath& Value)
+{
+	FString Path = Value.ToString();
+	*this << Path;
+	if (IsLoading())
+	{
+		Value.SetPath(Path);
+	}
+	return *this;
+}
+
+FArchive& FSaveGameArchive::operator<<(FLazyObjectPtr& Value)
+{
+	UObject* Object = Value.Get();
+	*this << Object;
+	if (IsLoading())
+	{
+		Value = Object;
+	}
+	return *this;
+}
@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/ArchiveProxy.h"
+
+/**
+ * Stable ids for the objects a snapshot refers to.
+ * An id is an index into the table of object paths, so references survive reloading the level
+ * and only cost a varint in the snapshot. INDEX_NONE is null.
+ */
+struct VICTOR_API FSaveGameIdTable
+{
+	int32 GetId(const UObject* Object);
+
+	/** Finds the object with the id's path, nullptr if it doesn't exist (any more) */
+	UObject* Resolve(int32 Id) const;
+
+	/** Makes the id refer to Object from now on, for actors that had to be spawned again under another name */
+	void Remap(int32 Id, UObject* Object);
+
+	void Reset();
+
+	TArray<FString> Paths;
+
+	TMap<FString, int32> Ids;
+
+	//objects we've handed out ids for, so repeated references skip GetPathName
+	TMap<FObjectKey, int32> ObjectIds;
+
+	TMap<int32, TWeakObjectPtr<UObject>> Remapped;
+};
+
+/**
+ * Serializes only SaveGame properties and writes object references as ids from a FSaveGameIdTable.
+ * Wraps a memory reader or writer. A reference that can't be resolved when loading keeps its current value.
+ */
+class VICTOR_API FSaveGameArchive : public FArchiveProxy
+{
+public:
+	FSaveGameArchive(FArchive& InInnerArchive, FSaveGameIdTable& InIds);
+
+	virtual FArchive& operator<<(UObject*& Object) override;
+	virtual FArchive& operator<<(FWeakObjectPtr& Value) override;
+	virtual FArchive& operator<<(FSoftObjectPtr& Value) override;
+	virtual FArchive& operator<<(FSoftObjectPath& Value) override;
+	virtual FArchive& operator<<(FLazyObjectPtr& Value) override;
+
+	virtual FString GetArchiveName() const override { return TEXT("FSaveGameArchive"); }
+
+private:
+	FSaveGameIdTable& Ids;
+};
@@ -0,0 +1,491 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VictorSaveSubsystem.h"
+
+#include "VictorCharacter.h"
+#include "VictorStats.h"
+#include "EngineUtils.h"
+#include "Async/Async.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/StructuredArchive.h"
+#include "Serialization/VictorVarInt.h"
+#include "Weapons/WeaponPoolSubsystem.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogVictorSave, Log, All);
+
+DECLARE_CYCLE_STAT(TEXT("Save checkpoint"), STAT_VictorSaveCheckpoint, STATGROUP_Victor);
+DECLARE_CYCLE_STAT(TEXT("Load checkpoint"), STAT_VictorLoadCheckpoint, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Checkpoint actors written"), STAT_VictorCheckpointActorsWritten, STATGROUP_Victor);
+
+namespace
+{
+	const uint32 SaveMagic = 0x56415356; //"VSAV"
+
+	const uint32 SaveVersion = 1;
+
+	//counts read from a file can't be larger than the bytes left in it
+	bool ReadCount(FArchive& Ar, int32& OutCount)
+	{
+		VictorVarInt::Serialize(Ar, OutCount);
+		if (OutCount < 0 || OutCount > Ar.TotalSize() - Ar.Tell())
+		{
+			Ar.SetError();
+			return false;
+		}
+		return true;
+	}
+}
+
+void UVictorSaveSubsystem::FActorRecord::Serialize(FArchive& Ar)
+{
+	VictorVarInt::Serialize(Ar, ClassId);
+	Ar << SchemaHash;
+	uint8 bTransform = bHasTransform ? 1 : 0;
+	Ar << bTransform;
+	bHasTransform = bTransform != 0;
+	if (bHasTransform)
+	{
+		Ar << Transform;
+	}
+
+	int32 NumBytes = Properties.Num();
+	if (Ar.IsLoading())
+	{
+		if (!ReadCount(Ar, NumBytes))
+		{
+			return;
+		}
+		Properties.SetNumUninitialized(NumBytes);
+	}
+	else
+	{
+		VictorVarInt::Serialize(Ar, NumBytes);
+	}
+	Ar.Serialize(Properties.GetData(), NumBytes);
+}
+
+void UVictorSaveSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	//the level start is the first checkpoint, taken on the first frame once the actors began play
+	bSaveRequested = GetWorld()->IsGameWorld();
+}
+
+void UVictorSaveSubsystem::Deinitialize()
+{
+	FlushWrites();
+	Checkpoint.Empty();
+	Ids.Reset();
+	Schemas.Empty();
+
+	Super::Deinitialize();
+}
+
+const UVictorSaveSubsystem::FClassSchema& UVictorSaveSubsystem::GetSchema(UClass* Class)
+{
+	if (const FClassSchema* Schema = Schemas.Find(Class))
+	{
+		return *Schema;
+	}
+
+	FClassSchema& Schema = Schemas.Add(Class);
+	for (TFieldIterator<FProperty> It(Class); It; ++It)
+	{
+		if (It->HasAnyPropertyFlags(CPF_SaveGame))
+		{
+			Schema.Properties.Add(*It);
+			Schema.Hash = FCrc::StrCrc32(*It->GetName(), Schema.Hash);
+			Schema.Hash = FCrc::StrCrc32(*It->GetCPPType(), Schema.Hash);
+		}
+	}
+	return Schema;
+}
+
+bool UVictorSaveSubsystem::IsVictorActor(const AActor* Actor)
+{
+	//Blueprints count as the native class they derive from
+	static const FName VictorScriptPackage(TEXT("/Script/Victor"));
+	for (const UClass* Class = Actor->GetClass(); Class != nullptr; Class = Class->GetSuperClass())
+	{
+		if (Class->HasAnyClassFlags(CLASS_Native))
+		{
+			return Class->GetOutermost()->GetFName() == VictorScriptPackage;
+		}
+	}
+	return false;
+}
+
+void UVictorSaveSubsystem::WriteActor(AActor* Actor, FActorRecord& OutRecord)
+{
+	const FClassSchema& Schema = GetSchema(Actor->GetClass());
+	OutRecord.ClassId = Ids.GetId(Actor->GetClass());
+	OutRecord.SchemaHash = Schema.Hash;
+	//attached actors, like held weapons, follow their parent
+	const USceneComponent* Root = Actor->GetRootComponent();
+	OutRecord.bHasTransform = Root != nullptr && Root->GetAttachParent() == nullptr;
+	if (OutRecord.bHasTransform)
+	{
+		OutRecord.Transform = Actor->GetActorTransform();
+	}
+
+	OutRecord.Properties.Reset();
+	FMemoryWriter Writer(OutRecord.Properties);
+	FSaveGameArchive Ar(Writer, Ids);
+	for (FProperty* Property : Schema.Properties)
+	{
+		for (int32 Index = 0; Index < Property->ArrayDim; Index++)
+		{
+			FStructuredArchiveFromArchive Adapter(Ar);
+			Property->SerializeItem(Adapter.GetSlot(), Property->ContainerPtrToValuePtr<void>(Actor, Index));
+		}
+	}
+}
+
+void UVictorSaveSubsystem::ReadActor(AActor* Actor, const FActorRecord& Record)
+{
+	const FClassSchema& Schema = GetSchema(Actor->GetClass());
+	if (Schema.Hash != Record.SchemaHash)
+	{
+		UE_LOG(LogVictorSave, Warning, TEXT("%s changed its SaveGame properties since the checkpoint, only its transform is restored"), *Actor->GetName());
+	}
+	else
+	{
+		FMemoryReader Reader(Record.Properties);
+		FSaveGameArchive Ar(Reader, Ids);
+		for (FProperty* Property : Schema.Properties)
+		{
+			for (int32 Index = 0; Index < Property->ArrayDim; Index++)
+			{
+				FStructuredArchiveFromArchive Adapter(Ar);
+				Property->SerializeItem(Adapter.GetSlot(), Property->ContainerPtrToValuePtr<void>(Actor, Index));
+			}
+		}
+	}
+
+	if (Record.bHasTransform)
+	{
+		Actor->SetActorTransform(Record.Transform, false, nullptr, ETeleportType::TeleportPhysics);
+	}
+}
+
+AActor* UVictorSaveSubsystem::FindOrSpawnActor(int32 Id, const FActorRecord& Record)
+{
+	if (AActor* Actor = Cast<AActor>(Ids.Resolve(Id)))
+	{
+		return Actor;
+	}
+
+	//destroyed since the checkpoint
+	UClass* Class = Cast<UClass>(Ids.Resolve(Record.ClassId));
+	if (Class == nullptr || !Class->IsChildOf<AActor>() || !Record.bHasTransform)
+	{
+		return nullptr;
+	}
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	//the destroyed actor keeps its name until it is garbage collected
+	const FName Name(*FPackageName::ObjectPathToObjectName(Ids.Paths[Id]));
+	if (StaticFindObjectFast(nullptr, GetWorld()->PersistentLevel, Name) == nullptr)
+	{
+		SpawnParameters.Name = Name;
+	}
+	AActor* Actor = GetWorld()->SpawnActor(Class, &Record.Transform, SpawnParameters);
+	if (Actor != nullptr)
+	{
+		Ids.Remap(Id, Actor);
+	}
+	return Actor;
+}
+
+void UVictorSaveSubsystem::SaveCheckpoint()
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorSaveCheckpoint);
+	bSaveRequested = false;
+
+	TMap<int32, FActorRecord> NewCheckpoint;
+	NewCheckpoint.Reserve(Checkpoint.Num());
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		AActor* Actor = *It;
+		if (!Actor->IsPendingKillPending() && IsVictorActor(Actor) && GetSchema(Actor->GetClass()).Properties.Num() > 0)
+		{
+			WriteActor(Actor, NewCheckpoint.Add(Ids.GetId(Actor)));
+		}
+	}
+
+	TArray<int32> ChangedActors;
+	for (const TPair<int32, FActorRecord>& Pair : NewCheckpoint)
+	{
+		const FActorRecord* Previous = Checkpoint.Find(Pair.Key);
+		if (Previous == nullptr || !(*Previous == Pair.Value))
+		{
+			ChangedActors.Add(Pair.Key);
+		}
+	}
+	TArray<int32> RemovedActors;
+	for (const TPair<int32, FActorRecord>& Pair : Checkpoint)
+	{
+		if (!NewCheckpoint.Contains(Pair.Key))
+		{
+			RemovedActors.Add(Pair.Key);
+		}
+	}
+
+	//the first checkpoint of a save file starts it over
+	const bool bNewFile = !bSaveFileStarted;
+	bSaveFileStarted = true;
+	TArray<uint8> Data;
+	FMemoryWriter Writer(Data);
+	if (bNewFile)
+	{
+		uint32 Magic = SaveMagic;
+		uint32 Version = SaveVersion;
+		Writer << Magic << Version;
+	}
+
+	int32 NumNewIds = Ids.Paths.Num() - NumWrittenIds;
+	VictorVarInt::Serialize(Writer, NumNewIds);
+	for (int32 Id = NumWrittenIds; Id < Ids.Paths.Num(); Id++)
+	{
+		Writer << Ids.Paths[Id];
+	}
+	NumWrittenIds = Ids.Paths.Num();
+
+	int32 NumChanged = ChangedActors.Num();
+	VictorVarInt::Serialize(Writer, NumChanged);
+	for (int32 Id : ChangedActors)
+	{
+		VictorVarInt::Serialize(Writer, Id);
+		NewCheckpoint[Id].Serialize(Writer);
+	}
+	int32 NumRemoved = RemovedActors.Num();
+	VictorVarInt::Serialize(Writer, NumRemoved);
+	for (int32 Id : RemovedActors)
+	{
+		VictorVarInt::Serialize(Writer, Id);
+	}
+	Checkpoint = MoveTemp(NewCheckpoint);
+	SET_DWORD_STAT(STAT_VictorCheckpointActorsWritten, NumChanged);
+
+	const FString FileName = GetSaveFilePath();
+	TFuture<void> PreviousWrite = MoveTemp(PendingWrite);
+	PendingWrite = Async(EAsyncExecution::ThreadPool, [PreviousWrite = MoveTemp(PreviousWrite), Data = MoveTemp(Data), FileName, bNewFile]() mutable
+	{
+		if (PreviousWrite.IsValid())
+		{
+			PreviousWrite.Wait();
+		}
+		if (!FFileHelper::SaveArrayToFile(Data, *FileName, &IFileManager::Get(), bNewFile ? 0 : FILEWRITE_Append))
+		{
+			UE_LOG(LogVictorSave, Error, TEXT("Could not write checkpoint to %s"), *FileName);
+		}
+	});
+}
+
+bool UVictorSaveSubsystem::ReadSaveFile()
+{
+	FlushWrites();
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *GetSaveFilePath(), FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(FileData);
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	Reader << Magic << Version;
+	if (Magic != SaveMagic || Version != SaveVersion)
+	{
+		UE_LOG(LogVictorSave, Warning, TEXT("%s is not a save of this version"), *GetSaveFilePath());
+		return false;
+	}
+
+	Checkpoint.Reset();
+	Ids.Reset();
+	while (!Reader.AtEnd() && !Reader.IsError())
+	{
+		int32 NumNewIds = 0;
+		if (!ReadCount(Reader, NumNewIds))
+		{
+			break;
+		}
+		for (int32 i = 0; i < NumNewIds; i++)
+		{
+			FString Path;
+			Reader << Path;
+			Ids.Ids.Add(Path, Ids.Paths.Add(Path));
+		}
+
+		int32 NumChanged = 0;
+		if (!ReadCount(Reader, NumChanged))
+		{
+			break;
+		}
+		for (int32 i = 0; i < NumChanged && !Reader.IsError(); i++)
+		{
+			int32 Id = INDEX_NONE;
+			VictorVarInt::Serialize(Reader, Id);
+			Checkpoint.FindOrAdd(Id).Serialize(Reader);
+		}
+
+		int32 NumRemoved = 0;
+		if (!ReadCount(Reader, NumRemoved))
+		{
+			break;
+		}
+		for (int32 i = 0; i < NumRemoved; i++)
+		{
+			int32 Id = INDEX_NONE;
+			VictorVarInt::Serialize(Reader, Id);
+			Checkpoint.Remove(Id);
+		}
+	}
+
+	if (Reader.IsError())
+	{
+		UE_LOG(LogVictorSave, Warning, TEXT("%s is damaged"), *GetSaveFilePath());
+		Checkpoint.Reset();
+		Ids.Reset();
+		return false;
+	}
+	NumWrittenIds = Ids.Paths.Num();
+	bSaveFileStarted = true;
+	return Checkpoint.Num() > 0;
+}
+
+bool UVictorSaveSubsystem::LoadLastCheckpoint()
+{
+	//a save file this session didn't write may be from another run of the level, it is never read implicitly
+	if (Checkpoint.Num() == 0)
+	{
+		return false;
+	}
+	ApplyCheckpoint();
+	return true;
+}
+
+bool UVictorSaveSubsystem::LoadSaveFile()
+{
+	if (!ReadSaveFile())
+	{
+		return false;
+	}
+	//what was read is the checkpoint now
+	bSaveRequested = false;
+	ApplyCheckpoint();
+	return true;
+}
+
+void UVictorSaveSubsystem::ApplyCheckpoint()
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorLoadCheckpoint);
+	const double StartTime = FPlatformTime::Seconds();
+
+	//find or respawn every actor before reading, so references between them resolve
+	TArray<TPair<AActor*, const FActorRecord*>> Actors;
+	Actors.Reserve(Checkpoint.Num());
+	for (const TPair<int32, FActorRecord>& Pair : Checkpoint)
+	{
+		if (AActor* Actor = FindOrSpawnActor(Pair.Key, Pair.Value))
+		{
+			Actors.Emplace(Actor, &Pair.Value);
+		}
+	}
+
+	TArray<TPair<AVictorCharacter*, AWeaponBase*>> Characters;
+	for (const TPair<AActor*, const FActorRecord*>& Pair : Actors)
+	{
+		AVictorCharacter* Character = Cast<AVictorCharacter>(Pair.Key);
+		if (Character != nullptr)
+		{
+			Characters.Emplace(Character, Character->Weapon);
+		}
+		ReadActor(Pair.Key, *Pair.Value);
+	}
+
+	//weapons that changed hands since go back to the pool first, so whoever held them at the checkpoint can reclaim them
+	UWeaponPoolSubsystem* WeaponPool = GetWorld()->GetSubsystem<UWeaponPoolSubsystem>();
+	for (const TPair<AVictorCharacter*, AWeaponBase*>& Pair : Characters)
+	{
+		if (Pair.Value != nullptr && Pair.Value != Pair.Key->Weapon)
+		{
+			WeaponPool->ReleaseWeapon(Pair.Value);
+		}
+	}
+	for (const TPair<AVictorCharacter*, AWeaponBase*>& Pair : Characters)
+	{
+		Pair.Key->OnCheckpointLoaded();
+	}
+
+	//possession isn't a property, give the player back the body it controlled
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (PlayerController != nullptr)
+	{
+		for (const TPair<AVictorCharacter*, AWeaponBase*>& Pair : Characters)
+		{
+			AVictorCharacter* Character = Pair.Key;
+			if (Character->bControlledByPlayer && !Character->bDead)
+			{
+				if (PlayerController->GetPawn() != Character)
+				{
+					PlayerController->Possess(Character);
+				}
+				Character->EnableInput(PlayerController);
+				break;
+			}
+		}
+	}
+
+	UE_LOG(LogVictorSave, Log, TEXT("Loaded checkpoint of %d actors in %.2f ms"), Actors.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+}
+
+void UVictorSaveSubsystem::FlushWrites()
+{
+	if (PendingWrite.IsValid())
+	{
+		PendingWrite.Wait();
+		PendingWrite.Reset();
+	}
+}
+
+FString UVictorSaveSubsystem::GetSaveFilePath() const
+{
+	return FPaths::ProjectSavedDir() / TEXT("SaveGames") / UWorld::RemovePIEPrefix(GetWorld()->GetMapName()) + TEXT(".vsave");
+}
+
+void UVictorSaveSubsystem::Tick(float DeltaTime)
+{
+	if (bLoadRequested)
+	{
+		//whatever asked for a checkpoint this frame is undone by the load
+		bLoadRequested = false;
+		bSaveRequested = false;
+		if (!LoadLastCheckpoint())
+		{
+			UE_LOG(LogVictorSave, Warning, TEXT("No checkpoint to load in %s"), *GetWorld()->GetMapName());
+		}
+	}
+	else if (bSaveRequested && GetWorld()->HasBegunPlay())
+	{
+		SaveCheckpoint();
+	}
+}
+
+TStatId UVictorSaveSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UVictorSaveSubsystem, STATGROUP_Tickables);
+}
+
+ETickableTickType UVictorSaveSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Async/Future.h"
+#include "Save/SaveGameArchive.h"
+#include "VictorSaveSubsystem.generated.h"
+
+/**
+ * Native checkpoints of every Victor actor's SaveGame properties.
+ * A checkpoint is kept in memory, so loading it is a few milliseconds on the game thread, and appended to
+ * Saved/SaveGames/<Map>.vsave on a worker thread. The file only gets the actors that changed since the previous
+ * checkpoint; object references are ids into a path table that is also written incrementally.
+ *
+ * The level start is the first checkpoint and starts the file over; taking a new body is another.
+ * Loading only ever restores a checkpoint of this session, the file is read back through LoadSaveFile().
+ *
+ * File: magic, version, then one record per checkpoint:
+ *   new id paths | changed actors (id, class id, schema hash, transform, property bytes) | removed actor ids
+ */
+UCLASS()
+class VICTOR_API UVictorSaveSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/** Snapshots all Victor actors now and writes the changes to disk in the background */
+	UFUNCTION(BlueprintCallable, Category = SaveSystem)
+	void SaveCheckpoint();
+
+	/** Takes a checkpoint at the start of the next frame, so gameplay calls like Possess() don't pay for it */
+	UFUNCTION(BlueprintCallable, Category = SaveSystem)
+	void RequestCheckpoint() { bSaveRequested = true; }
+
+	/** Restores the last checkpoint at the start of the next frame, so callers like Die() can finish first */
+	UFUNCTION(BlueprintCallable, Category = SaveSystem)
+	void RequestLoadLastCheckpoint() { bLoadRequested = true; }
+
+	/** Restores the last checkpoint of this session now. False if there is none */
+	UFUNCTION(BlueprintCallable, Category = SaveSystem)
+	bool LoadLastCheckpoint();
+
+	/**
+	 * Restores the checkpoint in the save file, e.g. one an earlier session wrote. False if there is none.
+	 * Must be called before the level start checkpoint, like from BeginPlay, which starts the file over.
+	 */
+	UFUNCTION(BlueprintCallable, Category = SaveSystem)
+	bool LoadSaveFile();
+
+	UFUNCTION(BlueprintPure, Category = SaveSystem)
+	bool HasCheckpoint() const { return Checkpoint.Num() > 0; }
+
+	/** Blocks until the background writes are on disk */
+	void FlushWrites();
+
+	FString GetSaveFilePath() const;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return bLoadRequested || bSaveRequested; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual ETickableTickType GetTickableTickType() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	struct FActorRecord
+	{
+		int32 ClassId = INDEX_NONE;
+		uint32 SchemaHash = 0;
+		bool bHasTransform = false;
+		FTransform Transform;
+		TArray<uint8> Properties;
+
+		bool operator==(const FActorRecord& Other) const
+		{
+			return ClassId == Other.ClassId
+				&& SchemaHash == Other.SchemaHash
+				&& bHasTransform == Other.bHasTransform
+				&& (!bHasTransform || Transform.Equals(Other.Transform, 0.01f))
+				&& Properties == Other.Properties;
+		}
+
+		void Serialize(FArchive& Ar);
+	};
+
+	/** SaveGame properties of a class in serialization order and a hash of their names and types */
+	struct FClassSchema
+	{
+		TArray<FProperty*> Properties;
+		uint32 Hash = 0;
+	};
+
+	const FClassSchema& GetSchema(UClass* Class);
+
+	static bool IsVictorActor(const AActor* Actor);
+
+	void WriteActor(AActor* Actor, FActorRecord& OutRecord);
+
+	void ReadActor(AActor* Actor, const FActorRecord& Record);
+
+	AActor* FindOrSpawnActor(int32 Id, const FActorRecord& Record);
+
+	/** Reads every record of the save file into Checkpoint */
+	bool ReadSaveFile();
+
+	void ApplyCheckpoint();
+
+	//actor id -> state at the last checkpoint
+	TMap<int32, FActorRecord> Checkpoint;
+
+	FSaveGameIdTable Ids;
+
+	//ids already in the save file
+	int32 NumWrittenIds = 0;
+
+	//false until this session wrote or read the save file, the next checkpoint then starts a new one
+	bool bSaveFileStarted = false;
+
+	TMap<UClass*, FClassSchema> Schemas;
+
+	bool bLoadRequested = false;
+
+	bool bSaveRequested = false;
+
+	//checkpoints are appended in order, each write waits for the one before it
+	TFuture<void> PendingWrite;
+};
@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/Archive.h"
+
+/**
+ * Signed varints shared by the input recordings, the save checkpoints and the replicated plane movement.
+ * Values are zigzag mapped, so small negative values pack as small as small positive ones, then written
+ * 7 bits per byte, low bits first, with the top bit set on every byte but the last. At most 5 bytes.
+ */
+namespace VictorVarInt
+{
+	static const int32 MaxBytes = 5;
+
+	FORCEINLINE uint32 ZigZag(int32 Value)
+	{
+		return (uint32(Value) << 1) ^ uint32(Value >> 31);
+	}
+
+	FORCEINLINE int32 UnZigZag(uint32 Value)
+	{
+		return int32(Value >> 1) ^ -int32(Value & 1);
+	}
+
+	/** Appends Value to Data */
+	inline void Write(TArray<uint8>& Data, int32 Value)
+	{
+		uint32 Remaining = ZigZag(Value);
+		do
+		{
+			const uint8 Byte = Remaining & 0x7F;
+			Remaining >>= 7;
+			Data.Add(Remaining != 0 ? Byte | 0x80 : Byte);
+		}
+		while (Remaining != 0);
+	}
+
+	/** Reads the value at Cursor and moves Cursor past it. False if Data ends first or the value is too long */
+	inline bool Read(const TArray<uint8>& Data, int32& Cursor, int32& OutValue)
+	{
+		uint32 Encoded = 0;
+		for (int32 Index = 0; Index < MaxBytes; Index++)
+		{
+			if (!Data.IsValidIndex(Cursor))
+			{
+				return false;
+			}
+			const uint8 Byte = Data[Cursor++];
+			Encoded |= uint32(Byte & 0x7F) << (Index * 7);
+			if ((Byte & 0x80) == 0)
+			{
+				OutValue = UnZigZag(Encoded);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/** Writes Value to a saving archive, or reads it from a loading one. A value that is too long sets the archive's error */
+	inline void Serialize(FArchive& Ar, int32& Value)
+	{
+		if (Ar.IsSaving())
+		{
+			uint32 Remaining = ZigZag(Value);
+			do
+			{
+				uint8 Byte = Remaining & 0x7F;
+				Remaining >>= 7;
+				if (Remaining != 0)
+				{
+					Byte |= 0x80;
+				}
+				Ar << Byte;
+			}
+			while (Remaining != 0);
+			return;
+		}
+
+		uint32 Encoded = 0;
+		for (int32 Index = 0; Index < MaxBytes && !Ar.IsError(); Index++)
+		{
+			uint8 Byte = 0;
+			Ar << Byte;
+			Encoded |= uint32(Byte & 0x7F) << (Index * 7);
+			if ((Byte & 0x80) == 0)
+			{
+				Value = UnZigZag(Encoded);
+				return;
+			}
+		}
+		Value = 0;
+		Ar.SetError();
+	}
+}
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "VictorCharacter.h"
+#include "VictorTestWorld.h"
+#include "PaperFlipbook.h"
+#include "Animation/AnimationStreamingSubsystem.h"
+#include "Animation/VictorAnimationTable.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "UObject/StrongObjectPtr.h"
+
+namespace VictorAnimationStreamingTest
+{
+	FVictorAnimationRule MakeUnarmedRule(ELocomotionState Locomotion, UPaperFlipbook* Flipbook)
+	{
+		FVictorAnimationRule Rule;
+		Rule.bArmed = false;
+		Rule.Locomotion = Locomotion;
+		Rule.Flipbook = Flipbook;
+		return Rule;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVictorAnimationStreamingTest, "Victor.Animation.LoadAndRelease", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVictorAnimationStreamingTest::RunTest(const FString& Parameters)
+{
+	using namespace VictorAnimationStreamingTest;
+
+	FVictorTestWorld TestWorld;
+	UAnimationStreamingSubsystem* Streaming = TestWorld.GetWorld()->GetSubsystem<UAnimationStreamingSubsystem>();
+	//a pass every frame, and a residency the test can wait out
+	Streaming->UpdateInterval = 0.f;
+	Streaming->MinBundleResidency = 1.f;
+
+	TStrongObjectPtr<UPaperFlipbook> Idle(NewObject<UPaperFlipbook>(GetTransientPackage(), TEXT("VictorTestIdle")));
+	TStrongObjectPtr<UPaperFlipbook> Running(NewObject<UPaperFlipbook>(GetTransientPackage(), TEXT("VictorTestRunning")));
+	TStrongObjectPtr<UVictorAnimationTable> Table(NewObject<UVictorAnimationTable>());
+	Table->Rules.Add(MakeUnarmedRule(ELocomotionState::ELS_Idle, Idle.Get()));
+	Table->Rules.Add(MakeUnarmedRule(ELocomotionState::ELS_Moving, Running.Get()));
+
+	AVictorCharacter* Character = TestWorld.SpawnCharacter(FVector::ZeroVector, ETeam::ET_Guards);
+	Character->AnimationTable = Table.Get();
+	Character->bLoadAnimationsOnDemand = true;
+	//stay where it was put
+	Character->GetCharacterMovement()->DisableMovement();
+
+	//the table's flipbooks load with the bundle their state is in
+	TArray<FSoftObjectPath> Paths;
+	Character->GetAnimationBundlePaths(EAnimationBundle::Unarmed, Paths);
+	TestTrue(TEXT("Unarmed bundle has the table's idle flipbook"), Paths.Contains(FSoftObjectPath(Idle.Get())));
+	TestTrue(TEXT("Unarmed bundle has the table's running flipbook"), Paths.Contains(FSoftObjectPath(Running.Get())));
+	Paths.Reset();
+	Character->GetAnimationBundlePaths(EAnimationBundle::Pistol, Paths);
+	TestEqual(TEXT("Pistol bundle paths"), Paths.Num(), 0);
+
+	const uint16 IdleKey = FAnimationStateKey::Make(EWeaponAnimType::EWT_MeleeKnife, false, ELocomotionState::ELS_Idle, false, false);
+	const uint16 MovingKey = FAnimationStateKey::Make(EWeaponAnimType::EWT_MeleeKnife, false, ELocomotionState::ELS_Moving, false, false);
+
+	Streaming->SetViewOverride(FVector2D::ZeroVector);
+	TestWorld.Tick();
+	TestTrue(TEXT("Unarmed bundle requested near the camera"), Character->IsAnimationBundleRequested(EAnimationBundle::Unarmed));
+	TestEqual(TEXT("Prefetched characters"), Streaming->GetNumPrefetchedCharacters(), 1);
+	TestTrue(TEXT("Idle flipbook from the table"), Character->ResolveAnimation(IdleKey) == Idle.Get());
+
+	//far away, but requested too recently to be let go
+	Streaming->SetViewOverride(FVector2D(100000.f, 0.f));
+	TestWorld.Tick(30);
+	TestTrue(TEXT("Unarmed bundle kept for its residency"), Character->IsAnimationBundleRequested(EAnimationBundle::Unarmed));
+
+	//a state change out there asks for the bundle again, which restarts its residency instead of reloading it
+	Character->ApplyAnimationState(MovingKey, nullptr);
+	TestWorld.Tick(45);
+	TestTrue(TEXT("Unarmed bundle kept after it was requested again"), Character->IsAnimationBundleRequested(EAnimationBundle::Unarmed));
+
+	TestWorld.Tick(30);
+	TestFalse(TEXT("Unarmed bundle released once its residency is over"), Character->IsAnimationBundleRequested(EAnimationBundle::Unarmed));
+	TestEqual(TEXT("Prefetched characters when far"), Streaming->GetNumPrefetchedCharacters(), 0);
+
+	Streaming->SetViewOverride(FVector2D::ZeroVector);
+	TestWorld.Tick();
+	TestTrue(TEXT("Unarmed bundle requested when back near the camera"), Character->IsAnimationBundleRequested(EAnimationBundle::Unarmed));
+	return true;
+}
+
+#endif
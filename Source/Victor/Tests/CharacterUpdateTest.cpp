@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "VictorCharacter.h"
+#include "VictorTestController.h"
+#include "VictorTestWorld.h"
+#include "Characters/CharacterUpdateSubsystem.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "PaperFlipbook.h"
+#include "PaperFlipbookComponent.h"
+
+namespace VictorCharacterUpdateTest
+{
+	//the locomotion flipbooks are protected soft references, set them the way the Blueprint defaults would
+	void SetFlipbook(AVictorCharacter* Character, const TCHAR* PropertyName, UPaperFlipbook* Flipbook)
+	{
+		FSoftObjectProperty* Property = FindFProperty<FSoftObjectProperty>(AVictorCharacter::StaticClass(), PropertyName);
+		*Property->ContainerPtrToValuePtr<FSoftObjectPtr>(Character) = FSoftObjectPtr(Flipbook);
+	}
+
+	/** What one character is set up as, and what the update should make of it */
+	struct FCharacterCase
+	{
+		float VelocityX;
+		bool bFalling;
+		bool bStartFacingLeft;
+		bool bExpectMoving;
+		bool bExpectFacingLeft;
+	};
+
+	bool IsFacingLeft(const AController* Controller)
+	{
+		return FMath::Abs(FRotator::NormalizeAxis(Controller->GetControlRotation().Yaw)) > 90.f;
+	}
+
+	void RunUpdate(UCharacterUpdateSubsystem* Updates, bool bBatched)
+	{
+		IConsoleVariable* Batched = IConsoleManager::Get().FindConsoleVariable(TEXT("victor.BatchedCharacterUpdate"));
+		const int32 Previous = Batched->GetInt();
+		Batched->Set(bBatched ? 1 : 0, ECVF_SetByCode);
+		for (AVictorCharacter* Character : Updates->GetCharacters())
+		{
+			Character->InvalidateAnimationState();
+		}
+		Updates->UpdateCharacters();
+		Batched->Set(Previous, ECVF_SetByCode);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVictorCharacterUpdateBatchedMatchesPerActorTest, "Victor.CharacterUpdate.BatchedMatchesPerActor", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVictorCharacterUpdateBatchedMatchesPerActorTest::RunTest(const FString& Parameters)
+{
+	using namespace VictorCharacterUpdateTest;
+
+	FVictorTestWorld TestWorld;
+	UCharacterUpdateSubsystem* Updates = TestWorld.GetWorld()->GetSubsystem<UCharacterUpdateSubsystem>();
+
+	UPaperFlipbook* Idle = NewObject<UPaperFlipbook>(GetTransientPackage(), TEXT("VictorTestIdle"));
+	UPaperFlipbook* Running = NewObject<UPaperFlipbook>(GetTransientPackage(), TEXT("VictorTestRunning"));
+
+	//standing still keeps the facing, running or falling turns toward the travel direction
+	const FCharacterCase Cases[] =
+	{
+		{ 0.f, false, false, false, false },
+		{ 0.f, false, true, false, true },
+		{ 300.f, false, true, true, false },
+		{ -300.f, false, false, true, true },
+		{ 0.f, true, true, true, true },
+		{ -200.f, true, false, true, true },
+		{ 200.f, true, true, true, false }
+	};
+	const int32 NumCharacters = UE_ARRAY_COUNT(Cases);
+
+	TArray<AVictorCharacter*> Characters;
+	TArray<AController*> Controllers;
+	for (int32 i = 0; i < NumCharacters; i++)
+	{
+		AVictorCharacter* Character = TestWorld.SpawnCharacter(FVector(i * 200.f, 0.f, 0.f), ETeam::ET_Guards);
+		SetFlipbook(Character, TEXT("IdleAnimation"), Idle);
+		SetFlipbook(Character, TEXT("RunningAnimation"), Running);
+		//facing only turns characters that have a controller
+		AController* Controller = TestWorld.GetWorld()->SpawnActor<AVictorTestController>();
+		Controller->Possess(Character);
+		Characters.Add(Character);
+		Controllers.Add(Controller);
+	}
+	TestEqual(TEXT("Every character registered"), Updates->Num(), NumCharacters);
+
+	//both paths start from the same velocities and facing
+	auto ResetCharacters = [&]()
+	{
+		for (int32 i = 0; i < NumCharacters; i++)
+		{
+			UCharacterMovementComponent* Movement = Characters[i]->GetCharacterMovement();
+			Movement->SetMovementMode(Cases[i].bFalling ? MOVE_Falling : MOVE_Walking);
+			Movement->Velocity = FVector(Cases[i].VelocityX, 0.f, 0.f);
+			Controllers[i]->SetControlRotation(FRotator(0.f, Cases[i].bStartFacingLeft ? 180.f : 0.f, 0.f));
+		}
+	};
+
+	auto TestResults = [&](const TCHAR* Path)
+	{
+		for (int32 i = 0; i < NumCharacters; i++)
+		{
+			UPaperFlipbook* Expected = Cases[i].bExpectMoving ? Running : Idle;
+			TestTrue(FString::Printf(TEXT("%s character %d flipbook"), Path, i), Characters[i]->GetSprite()->GetFlipbook() == Expected);
+			TestEqual(FString::Printf(TEXT("%s character %d facing left"), Path, i), IsFacingLeft(Controllers[i]), Cases[i].bExpectFacingLeft);
+		}
+	};
+
+	ResetCharacters();
+	RunUpdate(Updates, true);
+	TestResults(TEXT("Batched"));
+	TArray<uint16> BatchedKeys;
+	for (AVictorCharacter* Character : Characters)
+	{
+		BatchedKeys.Add(Character->AnimationStateKey);
+	}
+
+	ResetCharacters();
+	RunUpdate(Updates, false);
+	TestResults(TEXT("Per-actor"));
+	for (int32 i = 0; i < NumCharacters; i++)
+	{
+		TestEqual(FString::Printf(TEXT("Character %d state key"), i), int32(Characters[i]->AnimationStateKey), int32(BatchedKeys[i]));
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "VictorCharacter.h"
+#include "VictorTestWorld.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Weapons/DamageQueueSubsystem.h"
+
+namespace VictorDamageQueueTest
+{
+	AVictorCharacter* SpawnStill(FVictorTestWorld& TestWorld, const FVector& Location, ETeam Team)
+	{
+		AVictorCharacter* Character = TestWorld.SpawnCharacter(Location, Team);
+		Character->GetCharacterMovement()->DisableMovement();
+		return Character;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVictorDamageQueueTeamTest, "Victor.DamageQueue.Teams", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVictorDamageQueueTeamTest::RunTest(const FString& Parameters)
+{
+	using namespace VictorDamageQueueTest;
+
+	FVictorTestWorld TestWorld;
+	UDamageQueueSubsystem* DamageQueue = TestWorld.GetWorld()->GetSubsystem<UDamageQueueSubsystem>();
+	TestFalse(TEXT("Friendly fire off"), DamageQueue->bFriendlyFire);
+
+	//a guard body the player took over is still on the guards' team, but fights for the player
+	AVictorCharacter* Possessed = SpawnStill(TestWorld, FVector(0.f, 0.f, 0.f), ETeam::ET_Guards);
+	Possessed->bControlledByPlayer = true;
+	AVictorCharacter* GuardA = SpawnStill(TestWorld, FVector(1000.f, 0.f, 0.f), ETeam::ET_Guards);
+	AVictorCharacter* GuardB = SpawnStill(TestWorld, FVector(2000.f, 0.f, 0.f), ETeam::ET_Guards);
+
+	ETeam Team = ETeam::ET_Guards;
+	TestTrue(TEXT("Possessed body has a team"), UDamageQueueSubsystem::GetAttackerTeam(nullptr, Possessed, Team));
+	TestTrue(TEXT("Possessed body attacks for the player"), Team == ETeam::ET_Player);
+
+	//guards don't hurt each other, and the filtered hit isn't queued
+	DamageQueue->ResetStats();
+	TestFalse(TEXT("Guard hit by a guard queued"), DamageQueue->QueueDamage(GuardB, 10.f, nullptr, GuardA));
+	TestEqual(TEXT("Queued events after a filtered hit"), DamageQueue->GetNumQueuedEvents(), 0);
+	TestEqual(TEXT("Damage a guard takes from a guard"), GuardB->TakeDamage(10.f, FDamageEvent(), nullptr, GuardA), 0.f);
+	DamageQueue->Flush();
+	TestFalse(TEXT("Guard hit by a guard"), GuardB->bDead);
+	TestEqual(TEXT("Filtered hits between guards"), DamageQueue->GetStats().FilteredHits, 2);
+
+	//the player's body hits a guard
+	TArray<AVictorCharacter*> Killed;
+	TArray<AActor*> Killers;
+	const FDelegateHandle KillsHandle = DamageQueue->OnDamageBatchApplied.AddLambda([&Killed, &Killers](const TArray<FDamageQueueKill>& Kills)
+	{
+		for (const FDamageQueueKill& Kill : Kills)
+		{
+			Killed.Add(Kill.Character);
+			Killers.Add(Kill.DamageCauser.Get());
+		}
+	});
+	DamageQueue->QueueDamage(GuardA, 10.f, nullptr, Possessed);
+	DamageQueue->Flush();
+	TestTrue(TEXT("Guard hit by the player's body"), GuardA->bDead);
+	TestTrue(TEXT("Kill credited to the player's body"), Killed.Num() == 1 && Killed[0] == GuardA && Killers[0] == Possessed);
+	TestEqual(TEXT("Filtered hits after the player's hit"), DamageQueue->GetStats().FilteredHits, 2);
+
+	//a guard's explosion spares the other guards but not the player's body
+	DamageQueue->QueueRadialDamage(FVector(1000.f, 0.f, 0.f), 5000.f, 10.f, 10.f, ETeam::ET_Guards, true, nullptr, GuardB);
+	DamageQueue->Flush();
+	TestTrue(TEXT("Player's body in a guard's explosion"), Possessed->bDead);
+	TestFalse(TEXT("Guard in a guard's explosion"), GuardB->bDead);
+	TestEqual(TEXT("Filtered hits of the explosion"), DamageQueue->GetStats().FilteredHits, 3);
+	TestEqual(TEXT("Deaths"), DamageQueue->GetStats().Deaths, 2);
+	DamageQueue->OnDamageBatchApplied.Remove(KillsHandle);
+
+	//an explosion without a team hurts the guards too
+	AVictorCharacter* GuardC = SpawnStill(TestWorld, FVector(3000.f, 0.f, 0.f), ETeam::ET_Guards);
+	DamageQueue->QueueRadialDamage(FVector(3000.f, 0.f, 0.f), 500.f, 10.f, 10.f, ETeam::ET_Guards, false, nullptr, nullptr);
+	DamageQueue->Flush();
+	TestTrue(TEXT("Guard in an explosion without a team"), GuardC->bDead);
+	TestEqual(TEXT("Filtered hits of the explosion without a team"), DamageQueue->GetStats().FilteredHits, 3);
+	return true;
+}
+
+#endif
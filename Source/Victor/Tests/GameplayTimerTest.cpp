@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "VictorTestWorld.h"
+#include "Engine/World.h"
+#include "Timers/GameplayTimerSubsystem.h"
+#include "Timers/GameplayTimerWheel.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVictorTimerWheelRescheduleTest, "Victor.Timers.RescheduleFromCallback", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVictorTimerWheelRescheduleTest::RunTest(const FString& Parameters)
+{
+	FGameplayTimerWheel Wheel;
+	int32 NumFired = 0;
+	FGameplayTimerHandle Rescheduled;
+	FGameplayTimerHandle Cancelled;
+
+	//the last timer sets a new one from its callback, the wheel is empty and still advancing then
+	Wheel.Schedule(10, FSimpleDelegate::CreateLambda([&]()
+	{
+		NumFired++;
+		TestEqual(TEXT("Timers while the last one fires"), Wheel.Num(), 0);
+		TestTrue(TEXT("Advancing in a callback"), Wheel.IsAdvancing());
+		Rescheduled = Wheel.Schedule(Wheel.GetCurrentTick() + 5, FSimpleDelegate::CreateLambda([&NumFired]()
+		{
+			NumFired++;
+		}));
+	}));
+	TestEqual(TEXT("Fired at the deadline"), Wheel.Advance(10), 1);
+	TestFalse(TEXT("Advancing after Advance"), Wheel.IsAdvancing());
+	TestTrue(TEXT("Rescheduled timer"), Wheel.IsScheduled(Rescheduled));
+	TestEqual(TEXT("Rescheduled timer remaining ticks"), Wheel.GetRemainingTicks(Rescheduled), int64(5));
+	TestEqual(TEXT("Fired before the rescheduled deadline"), Wheel.Advance(14), 0);
+	TestEqual(TEXT("Fired at the rescheduled deadline"), Wheel.Advance(15), 1);
+	TestEqual(TEXT("Callbacks"), NumFired, 2);
+	TestEqual(TEXT("Timers left"), Wheel.Num(), 0);
+
+	//both expire in one Advance, the first cancels the second while it waits for its callback and sets itself again
+	NumFired = 0;
+	Wheel.Schedule(20, FSimpleDelegate::CreateLambda([&]()
+	{
+		NumFired++;
+		TestTrue(TEXT("Cancelling an expired timer"), Wheel.Cancel(Cancelled));
+		Rescheduled = Wheel.Schedule(Wheel.GetCurrentTick() + 1, FSimpleDelegate::CreateLambda([&NumFired]()
+		{
+			NumFired++;
+		}));
+	}));
+	Cancelled = Wheel.Schedule(21, FSimpleDelegate::CreateLambda([&NumFired]()
+	{
+		NumFired += 100;
+	}));
+	TestEqual(TEXT("Fired in the batch"), Wheel.Advance(21), 1);
+	TestEqual(TEXT("Fired after the batch"), Wheel.Advance(22), 1);
+	TestEqual(TEXT("Callbacks after the batch"), NumFired, 2);
+	TestEqual(TEXT("Timers left after the batch"), Wheel.Num(), 0);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVictorTimerSubsystemRescheduleTest, "Victor.Timers.SetTimerFromCallback", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVictorTimerSubsystemRescheduleTest::RunTest(const FString& Parameters)
+{
+	FVictorTestWorld TestWorld;
+	UGameplayTimerSubsystem* Timers = TestWorld.GetWorld()->GetSubsystem<UGameplayTimerSubsystem>();
+
+	//like EndMeleeAttackAnim setting FinishAttackAnimTimerHandle when its own timer was the only one
+	FGameplayTimerHandle First;
+	FGameplayTimerHandle Second;
+	int32 NumSecondFired = 0;
+	Timers->SetTimer(First, FSimpleDelegate::CreateLambda([&]()
+	{
+		Timers->SetTimer(Second, FSimpleDelegate::CreateLambda([&NumSecondFired]()
+		{
+			NumSecondFired++;
+		}), 0.1f);
+	}), 0.1f);
+
+	TestWorld.Tick(8);
+	TestFalse(TEXT("First timer after it fired"), Timers->IsTimerActive(First));
+	TestTrue(TEXT("Timer set from the callback"), Timers->IsTimerActive(Second));
+	TestTrue(TEXT("Timer set from the callback counts from when it was set"), Timers->GetTimerRemaining(Second) > 0.f);
+	TestWorld.Tick(8);
+	TestEqual(TEXT("Timer set from the callback fired"), NumSecondFired, 1);
+	TestFalse(TEXT("Timer set from the callback after it fired"), Timers->IsTimerActive(Second));
+	return true;
+}
+
+#endif
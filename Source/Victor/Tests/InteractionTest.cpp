@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "VictorCharacter.h"
+#include "VictorTestInteractable.h"
+#include "VictorTestWorld.h"
+#include "Components/BoxComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "Interaction/InteractionSubsystem.h"
+
+namespace VictorInteractionTest
+{
+	AVictorTestInteractable* SpawnInteractable(UWorld* World, const FVector& Location, float HalfExtent)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		AVictorTestInteractable* Interactable = World->SpawnActor<AVictorTestInteractable>(Location, FRotator::ZeroRotator, SpawnParameters);
+		Interactable->Box->SetBoxExtent(FVector(HalfExtent));
+		Interactable->GetWorld()->GetSubsystem<UInteractionSubsystem>()->UpdateInteractable(Interactable);
+		Interactable->UpdateOverlaps();
+		return Interactable;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVictorInteractionOverlapTest, "Victor.Interaction.Overlap", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVictorInteractionOverlapTest::RunTest(const FString& Parameters)
+{
+	using namespace VictorInteractionTest;
+
+	FVictorTestWorld TestWorld;
+	UWorld* World = TestWorld.GetWorld();
+	UInteractionSubsystem* Interactions = World->GetSubsystem<UInteractionSubsystem>();
+	AVictorCharacter* Character = TestWorld.SpawnCharacter(FVector::ZeroVector, ETeam::ET_Player);
+	const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+	const float Radius = Capsule->GetScaledCapsuleRadius();
+	const float HalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+
+	//touching the side of the capsule
+	AVictorTestInteractable* Touching = SpawnInteractable(World, FVector(Radius + 5.f, 0.f, 0.f), 10.f);
+	//inside the capsule's bounding box, but past the round top of the capsule, like a vent behind the ceiling
+	AVictorTestInteractable* PastCorner = SpawnInteractable(World, FVector(Radius + 5.f, 0.f, HalfHeight + 5.f), 10.f);
+	//nowhere near
+	AVictorTestInteractable* Far = SpawnInteractable(World, FVector(Radius + 500.f, 0.f, 0.f), 10.f);
+	TestEqual(TEXT("Registered interactables"), Interactions->NumInteractables(), 3);
+
+	Character->Interact();
+	TestEqual(TEXT("Overlapping interactable"), Touching->NumInteractions, 1);
+	TestEqual(TEXT("Interactable only inside the bounds"), PastCorner->NumInteractions, 0);
+	TestEqual(TEXT("Far interactable"), Far->NumInteractions, 0);
+
+	//a level streaming out ends play of its actors without destroying them
+	Touching->RouteEndPlay(EEndPlayReason::RemovedFromWorld);
+	TestEqual(TEXT("Interactables after one ended play"), Interactions->NumInteractables(), 2);
+	Character->Interact();
+	TestEqual(TEXT("Interactable that ended play"), Touching->NumInteractions, 1);
+
+	Far->Destroy();
+	TestEqual(TEXT("Interactables after one was destroyed"), Interactions->NumInteractables(), 1);
+	return true;
+}
+
+#endif
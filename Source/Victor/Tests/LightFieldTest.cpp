@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "VictorCharacter.h"
+#include "VictorTestWorld.h"
+#include "Components/BoxComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Lighting/LightFieldSubsystem.h"
+
+namespace VictorLightFieldTest
+{
+	/** A tagged light whose box is the lit area, the way level designers place them */
+	UBoxComponent* SpawnLightBox(UWorld* World, FName LightTag, const FVector& Center, const FVector& HalfExtent)
+	{
+		AActor* Light = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(Center));
+		UBoxComponent* Box = NewObject<UBoxComponent>(Light);
+		Box->SetBoxExtent(HalfExtent);
+		Box->SetCollisionProfileName(UCollisionProfile::OverlapAll_ProfileName);
+		Light->SetRootComponent(Box);
+		Box->RegisterComponent();
+		Box->SetWorldLocation(Center);
+		Light->Tags.Add(LightTag);
+		return Box;
+	}
+
+	/** What the per-character collision query against the light volumes decides */
+	bool IsLitByQuery(const TArray<UBoxComponent*>& Lights, const FVector& Location)
+	{
+		for (UBoxComponent* Light : Lights)
+		{
+			if (Light->OverlapComponent(Location, FQuat::Identity, FCollisionShape::MakeSphere(1.f)))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVictorLightFieldMatchesQueryTest, "Victor.LightField.MatchesQuery", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVictorLightFieldMatchesQueryTest::RunTest(const FString& Parameters)
+{
+	using namespace VictorLightFieldTest;
+
+	FVictorTestWorld TestWorld;
+	UWorld* World = TestWorld.GetWorld();
+	ULightFieldSubsystem* LightFieldSubsystem = World->GetSubsystem<ULightFieldSubsystem>();
+
+	//edges on the light field's cells, and characters at least a cell and a half from any edge
+	TArray<UBoxComponent*> Lights;
+	Lights.Add(SpawnLightBox(World, LightFieldSubsystem->LightActorTag, FVector(0.f, 0.f, 0.f), FVector(192.f, 50.f, 192.f)));
+	Lights.Add(SpawnLightBox(World, LightFieldSubsystem->LightActorTag, FVector(640.f, 0.f, 0.f), FVector(96.f, 50.f, 96.f)));
+	LightFieldSubsystem->MarkLightFieldDirty();
+
+	const float Xs[] = { -400.f, -96.f, 0.f, 96.f, 400.f, 640.f, 900.f };
+	const float Zs[] = { -320.f, 0.f, 128.f };
+	TArray<AVictorCharacter*> Characters;
+	for (const float X : Xs)
+	{
+		for (const float Z : Zs)
+		{
+			AVictorCharacter* Character = TestWorld.SpawnCharacter(FVector(X, 0.f, Z), ETeam::ET_Guards);
+			Character->bShadowFromLightField = true;
+			//stay where they were put
+			Character->GetCharacterMovement()->DisableMovement();
+			Characters.Add(Character);
+		}
+	}
+
+	TestWorld.Tick();
+
+	int32 NumDark = 0;
+	for (AVictorCharacter* Character : Characters)
+	{
+		const FVector Location = Character->GetActorLocation();
+		const bool bLit = IsLitByQuery(Lights, Location);
+		NumDark += bLit ? 0 : 1;
+		TestEqual(FString::Printf(TEXT("In darkness at %s"), *Location.ToString()), Character->bInDarkness, !bLit);
+		TestEqual(FString::Printf(TEXT("Can be seen at %s"), *Location.ToString()), Character->CanBeSeen(), bLit);
+		//the light field must not take the movement-blocking hide state
+		TestFalse(FString::Printf(TEXT("Hidden in shadow at %s"), *Location.ToString()), Character->bHiddenInShadow);
+	}
+	TestTrue(TEXT("Both lit and dark characters were tested"), NumDark > 0 && NumDark < Characters.Num());
+	return true;
+}
+
+#endif
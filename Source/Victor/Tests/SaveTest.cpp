@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "VictorCharacter.h"
+#include "VictorTestWorld.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Save/VictorSaveSubsystem.h"
+#include "Weapons/WeaponBase.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVictorSaveRoundTripTest, "Victor.Save.RoundTrip", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVictorSaveRoundTripTest::RunTest(const FString& Parameters)
+{
+	FString SaveFilePath;
+	{
+		FVictorTestWorld TestWorld;
+		UVictorSaveSubsystem* Saves = TestWorld.GetWorld()->GetSubsystem<UVictorSaveSubsystem>();
+		SaveFilePath = Saves->GetSaveFilePath();
+		TestFalse(TEXT("Load without a checkpoint"), Saves->LoadLastCheckpoint());
+
+		const FVector StartA(0.f, 0.f, 0.f);
+		const FVector StartB(500.f, 0.f, 0.f);
+		AVictorCharacter* A = TestWorld.SpawnCharacter(StartA, ETeam::ET_Guards);
+		AVictorCharacter* B = TestWorld.SpawnCharacter(StartB, ETeam::ET_Guards);
+		A->SetWeapon(AWeaponBase::StaticClass());
+		B->SetWeapon(AWeaponBase::StaticClass());
+		AWeaponBase* WeaponA = A->Weapon;
+		AWeaponBase* WeaponB = B->Weapon;
+		Saves->SaveCheckpoint();
+		TestTrue(TEXT("Checkpoint taken"), Saves->HasCheckpoint());
+
+		//both die and drop their weapons into the pool, a character from after the checkpoint picks one up
+		A->SetActorLocation(StartA + FVector(200.f, 0.f, 0.f));
+		A->Die();
+		B->Die();
+		AVictorCharacter* Late = TestWorld.SpawnCharacter(FVector(-500.f, 0.f, 0.f), ETeam::ET_Guards);
+		Late->SetWeapon(AWeaponBase::StaticClass());
+		AWeaponBase* Taken = Late->Weapon;
+		TestTrue(TEXT("The late character took a pooled weapon"), Taken == WeaponA || Taken == WeaponB);
+
+		TestTrue(TEXT("Load the checkpoint"), Saves->LoadLastCheckpoint());
+		TestFalse(TEXT("A alive again"), A->bDead);
+		TestFalse(TEXT("B alive again"), B->bDead);
+		TestTrue(TEXT("A back where it was"), A->GetActorLocation().Equals(StartA, 1.f));
+
+		//the weapon still in the pool is reclaimed, the one picked up stays with its new owner
+		AVictorCharacter* Robbed = Taken == WeaponA ? A : B;
+		AVictorCharacter* Kept = Taken == WeaponA ? B : A;
+		AWeaponBase* KeptWeapon = Taken == WeaponA ? WeaponB : WeaponA;
+		TestTrue(TEXT("Pooled weapon reclaimed"), Kept->Weapon == KeptWeapon && KeptWeapon->WeaponOwner == Kept && !KeptWeapon->bIsInPool);
+		TestTrue(TEXT("Taken weapon not re-attached"), Robbed->Weapon == nullptr);
+		TestTrue(TEXT("Taken weapon stays with its holder"), Late->Weapon == Taken && Taken->WeaponOwner == Late && Taken->GetAttachParentActor() == Late);
+
+		//the same state comes back from the file
+		Saves->FlushWrites();
+		A->SetActorLocation(StartA + FVector(300.f, 0.f, 0.f));
+		TestTrue(TEXT("Load the save file"), Saves->LoadSaveFile());
+		TestTrue(TEXT("A back where it was after the file load"), A->GetActorLocation().Equals(StartA, 1.f));
+		Saves->FlushWrites();
+	}
+
+	{
+		//another run of the level has no checkpoint of its own, the file it finds is not loaded behind its back
+		FVictorTestWorld TestWorld;
+		UVictorSaveSubsystem* Saves = TestWorld.GetWorld()->GetSubsystem<UVictorSaveSubsystem>();
+		TestTrue(TEXT("Same save file"), Saves->GetSaveFilePath() == SaveFilePath);
+		TestFalse(TEXT("Stale save file not loaded"), Saves->LoadLastCheckpoint());
+	}
+
+	IFileManager::Get().Delete(*SaveFilePath, false, false, true);
+	return true;
+}
+
+#endif
@@ -0,0 +1,17 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Controller.h"
+#include "VictorTestController.generated.h"
+
+/**
+ * Bare controller for the automation tests, AController itself is abstract.
+ * Possesses a character so it turns, without a player or any AI running it.
+ */
+UCLASS(NotBlueprintable, NotPlaceable, Transient)
+class VICTOR_API AVictorTestController : public AController
+{
+	GENERATED_BODY()
+};
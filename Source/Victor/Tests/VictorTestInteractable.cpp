@@ -0,0 +1,19 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VictorTestInteractable.h"
+
+#include "Components/BoxComponent.h"
+
+AVictorTestInteractable::AVictorTestInteractable()
+{
+	Box = CreateDefaultSubobject<UBoxComponent>(TEXT("Box"));
+	Box->SetCollisionProfileName(UCollisionProfile::OverlapAll_ProfileName);
+	Box->SetGenerateOverlapEvents(true);
+	RootComponent = Box;
+}
+
+void AVictorTestInteractable::Interact_Implementation(AActor* interactor)
+{
+	NumInteractions++;
+}
@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Interactions.h"
+#include "VictorTestInteractable.generated.h"
+
+class UBoxComponent;
+
+/**
+ * Native IInteractions implementation for the automation tests, which can't declare classes of their own.
+ * A box that overlaps everything and counts how often it was interacted with.
+ */
+UCLASS(NotBlueprintable, NotPlaceable, Transient)
+class VICTOR_API AVictorTestInteractable : public AActor, public IInteractions
+{
+	GENERATED_BODY()
+
+public:
+	AVictorTestInteractable();
+
+	virtual void Interact_Implementation(AActor* interactor) override;
+
+	virtual bool CanActorBeHeld_Implementation() override { return false; }
+
+	UPROPERTY(VisibleAnywhere)
+	UBoxComponent* Box;
+
+	int32 NumInteractions = 0;
+};
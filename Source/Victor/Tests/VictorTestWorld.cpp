@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VictorTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "VictorCharacter.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "Misc/App.h"
+
+FVictorTestWorld::FVictorTestWorld()
+{
+	World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("VictorTestWorld"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+}
+
+FVictorTestWorld::FVictorTestWorld(const FString& MapName)
+{
+	GameInstance = NewObject<UGameInstance>(GEngine);
+	GameInstance->AddToRoot();
+	GameInstance->InitializeStandalone();
+	FWorldContext* WorldContext = GameInstance->GetWorldContext();
+
+	FString Error;
+	if (GEngine->LoadMap(*WorldContext, FURL(nullptr, *MapName, TRAVEL_Absolute), nullptr, Error))
+	{
+		World = WorldContext->World();
+	}
+}
+
+FVictorTestWorld::~FVictorTestWorld()
+{
+	if (GameInstance != nullptr)
+	{
+		if (World != nullptr)
+		{
+			World->BeginTearingDown();
+		}
+		GameInstance->Shutdown();
+		if (World != nullptr)
+		{
+			World->DestroyWorld(false);
+		}
+		GameInstance->RemoveFromRoot();
+	}
+	else
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
+
+AVictorCharacter* FVictorTestWorld::SpawnCharacter(const FVector& Location, ETeam Team)
+{
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AVictorCharacter* Character = World->SpawnActor<AVictorCharacter>(AVictorCharacter::StaticClass(), Location, FRotator::ZeroRotator, SpawnParameters);
+	if (Character != nullptr)
+	{
+		Character->Team = Team;
+	}
+	return Character;
+}
+
+AActor* FVictorTestWorld::SpawnBlock(const FVector& Center, const FVector& HalfExtent)
+{
+	UStaticMesh* Cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AStaticMeshActor* Block = World->SpawnActor<AStaticMeshActor>(Center, FRotator::ZeroRotator, SpawnParameters);
+	UStaticMeshComponent* Mesh = Block->GetStaticMeshComponent();
+	Mesh->SetMobility(EComponentMobility::Movable);
+	Mesh->SetStaticMesh(Cube);
+	//the engine cube is 100 units across
+	Block->SetActorScale3D(HalfExtent / 50.f);
+	Mesh->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	Mesh->SetMobility(EComponentMobility::Static);
+	return Block;
+}
+
+void FVictorTestWorld::Tick(int32 Frames, float DeltaTime)
+{
+	for (int32 Frame = 0; Frame < Frames; Frame++)
+	{
+		FApp::SetDeltaTime(DeltaTime);
+		FApp::SetCurrentTime(FApp::GetCurrentTime() + DeltaTime);
+		World->Tick(LEVELTICK_All, DeltaTime);
+		GFrameCounter++;
+	}
+}
+
+#endif
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+class AActor;
+class AVictorCharacter;
+class UGameInstance;
+class UWorld;
+struct FWorldContext;
+enum class ETeam : uint8;
+
+/**
+ * Empty game world for automation tests, with the Victor world subsystems, that has begun play.
+ * Destroyed with everything spawned in it when the fixture goes out of scope.
+ */
+class FVictorTestWorld
+{
+public:
+	FVictorTestWorld();
+
+	/** Loads the map into a standalone game instance, the way the benchmark commandlet does. GetWorld is null if it can't be loaded */
+	explicit FVictorTestWorld(const FString& MapName);
+
+	~FVictorTestWorld();
+
+	UWorld* GetWorld() const { return World; }
+
+	/** A native Victor character, standing wherever it is put; ticks only through the world */
+	AVictorCharacter* SpawnCharacter(const FVector& Location, ETeam Team);
+
+	/** Static cube with block-all collision filling Center +- HalfExtent */
+	AActor* SpawnBlock(const FVector& Center, const FVector& HalfExtent);
+
+	/** Ticks the world Frames times at DeltaTime, the way the benchmark commandlet does */
+	void Tick(int32 Frames = 1, float DeltaTime = 1.f / 60.f);
+
+private:
+	UWorld* World = nullptr;
+
+	UGameInstance* GameInstance = nullptr;
+};
+
+#endif
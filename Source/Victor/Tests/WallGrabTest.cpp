@@ -0,0 +1,240 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "VictorCharacter.h"
+#include "VictorTestWorld.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/GameModeBase.h"
+#include "HAL/IConsoleManager.h"
+#include "World/LevelGridSubsystem.h"
+
+namespace VictorWallGrabTest
+{
+	/** Puts the character so the front of its WallGrabBox is Gap units short of WallX, a negative gap overlaps the wall */
+	void PlaceBeforeWall(AVictorCharacter* Character, float WallX, float Gap)
+	{
+		const UBoxComponent* Box = Character->GetWallGrabBox();
+		const float BoxFront = Box->GetComponentLocation().X + Box->GetScaledBoxExtent().X - Character->GetActorLocation().X;
+		const FVector Location = Character->GetActorLocation();
+		Character->SetActorLocation(FVector(WallX - Gap - BoxFront, Location.Y, Location.Z));
+	}
+
+	/** What characters did in one replay of the example map */
+	struct FReplay
+	{
+		//bIsHoldingWall of every character, frame after frame
+		TArray<bool> HoldingWall;
+		//overlap pairs the characters' components kept, per frame
+		TArray<int32> OverlapPairs;
+		int32 NumCharacters = 0;
+		int32 Grabs = 0;
+	};
+
+	/**
+	 * Loads the example map with victor.WallGrabQuery set to WallGrabQuery and walks and jumps NumCharacters
+	 * characters along it for Frames frames, the way the benchmark's WallGrab scenario does.
+	 */
+	bool ReplayExampleMap(FAutomationTestBase& Test, int32 WallGrabQuery, int32 NumCharacters, int32 Frames, FReplay& OutReplay)
+	{
+		IConsoleVariable* CVar = IConsoleManager::Get().FindConsoleVariable(TEXT("victor.WallGrabQuery"));
+		const int32 PreviousValue = CVar->GetInt();
+		//read when the characters begin play, the map's own ones too
+		CVar->Set(WallGrabQuery, ECVF_SetByCode);
+
+		bool bLoaded = false;
+		{
+			FVictorTestWorld TestWorld(TEXT("/Game/2DSideScrollerCPP/Maps/2DSideScrollerExampleMap"));
+			UWorld* World = TestWorld.GetWorld();
+			bLoaded = Test.TestNotNull(TEXT("Example map"), World);
+			if (bLoaded)
+			{
+				AGameModeBase* GameMode = World->GetAuthGameMode();
+				const AActor* PlayerStart = GameMode != nullptr ? GameMode->FindPlayerStart(nullptr) : nullptr;
+				const FVector StartLocation = PlayerStart != nullptr ? PlayerStart->GetActorLocation() : FVector::ZeroVector;
+				FActorSpawnParameters SpawnParameters;
+				SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+				//far enough apart that no character's box reaches another, overlap events would grab characters too
+				TArray<AVictorCharacter*> Characters;
+				for (int32 i = 0; i < NumCharacters; i++)
+				{
+					const FVector Location = StartLocation + FVector((i - NumCharacters / 2) * 1500.f, 0.f, 0.f);
+					AVictorCharacter* Character = World->SpawnActor<AVictorCharacter>(AVictorCharacter::StaticClass(), Location, FRotator::ZeroRotator, SpawnParameters);
+					if (Character != nullptr)
+					{
+						Character->SpawnDefaultController();
+						Characters.Add(Character);
+					}
+				}
+				OutReplay.NumCharacters = Characters.Num();
+
+				TArray<UPrimitiveComponent*> Components;
+				for (int32 Frame = 0; Frame < Frames; Frame++)
+				{
+					for (int32 i = 0; i < Characters.Num(); i++)
+					{
+						//all run the same way, so they keep apart, and jump at different times
+						Characters[i]->MoveRight((Frame / 90) % 2 == 0 ? 1.f : -1.f);
+						if ((Frame + i * 7) % 45 == 0)
+						{
+							Characters[i]->Jump();
+						}
+						else if ((Frame + i * 7) % 45 == 20)
+						{
+							Characters[i]->StopJumping();
+						}
+					}
+					TestWorld.Tick();
+
+					int32 OverlapPairs = 0;
+					for (AVictorCharacter* Character : Characters)
+					{
+						const bool bWasHolding = OutReplay.HoldingWall.Num() >= Characters.Num() && OutReplay.HoldingWall[OutReplay.HoldingWall.Num() - Characters.Num()];
+						OutReplay.Grabs += Character->bIsHoldingWall && !bWasHolding ? 1 : 0;
+						OutReplay.HoldingWall.Add(Character->bIsHoldingWall);
+
+						Character->GetComponents(Components);
+						for (const UPrimitiveComponent* Component : Components)
+						{
+							OverlapPairs += Component->GetOverlapInfos().Num();
+						}
+					}
+					OutReplay.OverlapPairs.Add(OverlapPairs);
+				}
+			}
+		}
+
+		CVar->Set(PreviousValue, ECVF_SetByCode);
+		return bLoaded;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVictorWallGrabTest, "Victor.WallGrab.Query", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVictorWallGrabTest::RunTest(const FString& Parameters)
+{
+	using namespace VictorWallGrabTest;
+
+	FVictorTestWorld TestWorld;
+	ULevelGridSubsystem& LevelGrid = *TestWorld.GetWorld()->GetSubsystem<ULevelGridSubsystem>();
+	const float WallX = 200.f;
+	TestWorld.SpawnBlock(FVector(WallX + 50.f, 0.f, 300.f), FVector(50.f, 200.f, 300.f));
+	AVictorCharacter* Character = TestWorld.SpawnCharacter(FVector(0.f, 0.f, 300.f), ETeam::ET_Guards);
+	UCharacterMovementComponent* Movement = Character->GetCharacterMovement();
+
+	//the first airborne update only records what the box touches
+	Movement->SetMovementMode(MOVE_Falling);
+	PlaceBeforeWall(Character, WallX, 40.f);
+	Character->UpdateWallGrab(LevelGrid);
+	Character->UpdateWallGrab(LevelGrid);
+	TestFalse(TEXT("Holding a wall 40 units away"), Character->bIsHoldingWall);
+
+	//in the wall's cell, but not touching the wall
+	PlaceBeforeWall(Character, WallX, 4.f);
+	Character->UpdateWallGrab(LevelGrid);
+	TestFalse(TEXT("Holding a wall 4 units away"), Character->bIsHoldingWall);
+
+	PlaceBeforeWall(Character, WallX, -4.f);
+	Character->UpdateWallGrab(LevelGrid);
+	TestTrue(TEXT("Holding the wall the box touches"), Character->bIsHoldingWall);
+
+	//landing lets go even though the box still touches the wall
+	Movement->SetMovementMode(MOVE_Walking);
+	Character->UpdateWallGrab(LevelGrid);
+	TestFalse(TEXT("Holding the wall after landing"), Character->bIsHoldingWall);
+	TestEqual(TEXT("Gravity after landing"), Movement->GravityScale, 2.f);
+
+	//geometry that moves is grabbed like the level's
+	const float PlatformX = -400.f;
+	AActor* Platform = TestWorld.SpawnBlock(FVector(PlatformX + 50.f, 0.f, 1000.f), FVector(50.f, 200.f, 100.f));
+	Cast<AStaticMeshActor>(Platform)->GetStaticMeshComponent()->SetMobility(EComponentMobility::Movable);
+	//made movable after it spawned
+	LevelGrid.RegisterMovableBlockers(Platform);
+	TestEqual(TEXT("Movable blockers"), LevelGrid.GetNumMovableBlockers(), 1);
+	AVictorCharacter* Climber = TestWorld.SpawnCharacter(FVector(-600.f, 0.f, 1000.f), ETeam::ET_Guards);
+	Climber->GetCharacterMovement()->SetMovementMode(MOVE_Falling);
+	PlaceBeforeWall(Climber, PlatformX, 20.f);
+	Climber->UpdateWallGrab(LevelGrid);
+	PlaceBeforeWall(Climber, PlatformX, 4.f);
+	Climber->UpdateWallGrab(LevelGrid);
+	TestFalse(TEXT("Holding a movable wall 4 units away"), Climber->bIsHoldingWall);
+	PlaceBeforeWall(Climber, PlatformX, -4.f);
+	Climber->UpdateWallGrab(LevelGrid);
+	TestTrue(TEXT("Holding a movable wall"), Climber->bIsHoldingWall);
+
+	//the platform moves away from the box on the next frame
+	Platform->SetActorLocation(Platform->GetActorLocation() + FVector(100.f, 0.f, 0.f));
+	TestWorld.Tick();
+	Climber->GetCharacterMovement()->SetMovementMode(MOVE_Falling);
+	Climber->UpdateWallGrab(LevelGrid);
+	TestFalse(TEXT("Holding a movable wall that moved away"), Climber->bIsHoldingWall);
+
+	//other characters are not walls
+	AVictorCharacter* Other = TestWorld.SpawnCharacter(FVector(0.f, 0.f, 2000.f), ETeam::ET_Guards);
+	Other->GetCharacterMovement()->SetMovementMode(MOVE_Falling);
+	Other->UpdateWallGrab(LevelGrid);
+	Character->SetActorLocation(Other->GetWallGrabBox()->GetComponentLocation());
+	Other->UpdateWallGrab(LevelGrid);
+	TestFalse(TEXT("Holding another character"), Other->bIsHoldingWall);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FVictorWallGrabExampleMapTest, "Victor.WallGrab.ExampleMap", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FVictorWallGrabExampleMapTest::RunTest(const FString& Parameters)
+{
+	using namespace VictorWallGrabTest;
+
+	const int32 NumCharacters = 3;
+	const int32 Frames = 900;
+	FReplay OverlapReplay;
+	FReplay GridReplay;
+	if (!ReplayExampleMap(*this, 0, NumCharacters, Frames, OverlapReplay) || !ReplayExampleMap(*this, 1, NumCharacters, Frames, GridReplay))
+	{
+		return false;
+	}
+	TestEqual(TEXT("Characters"), GridReplay.NumCharacters, OverlapReplay.NumCharacters);
+	TestEqual(TEXT("Recorded frames"), GridReplay.HoldingWall.Num(), OverlapReplay.HoldingWall.Num());
+
+	//the same frames grab and let go of the same walls
+	for (int32 i = 0; i < OverlapReplay.HoldingWall.Num() && i < GridReplay.HoldingWall.Num(); i++)
+	{
+		if (OverlapReplay.HoldingWall[i] != GridReplay.HoldingWall[i])
+		{
+			AddError(FString::Printf(TEXT("Character %d on frame %d is %s the wall with overlap events and %s it with the grid"),
+				i % OverlapReplay.NumCharacters, i / OverlapReplay.NumCharacters,
+				OverlapReplay.HoldingWall[i] ? TEXT("holding") : TEXT("not holding"), GridReplay.HoldingWall[i] ? TEXT("holding") : TEXT("not holding")));
+			break;
+		}
+	}
+	TestEqual(TEXT("Grabs"), GridReplay.Grabs, OverlapReplay.Grabs);
+	if (OverlapReplay.Grabs == 0)
+	{
+		AddWarning(TEXT("No character grabbed a wall, the replay doesn't compare any transitions"));
+	}
+
+	int64 OverlapPairs = 0;
+	int64 GridPairs = 0;
+	for (int32 Frame = 0; Frame < Frames; Frame++)
+	{
+		const int32 OverlapFramePairs = OverlapReplay.OverlapPairs.IsValidIndex(Frame) ? OverlapReplay.OverlapPairs[Frame] : 0;
+		const int32 GridFramePairs = GridReplay.OverlapPairs.IsValidIndex(Frame) ? GridReplay.OverlapPairs[Frame] : 0;
+		AddInfo(FString::Printf(TEXT("Frame %d overlap pairs: %d with overlap events, %d with the grid"), Frame, OverlapFramePairs, GridFramePairs));
+		OverlapPairs += OverlapFramePairs;
+		GridPairs += GridFramePairs;
+	}
+	AddInfo(FString::Printf(TEXT("Overlap pairs per frame: %.2f with overlap events, %.2f with the grid, %d grabs"),
+		double(OverlapPairs) / Frames, double(GridPairs) / Frames, GridReplay.Grabs));
+	TestTrue(TEXT("The grid path keeps fewer overlap pairs"), GridPairs <= OverlapPairs);
+	return true;
+}
+
+#endif
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayTimerSubsystem.h"
+
+#include "VictorStats.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Gameplay timers"), STAT_VictorGameplayTimers, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gameplay timers active"), STAT_VictorGameplayTimersActive, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Gameplay timers fired"), STAT_VictorGameplayTimersFired, STATGROUP_Victor);
+
+void UGameplayTimerSubsystem::Deinitialize()
+{
+	Wheel.Reset();
+
+	Super::Deinitialize();
+}
+
+uint64 UGameplayTimerSubsystem::GetWorldTick() const
+{
+	return uint64(FMath::Max(double(GetWorld()->GetTimeSeconds()) / TickSeconds, 0.0));
+}
+
+void UGameplayTimerSubsystem::SetTimer(FGameplayTimerHandle& Handle, FSimpleDelegate&& Callback, float Delay)
+{
+	Wheel.Cancel(Handle);
+	//the last timer's callback sees an empty wheel, but that one is already at the world's tick
+	if (Wheel.Num() == 0 && !Wheel.IsAdvancing())
+	{
+		//an idle wheel isn't ticked, catch up so the deadline isn't counted from an old tick
+		Wheel.Advance(GetWorldTick());
+	}
+	const uint64 DelayTicks = uint64(FMath::Max(FMath::CeilToInt(Delay / TickSeconds), 1));
+	Handle = Wheel.Schedule(GetWorldTick() + DelayTicks, MoveTemp(Callback));
+}
+
+void UGameplayTimerSubsystem::ClearTimer(FGameplayTimerHandle& Handle)
+{
+	Wheel.Cancel(Handle);
+	Handle.Invalidate();
+}
+
+float UGameplayTimerSubsystem::GetTimerRemaining(const FGameplayTimerHandle& Handle) const
+{
+	const int64 RemainingTicks = Wheel.GetRemainingTicks(Handle);
+	return RemainingTicks >= 0 ? RemainingTicks * TickSeconds : -1.f;
+}
+
+void UGameplayTimerSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorGameplayTimers);
+	const int32 NumFired = Wheel.Advance(GetWorldTick());
+
+	SET_DWORD_STAT(STAT_VictorGameplayTimersFired, NumFired);
+	SET_DWORD_STAT(STAT_VictorGameplayTimersActive, Wheel.Num());
+}
+
+TStatId UGameplayTimerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGameplayTimerSubsystem, STATGROUP_Tickables);
+}
+
+ETickableTickType UGameplayTimerSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Timers/GameplayTimerWheel.h"
+#include "GameplayTimerSubsystem.generated.h"
+
+/**
+ * One-shot gameplay timers of the world on a FGameplayTimerWheel, instead of an FTimerManager entry per timer.
+ * Timers run on world time, so they stop while the game is paused and follow time dilation, and are rounded up
+ * to whole ticks of TickSeconds. The timers that expired in a frame fire together once the world ticked.
+ * Callbacks bound to an object are dropped if the object is gone by then.
+ */
+UCLASS(config=Game)
+class VICTOR_API UGameplayTimerSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	/** Fires Callback in Delay seconds. Replaces the timer Handle was set to, if it hasn't fired yet */
+	void SetTimer(FGameplayTimerHandle& Handle, FSimpleDelegate&& Callback, float Delay);
+
+	template<typename UserClass>
+	void SetTimer(FGameplayTimerHandle& Handle, UserClass* Object, typename FSimpleDelegate::TUObjectMethodDelegate<UserClass>::FMethodPtr Method, float Delay)
+	{
+		SetTimer(Handle, FSimpleDelegate::CreateUObject(Object, Method), Delay);
+	}
+
+	/** Cancels the timer if it hasn't fired yet and invalidates Handle */
+	void ClearTimer(FGameplayTimerHandle& Handle);
+
+	bool IsTimerActive(const FGameplayTimerHandle& Handle) const { return Wheel.IsScheduled(Handle); }
+
+	/** Seconds until the timer fires, -1 if it isn't active */
+	float GetTimerRemaining(const FGameplayTimerHandle& Handle) const;
+
+	int32 GetNumTimers() const { return Wheel.Num(); }
+
+	/** Length of a wheel tick, the precision timers fire with */
+	UPROPERTY(Config, EditAnywhere, Category = Timers, meta = (ClampMin = "0.001"))
+	float TickSeconds = 1.f / 120.f;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return Wheel.Num() > 0; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual ETickableTickType GetTickableTickType() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	//wheel tick the world time is in
+	uint64 GetWorldTick() const;
+
+	FGameplayTimerWheel Wheel;
+};
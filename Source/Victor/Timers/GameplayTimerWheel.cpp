@@ -0,0 +1,204 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GameplayTimerWheel.h"
+
+FGameplayTimerWheel::FGameplayTimerWheel()
+{
+	Reset();
+}
+
+void FGameplayTimerWheel::Reset()
+{
+	Entries.Reset();
+	Callbacks.Reset();
+	Expired.Reset();
+	for (int32& Head : SlotHeads)
+	{
+		Head = INDEX_NONE;
+	}
+	FirstFree = INDEX_NONE;
+	NumScheduled = 0;
+	NumInSlots = 0;
+}
+
+FGameplayTimerHandle FGameplayTimerWheel::Schedule(uint64 Deadline, FSimpleDelegate&& Callback)
+{
+	int32 Index = FirstFree;
+	if (Index != INDEX_NONE)
+	{
+		FirstFree = Entries[Index].Next;
+		Callbacks[Index] = MoveTemp(Callback);
+	}
+	else
+	{
+		Index = Entries.AddUninitialized();
+		Callbacks.Add(MoveTemp(Callback));
+	}
+
+	FEntry& Entry = Entries[Index];
+	Entry.Deadline = FMath::Max(Deadline, CurrentTick + 1);
+	Entry.Serial = NextSerial;
+	NextSerial = NextSerial == MAX_uint32 ? 1 : NextSerial + 1;
+	NumScheduled++;
+	Insert(Index);
+	return { uint32(Index), Entry.Serial };
+}
+
+bool FGameplayTimerWheel::Cancel(const FGameplayTimerHandle& Handle)
+{
+	if (FindEntry(Handle) == nullptr)
+	{
+		return false;
+	}
+	//an expired timer still waiting for its callback is only freed, Advance skips it
+	if (Entries[Handle.Index].Slot != ExpiredSlot)
+	{
+		Unlink(Handle.Index);
+	}
+	Free(Handle.Index);
+	return true;
+}
+
+bool FGameplayTimerWheel::IsScheduled(const FGameplayTimerHandle& Handle) const
+{
+	return FindEntry(Handle) != nullptr;
+}
+
+int64 FGameplayTimerWheel::GetRemainingTicks(const FGameplayTimerHandle& Handle) const
+{
+	const FEntry* Entry = FindEntry(Handle);
+	if (Entry == nullptr)
+	{
+		return -1;
+	}
+	return Entry->Deadline > CurrentTick ? int64(Entry->Deadline - CurrentTick) : 0;
+}
+
+int32 FGameplayTimerWheel::Advance(uint64 Tick)
+{
+	//Expired is being iterated further up the stack
+	if (!ensureMsgf(!bAdvancing, TEXT("FGameplayTimerWheel::Advance called from a timer callback")))
+	{
+		return 0;
+	}
+	TGuardValue<bool> AdvancingGuard(bAdvancing, true);
+	Expired.Reset();
+	while (CurrentTick < Tick)
+	{
+		if (NumInSlots == 0)
+		{
+			//nothing to cascade or expire on the way
+			CurrentTick = Tick;
+			break;
+		}
+		CurrentTick++;
+
+		//top level first, so timers moving down can move down again in the same tick
+		for (int32 Level = NumLevels - 1; Level > 0; Level--)
+		{
+			const int32 Shift = SlotBits * Level;
+			if ((CurrentTick & ((uint64(1) << Shift) - 1)) == 0)
+			{
+				Cascade(Level, int32((CurrentTick >> Shift) & SlotMask));
+			}
+		}
+
+		int32& Head = SlotHeads[CurrentTick & SlotMask];
+		for (int32 Index = Head; Index != INDEX_NONE; Index = Entries[Index].Next)
+		{
+			Entries[Index].Slot = ExpiredSlot;
+			Expired.Add({ uint32(Index), Entries[Index].Serial });
+			NumInSlots--;
+		}
+		Head = INDEX_NONE;
+	}
+
+	int32 NumFired = 0;
+	for (const FGameplayTimerHandle& Handle : Expired)
+	{
+		//cancelled by an earlier callback of this batch
+		if (FindEntry(Handle) == nullptr)
+		{
+			continue;
+		}
+		//freed first so the callback can set its timer again
+		FSimpleDelegate Callback = MoveTemp(Callbacks[Handle.Index]);
+		Free(Handle.Index);
+		Callback.ExecuteIfBound();
+		NumFired++;
+	}
+	Expired.Reset();
+	return NumFired;
+}
+
+SIZE_T FGameplayTimerWheel::GetAllocatedSize() const
+{
+	return Entries.GetAllocatedSize() + Callbacks.GetAllocatedSize() + Expired.GetAllocatedSize();
+}
+
+void FGameplayTimerWheel::Insert(int32 Index)
+{
+	FEntry& Entry = Entries[Index];
+	const uint64 Delta = Entry.Deadline > CurrentTick ? Entry.Deadline - CurrentTick : 0;
+	int32 Level = 0;
+	while (Level < NumLevels - 1 && Delta >= (uint64(1) << (SlotBits * (Level + 1))))
+	{
+		Level++;
+	}
+	const int32 Slot = Level * NumSlots + int32((Entry.Deadline >> (SlotBits * Level)) & SlotMask);
+
+	Entry.Slot = uint16(Slot);
+	Entry.Prev = INDEX_NONE;
+	Entry.Next = SlotHeads[Slot];
+	if (Entry.Next != INDEX_NONE)
+	{
+		Entries[Entry.Next].Prev = Index;
+	}
+	SlotHeads[Slot] = Index;
+	NumInSlots++;
+}
+
+void FGameplayTimerWheel::Unlink(int32 Index)
+{
+	FEntry& Entry = Entries[Index];
+	if (Entry.Prev != INDEX_NONE)
+	{
+		Entries[Entry.Prev].Next = Entry.Next;
+	}
+	else
+	{
+		SlotHeads[Entry.Slot] = Entry.Next;
+	}
+	if (Entry.Next != INDEX_NONE)
+	{
+		Entries[Entry.Next].Prev = Entry.Prev;
+	}
+	Entry.Slot = NoSlot;
+	NumInSlots--;
+}
+
+void FGameplayTimerWheel::Free(int32 Index)
+{
+	FEntry& Entry = Entries[Index];
+	Entry.Serial = 0;
+	Entry.Slot = NoSlot;
+	Entry.Next = FirstFree;
+	FirstFree = Index;
+	Callbacks[Index].Unbind();
+	NumScheduled--;
+}
+
+void FGameplayTimerWheel::Cascade(int32 Level, int32 Slot)
+{
+	int32& Head = SlotHeads[Level * NumSlots + Slot];
+	int32 Index = Head;
+	Head = INDEX_NONE;
+	while (Index != INDEX_NONE)
+	{
+		const int32 Next = Entries[Index].Next;
+		NumInSlots--;
+		Insert(Index);
+		Index = Next;
+	}
+}
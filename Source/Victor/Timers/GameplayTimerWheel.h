@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** One timer of a FGameplayTimerWheel. Stays valid after the timer fired or was cancelled until it is invalidated */
+struct FGameplayTimerHandle
+{
+	uint32 Index = 0;
+
+	/** 0 for a handle that was never set */
+	uint32 Serial = 0;
+
+	bool IsValid() const { return Serial != 0; }
+
+	void Invalidate() { Serial = 0; }
+
+	bool operator==(const FGameplayTimerHandle& Other) const { return Index == Other.Index && Serial == Other.Serial; }
+
+	bool operator!=(const FGameplayTimerHandle& Other) const { return !(*this == Other); }
+};
+
+/**
+ * Hierarchical timing wheel of one-shot timers, in whole ticks.
+ * Level 0 has a slot per tick for the next NumSlots ticks, every level above a slot per NumSlots ticks of the level
+ * below; a timer sits in the lowest level its deadline fits in and moves down when its slot comes up, so scheduling,
+ * cancelling and firing are O(1) however many timers there are. Deadlines past the top level wait in it and are
+ * put back each time their slot comes up.
+ * Timers are 24 byte entries linked into their slot, callbacks are kept apart and only touched when the timer fires.
+ */
+class VICTOR_API FGameplayTimerWheel
+{
+public:
+	static constexpr int32 SlotBits = 6;
+
+	static constexpr int32 NumSlots = 1 << SlotBits;
+
+	static constexpr int32 NumLevels = 4;
+
+	FGameplayTimerWheel();
+
+	/** Fires Callback on the Advance that reaches Deadline, the next tick if Deadline isn't after the current one */
+	FGameplayTimerHandle Schedule(uint64 Deadline, FSimpleDelegate&& Callback);
+
+	/** False if the timer already fired or was cancelled */
+	bool Cancel(const FGameplayTimerHandle& Handle);
+
+	bool IsScheduled(const FGameplayTimerHandle& Handle) const;
+
+	/** Ticks until the timer fires, -1 if it isn't scheduled */
+	int64 GetRemainingTicks(const FGameplayTimerHandle& Handle) const;
+
+	/**
+	 * Moves the wheel to Tick and fires every timer that expired on the way, in deadline order, in one pass after
+	 * the wheel got there. Callbacks may schedule and cancel timers; new ones don't fire before the next Advance.
+	 * Callbacks can't advance the wheel, a nested Advance does nothing. Returns how many timers fired.
+	 */
+	int32 Advance(uint64 Tick);
+
+	/** True while Advance fires callbacks */
+	bool IsAdvancing() const { return bAdvancing; }
+
+	uint64 GetCurrentTick() const { return CurrentTick; }
+
+	/** Timers scheduled and not fired or cancelled yet */
+	int32 Num() const { return NumScheduled; }
+
+	void Reset();
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	static constexpr uint16 NoSlot = MAX_uint16;
+
+	//slot of a timer that expired and waits for its callback in Advance
+	static constexpr uint16 ExpiredSlot = MAX_uint16 - 1;
+
+	struct FEntry
+	{
+		uint64 Deadline;
+		//neighbours in the slot's list, or the next free entry
+		int32 Next;
+		int32 Prev;
+		//0 while the entry is free
+		uint32 Serial;
+		//Level * NumSlots + slot, NoSlot or ExpiredSlot
+		uint16 Slot;
+	};
+
+	static constexpr uint64 SlotMask = NumSlots - 1;
+
+	const FEntry* FindEntry(const FGameplayTimerHandle& Handle) const
+	{
+		if (!Handle.IsValid() || !Entries.IsValidIndex(Handle.Index))
+		{
+			return nullptr;
+		}
+		const FEntry& Entry = Entries[Handle.Index];
+		return Entry.Serial == Handle.Serial ? &Entry : nullptr;
+	}
+
+	//puts the entry in the slot its deadline belongs to from CurrentTick
+	void Insert(int32 Index);
+
+	void Unlink(int32 Index);
+
+	void Free(int32 Index);
+
+	//moves the timers of a slot above level 0 to the levels below
+	void Cascade(int32 Level, int32 Slot);
+
+	TArray<FEntry> Entries;
+
+	TArray<FSimpleDelegate> Callbacks;
+
+	//first entry of every slot's list, INDEX_NONE if empty
+	int32 SlotHeads[NumLevels * NumSlots];
+
+	int32 FirstFree = INDEX_NONE;
+
+	int32 NumScheduled = 0;
+
+	//timers in the slots, without the expired ones waiting for their callback
+	int32 NumInSlots = 0;
+
+	uint32 NextSerial = 1;
+
+	uint64 CurrentTick = 0;
+
+	bool bAdvancing = false;
+
+	//timers that expired during one Advance, fired once the wheel is at the target tick
+	TArray<FGameplayTimerHandle> Expired;
+};
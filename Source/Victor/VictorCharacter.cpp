@@ -3,6 +3,9 @@
 #include "VictorCharacter.h"
 
 #include "Interactions.h"
+#include "Animation/CrowdSpriteSubsystem.h"
+#include "Audio/GameplayAudioSubsystem.h"
+#include "PaperFlipbook.h"
 #include "PaperFlipbookComponent.h"
 #include "Components/TextRenderComponent.h"
 #include "Components/CapsuleComponent.h"
@@ -11,15 +14,48 @@
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/Controller.h"
 #include "Camera/CameraComponent.h"
+#include "Engine/AssetManager.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "HAL/IConsoleManager.h"
 #include "Player/PossesivePlayerController.h"
+#include "Characters/CharacterUpdateSubsystem.h"
+#include "Characters/VictorMovementComponent.h"
+#include "Weapons/DamageQueueSubsystem.h"
+#include "Weapons/WeaponPoolSubsystem.h"
+#include "Weapons/WeaponSocketCache.h"
+#include "Possession/PossessionTargetSubsystem.h"
+#include "Interaction/InteractionSubsystem.h"
+#include "Save/VictorSaveSubsystem.h"
+#include "Timers/GameplayTimerSubsystem.h"
+#include "World/LevelGridSubsystem.h"
+#include "VictorStats.h"
 
 
 DEFINE_LOG_CATEGORY_STATIC(SideScrollerCharacter, Log, All);
 
+static TAutoConsoleVariable<int32> CVarWallGrabQuery(
+	TEXT("victor.WallGrabQuery"),
+	1,
+	TEXT("1 - airborne characters find walls to grab by testing WallGrabBox against the level collision grid and the movable blockers, without physics overlaps (default).\n")
+	TEXT("0 - WallGrabBox overlaps every channel and its overlap events grab the wall, as before. Read when a character begins play."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarAnimationBundles(
+	TEXT("victor.AnimationBundles"),
+	1,
+	TEXT("1 - character flipbooks are loaded asynchronously per bundle, when the weapon, the camera or death needs them (default).\n")
+	TEXT("0 - every bundle is loaded when the character begins play, like the hard references used to be. Read when a character begins play."),
+	ECVF_Default);
+
+//half of one screen of the side view camera, OrthoWidth 2048 at 16:9
+static const FVector2D NetScreenHalfExtent(1024.f, 576.f);
+
 //////////////////////////////////////////////////////////////////////////
 // AVictorCharacter
 
-AVictorCharacter::AVictorCharacter()
+AVictorCharacter::AVictorCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UVictorMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	// Use only Yaw from the controller and ignore the rest of the rotation.
 	bUseControllerRotationPitch = false;
@@ -60,9 +96,7 @@ AVictorCharacter::AVictorCharacter()
 	GetCharacterMovement()->MaxWalkSpeed = 600.0f;
 	GetCharacterMovement()->MaxFlySpeed = 600.0f;
 
-	DeathAudio = CreateDefaultSubobject<UAudioComponent>(TEXT("DeathAudio"));
-	DeathAudio->SetupAttachment(RootComponent);
-	DeathAudio->bAutoActivate = false;
+	FootstepSound = TSoftObjectPtr<USoundBase>(FSoftObjectPath(TEXT("/Game/Retro_8Bit_Sounds/Footstep_Movement/Cues/retro_footstep_movement_01_Cue.retro_footstep_movement_01_Cue")));
 
 	WallGrabBox=CreateDefaultSubobject<UBoxComponent>(TEXT("WallGrabBox"));
 	WallGrabBox->SetupAttachment(RootComponent);
@@ -85,9 +119,12 @@ AVictorCharacter::AVictorCharacter()
     // 	TextComponent->SetRelativeRotation(FRotator(0.0f, 90.0f, 0.0f));
     // 	TextComponent->SetupAttachment(RootComponent);
 
-	// Enable replication on the Sprite component so animations show up when networked
-	GetSprite()->SetIsReplicated(true);
+	// Replicate the gameplay flags and the plane movement. Every machine picks the flipbook from those,
+	// so the sprite component isn't replicated, and guards that stand still send nothing
 	bReplicates = true;
+	SetReplicatingMovement(false);
+	NetUpdateFrequency = 30.f;
+	MinNetUpdateFrequency = 5.f;
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -95,7 +132,14 @@ AVictorCharacter::AVictorCharacter()
 
 bool AVictorCharacter::SetWeapon(TSubclassOf<AWeaponBase> WeaponClass)
 {
-	Weapon = GetWorld()->SpawnActor<AWeaponBase>(WeaponClass);
+	UWeaponPoolSubsystem* WeaponPool = GetWorld()->GetSubsystem<UWeaponPoolSubsystem>();
+	if(Weapon != nullptr)
+	{
+		WeaponPool->ReleaseWeapon(Weapon);
+	}
+	Weapon = WeaponPool->AcquireWeapon(WeaponClass);
+	//start loading the new weapon's flipbooks before the state key switches to them
+	RequestWeaponAnimationBundles();
 	if(Weapon != nullptr)
 	{
 		Weapon->AttachToComponent(GetSprite(),FAttachmentTransformRules::SnapToTargetNotIncludingScale, GetWeaponAttachmentSocketName(Weapon->AnimType));
@@ -107,67 +151,274 @@ bool AVictorCharacter::SetWeapon(TSubclassOf<AWeaponBase> WeaponClass)
 
 void AVictorCharacter::UpdateAnimation()
 {
-	if(!bDead && !bPlayingMeleeAttackAnim)
+	VICTOR_SCOPE_CYCLE_COUNTER(UpdateAnimation);
+	const uint16 StateKey = GetAnimationStateKey();
+	if (StateKey != AnimationStateKey)
 	{
-		// Are we moving or standing still?
-		UPaperFlipbook* DesiredAnimation = GetDesiredAnimation(); 
-		if( GetSprite()->GetFlipbook() != DesiredAnimation 	)
+		ApplyAnimationState(StateKey, GetDesiredAnimation());
+	}
+}
+
+void AVictorCharacter::ApplyAnimationState(uint16 StateKey, UPaperFlipbook* Flipbook)
+{
+	AnimationStateKey = StateKey;
+	//Die() and the melee attack drive the sprite themselves
+	if(!FAnimationStateKey::IsDead(StateKey) && !FAnimationStateKey::IsAttacking(StateKey))
+	{
+		if (Flipbook == nullptr)
+		{
+			//not loaded yet, the last flipbook stays until OnAnimationBundleLoaded picks it again
+			RequestAnimationBundle(GetAnimationBundle(StateKey), FStreamableManager::AsyncLoadHighPriority);
+		}
+		else if( GetSprite()->GetFlipbook() != Flipbook 	)
 		{
-			GetSprite()->SetFlipbook(DesiredAnimation);
+			GetSprite()->SetFlipbook(Flipbook);
 		}
 		if (!GetSprite()->IsLooping()) { GetSprite()->SetLooping(true); GetSprite()->PlayFromStart(); }
 	}
 }
 
+void AVictorCharacter::RequestAnimationBundle(EAnimationBundle Bundle, TAsyncLoadPriority Priority)
+{
+	AnimationBundleRequestTimes[(int32)Bundle] = GetWorld()->GetTimeSeconds();
+	TSharedPtr<FStreamableHandle>& Handle = AnimationBundleHandles[(int32)Bundle];
+	if (Handle.IsValid())
+	{
+		return;
+	}
+	TArray<FSoftObjectPath> Paths;
+	GetAnimationBundlePaths(Bundle, Paths);
+	if (Paths.Num() == 0)
+	{
+		return;
+	}
+
+	FStreamableManager& Streamable = UAssetManager::GetStreamableManager();
+	if (bLoadAnimationsOnDemand)
+	{
+		Handle = Streamable.RequestAsyncLoad(Paths, FStreamableDelegate::CreateUObject(this, &AVictorCharacter::OnAnimationBundleLoaded, Bundle), Priority);
+	}
+	else
+	{
+		Handle = Streamable.RequestSyncLoad(Paths);
+		OnAnimationBundleLoaded(Bundle);
+	}
+}
+
+void AVictorCharacter::RequestWeaponAnimationBundles()
+{
+	if (Weapon != nullptr && Weapon->AnimType == EWeaponAnimType::EWT_Pistol)
+	{
+		RequestAnimationBundle(EAnimationBundle::Pistol);
+	}
+	else
+	{
+		RequestAnimationBundle(EAnimationBundle::Unarmed);
+		if (Weapon != nullptr)
+		{
+			RequestAnimationBundle(EAnimationBundle::Stab);
+		}
+	}
+	if (bControlledByPlayer)
+	{
+		RequestAnimationBundle(EAnimationBundle::Possession);
+	}
+}
+
+void AVictorCharacter::ReleaseAnimationBundles(float MinResidency)
+{
+	const float ReleaseBefore = GetWorld()->GetTimeSeconds() - MinResidency;
+	for (int32 Bundle = 0; Bundle < (int32)EAnimationBundle::Num; Bundle++)
+	{
+		TSharedPtr<FStreamableHandle>& Handle = AnimationBundleHandles[Bundle];
+		if (Handle.IsValid() && AnimationBundleRequestTimes[Bundle] <= ReleaseBefore)
+		{
+			//also cancels a load still in flight, its delegate won't be called
+			Handle->ReleaseHandle();
+			Handle.Reset();
+		}
+	}
+}
+
+void AVictorCharacter::GetAnimationBundlePaths(EAnimationBundle Bundle, TArray<FSoftObjectPath>& OutPaths) const
+{
+	auto AddPath = [&OutPaths](const TSoftObjectPtr<UPaperFlipbook>& Flipbook)
+	{
+		if (!Flipbook.IsNull())
+		{
+			OutPaths.AddUnique(Flipbook.ToSoftObjectPath());
+		}
+	};
+
+	switch (Bundle)
+	{
+	case EAnimationBundle::Unarmed:
+		AddPath(IdleAnimation);
+		AddPath(RunningAnimation);
+		break;
+	case EAnimationBundle::Pistol:
+		AddPath(PistolIdleAnimation);
+		AddPath(PistolWalkAnimation);
+		break;
+	case EAnimationBundle::Stab:
+		AddPath(StabAnimation);
+		break;
+	case EAnimationBundle::Death:
+		AddPath(DeathAnimation);
+		break;
+	case EAnimationBundle::Possession:
+		AddPath(UnPossesAnimation);
+		break;
+	default:
+		break;
+	}
+	if (AnimationTable != nullptr)
+	{
+		AnimationTable->GetBundlePaths(Bundle, OutPaths);
+	}
+}
+
+void AVictorCharacter::OnAnimationBundleLoaded(EAnimationBundle Bundle)
+{
+	//bake weapon sockets now so the first frames showing these flipbooks don't pay for it
+	TArray<FSoftObjectPath> Paths;
+	GetAnimationBundlePaths(Bundle, Paths);
+	for (const FSoftObjectPath& Path : Paths)
+	{
+		FWeaponSocketCache::Get().BakeFlipbook(Cast<UPaperFlipbook>(Path.ResolveObject()));
+	}
+
+	if (Bundle == EAnimationBundle::Death)
+	{
+		if (bDead)
+		{
+			ApplyDeathAnimation();
+		}
+	}
+	else
+	{
+		InvalidateAnimationState();
+	}
+}
+
+ELocomotionState AVictorCharacter::GetLocomotionState() const
+{
+	return ComputeLocomotionState(bIsHoldingWall, GetVelocity().SizeSquared(), GetCharacterMovement()->IsFalling());
+}
+
+uint16 AVictorCharacter::GetAnimationStateKey() const
+{
+	return FAnimationStateKey::Make(
+		Weapon != nullptr ? Weapon->AnimType : EWeaponAnimType::EWT_MeleeKnife,
+		Weapon != nullptr,
+		GetLocomotionState(),
+		bDead,
+		bPlayingMeleeAttackAnim);
+}
+
 void AVictorCharacter::Tick(float DeltaSeconds)
 {
 	Super::Tick(DeltaSeconds);
-	
-	UpdateCharacter();	
+
+	//characters registered with UCharacterUpdateSubsystem are updated in its batched pass
+	if (UpdateSlot == INDEX_NONE)
+	{
+		VICTOR_SCOPE_CYCLE_COUNTER(UpdateCharacter);
+		UpdateWallGrab(*GetWorld()->GetSubsystem<ULevelGridSubsystem>());
+		UpdateCharacter();
+		UpdateFootsteps(DeltaSeconds);
+		UpdateDeathDormancy();
+	}
 }
 
 
 //////////////////////////////////////////////////////////////////////////
 // Input
 
+DECLARE_DELEGATE_OneParam(FVictorInputActionDelegate, EVictorInputEvent);
+
 void AVictorCharacter::SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent)
 {
 	// Note: the 'Jump' action and the 'MoveRight' axis are bound to actual keys/buttons/sticks in DefaultInput.ini (editable from Project Settings..Input)
-	PlayerInputComponent->BindAction("Jump", IE_Pressed, this, &ACharacter::Jump);
-	PlayerInputComponent->BindAction("Jump", IE_Released, this, &ACharacter::StopJumping);
-	PlayerInputComponent->BindAxis("MoveRight", this, &AVictorCharacter::MoveRight);
+	// Everything goes through OnInputAction/OnMoveRightInput so APossesivePlayerController can record and replay it
+	PlayerInputComponent->BindAction<FVictorInputActionDelegate>("Jump", IE_Pressed, this, &AVictorCharacter::OnInputAction, EVictorInputEvent::JumpPressed);
+	PlayerInputComponent->BindAction<FVictorInputActionDelegate>("Jump", IE_Released, this, &AVictorCharacter::OnInputAction, EVictorInputEvent::JumpReleased);
+	PlayerInputComponent->BindAxis("MoveRight", this, &AVictorCharacter::OnMoveRightInput);
 
-	PlayerInputComponent->BindAction("Interact",IE_Pressed,this,&AVictorCharacter::Interact);
+	PlayerInputComponent->BindAction<FVictorInputActionDelegate>("Interact",IE_Pressed,this,&AVictorCharacter::OnInputAction, EVictorInputEvent::Interact);
 
-	PlayerInputComponent->BindAction("Possess",IE_Pressed,this,&AVictorCharacter::StartPossess);
-	PlayerInputComponent->BindAction("Possess",IE_Released,this,&AVictorCharacter::StopPossess);
+	PlayerInputComponent->BindAction<FVictorInputActionDelegate>("Possess",IE_Pressed,this,&AVictorCharacter::OnInputAction, EVictorInputEvent::PossessPressed);
+	PlayerInputComponent->BindAction<FVictorInputActionDelegate>("Possess",IE_Released,this,&AVictorCharacter::OnInputAction, EVictorInputEvent::PossessReleased);
 	
-	PlayerInputComponent->BindAction("Attack",IE_Pressed,this,&AVictorCharacter::Attack);
+	PlayerInputComponent->BindAction<FVictorInputActionDelegate>("Attack",IE_Pressed,this,&AVictorCharacter::OnInputAction, EVictorInputEvent::Attack);
 }
 
-bool AVictorCharacter::CanBeSeen()
+void AVictorCharacter::OnInputAction(EVictorInputEvent Event)
 {
-	return !(bDead || bHiddenInShadow);
+	APossesivePlayerController* PC = Cast<APossesivePlayerController>(GetController());
+	if (PC == nullptr || PC->HandleLiveInput(Event, 0.f))
+	{
+		ApplyInputEvent(Event, 0.f);
+	}
 }
 
-void AVictorCharacter::Interact()
+void AVictorCharacter::OnMoveRightInput(float Value)
 {
-	TArray<AActor*> actors;
-	GetCapsuleComponent()->GetOverlappingActors(actors);
-	if (actors.Num() > 0)
+	APossesivePlayerController* PC = Cast<APossesivePlayerController>(GetController());
+	if (PC == nullptr || PC->HandleLiveInput(EVictorInputEvent::MoveRight, Value))
 	{
-		for (int i = 0; i < actors.Num(); i++)
-		{
-			if (actors[i]->Implements<UInteractions>() || (Cast<IInteractions>(actors[i]) != nullptr))
-			{
-				IInteractions::Execute_Interact(actors[i], this);
-			}
-		}
+		MoveRight(Value);
+	}
+}
+
+void AVictorCharacter::ApplyInputEvent(EVictorInputEvent Event, float Value)
+{
+	switch (Event)
+	{
+	case EVictorInputEvent::MoveRight:
+		MoveRight(Value);
+		break;
+	case EVictorInputEvent::JumpPressed:
+		Jump();
+		break;
+	case EVictorInputEvent::JumpReleased:
+		StopJumping();
+		break;
+	case EVictorInputEvent::Interact:
+		Interact();
+		break;
+	case EVictorInputEvent::PossessPressed:
+		StartPossess();
+		break;
+	case EVictorInputEvent::PossessReleased:
+		StopPossess();
+		break;
+	case EVictorInputEvent::Attack:
+		Attack();
+		break;
+	default:
+		break;
 	}
 }
 
+bool AVictorCharacter::CanBeSeen()
+{
+	return !(bDead || bHiddenInShadow || bInDarkness);
+}
+
+void AVictorCharacter::Interact()
+{
+	VICTOR_SCOPE_CYCLE_COUNTER(Interact);
+	//only interactables registered near the capsule are examined, and only those the capsule overlaps interact
+	const UCapsuleComponent* Capsule = GetCapsuleComponent();
+	const FVector2D Center = ToPlane2D(Capsule->GetComponentLocation());
+	const FVector2D HalfExtent(Capsule->GetScaledCapsuleRadius(), Capsule->GetScaledCapsuleHalfHeight());
+	GetWorld()->GetSubsystem<UInteractionSubsystem>()->InteractInBox(FBox2D(Center - HalfExtent, Center + HalfExtent), this, Capsule);
+}
+
 void AVictorCharacter::Die()
 {
+	VICTOR_SCOPE_CYCLE_COUNTER(Die);
 	if (!bDead)
 	{
 		APossesivePlayerController*PC = Cast<APossesivePlayerController>(GetController());
@@ -178,15 +429,8 @@ void AVictorCharacter::Die()
 			//TODO: Remove this after testing
 		}
 		bDead = true;
-		if (DeathAnimation != nullptr)
-		{
-			GetSprite()->SetFlipbook(DeathAnimation);
-			GetSprite()->SetLooping(false);
-		}
-		if(!DeathAudio->IsPlaying())
-		{
-			DeathAudio->Play();
-		}
+		MARK_PROPERTY_DIRTY_FROM_NAME(AVictorCharacter, bDead, this);
+		PlayDeath();
 		if (GetController() != nullptr)
 		{
 			if(Cast<APlayerController>(GetController()) == nullptr)
@@ -196,20 +440,101 @@ void AVictorCharacter::Die()
 		}
 		if(Weapon != nullptr)
 		{
-			Weapon->Destroy();
+			GetWorld()->GetSubsystem<UWeaponPoolSubsystem>()->ReleaseWeapon(Weapon);
 			Weapon = nullptr;
 		}
+		//the body keeps falling without a controller, and goes dormant once it lies still, see UpdateDeathDormancy
+		GetCharacterMovement()->bRunPhysicsWithNoController = true;
+		bDormantOnceSettled = true;
+	}
+}
+
+void AVictorCharacter::PlayDeath()
+{
+	ApplyDeathAnimation();
+	GetWorld()->GetSubsystem<UGameplayAudioSubsystem>()->PlaySound(DeathSound, EGameplaySoundCategory::Deaths, GetActorLocation(), 2.f);
+}
+
+void AVictorCharacter::ApplyDeathAnimation()
+{
+	AnimationStateKey = GetAnimationStateKey();
+	UPaperFlipbook* DeathFlipbook = ResolveAnimation(AnimationStateKey);
+	if (DeathFlipbook != nullptr)
+	{
+		GetSprite()->SetFlipbook(DeathFlipbook);
+		GetSprite()->SetLooping(false);
+	}
+	else
+	{
+		//few characters die, so the death bundle is only loaded when one does
+		RequestAnimationBundle(EAnimationBundle::Death, FStreamableManager::AsyncLoadHighPriority);
+	}
+}
+
+void AVictorCharacter::LoadLastSave_Implementation()
+{
+	GetWorld()->GetSubsystem<UVictorSaveSubsystem>()->RequestLoadLastCheckpoint();
+}
+
+void AVictorCharacter::OnCheckpointLoaded()
+{
+	GetCharacterMovement()->StopMovementImmediately();
+	SetHiddenInTheShadow(bHiddenInShadow);
+	MarkReplicatedStateDirty();
+	if (!bDead)
+	{
+		bDormantOnceSettled = false;
+		GetCharacterMovement()->bRunPhysicsWithNoController = false;
+		SetNetDormancy(DORM_Awake);
+	}
+
+	//the weapon went back to the pool when the character died, someone may have picked it up since
+	if (Weapon != nullptr && !GetWorld()->GetSubsystem<UWeaponPoolSubsystem>()->ReclaimWeapon(Weapon, this))
+	{
+		Weapon = nullptr;
+	}
+	if (Weapon != nullptr)
+	{
+		Weapon->AttachToComponent(GetSprite(), FAttachmentTransformRules::SnapToTargetNotIncludingScale, GetWeaponAttachmentSocketName(Weapon->AnimType));
+		Weapon->WeaponOwner = this;
+		Weapon->SetHiddenInShadow(bHiddenInShadow || bInDarkness);
+	}
+	RequestWeaponAnimationBundles();
+
+	if (!bDead)
+	{
+		GetSprite()->SetLooping(true);
+		GetSprite()->Play();
+		if (GetController() == nullptr && !bControlledByPlayer)
+		{
+			SpawnDefaultController();
+		}
 	}
+	InvalidateAnimationState();
 }
 
 void AVictorCharacter::SetHiddenInTheShadow(bool Hidden)
 {
 	bHiddenInShadow = Hidden;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AVictorCharacter, bHiddenInShadow, this);
+	UpdateShadowAppearance();
+}
+
+void AVictorCharacter::SetInDarkness(bool bDark)
+{
+	bInDarkness = bDark;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AVictorCharacter, bInDarkness, this);
+	UpdateShadowAppearance();
+}
+
+void AVictorCharacter::UpdateShadowAppearance()
+{
+	const bool bDark = bHiddenInShadow || bInDarkness;
 	if (Weapon != nullptr)
 	{
-		Weapon->SetHiddenInShadow(Hidden);
+		Weapon->SetHiddenInShadow(bDark);
 	}
-	if (Hidden)
+	if (bDark)
 	{
 		GetSprite()->SetSpriteColor(FColor::Black);
 	}
@@ -221,71 +546,79 @@ void AVictorCharacter::SetHiddenInTheShadow(bool Hidden)
 
 UPaperFlipbook* AVictorCharacter::GetDesiredAnimation()
 {
-	const FVector PlayerVelocity = GetVelocity();
-	const float PlayerSpeedSqr = PlayerVelocity.SizeSquared();
-	
-	if(Weapon != nullptr)
+	return ResolveAnimation(GetAnimationStateKey());
+}
+
+UPaperFlipbook* AVictorCharacter::ResolveAnimation(uint16 StateKey) const
+{
+	if (AnimationTable != nullptr)
 	{
-		switch (Weapon->AnimType)
+		if (const TSoftObjectPtr<UPaperFlipbook>* Flipbook = AnimationTable->FindAnimation(StateKey))
+		{
+			//null until the rule's bundle is in, the character's own flipbook for the state is not the one wanted
+			return Flipbook->Get();
+		}
+	}
+
+	if (FAnimationStateKey::IsDead(StateKey))
+	{
+		return DeathAnimation.Get();
+	}
+	if (FAnimationStateKey::IsAttacking(StateKey))
+	{
+		return StabAnimation.Get();
+	}
+	// Are we moving or standing still?
+	const ELocomotionState Locomotion = FAnimationStateKey::GetLocomotion(StateKey);
+	const bool bMoving = Locomotion == ELocomotionState::ELS_Moving || Locomotion == ELocomotionState::ELS_Falling;
+	return SelectAnimation(FAnimationStateKey::GetWeaponAnimType(StateKey), FAnimationStateKey::IsArmed(StateKey), bMoving);
+}
+
+UPaperFlipbook* AVictorCharacter::SelectAnimation(EWeaponAnimType WeaponAnimType, bool bHasWeapon, bool bMoving) const
+{
+	if(bHasWeapon)
+	{
+		switch (WeaponAnimType)
 		{
 		case EWeaponAnimType::EWT_Pistol:
-			return (PlayerSpeedSqr > 0.0f) ? PistolWalkAnimation : PistolIdleAnimation;
+			return bMoving ? PistolWalkAnimation.Get() : PistolIdleAnimation.Get();
 			break;
 			
 		case EWeaponAnimType::EWT_MeleeKnife:
-			return (PlayerSpeedSqr > 0.0f) ? RunningAnimation : IdleAnimation;
+			return bMoving ? RunningAnimation.Get() : IdleAnimation.Get();
 			break;
 			
 		default:
-			return (PlayerSpeedSqr > 0.0f) ? RunningAnimation : IdleAnimation;
+			return bMoving ? RunningAnimation.Get() : IdleAnimation.Get();
 			break;
 		}
 	}
 	else
 	{
-		
-		return (PlayerSpeedSqr > 0.0f) ? RunningAnimation : IdleAnimation;
+		return bMoving ? RunningAnimation.Get() : IdleAnimation.Get();
 	}
 }
 
 FVector AVictorCharacter::GetWeaponSocketLocation() const
 {
-	if(Weapon != nullptr)
-	{
-		return GetSprite()->GetSocketLocation(GetWeaponAttachmentSocketName(Weapon->AnimType));
-	}
-	else
-	{
-		return GetSprite()->GetSocketLocation(TEXT("WeaponHolding"));
-	}
+	VICTOR_SCOPE_CYCLE_COUNTER(GetWeaponSocketLocation);
+	return GetWeaponSocketTransform().GetLocation();
 }
 
 FRotator AVictorCharacter::GetWeaponSocketRotation() const
 {
-	if(Weapon != nullptr)
-	{
-		return GetSprite()->GetSocketRotation(GetWeaponAttachmentSocketName(Weapon->AnimType));
-	}
-	else
-	{
-		return GetSprite()->GetSocketRotation(TEXT("WeaponHolding"));
-	}
+	return GetWeaponSocketTransform().Rotator();
+}
+
+FTransform AVictorCharacter::GetWeaponSocketTransform() const
+{
+	const EWeaponSocketSlot Slot = FWeaponSocketCache::GetSocketSlot(Weapon != nullptr ? Weapon->AnimType : EWeaponAnimType::EWT_MeleeKnife);
+	return FWeaponSocketCache::Get().GetSocketTransform(GetSprite(), Slot);
 }
 
 FName AVictorCharacter::GetWeaponAttachmentSocketName(EWeaponAnimType animType)const
 {
-	switch (animType)
-	{
-	case EWeaponAnimType::EWT_Pistol:
-		return TEXT("PistolHolding");
-		break;
-	case EWeaponAnimType::EWT_MeleeKnife:
-		return TEXT("WeaponHolding");
-		break;
-	default:
-		return TEXT("WeaponHolding");
-		break;
-	}
+	return FWeaponSocketCache::GetSocketName(FWeaponSocketCache::GetSocketSlot(animType));
 }
 
 void AVictorCharacter::Attack()
@@ -322,18 +655,19 @@ void AVictorCharacter::Attack()
 
 void AVictorCharacter::EndMeleeAttackAnim()
 {
-	GetWorldTimerManager().ClearTimer(EndMeleeAttackAnimTimerHandle);
-	if(StabAnimation != nullptr)
+	GetWorld()->GetSubsystem<UGameplayTimerSubsystem>()->ClearTimer(EndMeleeAttackAnimTimerHandle);
+	if(StabAnimation.Get() != nullptr)
 	{
 		//Cast<AKnifeBase>(Weapon)->DealDamage();
 		GetSprite()->ReverseFromEnd();
-		GetWorldTimerManager().SetTimer(FinishAttackAnimTimerHandle,this,&AVictorCharacter::FinishMeleeAttack,GetSprite()->GetFlipbookLength());
+		GetWorld()->GetSubsystem<UGameplayTimerSubsystem>()->SetTimer(FinishAttackAnimTimerHandle,this,&AVictorCharacter::FinishMeleeAttack,GetSprite()->GetFlipbookLength());
 	}
 }
 
 void AVictorCharacter::FinishMeleeAttack()
 {
 	bPlayingMeleeAttackAnim = false;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AVictorCharacter, bPlayingMeleeAttackAnim, this);
 }
 
 void AVictorCharacter::BeginDestroy()
@@ -349,7 +683,10 @@ void AVictorCharacter::BeginDestroy()
 
 void AVictorCharacter::Possess()
 {
-	GetWorldTimerManager().ClearTimer(StartPossesingTimerHandle);
+	VICTOR_SCOPE_CYCLE_COUNTER(Possess);
+	GetWorld()->GetSubsystem<UGameplayTimerSubsystem>()->ClearTimer(StartPossesingTimerHandle);
+	UPossessionTargetSubsystem* PossessionTargets = GetWorld()->GetSubsystem<UPossessionTargetSubsystem>();
+	PossessionTargets->EndTargeting(this);
 	if (GetController() != nullptr)
 	{
 		APossesivePlayerController*PC = Cast<APossesivePlayerController>(GetController());
@@ -364,39 +701,21 @@ void AVictorCharacter::Possess()
 			}
 			else
 			{
-				GEngine->AddOnScreenDebugMessage(-1,5.f,FColor::Emerald,"Shooting line");
-				FHitResult hit;
-				PC->GetHitResultUnderCursorByChannel(ETraceTypeQuery::TraceTypeQuery2,false,hit);
-				if(hit.bBlockingHit)
+				//the target was picked while the key was held, only pick again if it went away since
+				AVictorCharacter* Other = PossessTarget;
+				if (Other == nullptr || Other->IsPendingKillPending() || !Other->CanBePossesed())
 				{
-					if(hit.Actor != nullptr)
-					{
-						AVictorCharacter* Other = Cast<AVictorCharacter>(hit.GetActor());
-						if(Other!=nullptr)
-						{
-							if(Other->CanBePossesed())
-							{
-								OnUnPosses();
-								Other->OnPosses(this);
-								PC->OnChangedBodies();
-								PC->Possess(Other);
-							}
-						}
-						else
-						{
-							GEngine->AddOnScreenDebugMessage(-1,5.f,FColor::Yellow,"Actor is not possesable. Actor name: " + hit.GetActor()->GetName());
-						
-						}
-					}
-					else
-					{
-						GEngine->AddOnScreenDebugMessage(-1,5.f,FColor::Emerald,"Hit but found no actor");
-					}
+					Other = PossessionTargets->PickUnderCursor(PC, this);
 				}
-				else
+				PossessTarget = nullptr;
+				if(Other!=nullptr)
 				{
-					GEngine->AddOnScreenDebugMessage(-1,5.f,FColor::Red,"Didn't hit");
-					GEngine->AddOnScreenDebugMessage(-1,5.f,FColor::Red,hit.TraceStart.ToString());
+					OnUnPosses();
+					Other->OnPosses(this);
+					PC->OnChangedBodies();
+					PC->Possess(Other);
+					//a new body is progress, dying from here on comes back to it
+					GetWorld()->GetSubsystem<UVictorSaveSubsystem>()->RequestCheckpoint();
 				}
 			}
 		}
@@ -408,41 +727,177 @@ void AVictorCharacter::StartPossess()
 	GEngine->AddOnScreenDebugMessage(-1,5.f,FColor::Emerald,"Starting...");
 	if(!StartPossesingTimerHandle.IsValid())
 	{
-		GetWorldTimerManager().SetTimer(StartPossesingTimerHandle,this,&AVictorCharacter::Possess,PossesTime);
+		GetWorld()->GetSubsystem<UGameplayTimerSubsystem>()->SetTimer(StartPossesingTimerHandle,this,&AVictorCharacter::Possess,PossesTime);
+		GetWorld()->GetSubsystem<UPossessionTargetSubsystem>()->BeginTargeting(this);
 	}
 }
 
 void AVictorCharacter::StopPossess()
 {
 	GEngine->AddOnScreenDebugMessage(-1,5.f,FColor::Emerald,"Aborting...");
-	GetWorldTimerManager().ClearTimer(StartPossesingTimerHandle);
+	GetWorld()->GetSubsystem<UGameplayTimerSubsystem>()->ClearTimer(StartPossesingTimerHandle);
+	GetWorld()->GetSubsystem<UPossessionTargetSubsystem>()->EndTargeting(this);
+	PossessTarget = nullptr;
 }
 
 void AVictorCharacter::OnUnPosses()
 {
 	bControlledByPlayer = false;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AVictorCharacter, bControlledByPlayer, this);
 }
 
 void AVictorCharacter::OnPosses(AVictorCharacter*originalBody)
 {
 	OriginalBody = originalBody;
 	bControlledByPlayer = true;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AVictorCharacter, bControlledByPlayer, this);
+	RequestAnimationBundle(EAnimationBundle::Possession, FStreamableManager::AsyncLoadHighPriority);
+}
+
+void AVictorCharacter::PostLoad()
+{
+	Super::PostLoad();
+
+	//content saved with the DeathAudio component, resaving it drops the component for good
+	if (DeathAudio_DEPRECATED != nullptr)
+	{
+		if (DeathSound == nullptr)
+		{
+			DeathSound = DeathAudio_DEPRECATED->Sound;
+		}
+		RemoveOwnedComponent(DeathAudio_DEPRECATED);
+		DeathAudio_DEPRECATED->MarkPendingKill();
+		DeathAudio_DEPRECATED = nullptr;
+	}
 }
 
 void AVictorCharacter::BeginPlay()
 {
+	//before Super, Blueprint BeginPlay may already give the character a weapon
+	bLoadAnimationsOnDemand = CVarAnimationBundles.GetValueOnGameThread() != 0;
+
 	Super::BeginPlay();
 
-	WallGrabBox->OnComponentBeginOverlap.AddDynamic(this, &AVictorCharacter::OnWallGrabBoxBeginOverlap);
+	bWallGrabByQuery = CVarWallGrabQuery.GetValueOnGameThread() != 0;
+	if (bWallGrabByQuery)
+	{
+		//UpdateWallGrab only reads the box's shape, it no longer needs to overlap everything it moves through
+		WallGrabBox->SetGenerateOverlapEvents(false);
+		WallGrabBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	}
+	else
+	{
+		WallGrabBox->OnComponentBeginOverlap.AddDynamic(this, &AVictorCharacter::OnWallGrabBoxBeginOverlap);
+
+		WallGrabBox->OnComponentEndOverlap.AddDynamic(this, &AVictorCharacter::OnWallGrabBoxEndOverlap);
+	}
+
+	//otherwise SetWeapon, UAnimationStreamingSubsystem and the state changes load the bundles as they are needed
+	if (!bLoadAnimationsOnDemand)
+	{
+		for (int32 Bundle = 0; Bundle < (int32)EAnimationBundle::Num; Bundle++)
+		{
+			RequestAnimationBundle((EAnimationBundle)Bundle);
+		}
+	}
+	if (!FootstepSound.IsNull())
+	{
+		FootstepSoundHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(FootstepSound.ToSoftObjectPath());
+	}
+
+	if (UCharacterUpdateSubsystem* UpdateSubsystem = GetWorld()->GetSubsystem<UCharacterUpdateSubsystem>())
+	{
+		UpdateSubsystem->RegisterCharacter(this);
+		//Blueprint children may still need Event Tick, otherwise the subsystem does all the work
+		if (!GetClass()->IsFunctionImplementedInScript(GET_FUNCTION_NAME_CHECKED(AVictorCharacter, ReceiveTick)))
+		{
+			SetActorTickEnabled(false);
+		}
+	}
+
+	if (bDrawInCrowd)
+	{
+		GetWorld()->GetSubsystem<UCrowdSpriteSubsystem>()->AddCharacter(this);
+	}
+}
+
+void AVictorCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UCharacterUpdateSubsystem* UpdateSubsystem = GetWorld()->GetSubsystem<UCharacterUpdateSubsystem>())
+	{
+		UpdateSubsystem->UnregisterCharacter(this);
+	}
+	if (UCrowdSpriteSubsystem* CrowdSubsystem = GetWorld()->GetSubsystem<UCrowdSpriteSubsystem>())
+	{
+		CrowdSubsystem->RemoveCharacter(this);
+	}
+	ReleaseAnimationBundles();
+	if (FootstepSoundHandle.IsValid())
+	{
+		FootstepSoundHandle->ReleaseHandle();
+		FootstepSoundHandle.Reset();
+	}
+	if (UGameplayTimerSubsystem* Timers = GetWorld()->GetSubsystem<UGameplayTimerSubsystem>())
+	{
+		Timers->ClearTimer(StartPossesingTimerHandle);
+		Timers->ClearTimer(FinishAttackAnimTimerHandle);
+		Timers->ClearTimer(MeleeDealDamageTimerHandle);
+		Timers->ClearTimer(EndMeleeAttackAnimTimerHandle);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AVictorCharacter::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+	//bodies taken over through OnPosses know their original body, only the one the player spawns in doesn't
+	if (NewController != nullptr && NewController->IsPlayerController() && OriginalBody == nullptr && Team != ETeam::ET_Player)
+	{
+		Team = ETeam::ET_Player;
+	}
+}
 
-	WallGrabBox->OnComponentEndOverlap.AddDynamic(this, &AVictorCharacter::OnWallGrabBoxEndOverlap);
+ETeam AVictorCharacter::GetTeam() const
+{
+	return bControlledByPlayer || IsPlayerControlled() ? ETeam::ET_Player : Team;
+}
+
+void AVictorCharacter::SetDrawInCrowd(bool bInDrawInCrowd)
+{
+	bDrawInCrowd = bInDrawInCrowd;
+	if (HasActorBegunPlay())
+	{
+		UCrowdSpriteSubsystem* CrowdSubsystem = GetWorld()->GetSubsystem<UCrowdSpriteSubsystem>();
+		if (bDrawInCrowd)
+		{
+			CrowdSubsystem->AddCharacter(this);
+		}
+		else
+		{
+			CrowdSubsystem->RemoveCharacter(this);
+		}
+	}
 }
 
 float AVictorCharacter::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator,
 	AActor* DamageCauser)
 {
-	if(!bDead){Die();}
-	return DamageAmount;
+	VICTOR_SCOPE_CYCLE_COUNTER(TakeDamage);
+	if (bDead)
+	{
+		return 0.f;
+	}
+	UDamageQueueSubsystem* DamageQueue = GetWorld()->GetSubsystem<UDamageQueueSubsystem>();
+	if (DamageQueue == nullptr)
+	{
+		Die();
+		return DamageAmount;
+	}
+	//a hit from the character's own team does nothing, the caller is told so; the rest dies in the queue's batch
+	ETeam AttackerTeam = ETeam::ET_Player;
+	const bool bHasTeam = UDamageQueueSubsystem::GetAttackerTeam(EventInstigator, DamageCauser, AttackerTeam);
+	return DamageQueue->QueuePointDamage(this, DamageAmount, AttackerTeam, bHasTeam, EventInstigator, DamageCauser) ? DamageAmount : 0.f;
 }
 
 bool AVictorCharacter::CanJumpInternal_Implementation() const
@@ -491,6 +946,123 @@ bool AVictorCharacter::CanJumpInternal_Implementation() const
 	
 }
 
+void AVictorCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS(AVictorCharacter, bDead, Params);
+	DOREPLIFETIME_WITH_PARAMS(AVictorCharacter, bPlayingMeleeAttackAnim, Params);
+	DOREPLIFETIME_WITH_PARAMS(AVictorCharacter, bHiddenInShadow, Params);
+	DOREPLIFETIME_WITH_PARAMS(AVictorCharacter, bInDarkness, Params);
+	DOREPLIFETIME_WITH_PARAMS(AVictorCharacter, bControlledByPlayer, Params);
+
+	//the owning client predicts its own movement and gets corrections from the movement component
+	Params.Condition = COND_SimulatedOnly;
+	DOREPLIFETIME_WITH_PARAMS(AVictorCharacter, PlaneMovement, Params);
+}
+
+void AVictorCharacter::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	UpdatePlaneMovement();
+}
+
+void AVictorCharacter::UpdatePlaneMovement()
+{
+	const bool bFacingLeft = FMath::Abs(FRotator::NormalizeAxis(GetActorRotation().Yaw)) > 90.f;
+	const FPlaneRepMovement NewMovement = FPlaneRepMovement::Quantize(GetActorLocation(), GetVelocity(), bFacingLeft);
+	if (NewMovement != PlaneMovement)
+	{
+		PlaneMovement = NewMovement;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AVictorCharacter, PlaneMovement, this);
+	}
+}
+
+bool AVictorCharacter::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	if (bAlwaysRelevant || IsOwnedBy(ViewTarget) || IsOwnedBy(RealViewer) || this == ViewTarget || ViewTarget == GetInstigator())
+	{
+		return true;
+	}
+	//the player's own body stays relevant while they are in another one
+	const AVictorCharacter* ViewCharacter = Cast<AVictorCharacter>(ViewTarget);
+	if (ViewCharacter != nullptr && ViewCharacter->OriginalBody == this)
+	{
+		return true;
+	}
+	//the side view sees a box around the camera, depth doesn't matter
+	const FVector Offset = GetActorLocation() - SrcLocation;
+	return FMath::Abs(Offset.X) <= NetRelevantHalfExtent.X && FMath::Abs(Offset.Z) <= NetRelevantHalfExtent.Y;
+}
+
+float AVictorCharacter::GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth)
+{
+	float Priority = NetPriority * Time;
+	if (ViewTarget == this || ViewTarget == GetInstigator() || IsOwnedBy(Viewer))
+	{
+		return Priority * 4.f;
+	}
+
+	const FVector Offset = GetActorLocation() - ViewPos;
+	if (FMath::Abs(Offset.X) <= NetScreenHalfExtent.X && FMath::Abs(Offset.Z) <= NetScreenHalfExtent.Y)
+	{
+		Priority *= 2.f;
+	}
+	else if (ViewTarget == nullptr || Offset.X * ViewTarget->GetVelocity().X <= 0.f)
+	{
+		//off screen and not where the viewer is heading
+		Priority *= 0.5f;
+	}
+	if (bDead)
+	{
+		Priority *= 0.25f;
+	}
+	return Priority;
+}
+
+void AVictorCharacter::MarkReplicatedStateDirty()
+{
+	MARK_PROPERTY_DIRTY_FROM_NAME(AVictorCharacter, bDead, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AVictorCharacter, bPlayingMeleeAttackAnim, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AVictorCharacter, bHiddenInShadow, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AVictorCharacter, bInDarkness, this);
+	MARK_PROPERTY_DIRTY_FROM_NAME(AVictorCharacter, bControlledByPlayer, this);
+}
+
+void AVictorCharacter::OnRep_Dead()
+{
+	if (bDead)
+	{
+		PlayDeath();
+	}
+	else
+	{
+		//brought back by a checkpoint
+		GetSprite()->SetLooping(true);
+		GetSprite()->Play();
+		InvalidateAnimationState();
+	}
+}
+
+void AVictorCharacter::OnRep_HiddenInShadow()
+{
+	SetHiddenInTheShadow(bHiddenInShadow);
+}
+
+void AVictorCharacter::OnRep_InDarkness()
+{
+	UpdateShadowAppearance();
+}
+
+void AVictorCharacter::OnRep_PlaneMovement()
+{
+	SetActorLocationAndRotation(PlaneMovement.GetLocation(GetActorLocation().Y), PlaneMovement.GetRotation());
+	GetCharacterMovement()->Velocity = PlaneMovement.GetVelocity();
+}
+
 
 void AVictorCharacter::OnWallGrabBoxBeginOverlap(UPrimitiveComponent* OverlappedComp, AActor* OtherActor,
                                                    UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
@@ -499,10 +1071,7 @@ void AVictorCharacter::OnWallGrabBoxBeginOverlap(UPrimitiveComponent* Overlapped
 	{
 		if(!GetCharacterMovement()->IsMovingOnGround())
 		{
-			GetCharacterMovement()->GravityScale = 0.f;
-			GetCharacterMovement()->Velocity = FVector(0,0,0);
-			GetCharacterMovement()->StopActiveMovement();
-			bIsHoldingWall = true;
+			BeginHoldingWall();
 		}
 	}
 }
@@ -511,8 +1080,105 @@ void AVictorCharacter::OnWallGrabBoxEndOverlap(UPrimitiveComponent* OverlappedCo
 {
 	if (GetCharacterMovement() != nullptr)
 	{
-		GetCharacterMovement()->GravityScale = 2.f;
-		bIsHoldingWall = false;
+		StopHoldingWall();
+	}
+}
+
+void AVictorCharacter::BeginHoldingWall()
+{
+	GetCharacterMovement()->GravityScale = 0.f;
+	GetCharacterMovement()->Velocity = FVector(0,0,0);
+	GetCharacterMovement()->StopActiveMovement();
+	bIsHoldingWall = true;
+}
+
+void AVictorCharacter::StopHoldingWall()
+{
+	GetCharacterMovement()->GravityScale = 2.f;
+	bIsHoldingWall = false;
+}
+
+bool AVictorCharacter::IsWallGrabBoxTouchingWall(ULevelGridSubsystem& LevelGrid) const
+{
+	const FVector Center = WallGrabBox->GetComponentLocation();
+	const FVector Extent = WallGrabBox->GetScaledBoxExtent();
+	const FBox2D Box(ToPlane2D(Center - Extent), ToPlane2D(Center + Extent));
+	//the level's geometry down to what each solid cell holds, so the box isn't a cell early; moving platforms from their hash
+	return LevelGrid.GetCollisionGrid().IsBoxOverlappingSolid(Box) || LevelGrid.IsBoxOverlappingMovableBlocker(Box, Weapon);
+}
+
+void AVictorCharacter::UpdateWallGrab(ULevelGridSubsystem& LevelGrid)
+{
+	if (!bWallGrabByQuery)
+	{
+		return;
+	}
+	if (!GetCharacterMovement()->IsFalling())
+	{
+		//landed while holding the wall, the box may still touch it but there is nothing to hang from
+		if (bIsHoldingWall)
+		{
+			StopHoldingWall();
+		}
+		bWallGrabAirborne = false;
+		return;
+	}
+
+	const bool bTouching = IsWallGrabBoxTouchingWall(LevelGrid);
+
+	//a wall the box already touched on the ground isn't grabbed by jumping, same as with overlap events
+	if (!bWallGrabAirborne)
+	{
+		bWallGrabAirborne = true;
+		bWallGrabBoxTouching = bTouching;
+		return;
+	}
+	if (bTouching != bWallGrabBoxTouching)
+	{
+		bWallGrabBoxTouching = bTouching;
+		if (bTouching)
+		{
+			BeginHoldingWall();
+		}
+		else
+		{
+			StopHoldingWall();
+		}
+	}
+}
+
+void AVictorCharacter::UpdateDeathDormancy()
+{
+	if (!bDormantOnceSettled)
+	{
+		return;
+	}
+	const UCharacterMovementComponent* Movement = GetCharacterMovement();
+	if (!Movement->IsMovingOnGround() || !Movement->Velocity.IsNearlyZero())
+	{
+		return;
+	}
+	bDormantOnceSettled = false;
+	//a dormant channel still sends what changed before it closes, but PreReplication won't run for the body again
+	UpdatePlaneMovement();
+	ForceNetUpdate();
+	SetNetDormancy(DORM_DormantAll);
+}
+
+void AVictorCharacter::UpdateFootsteps(float DeltaTime)
+{
+	const UCharacterMovementComponent* Movement = GetCharacterMovement();
+	if (bDead || FootstepDistance <= 0.f || !Movement->IsMovingOnGround())
+	{
+		FootstepTravel = 0.f;
+		return;
+	}
+	FootstepTravel += FMath::Abs(Movement->Velocity.X) * DeltaTime;
+	if (FootstepTravel >= FootstepDistance)
+	{
+		FootstepTravel = FMath::Fmod(FootstepTravel, FootstepDistance);
+		//silent until the sound finished loading
+		GetWorld()->GetSubsystem<UGameplayAudioSubsystem>()->PlaySound(FootstepSound.Get(), EGameplaySoundCategory::Footsteps, GetActorLocation(), 0.5f);
 	}
 }
 
@@ -541,6 +1207,7 @@ void AVictorCharacter::TouchStopped(const ETouchIndex::Type FingerIndex, const F
 
 void AVictorCharacter::UpdateCharacter()
 {
+	//timed by the caller, UCharacterUpdateSubsystem or Tick
 	// Update animation to match the motion
 	UpdateAnimation();
 
@@ -549,29 +1216,36 @@ void AVictorCharacter::UpdateCharacter()
 	float TravelDirection = PlayerVelocity.X;
 	if(!bIsHoldingWall || !bControlledByPlayer)
 	{
-		// Set the rotation so that the character faces his direction of travel.
-		if (Controller != nullptr)
+		UpdateFacing(TravelDirection);
+	}
+}
+
+void AVictorCharacter::UpdateFacing(float TravelDirection)
+{
+	// Set the rotation so that the character faces his direction of travel.
+	if (Controller != nullptr)
+	{
+		if (TravelDirection < 0.0f)
 		{
-			if (TravelDirection < 0.0f)
+			Controller->SetControlRotation(FRotator(0.0, 180.0f, 0.0f));
+			if(Weapon != nullptr)
 			{
-				Controller->SetControlRotation(FRotator(0.0, 180.0f, 0.0f));
-				if(Weapon != nullptr)
+				const FVector SocketLocation = GetWeaponSocketLocation();
+				if(Weapon->GetActorLocation().Y!=SocketLocation.Y+0.02)
 				{
-					if(Weapon->GetActorLocation().Y!=GetWeaponSocketLocation().Y+0.02)
-					{
-						Weapon->SetActorLocation(FVector(GetWeaponSocketLocation().X,GetWeaponSocketLocation().Y + 0.02, GetWeaponSocketLocation().Z));						
-					}
+					Weapon->SetActorLocation(FVector(SocketLocation.X,SocketLocation.Y + 0.02, SocketLocation.Z));						
 				}
 			}
-			else if (TravelDirection > 0.0f)
+		}
+		else if (TravelDirection > 0.0f)
+		{
+			Controller->SetControlRotation(FRotator(0.0f, 0.0f, 0.0f));
+			if(Weapon != nullptr)
 			{
-				Controller->SetControlRotation(FRotator(0.0f, 0.0f, 0.0f));
-				if(Weapon != nullptr)
+				const FVector SocketLocation = GetWeaponSocketLocation();
+				if(Weapon->GetActorLocation().Y!=SocketLocation.Y)
 				{
-					if(Weapon->GetActorLocation().Y!=GetSprite()->GetSocketLocation(GetWeaponAttachmentSocketName(Weapon->AnimType)).Y)
-					{
-						Weapon->SetActorLocation(GetWeaponSocketLocation());						
-					}
+					Weapon->SetActorLocation(SocketLocation);						
 				}
 			}
 		}
@@ -6,9 +6,16 @@
 #include "PaperCharacter.h"
 #include "Components/BoxComponent.h"
 #include "Weapons/WeaponBase.h"
+#include "Animation/VictorAnimationTable.h"
 #include "Components/AudioComponent.h"
+#include "Player/InputRecording.h"
+#include "Characters/PlaneRepMovement.h"
+#include "Timers/GameplayTimerWheel.h"
+#include "Engine/StreamableManager.h"
 #include "VictorCharacter.generated.h"
 
+class ULevelGridSubsystem;
+
 UENUM(BlueprintType)
 enum class ETeam:uint8
 {
@@ -21,7 +28,7 @@ enum class ETeam:uint8
  * physical interaction between the player and the world.
  *
  * The capsule component (inherited from ACharacter) handles collision with the world
- * The CharacterMovementComponent (inherited from ACharacter) handles movement of the collision capsule
+ * The CharacterMovementComponent (inherited from ACharacter, a UVictorMovementComponent) handles movement of the collision capsule
  * The Sprite component (inherited from APaperCharacter) handles the visuals
  */
 UCLASS(config=Game)
@@ -41,51 +48,71 @@ class AVictorCharacter : public APaperCharacter
 protected:
 	// The animation to play while running around
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Animations)
-	class UPaperFlipbook* RunningAnimation;
+	TSoftObjectPtr<UPaperFlipbook> RunningAnimation;
 
 	// The animation to play while idle (standing still)
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animations)
-	class UPaperFlipbook* IdleAnimation;
+	TSoftObjectPtr<UPaperFlipbook> IdleAnimation;
 
 	UPROPERTY(BlueprintReadWrite,EditDefaultsOnly)
 	UBoxComponent* WallGrabBox;
 
-	FTimerHandle StartPossesingTimerHandle;
+	//timers of UGameplayTimerSubsystem, cleared in EndPlay
+	FGameplayTimerHandle StartPossesingTimerHandle;
 
-	FTimerHandle FinishAttackAnimTimerHandle;
+	FGameplayTimerHandle FinishAttackAnimTimerHandle;
 
-	FTimerHandle MeleeDealDamageTimerHandle;
+	FGameplayTimerHandle MeleeDealDamageTimerHandle;
 
-	FTimerHandle EndMeleeAttackAnimTimerHandle;
+	FGameplayTimerHandle EndMeleeAttackAnimTimerHandle;
 
 public:
 	
+	//The flipbooks are soft references loaded in bundles, see EAnimationBundle. Get() is null until their bundle is in
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animations,SaveGame)
-	UPaperFlipbook* StabAnimation;
+	TSoftObjectPtr<UPaperFlipbook> StabAnimation;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animations,SaveGame)
-	UPaperFlipbook* DeathAnimation;
+	TSoftObjectPtr<UPaperFlipbook> DeathAnimation;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = WeaponAnimations,SaveGame)
-	UPaperFlipbook* PistolIdleAnimation;
+	TSoftObjectPtr<UPaperFlipbook> PistolIdleAnimation;
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = WeaponAnimations,SaveGame)
-	UPaperFlipbook* PistolWalkAnimation;
+	TSoftObjectPtr<UPaperFlipbook> PistolWalkAnimation;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animations,SaveGame)
-	class UPaperFlipbook* UnPossesAnimation;
+	TSoftObjectPtr<UPaperFlipbook> UnPossesAnimation;
+
+	//Optional overrides for the flipbooks above. States it doesn't cover use the flipbooks set on the character
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Animations)
+	UVictorAnimationTable* AnimationTable;
+
+	//State key of the flipbook currently chosen by UpdateAnimation, see FAnimationStateKey
+	uint16 AnimationStateKey = FAnimationStateKey::Invalid;
 
 	//UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Hold,SaveGame)
 	//AHoldableActor* CurrentlyHeldActor = nullptr;
 	
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Death,SaveGame)
+	//Replicated flags are push-model: C++ writes mark them dirty, Blueprint writes need MarkReplicatedStateDirty
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Death,SaveGame,ReplicatedUsing=OnRep_Dead)
 	bool bDead = false;
 
+	//Played through UGameplayAudioSubsystem in the Deaths category
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Death,SaveGame)
 	USoundBase* DeathSound;
 
-	UPROPERTY(BlueprintReadWrite,EditDefaultsOnly,Category = Death,SaveGame)
-	UAudioComponent* DeathAudio;
+	//Played through UGameplayAudioSubsystem in the Footsteps category while running on the ground
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Audio)
+	TSoftObjectPtr<USoundBase> FootstepSound;
+
+	//How far the character runs between two footsteps
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Audio)
+	float FootstepDistance = 128.f;
+
+	//The DeathAudio component content set its death sound on before DeathSound. PostLoad moves the sound over and drops it
+	UPROPERTY()
+	UAudioComponent* DeathAudio_DEPRECATED = nullptr;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite,Category=Posses,SaveGame)
 	float PossesTime = 1.f;
@@ -93,32 +120,168 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite,Category=Weapon,SaveGame)
 	AWeaponBase* Weapon;	
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite,Category=WeaponAnims,SaveGame)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite,Category=WeaponAnims,SaveGame,Replicated)
 	bool bPlayingMeleeAttackAnim = false;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite,Category=HiddenInShadow,SaveGame)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite,Category=HiddenInShadow,SaveGame,ReplicatedUsing=OnRep_HiddenInShadow)
 	bool bHiddenInShadow = false;
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite,Category=Posses,SaveGame)
+	//Let ULightFieldSubsystem set bInDarkness whenever this character stands in the dark, instead of shadow volumes
+	UPROPERTY(EditAnywhere, BlueprintReadWrite,Category=HiddenInShadow)
+	bool bShadowFromLightField = false;
+
+	//Set by ULightFieldSubsystem. Unlike bHiddenInShadow, which shadow volumes and input set, it only keeps the
+	//character from being seen and darkens it; it doesn't stop the character from moving or jumping
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly,Category=HiddenInShadow,Transient,ReplicatedUsing=OnRep_InDarkness)
+	bool bInDarkness = false;
+
+	//Draw this character through UCrowdSpriteSubsystem's shared component instead of its own sprite proxy. Meant for guards
+	UPROPERTY(EditAnywhere, BlueprintReadOnly,Category=Crowd)
+	bool bDrawInCrowd = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite,Category=Posses,SaveGame,Replicated)
 	bool bControlledByPlayer = false;
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite,Category=Posses,SaveGame)
 	AVictorCharacter*OriginalBody = nullptr;
 
+	//Body under the cursor while the Possess key is held, kept up to date by UPossessionTargetSubsystem
+	UPROPERTY(BlueprintReadOnly,Transient,Category=Posses)
+	AVictorCharacter*PossessTarget = nullptr;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Climbing,SaveGame)
 	bool bIsHoldingWall = false;
 
+	//Set at BeginPlay from victor.WallGrabQuery, false if WallGrabBox overlap events do the wall grab
+	bool bWallGrabByQuery = true;
+
+	//Grid and movable blocker result of the last airborne UpdateWallGrab
+	bool bWallGrabBoxTouching = false;
+
+	//False until the first UpdateWallGrab after leaving the ground, which only records what the box touches
+	bool bWallGrabAirborne = false;
+
+	//Loaded or loading flipbook bundles, indexed by EAnimationBundle. Kept by UAnimationStreamingSubsystem while the character is near the camera
+	TSharedPtr<FStreamableHandle> AnimationBundleHandles[(int32)EAnimationBundle::Num];
+
+	//World time each bundle was last requested, so bundles still in use are not released, see ReleaseAnimationBundles
+	float AnimationBundleRequestTimes[(int32)EAnimationBundle::Num] = {};
+
+	//Set at BeginPlay from victor.AnimationBundles, false if every bundle is loaded right away
+	bool bLoadAnimationsOnDemand = true;
+
+	//Keeps FootstepSound loaded while the character is in play
+	TSharedPtr<FStreamableHandle> FootstepSoundHandle;
+
+	//Distance run on the ground since the last footstep
+	float FootstepTravel = 0.f;
+
+	//Movement simulated proxies get instead of ReplicatedMovement, updated in PreReplication when it visibly changed
+	UPROPERTY(Transient,ReplicatedUsing=OnRep_PlaneMovement)
+	FPlaneRepMovement PlaneMovement;
+
+	//Set by Die, the body goes dormant once it lies still so clients get where it came to rest
+	bool bDormantOnceSettled = false;
+
+	//Half size of the box around a connection's camera in which this character is relevant to it
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Replication)
+	FVector2D NetRelevantHalfExtent = FVector2D(1536.f, 1024.f);
+
+	//Team of the body. Everyone starts as a guard, the body the player spawns in becomes ET_Player in PossessedBy.
+	//Compare teams with GetTeam(), which also counts the guard bodies the player took over
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Team)
+	ETeam Team = ETeam::ET_Guards;
+
+	/** Team the character fights for right now: ET_Player while the player controls it, Team otherwise */
+	UFUNCTION(BlueprintPure, Category = Team)
+	ETeam GetTeam() const;
+
 	UFUNCTION(BlueprintCallable)
 	virtual bool SetWeapon(TSubclassOf<AWeaponBase>WeaponClass);
 
-	/** Called to choose the correct animation to play based on the character's movement state */
+	/** Called to choose the correct animation to play based on the character's movement state. Does nothing until the state key changes */
 	void UpdateAnimation();
 
+	/** Applies the flipbook for a new state key. Used by UpdateAnimation and the batched update */
+	void ApplyAnimationState(uint16 StateKey, UPaperFlipbook* Flipbook);
+
+	/** Forces the next UpdateAnimation to pick the flipbook again, e.g. after Blueprint changed the sprite */
+	UFUNCTION(BlueprintCallable)
+	void InvalidateAnimationState() { AnimationStateKey = FAnimationStateKey::Invalid; }
+
+	/** Starts loading the flipbooks of the bundle unless they are loaded or loading already. The flipbook is picked again once they are in */
+	void RequestAnimationBundle(EAnimationBundle Bundle, TAsyncLoadPriority Priority = FStreamableManager::DefaultAsyncLoadPriority);
+
+	/** Requests the bundles the current weapon's locomotion and attack use, and UnPosses for a body the player controls */
+	void RequestWeaponAnimationBundles();
+
+	/**
+	 * Lets go of every bundle not requested in the last MinResidency seconds, all of them with 0.
+	 * Flipbooks still shown by the sprite stay loaded through it
+	 */
+	void ReleaseAnimationBundles(float MinResidency = 0.f);
+
+	bool IsAnimationBundleRequested(EAnimationBundle Bundle) const { return AnimationBundleHandles[(int32)Bundle].IsValid(); }
+
+	/** Paths of the flipbooks in the bundle that are set, AnimationTable's included */
+	void GetAnimationBundlePaths(EAnimationBundle Bundle, TArray<FSoftObjectPath>& OutPaths) const;
+
+	UFUNCTION(BlueprintPure)
+	ELocomotionState GetLocomotionState() const;
+
+	/** Packs the current weapon, locomotion, dead and attacking state */
+	uint16 GetAnimationStateKey() const;
+
 	/** Called for side to side input */
 	void MoveRight(float Value);
 
+	/** Performs a player input, live or replayed by APossesivePlayerController */
+	void ApplyInputEvent(EVictorInputEvent Event, float Value);
+
+	/** Bound input handlers, they let the controller record or suppress the input before applying it */
+	void OnInputAction(EVictorInputEvent Event);
+
+	void OnMoveRightInput(float Value);
+
 	void UpdateCharacter();
 
+	/** Turns the character (and moves the weapon) to face the direction of travel */
+	void UpdateFacing(float TravelDirection);
+
+	/** Slot in UCharacterUpdateSubsystem's arrays, INDEX_NONE if the character updates itself from Tick */
+	int32 UpdateSlot = INDEX_NONE;
+
+	/**
+	 * Tests WallGrabBox against the level collision grid and the movable blockers while the character is airborne,
+	 * and grabs or lets go of the wall when the box starts or stops touching them, like the box's overlap events used to.
+	 * Landing lets go of the wall. Called by UCharacterUpdateSubsystem; does nothing with victor.WallGrabQuery 0.
+	 */
+	void UpdateWallGrab(ULevelGridSubsystem& LevelGrid);
+
+	/** True if WallGrabBox overlaps geometry that blocks characters, other characters excluded. No physics queries */
+	bool IsWallGrabBoxTouchingWall(ULevelGridSubsystem& LevelGrid) const;
+
+	/** Plays FootstepSound every FootstepDistance the character runs on the ground. Called by UCharacterUpdateSubsystem */
+	void UpdateFootsteps(float DeltaTime);
+
+	/**
+	 * Puts a dead body to DORM_DormantAll once it is on the ground and stopped, after refreshing PlaneMovement
+	 * so its final position goes out before the channel closes. Called by UCharacterUpdateSubsystem.
+	 */
+	void UpdateDeathDormancy();
+
+	/** Quantizes the current location and velocity into PlaneMovement, marking it dirty if it changed */
+	void UpdatePlaneMovement();
+
+	/** Instance in UCrowdSpriteSubsystem's component, INDEX_NONE if the character draws its own sprite */
+	int32 CrowdSlot = INDEX_NONE;
+
+	/** Slot in UGuardAISubsystem's arrays, INDEX_NONE for characters that aren't guards */
+	int32 GuardAISlot = INDEX_NONE;
+
+	UFUNCTION(BlueprintCallable, Category=Crowd)
+	void SetDrawInCrowd(bool bInDrawInCrowd);
+
 	/** Handle touch inputs. */
 	void TouchStarted(const ETouchIndex::Type FingerIndex, const FVector Location);
 
@@ -141,15 +304,40 @@ public:
 	UFUNCTION(BlueprintCallable)
 	virtual void Die();
 
+	/** Death flipbook and sound, on the server from Die and on clients when bDead replicates */
+	void PlayDeath();
+
+	/** Shows the death flipbook, or loads it first and shows it from OnAnimationBundleLoaded */
+	void ApplyDeathAnimation();
+
+	void OnAnimationBundleLoaded(EAnimationBundle Bundle);
+
 	UFUNCTION(BlueprintCallable)
 	virtual void SetHiddenInTheShadow(bool Hidden);
+
+	/** Called by ULightFieldSubsystem when the light level at the character crosses its shadow threshold */
+	void SetInDarkness(bool bDark);
 	
+	/**
+	 * Flipbook for the current state. Both the batched and the per-actor update pick flipbooks through this,
+	 * but only when the animation state key changed, so overrides must not depend on anything outside the key
+	 */
 	UFUNCTION(BlueprintPure)
 	virtual UPaperFlipbook* GetDesiredAnimation();
 
+	/** Flipbook for the state key, from AnimationTable if it has a rule and from the character's flipbooks otherwise */
+	UPaperFlipbook* ResolveAnimation(uint16 StateKey) const;
+
+	/** Picks the locomotion animation for the given weapon and movement state when AnimationTable has no rule */
+	UPaperFlipbook* SelectAnimation(EWeaponAnimType WeaponAnimType, bool bHasWeapon, bool bMoving) const;
+
 	UFUNCTION(BlueprintPure)
 	FVector GetWeaponSocketLocation()const;
 
+	/** World transform of the socket the weapon is attached to, looked up from FWeaponSocketCache */
+	UFUNCTION(BlueprintPure)
+	FTransform GetWeaponSocketTransform()const;
+
 	UFUNCTION(BlueprintPure)
 	FName GetWeaponAttachmentSocketName(EWeaponAnimType animType)const;
 
@@ -159,7 +347,10 @@ public:
 	UFUNCTION(BlueprintCallable,BlueprintNativeEvent,Category= SaveSystem)
 	void LoadLastSave();
 	
-	void LoadLastSave_Implementation(){}
+	void LoadLastSave_Implementation();
+
+	/** Called by UVictorSaveSubsystem after it restored the SaveGame properties, to bring the rest of the character in line */
+	void OnCheckpointLoaded();
 	
 	
 	virtual void Attack();
@@ -183,12 +374,49 @@ public:
 	virtual void OnPosses(AVictorCharacter *originalBody);
 	
 
+	virtual void PostLoad() override;
+
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void PossessedBy(AController* NewController) override;
+
 	virtual float TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser) override;
 
 	virtual bool CanJumpInternal_Implementation() const override;
 
+	// AActor replication interface
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+	virtual float GetNetPriority(const FVector& ViewPos, const FVector& ViewDir, AActor* Viewer, AActor* ViewTarget, UActorChannel* InChannel, float Time, bool bLowBandwidth) override;
+	// End of AActor replication interface
+
+	/** Marks every replicated flag dirty, after they were written without going through C++, e.g. by a checkpoint load or Blueprint */
+	UFUNCTION(BlueprintCallable, Category=Replication)
+	void MarkReplicatedStateDirty();
+
+	UFUNCTION()
+	void OnRep_Dead();
+
+	UFUNCTION()
+	void OnRep_HiddenInShadow();
+
+	UFUNCTION()
+	void OnRep_InDarkness();
+
+	/** Darkens the sprite and weapon while the character is hidden in a shadow or stands in the dark */
+	void UpdateShadowAppearance();
+
+	UFUNCTION()
+	void OnRep_PlaneMovement();
+
+	/** Grabs the wall: gravity off and the character stops where it is */
+	void BeginHoldingWall();
+
+	void StopHoldingWall();
+
 	UFUNCTION()
     void OnWallGrabBoxBeginOverlap(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp,
                            int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
@@ -197,10 +425,12 @@ public:
     void OnWallGrabBoxEndOverlap(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
 
 public:
-	AVictorCharacter();
+	AVictorCharacter(const FObjectInitializer& ObjectInitializer);
 
 	/** Returns SideViewCameraComponent subobject **/
 	FORCEINLINE class UCameraComponent* GetSideViewCameraComponent() const { return SideViewCameraComponent; }
 	/** Returns CameraBoom subobject **/
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
+	/** Returns WallGrabBox subobject **/
+	FORCEINLINE UBoxComponent* GetWallGrabBox() const { return WallGrabBox; }
 };
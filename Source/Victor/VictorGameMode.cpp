@@ -2,9 +2,24 @@
 
 #include "VictorGameMode.h"
 #include "VictorCharacter.h"
+#include "Weapons/WeaponPoolSubsystem.h"
 
 AVictorGameMode::AVictorGameMode()
 {
 	// Set default pawn class to our character
 	DefaultPawnClass = AVictorCharacter::StaticClass();	
 }
+
+void AVictorGameMode::StartPlay()
+{
+	// Fill the weapon pool before any character calls SetWeapon
+	if (UWeaponPoolSubsystem* WeaponPool = GetWorld()->GetSubsystem<UWeaponPoolSubsystem>())
+	{
+		for (const TPair<TSubclassOf<AWeaponBase>, int32>& Entry : PrewarmedWeapons)
+		{
+			WeaponPool->PrewarmWeapons(Entry.Key, Entry.Value);
+		}
+	}
+
+	Super::StartPlay();
+}
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameModeBase.h"
+#include "Weapons/WeaponBase.h"
 #include "VictorGameMode.generated.h"
 
 /**
@@ -18,4 +19,10 @@ class AVictorGameMode : public AGameModeBase
 	GENERATED_BODY()
 public:
 	AVictorGameMode();
+
+	/** How many instances of each weapon class to spawn into the weapon pool when the level starts */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = WeaponPool)
+	TMap<TSubclassOf<AWeaponBase>, int32> PrewarmedWeapons;
+
+	virtual void StartPlay() override;
 };
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VictorStats.h"
+
+#if VICTOR_STATS
+CSV_DEFINE_CATEGORY_MODULE(VICTOR_API, Victor, true);
+#endif
+
+DEFINE_STAT(STAT_VictorUpdateCharacter);
+DEFINE_STAT(STAT_VictorUpdateAnimation);
+DEFINE_STAT(STAT_VictorGetWeaponSocketLocation);
+DEFINE_STAT(STAT_VictorPossess);
+DEFINE_STAT(STAT_VictorInteract);
+DEFINE_STAT(STAT_VictorDie);
+DEFINE_STAT(STAT_VictorTakeDamage);
+DEFINE_STAT(STAT_VictorWeaponFire);
+DEFINE_STAT(STAT_VictorWeaponCooldown);
+DEFINE_STAT(STAT_VictorMovement);
+DEFINE_STAT(STAT_VictorGuardAI);
+
+DEFINE_STAT(STAT_VictorUpdateCharacterCalls);
+DEFINE_STAT(STAT_VictorUpdateAnimationCalls);
+DEFINE_STAT(STAT_VictorGetWeaponSocketLocationCalls);
+DEFINE_STAT(STAT_VictorPossessCalls);
+DEFINE_STAT(STAT_VictorInteractCalls);
+DEFINE_STAT(STAT_VictorDieCalls);
+DEFINE_STAT(STAT_VictorTakeDamageCalls);
+DEFINE_STAT(STAT_VictorWeaponFireCalls);
+DEFINE_STAT(STAT_VictorWeaponCooldownCalls);
+DEFINE_STAT(STAT_VictorMovementCalls);
+DEFINE_STAT(STAT_VictorGuardAICalls);
+
+bool FVictorTimings::bEnabled = false;
+
+double FVictorTimings::Seconds[FVictorTimings::NumSections] = {};
+
+int32 FVictorTimings::Calls[FVictorTimings::NumSections] = {};
+
+void FVictorTimings::Reset()
+{
+	for (int32 i = 0; i < NumSections; i++)
+	{
+		Seconds[i] = 0.0;
+		Calls[i] = 0;
+	}
+}
+
+const TCHAR* FVictorTimings::GetSectionName(ESection Section)
+{
+	switch (Section)
+	{
+	case UpdateCharacter:
+		return TEXT("update_character");
+	case Possess:
+		return TEXT("possess");
+	case Interact:
+		return TEXT("interact");
+	case TakeDamage:
+		return TEXT("take_damage");
+	case Movement:
+		return TEXT("movement");
+	case GuardAI:
+		return TEXT("guard_ai");
+	case UpdateAnimation:
+		return TEXT("update_animation");
+	case GetWeaponSocketLocation:
+		return TEXT("get_weapon_socket_location");
+	case Die:
+		return TEXT("die");
+	case WeaponFire:
+		return TEXT("weapon_fire");
+	case WeaponCooldown:
+		return TEXT("weapon_cooldown");
+	default:
+		return TEXT("unknown");
+	}
+}
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+//Shown with "stat Victor"
+DECLARE_STATS_GROUP(TEXT("Victor"), STATGROUP_Victor, STATCAT_Advanced);
+
+//Gameplay instrumentation is never compiled into Shipping, even where stats or CSV capture are enabled for it
+#define VICTOR_STATS ((STATS || CSV_PROFILER) && !UE_BUILD_SHIPPING)
+
+#if VICTOR_STATS
+//Columns of "csvprofile start" captures
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(VICTOR_API, Victor);
+#endif
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("UpdateCharacter"), STAT_VictorUpdateCharacter, STATGROUP_Victor, VICTOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("UpdateAnimation"), STAT_VictorUpdateAnimation, STATGROUP_Victor, VICTOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("GetWeaponSocketLocation"), STAT_VictorGetWeaponSocketLocation, STATGROUP_Victor, VICTOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Possess"), STAT_VictorPossess, STATGROUP_Victor, VICTOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Interact"), STAT_VictorInteract, STATGROUP_Victor, VICTOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Die"), STAT_VictorDie, STATGROUP_Victor, VICTOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("TakeDamage"), STAT_VictorTakeDamage, STATGROUP_Victor, VICTOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Weapon Fire"), STAT_VictorWeaponFire, STATGROUP_Victor, VICTOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Weapon cooldown"), STAT_VictorWeaponCooldown, STATGROUP_Victor, VICTOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character movement"), STAT_VictorMovement, STATGROUP_Victor, VICTOR_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Guard AI"), STAT_VictorGuardAI, STATGROUP_Victor, VICTOR_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("UpdateCharacter calls"), STAT_VictorUpdateCharacterCalls, STATGROUP_Victor, VICTOR_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("UpdateAnimation calls"), STAT_VictorUpdateAnimationCalls, STATGROUP_Victor, VICTOR_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("GetWeaponSocketLocation calls"), STAT_VictorGetWeaponSocketLocationCalls, STATGROUP_Victor, VICTOR_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Possess calls"), STAT_VictorPossessCalls, STATGROUP_Victor, VICTOR_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Interact calls"), STAT_VictorInteractCalls, STATGROUP_Victor, VICTOR_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Die calls"), STAT_VictorDieCalls, STATGROUP_Victor, VICTOR_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("TakeDamage calls"), STAT_VictorTakeDamageCalls, STATGROUP_Victor, VICTOR_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Weapon Fire calls"), STAT_VictorWeaponFireCalls, STATGROUP_Victor, VICTOR_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Weapon cooldown calls"), STAT_VictorWeaponCooldownCalls, STATGROUP_Victor, VICTOR_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Character movement calls"), STAT_VictorMovementCalls, STATGROUP_Victor, VICTOR_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Guard AI calls"), STAT_VictorGuardAICalls, STATGROUP_Victor, VICTOR_API);
+
+/**
+ * Wall time and call counts of the VICTOR_SCOPE_CYCLE_COUNTER scopes, read by the benchmark commandlet.
+ * Nothing is measured unless bEnabled is set. A section per Victor stat above.
+ */
+struct VICTOR_API FVictorTimings
+{
+	enum ESection
+	{
+		UpdateCharacter,
+		Possess,
+		Interact,
+		TakeDamage,
+		Movement,
+		GuardAI,
+		UpdateAnimation,
+		GetWeaponSocketLocation,
+		Die,
+		WeaponFire,
+		WeaponCooldown,
+		NumSections
+	};
+
+	static bool bEnabled;
+
+	static double Seconds[NumSections];
+
+	static int32 Calls[NumSections];
+
+	static void Reset();
+
+	static const TCHAR* GetSectionName(ESection Section);
+};
+
+#if VICTOR_STATS
+struct FVictorTimingScope
+{
+	FVictorTimingScope(FVictorTimings::ESection InSection, int32 InNumCalls)
+		: Section(InSection)
+		, NumCalls(InNumCalls)
+		, bActive(FVictorTimings::bEnabled)
+		, StartTime(bActive ? FPlatformTime::Seconds() : 0.0)
+	{
+	}
+
+	~FVictorTimingScope()
+	{
+		if (bActive)
+		{
+			FVictorTimings::Seconds[Section] += FPlatformTime::Seconds() - StartTime;
+			FVictorTimings::Calls[Section] += NumCalls;
+		}
+	}
+
+private:
+	FVictorTimings::ESection Section;
+	int32 NumCalls;
+	bool bActive;
+	double StartTime;
+};
+#endif
+
+/**
+ * Times the enclosing scope as STAT_Victor<Name>, CSV stat Victor/<Name> and FVictorTimings::<Name>,
+ * and counts NumCalls calls in STAT_Victor<Name>Calls, Victor/<Name>Calls and the FVictorTimings section.
+ * For a batched pass, NumCalls is the number of per-object calls it stands for.
+ */
+#if VICTOR_STATS
+#define VICTOR_SCOPE_CYCLE_COUNTER_CALLS(Name, NumCalls) \
+	SCOPE_CYCLE_COUNTER(STAT_Victor##Name); \
+	INC_DWORD_STAT_BY(STAT_Victor##Name##Calls, NumCalls); \
+	CSV_SCOPED_TIMING_STAT(Victor, Name); \
+	CSV_CUSTOM_STAT(Victor, Name##Calls, NumCalls, ECsvCustomStatOp::Accumulate); \
+	FVictorTimingScope ANONYMOUS_VARIABLE(VictorTimingScope)(FVictorTimings::Name, NumCalls)
+#else
+#define VICTOR_SCOPE_CYCLE_COUNTER_CALLS(Name, NumCalls)
+#endif
+
+#define VICTOR_SCOPE_CYCLE_COUNTER(Name) VICTOR_SCOPE_CYCLE_COUNTER_CALLS(Name, 1)
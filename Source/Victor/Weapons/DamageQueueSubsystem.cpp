@@ -0,0 +1,243 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DamageQueueSubsystem.h"
+
+#include "VictorCharacter.h"
+#include "VictorStats.h"
+#include "WeaponBase.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "Characters/CharacterUpdateSubsystem.h"
+#include "World/LevelGridSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Damage resolve"), STAT_VictorDamageResolve, STATGROUP_Victor);
+DECLARE_CYCLE_STAT(TEXT("Damage apply"), STAT_VictorDamageApply, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage events"), STAT_VictorDamageEvents, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage targets examined"), STAT_VictorDamageTargetsExamined, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage deaths"), STAT_VictorDamageDeaths, STATGROUP_Victor);
+
+void UDamageQueueSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	Collection.InitializeDependency(ULevelGridSubsystem::StaticClass());
+	Collection.InitializeDependency(UCharacterUpdateSubsystem::StaticClass());
+	TargetHash = TSpatialHash2D<int32>(FMath::Max(TargetHashCellSize, 1.f));
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UDamageQueueSubsystem::OnWorldPostActorTick);
+}
+
+void UDamageQueueSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	PointEvents.Empty();
+	RadialEvents.Empty();
+	TargetCharacters.Empty();
+	TargetHash.Reset();
+	DamageTaken.Empty();
+	DamageTakenIndices.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UDamageQueueSubsystem::GetAttackerTeam(const AController* Instigator, const AActor* DamageCauser, ETeam& OutTeam)
+{
+	const AVictorCharacter* Attacker = Instigator != nullptr ? Cast<AVictorCharacter>(Instigator->GetPawn()) : nullptr;
+	if (Attacker == nullptr)
+	{
+		const AWeaponBase* Weapon = Cast<AWeaponBase>(DamageCauser);
+		Attacker = Cast<AVictorCharacter>(Weapon != nullptr ? Weapon->WeaponOwner : DamageCauser);
+	}
+	if (Attacker == nullptr)
+	{
+		return false;
+	}
+	OutTeam = Attacker->GetTeam();
+	return true;
+}
+
+bool UDamageQueueSubsystem::QueueDamage(AVictorCharacter* Target, float Damage, AController* Instigator, AActor* DamageCauser)
+{
+	ETeam Team = ETeam::ET_Player;
+	const bool bHasTeam = GetAttackerTeam(Instigator, DamageCauser, Team);
+	return QueuePointDamage(Target, Damage, Team, bHasTeam, Instigator, DamageCauser);
+}
+
+bool UDamageQueueSubsystem::QueuePointDamage(AVictorCharacter* Target, float Damage, ETeam Team, bool bHasTeam, AController* Instigator, AActor* DamageCauser)
+{
+	if (Target == nullptr)
+	{
+		return false;
+	}
+	if (IsFiltered(Target, Team, bHasTeam))
+	{
+		Stats.FilteredHits++;
+		return false;
+	}
+	PointEvents.Add({ Target, Damage, Team, bHasTeam, Instigator, DamageCauser });
+	return true;
+}
+
+void UDamageQueueSubsystem::QueueRadialDamage(FVector Origin, float Radius, float BaseDamage, float MinimumDamage, ETeam Team, bool bHasTeam, AController* Instigator, AActor* DamageCauser)
+{
+	if (Radius > 0.f)
+	{
+		RadialEvents.Add({ ToPlane2D(Origin), Radius, BaseDamage, MinimumDamage, Team, bHasTeam, Instigator, DamageCauser });
+	}
+}
+
+void UDamageQueueSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaTime)
+{
+	if (World == GetWorld())
+	{
+		Flush();
+	}
+}
+
+bool UDamageQueueSubsystem::IsFiltered(const AVictorCharacter* Character, ETeam Team, bool bHasTeam) const
+{
+	return bHasTeam && !bFriendlyFire && Character->GetTeam() == Team;
+}
+
+void UDamageQueueSubsystem::AddDamage(AVictorCharacter* Character, float Damage, const TWeakObjectPtr<AController>& Instigator, const TWeakObjectPtr<AActor>& DamageCauser)
+{
+	if (const int32* Index = DamageTakenIndices.Find(Character))
+	{
+		FDamageQueueKill& Taken = DamageTaken[*Index];
+		Taken.Damage += Damage;
+		if (Damage > Taken.LargestHit)
+		{
+			Taken.LargestHit = Damage;
+			Taken.Instigator = Instigator;
+			Taken.DamageCauser = DamageCauser;
+		}
+		return;
+	}
+	DamageTakenIndices.Add(Character, DamageTaken.Add({ Character, Damage, Damage, Instigator, DamageCauser }));
+}
+
+void UDamageQueueSubsystem::GatherTargets()
+{
+	TargetCharacters.Reset();
+	TargetHash.Reset();
+
+	const UCharacterUpdateSubsystem* Characters = GetWorld()->GetSubsystem<UCharacterUpdateSubsystem>();
+	for (AVictorCharacter* Character : Characters->GetCharacters())
+	{
+		if (Character->bDead || Character->IsPendingKillPending())
+		{
+			continue;
+		}
+		const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+		const int32 Index = TargetCharacters.Add(Character);
+		TargetHash.Add(Index, ToPlane2D(Capsule->GetComponentLocation()), FVector2D(Capsule->GetScaledCapsuleRadius(), Capsule->GetScaledCapsuleHalfHeight()));
+	}
+}
+
+void UDamageQueueSubsystem::Flush()
+{
+	if (PointEvents.Num() == 0 && RadialEvents.Num() == 0)
+	{
+		return;
+	}
+
+	//dying may deal damage again, that goes into the queue and not into this batch
+	TArray<FPointDamage> Points = MoveTemp(PointEvents);
+	TArray<FRadialDamage> Radials = MoveTemp(RadialEvents);
+	PointEvents.Reset();
+	RadialEvents.Reset();
+	DamageTaken.Reset();
+	DamageTakenIndices.Reset();
+
+	const double ResolveStartTime = FPlatformTime::Seconds();
+	int64 NumExamined = 0;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_VictorDamageResolve);
+		for (const FPointDamage& Event : Points)
+		{
+			AVictorCharacter* Character = Event.Target.Get();
+			if (Character == nullptr || Character->bDead || Character->IsPendingKillPending())
+			{
+				continue;
+			}
+			//possession may have changed the character's team since the hit was queued
+			if (IsFiltered(Character, Event.Team, Event.bHasTeam))
+			{
+				Stats.FilteredHits++;
+				continue;
+			}
+			AddDamage(Character, Event.Damage, Event.Instigator, Event.DamageCauser);
+		}
+
+		if (Radials.Num() > 0)
+		{
+			GatherTargets();
+			const FLevelCollisionGrid& Grid = GetWorld()->GetSubsystem<ULevelGridSubsystem>()->GetCollisionGrid();
+			const bool bUseGrid = bWallsBlockRadialDamage && Grid.IsBuilt();
+			for (const FRadialDamage& Event : Radials)
+			{
+				const FVector2D RadiusExtent(Event.Radius, Event.Radius);
+				NumExamined += TargetHash.ForEachInBox(FBox2D(Event.Origin - RadiusExtent, Event.Origin + RadiusExtent),
+					[&](int32 Index, const FVector2D& Center, const FVector2D& HalfExtent)
+				{
+					//distance to the capsule's box, so big characters aren't harder to hit
+					const FVector2D Closest(FMath::Clamp(Event.Origin.X, Center.X - HalfExtent.X, Center.X + HalfExtent.X),
+						FMath::Clamp(Event.Origin.Y, Center.Y - HalfExtent.Y, Center.Y + HalfExtent.Y));
+					const float Distance = FVector2D::Distance(Event.Origin, Closest);
+					if (Distance > Event.Radius)
+					{
+						return;
+					}
+					AVictorCharacter* Character = TargetCharacters[Index];
+					if (IsFiltered(Character, Event.Team, Event.bHasTeam))
+					{
+						Stats.FilteredHits++;
+						return;
+					}
+					if (bUseGrid && !Grid.HasLineOfSight(Event.Origin, Center))
+					{
+						return;
+					}
+					const float Damage = FMath::Lerp(Event.BaseDamage, Event.MinimumDamage, Distance / Event.Radius);
+					if (Damage > 0.f)
+					{
+						AddDamage(Character, Damage, Event.Instigator, Event.DamageCauser);
+					}
+				});
+			}
+		}
+	}
+	const double ApplyStartTime = FPlatformTime::Seconds();
+
+	//characters have no health, any damage kills, and each of them dies once however many hits it took
+	TArray<FDamageQueueKill> Killed;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_VictorDamageApply);
+		Killed.Reserve(DamageTaken.Num());
+		for (const FDamageQueueKill& Taken : DamageTaken)
+		{
+			AVictorCharacter* Character = Taken.Character;
+			if (Character->bDead || Character->IsPendingKillPending())
+			{
+				continue;
+			}
+			Character->Die();
+			Killed.Add(Taken);
+		}
+	}
+
+	Stats.Flushes++;
+	Stats.PointEvents += Points.Num();
+	Stats.RadialEvents += Radials.Num();
+	Stats.TargetsExamined += NumExamined;
+	Stats.Deaths += Killed.Num();
+	Stats.ResolveSeconds += ApplyStartTime - ResolveStartTime;
+	Stats.ApplySeconds += FPlatformTime::Seconds() - ApplyStartTime;
+	SET_DWORD_STAT(STAT_VictorDamageEvents, Points.Num() + Radials.Num());
+	SET_DWORD_STAT(STAT_VictorDamageTargetsExamined, NumExamined);
+	SET_DWORD_STAT(STAT_VictorDamageDeaths, Killed.Num());
+
+	if (Killed.Num() > 0)
+	{
+		OnDamageBatchApplied.Broadcast(Killed);
+	}
+}
@@ -0,0 +1,181 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineTypes.h"
+#include "World/SpatialHash2D.h"
+#include "DamageQueueSubsystem.generated.h"
+
+class AController;
+class AVictorCharacter;
+enum class ETeam : uint8;
+
+/** A character a damage batch killed, credited to the hit that dealt it the most damage */
+struct FDamageQueueKill
+{
+	AVictorCharacter* Character;
+
+	/** All the damage the character took in the batch */
+	float Damage;
+
+	float LargestHit;
+
+	TWeakObjectPtr<AController> Instigator;
+
+	TWeakObjectPtr<AActor> DamageCauser;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnDamageBatchApplied, const TArray<FDamageQueueKill>&);
+
+/** What the damage queue did since ResetStats */
+struct FDamageQueueStats
+{
+	int32 Flushes = 0;
+
+	int32 PointEvents = 0;
+
+	int32 RadialEvents = 0;
+
+	/** Hits on characters of the attacker's team that were dropped */
+	int32 FilteredHits = 0;
+
+	/** Characters the radial events looked at through the grid, in range or not */
+	int64 TargetsExamined = 0;
+
+	int32 Deaths = 0;
+
+	double ResolveSeconds = 0.0;
+
+	double ApplySeconds = 0.0;
+};
+
+/**
+ * Collects point and radial damage and applies it in one batch once the actors of the frame ticked,
+ * so an explosion or a burst of fire never kills characters inside the call stack that dealt the damage.
+ * AVictorCharacter::TakeDamage, hitscan and projectile hits all end up here; damage queued later in the frame,
+ * e.g. by tickables, waits for the next frame's batch.
+ * Damage from a team doesn't hurt that team's characters. Radial damage finds its characters through a 2D grid hash
+ * of the living characters instead of a physics overlap per explosion, and walls of the level collision grid shield them.
+ * Every character the batch damages dies once, then OnDamageBatchApplied tells who died and who killed them.
+ */
+UCLASS(config=Game)
+class VICTOR_API UDamageQueueSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/** Damage to one character, from the team of whoever Instigator or DamageCauser belong to. False if the team filters it out */
+	bool QueueDamage(AVictorCharacter* Target, float Damage, AController* Instigator, AActor* DamageCauser);
+
+	/**
+	 * Damage to one character. Team is the attacker's, bHasTeam false for damage that hurts everyone.
+	 * False if the hit is on the attacker's team and isn't queued; the batch checks the team again when it is applied.
+	 */
+	bool QueuePointDamage(AVictorCharacter* Target, float Damage, ETeam Team, bool bHasTeam, AController* Instigator, AActor* DamageCauser);
+
+	/** Damage to one character from an attacker of Team */
+	UFUNCTION(BlueprintCallable, Category = Damage)
+	void QueueTeamDamage(AVictorCharacter* Target, float Damage, ETeam Team, AController* Instigator, AActor* DamageCauser)
+	{
+		QueuePointDamage(Target, Damage, Team, true, Instigator, DamageCauser);
+	}
+
+	/**
+	 * Damage to every character not of Team whose capsule is within Radius of Origin on the XZ plane,
+	 * to every character in range if bHasTeam is false. BaseDamage at the center, falling off linearly to MinimumDamage at Radius.
+	 */
+	void QueueRadialDamage(FVector Origin, float Radius, float BaseDamage, float MinimumDamage, ETeam Team, bool bHasTeam, AController* Instigator, AActor* DamageCauser);
+
+	/** Radial damage from an attacker of Team */
+	UFUNCTION(BlueprintCallable, Category = Damage)
+	void QueueTeamRadialDamage(FVector Origin, float Radius, float BaseDamage, float MinimumDamage, ETeam Team, AController* Instigator, AActor* DamageCauser)
+	{
+		QueueRadialDamage(Origin, Radius, BaseDamage, MinimumDamage, Team, true, Instigator, DamageCauser);
+	}
+
+	/** Resolves and applies everything queued so far. The end of every frame does this */
+	void Flush();
+
+	UFUNCTION(BlueprintPure, Category = Damage)
+	int32 GetNumQueuedEvents() const { return PointEvents.Num() + RadialEvents.Num(); }
+
+	/** The characters one batch killed, after they all died. Only valid during the broadcast */
+	FOnDamageBatchApplied OnDamageBatchApplied;
+
+	/** Team the instigator's pawn, else the weapon owner or character that caused the damage, fights for. False if there is none */
+	static bool GetAttackerTeam(const AController* Instigator, const AActor* DamageCauser, ETeam& OutTeam);
+
+	/** True if damage from Team doesn't hurt the character. Damage without a team hurts everyone */
+	bool IsFiltered(const AVictorCharacter* Character, ETeam Team, bool bHasTeam) const;
+
+	const FDamageQueueStats& GetStats() const { return Stats; }
+
+	void ResetStats() { Stats = FDamageQueueStats(); }
+
+	/** Let damage from a team hurt its own characters */
+	UPROPERTY(Config, EditAnywhere, Category = Damage)
+	bool bFriendlyFire = false;
+
+	/** Characters without line of sight to the center of radial damage through the level collision grid take none of it */
+	UPROPERTY(Config, EditAnywhere, Category = Damage)
+	bool bWallsBlockRadialDamage = true;
+
+	/** Cell size of the character hash radial damage searches. About the radius of a typical explosion */
+	UPROPERTY(Config, EditAnywhere, Category = Damage)
+	float TargetHashCellSize = 256.f;
+
+protected:
+	struct FPointDamage
+	{
+		TWeakObjectPtr<AVictorCharacter> Target;
+		float Damage;
+		ETeam Team;
+		bool bHasTeam;
+		TWeakObjectPtr<AController> Instigator;
+		TWeakObjectPtr<AActor> DamageCauser;
+	};
+
+	struct FRadialDamage
+	{
+		FVector2D Origin;
+		float Radius;
+		float BaseDamage;
+		float MinimumDamage;
+		ETeam Team;
+		bool bHasTeam;
+		TWeakObjectPtr<AController> Instigator;
+		TWeakObjectPtr<AActor> DamageCauser;
+	};
+
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaTime);
+
+	/** Hashes the living characters for this batch's radial damage */
+	void GatherTargets();
+
+	void AddDamage(AVictorCharacter* Character, float Damage, const TWeakObjectPtr<AController>& Instigator, const TWeakObjectPtr<AActor>& DamageCauser);
+
+	TArray<FPointDamage> PointEvents;
+
+	TArray<FRadialDamage> RadialEvents;
+
+	UPROPERTY(Transient)
+	TArray<AVictorCharacter*> TargetCharacters;
+
+	TSpatialHash2D<int32> TargetHash;
+
+	//every character damaged this batch, the ones still alive die at the end of it
+	TArray<FDamageQueueKill> DamageTaken;
+
+	//index in DamageTaken of each character damaged this batch
+	TMap<AVictorCharacter*, int32> DamageTakenIndices;
+
+	FDamageQueueStats Stats;
+
+	FDelegateHandle PostActorTickHandle;
+};
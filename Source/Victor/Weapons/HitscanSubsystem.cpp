@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HitscanSubsystem.h"
+
+#include "VictorCharacter.h"
+#include "VictorStats.h"
+#include "WeaponBase.h"
+#include "DamageQueueSubsystem.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Hitscan submit"), STAT_VictorHitscanSubmit, STATGROUP_Victor);
+DECLARE_CYCLE_STAT(TEXT("Hitscan apply"), STAT_VictorHitscanApply, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hitscan traces submitted"), STAT_VictorHitscanSubmitted, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hitscan traces queued"), STAT_VictorHitscanQueued, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hitscan hits"), STAT_VictorHitscanHits, STATGROUP_Victor);
+
+void UHitscanSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	Collection.InitializeDependency(UDamageQueueSubsystem::StaticClass());
+	TraceDelegate.BindUObject(this, &UHitscanSubsystem::OnTraceDone);
+	PreActorTickHandle = FWorldDelegates::OnWorldPreActorTick.AddUObject(this, &UHitscanSubsystem::OnWorldPreActorTick);
+}
+
+void UHitscanSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPreActorTick.Remove(PreActorTickHandle);
+	TraceDelegate.Unbind();
+	Queue.Empty();
+	InFlight.Empty();
+	Hits.Empty();
+
+	Super::Deinitialize();
+}
+
+void UHitscanSubsystem::QueueTrace(AActor* Weapon, ETeam Team, FVector Start, FVector End, float Damage)
+{
+	const AWeaponBase* WeaponBase = Cast<AWeaponBase>(Weapon);
+	Queue.Add({ Weapon, WeaponBase != nullptr ? WeaponBase->WeaponOwner : nullptr, Team, Start, End, Damage });
+}
+
+void UHitscanSubsystem::SubmitTraces()
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorHitscanSubmit);
+	UWorld* World = GetWorld();
+	const int32 NumToSubmit = FMath::Min(Queue.Num(), FMath::Max(MaxTracesPerFrame, 0));
+
+	FCollisionResponseParams ResponseParams;
+	ResponseParams.CollisionResponse.SetResponse(ECC_Pawn, ECR_Overlap);
+	for (int32 Index = 0; Index < NumToSubmit; Index++)
+	{
+		const FShot& Shot = Queue[Index];
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(VictorHitscan), false, Shot.Weapon.Get());
+		QueryParams.AddIgnoredActor(Shot.Owner.Get());
+
+		const uint32 TraceId = NextTraceId++;
+		World->AsyncLineTraceByChannel(EAsyncTraceType::Multi, Shot.Start, Shot.End, TraceChannel, QueryParams, ResponseParams, &TraceDelegate, TraceId);
+		InFlight.Add(TraceId, Shot);
+	}
+	Queue.RemoveAt(0, NumToSubmit, false);
+
+	SET_DWORD_STAT(STAT_VictorHitscanSubmitted, NumToSubmit);
+	SET_DWORD_STAT(STAT_VictorHitscanQueued, Queue.Num());
+}
+
+void UHitscanSubsystem::OnTraceDone(const FTraceHandle& Handle, FTraceDatum& Datum)
+{
+	FShot Shot;
+	if (!InFlight.RemoveAndCopyValue(Datum.UserData, Shot))
+	{
+		return;
+	}
+
+	//hits are sorted by distance and end with the blocking one, if any
+	for (const FHitResult& Hit : Datum.OutHits)
+	{
+		AVictorCharacter* Character = Cast<AVictorCharacter>(Hit.GetActor());
+		if (Character != nullptr)
+		{
+			if (Character->GetTeam() != Shot.Team && !Character->bDead)
+			{
+				Hits.Add({ Shot, Character });
+				return;
+			}
+		}
+		else if (Hit.bBlockingHit)
+		{
+			return;
+		}
+	}
+}
+
+void UHitscanSubsystem::OnWorldPreActorTick(UWorld* World, ELevelTick TickType, float DeltaTime)
+{
+	if (World == GetWorld() && Hits.Num() > 0)
+	{
+		ApplyHits();
+	}
+}
+
+void UHitscanSubsystem::ApplyHits()
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorHitscanApply);
+	SET_DWORD_STAT(STAT_VictorHitscanHits, Hits.Num());
+
+	//the damage queue kills at the end of the actor tick, the shots of this batch still see everyone alive
+	TArray<FShotHit> Batch = MoveTemp(Hits);
+	Hits.Reset();
+	UDamageQueueSubsystem* DamageQueue = GetWorld()->GetSubsystem<UDamageQueueSubsystem>();
+	for (const FShotHit& Hit : Batch)
+	{
+		AVictorCharacter* Character = Hit.Target.Get();
+		if (Character == nullptr || Character->bDead)
+		{
+			continue;
+		}
+		const APawn* OwnerPawn = Cast<APawn>(Hit.Shot.Owner.Get());
+		DamageQueue->QueueTeamDamage(Character, Hit.Shot.Damage, Hit.Shot.Team, OwnerPawn != nullptr ? OwnerPawn->GetController() : nullptr, Hit.Shot.Weapon.Get());
+	}
+}
+
+void UHitscanSubsystem::Tick(float DeltaTime)
+{
+	SubmitTraces();
+}
+
+TStatId UHitscanSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHitscanSubsystem, STATGROUP_Tickables);
+}
+
+ETickableTickType UHitscanSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
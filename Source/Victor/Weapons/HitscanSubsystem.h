@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Engine/EngineTypes.h"
+#include "WorldCollision.h"
+#include "HitscanSubsystem.generated.h"
+
+class AVictorCharacter;
+enum class ETeam : uint8;
+
+/**
+ * Instant-hit shots without a synchronous trace per shot.
+ * AWeaponBase::Fire queues a trace; the queue is submitted once per frame through the world's async trace API,
+ * at most MaxTracesPerFrame at a time, and the hits are handed to UDamageQueueSubsystem in one batch when the next frame starts.
+ * A shot passes through its owner and characters of its team and stops at the first wall.
+ */
+UCLASS(config=Game)
+class VICTOR_API UHitscanSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/** Queues a shot from Start to End. Weapon is the damage causer and its WeaponOwner the instigator */
+	UFUNCTION(BlueprintCallable, Category = Hitscan)
+	void QueueTrace(AActor* Weapon, ETeam Team, FVector Start, FVector End, float Damage);
+
+	UFUNCTION(BlueprintPure, Category = Hitscan)
+	int32 GetNumQueuedTraces() const { return Queue.Num(); }
+
+	/** Traces submitted per frame, the rest wait in order for the next frames */
+	UPROPERTY(Config, EditAnywhere, Category = Hitscan)
+	int32 MaxTracesPerFrame = 256;
+
+	/** Walls block this channel; characters are only overlapped so the trace can look past teammates */
+	UPROPERTY(Config, EditAnywhere, Category = Hitscan)
+	TEnumAsByte<ECollisionChannel> TraceChannel = ECC_Pawn;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return Queue.Num() > 0; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual ETickableTickType GetTickableTickType() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	struct FShot
+	{
+		TWeakObjectPtr<AActor> Weapon;
+		TWeakObjectPtr<AActor> Owner;
+		ETeam Team;
+		FVector Start;
+		FVector End;
+		float Damage;
+	};
+
+	struct FShotHit
+	{
+		FShot Shot;
+		TWeakObjectPtr<AVictorCharacter> Target;
+	};
+
+	void SubmitTraces();
+
+	/** Async trace delegate, picks the character the shot hits and keeps it for ApplyHits */
+	void OnTraceDone(const FTraceHandle& Handle, FTraceDatum& Datum);
+
+	void OnWorldPreActorTick(UWorld* World, ELevelTick TickType, float DeltaTime);
+
+	void ApplyHits();
+
+	TArray<FShot> Queue;
+
+	//submitted shots by the UserData of their trace
+	TMap<uint32, FShot> InFlight;
+
+	uint32 NextTraceId = 0;
+
+	TArray<FShotHit> Hits;
+
+	FTraceDelegate TraceDelegate;
+
+	FDelegateHandle PreActorTickHandle;
+};
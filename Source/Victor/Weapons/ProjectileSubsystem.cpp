@@ -0,0 +1,314 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProjectileSubsystem.h"
+
+#include "VictorCharacter.h"
+#include "VictorStats.h"
+#include "WeaponBase.h"
+#include "DamageQueueSubsystem.h"
+#include "PaperGroupedSpriteComponent.h"
+#include "PaperSprite.h"
+#include "Async/ParallelFor.h"
+#include "Components/CapsuleComponent.h"
+#include "Characters/CharacterUpdateSubsystem.h"
+#include "World/LevelGridSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Projectile update"), STAT_VictorProjectileUpdate, STATGROUP_Victor);
+DECLARE_CYCLE_STAT(TEXT("Projectile sweeps"), STAT_VictorProjectileSweeps, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Live projectiles"), STAT_VictorLiveProjectiles, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile hits"), STAT_VictorProjectileHits, STATGROUP_Victor);
+
+namespace
+{
+	/** Fraction of the segment where it enters the box, or a value above 1 if it misses */
+	float SegmentEntryTime(const FVector2D& Start, const FVector2D& Delta, const FVector2D& Center, const FVector2D& HalfExtent)
+	{
+		float EntryTime = 0.f;
+		float ExitTime = 1.f;
+		for (int32 Axis = 0; Axis < 2; Axis++)
+		{
+			const float Min = Center[Axis] - HalfExtent[Axis];
+			const float Max = Center[Axis] + HalfExtent[Axis];
+			if (FMath::IsNearlyZero(Delta[Axis]))
+			{
+				if (Start[Axis] < Min || Start[Axis] > Max)
+				{
+					return 2.f;
+				}
+				continue;
+			}
+			const float InverseDelta = 1.f / Delta[Axis];
+			float Near = (Min - Start[Axis]) * InverseDelta;
+			float Far = (Max - Start[Axis]) * InverseDelta;
+			if (Near > Far)
+			{
+				Swap(Near, Far);
+			}
+			EntryTime = FMath::Max(EntryTime, Near);
+			ExitTime = FMath::Min(ExitTime, Far);
+			if (EntryTime > ExitTime)
+			{
+				return 2.f;
+			}
+		}
+		return EntryTime;
+	}
+}
+
+int32 FProjectileSimulation::Spawn(const FVector2D& Location, const FVector2D& Velocity, float Lifetime, ETeam Team, float Damage, AActor* Owner)
+{
+	Velocities.Add(Velocity);
+	Lifetimes.Add(Lifetime);
+	Teams.Add(Team);
+	Damages.Add(Damage);
+	Owners.Add(Owner);
+	Results.Add(Alive);
+	return Positions.Add(Location);
+}
+
+void FProjectileSimulation::Step(float DeltaTime, float Gravity, const FLevelCollisionGrid* Grid, const TSpatialHash2D<int32>& TargetHash,
+	const TArray<FProjectileTarget>& Targets, bool bParallel)
+{
+	{
+		SCOPE_CYCLE_COUNTER(STAT_VictorProjectileSweeps);
+		ParallelFor(Positions.Num(), [&](int32 Index)
+		{
+			const FVector2D Start = Positions[Index];
+			FVector2D& Velocity = Velocities[Index];
+			Velocity.Y -= Gravity * DeltaTime;
+			const FVector2D Delta = Velocity * DeltaTime;
+			const ETeam Team = Teams[Index];
+
+			//closest target of another team along the segment
+			int32 Result = Alive;
+			float HitTime = 1.f;
+			TargetHash.ForEachInBox(FBox2D(FVector2D::Min(Start, Start + Delta), FVector2D::Max(Start, Start + Delta)),
+				[&](int32 Target, const FVector2D& Center, const FVector2D& HalfExtent)
+			{
+				if (Targets[Target].Team != Team)
+				{
+					const float EntryTime = SegmentEntryTime(Start, Delta, Center, HalfExtent);
+					if (EntryTime <= HitTime)
+					{
+						HitTime = EntryTime;
+						Result = Target;
+					}
+				}
+			});
+
+			//a wall before the target, or anywhere along a miss, stops the projectile first
+			if (Grid != nullptr && !Grid->HasLineOfSight(Start, Start + Delta * HitTime))
+			{
+				Result = HitWall;
+			}
+
+			Positions[Index] = Start + Delta * HitTime;
+			Lifetimes[Index] -= DeltaTime;
+			if (Result == Alive && Lifetimes[Index] <= 0.f)
+			{
+				Result = Expired;
+			}
+			Results[Index] = Result;
+		}, !bParallel);
+	}
+
+	Hits.Reset();
+	NumStopped = 0;
+	for (int32 Index = Positions.Num() - 1; Index >= 0; Index--)
+	{
+		const int32 Result = Results[Index];
+		if (Result == Alive)
+		{
+			continue;
+		}
+		if (Result >= 0)
+		{
+			Hits.Add({ Result, Positions[Index], Damages[Index], Owners[Index] });
+		}
+		else
+		{
+			NumStopped++;
+		}
+		RemoveAtSwap(Index);
+	}
+}
+
+void FProjectileSimulation::Reset()
+{
+	Positions.Reset();
+	Velocities.Reset();
+	Lifetimes.Reset();
+	Teams.Reset();
+	Damages.Reset();
+	Owners.Reset();
+	Results.Reset();
+	Hits.Reset();
+	NumStopped = 0;
+}
+
+void FProjectileSimulation::RemoveAtSwap(int32 Index)
+{
+	Positions.RemoveAtSwap(Index, 1, false);
+	Velocities.RemoveAtSwap(Index, 1, false);
+	Lifetimes.RemoveAtSwap(Index, 1, false);
+	Teams.RemoveAtSwap(Index, 1, false);
+	Damages.RemoveAtSwap(Index, 1, false);
+	Owners.RemoveAtSwap(Index, 1, false);
+	Results.RemoveAtSwap(Index, 1, false);
+}
+
+void UProjectileSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	Collection.InitializeDependency(ULevelGridSubsystem::StaticClass());
+	Collection.InitializeDependency(UCharacterUpdateSubsystem::StaticClass());
+	Collection.InitializeDependency(UDamageQueueSubsystem::StaticClass());
+}
+
+void UProjectileSubsystem::Deinitialize()
+{
+	Simulation.Reset();
+	TargetCharacters.Empty();
+	Targets.Empty();
+	TargetHash.Reset();
+	LoadedSprite = nullptr;
+	SpriteInstances = nullptr;
+	NumDrawnInstances = 0;
+
+	Super::Deinitialize();
+}
+
+bool UProjectileSubsystem::FireProjectile(AActor* Owner, ETeam Team, FVector Location, FVector Direction, float Speed, float Damage, float Lifetime)
+{
+	const FVector2D Direction2D = ToPlane2D(Direction).GetSafeNormal();
+	if (Simulation.Num() >= MaxProjectiles || Direction2D.IsZero() || Speed <= 0.f)
+	{
+		return false;
+	}
+	Simulation.Spawn(ToPlane2D(Location), Direction2D * Speed, Lifetime, Team, Damage, Owner);
+	return true;
+}
+
+void UProjectileSubsystem::GatherTargets()
+{
+	TargetCharacters.Reset();
+	Targets.Reset();
+	TargetHash.Reset();
+
+	const UCharacterUpdateSubsystem* Characters = GetWorld()->GetSubsystem<UCharacterUpdateSubsystem>();
+	for (AVictorCharacter* Character : Characters->GetCharacters())
+	{
+		if (Character->bDead)
+		{
+			continue;
+		}
+		const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+		const FVector2D Center = ToPlane2D(Capsule->GetComponentLocation());
+		const FVector2D HalfExtent(Capsule->GetScaledCapsuleRadius(), Capsule->GetScaledCapsuleHalfHeight());
+		const int32 Index = Targets.Add({ Center, HalfExtent, Character->GetTeam() });
+		TargetCharacters.Add(Character);
+		TargetHash.Add(Index, Center, HalfExtent);
+	}
+}
+
+void UProjectileSubsystem::ApplyHits()
+{
+	UDamageQueueSubsystem* DamageQueue = GetWorld()->GetSubsystem<UDamageQueueSubsystem>();
+	for (const FProjectileSimulation::FHit& Hit : Simulation.Hits)
+	{
+		AVictorCharacter* Character = TargetCharacters[Hit.Target];
+		if (Character->bDead || Character->IsPendingKillPending())
+		{
+			continue;
+		}
+		AActor* DamageCauser = Hit.Owner.Get();
+		AController* Instigator = nullptr;
+		if (AWeaponBase* Weapon = Cast<AWeaponBase>(DamageCauser))
+		{
+			if (APawn* OwnerPawn = Cast<APawn>(Weapon->WeaponOwner))
+			{
+				Instigator = OwnerPawn->GetController();
+			}
+		}
+		DamageQueue->QueueDamage(Character, Hit.Damage, Instigator, DamageCauser);
+	}
+	SET_DWORD_STAT(STAT_VictorProjectileHits, Simulation.Hits.Num());
+}
+
+void UProjectileSubsystem::UpdateSprites()
+{
+	if (LoadedSprite == nullptr)
+	{
+		if (ProjectileSprite.IsNull())
+		{
+			return;
+		}
+		LoadedSprite = Cast<UPaperSprite>(ProjectileSprite.TryLoad());
+		if (LoadedSprite == nullptr)
+		{
+			return;
+		}
+	}
+	if (SpriteInstances == nullptr)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.ObjectFlags |= RF_Transient;
+		AActor* Actor = GetWorld()->SpawnActor<AActor>(SpawnParameters);
+		SpriteInstances = NewObject<UPaperGroupedSpriteComponent>(Actor);
+		SpriteInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Actor->SetRootComponent(SpriteInstances);
+		SpriteInstances->RegisterComponent();
+	}
+
+	const int32 NumProjectiles = Simulation.Num();
+	const int32 NumInstances = FMath::Max(NumProjectiles, NumDrawnInstances);
+	for (int32 Index = 0; Index < NumInstances; Index++)
+	{
+		FTransform Transform;
+		if (Index < NumProjectiles)
+		{
+			const FVector2D Location = Simulation.Positions[Index];
+			const FVector2D Velocity = Simulation.Velocities[Index];
+			Transform = FTransform(FRotator(FMath::RadiansToDegrees(FMath::Atan2(Velocity.Y, Velocity.X)), 0.f, 0.f), FVector(Location.X, 0.f, Location.Y));
+		}
+		else
+		{
+			Transform.SetScale3D(FVector::ZeroVector);
+		}
+
+		if (Index < SpriteInstances->GetInstanceCount())
+		{
+			SpriteInstances->UpdateInstanceTransform(Index, Transform, true, false);
+		}
+		else
+		{
+			SpriteInstances->AddInstance(Transform, LoadedSprite, true);
+		}
+	}
+	SpriteInstances->MarkRenderStateDirty();
+	NumDrawnInstances = NumProjectiles;
+}
+
+void UProjectileSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorProjectileUpdate);
+
+	GatherTargets();
+	const FLevelCollisionGrid& Grid = GetWorld()->GetSubsystem<ULevelGridSubsystem>()->GetCollisionGrid();
+	Simulation.Step(DeltaTime, Gravity, Grid.IsBuilt() ? &Grid : nullptr, TargetHash, Targets, bRunOnWorkerThreads);
+	ApplyHits();
+	UpdateSprites();
+
+	SET_DWORD_STAT(STAT_VictorLiveProjectiles, Simulation.Num());
+}
+
+TStatId UProjectileSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UProjectileSubsystem, STATGROUP_Tickables);
+}
+
+ETickableTickType UProjectileSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
@@ -0,0 +1,158 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "World/SpatialHash2D.h"
+#include "ProjectileSubsystem.generated.h"
+
+class AVictorCharacter;
+class FLevelCollisionGrid;
+class UPaperGroupedSpriteComponent;
+class UPaperSprite;
+enum class ETeam : uint8;
+
+/** Something projectiles can hit, gathered once per frame */
+struct FProjectileTarget
+{
+	FVector2D Center;
+	FVector2D HalfExtent;
+	ETeam Team;
+};
+
+/**
+ * Every live projectile in parallel arrays on the XZ plane.
+ * Step only reads the grid and the targets and writes each projectile's own slot, so it runs on worker threads;
+ * projectiles that hit something or ran out of lifetime are removed afterwards on the calling thread.
+ */
+class VICTOR_API FProjectileSimulation
+{
+public:
+	/** What happened to a projectile during the last Step. Values >= 0 are the index of the target it hit */
+	enum EResult : int32
+	{
+		Alive = -1,
+		HitWall = -2,
+		Expired = -3
+	};
+
+	struct FHit
+	{
+		int32 Target;
+		FVector2D Location;
+		float Damage;
+		TWeakObjectPtr<AActor> Owner;
+	};
+
+	int32 Spawn(const FVector2D& Location, const FVector2D& Velocity, float Lifetime, ETeam Team, float Damage, AActor* Owner);
+
+	/**
+	 * Moves every projectile and sweeps the segment it travelled against the grid and against targets of other teams.
+	 * Fills Hits with the projectiles that hit a target and removes every projectile that stopped.
+	 */
+	void Step(float DeltaTime, float Gravity, const FLevelCollisionGrid* Grid, const TSpatialHash2D<int32>& TargetHash,
+		const TArray<FProjectileTarget>& Targets, bool bParallel);
+
+	void Reset();
+
+	int32 Num() const { return Positions.Num(); }
+
+	TArray<FVector2D> Positions;
+
+	TArray<FVector2D> Velocities;
+
+	TArray<float> Lifetimes;
+
+	TArray<ETeam> Teams;
+
+	TArray<float> Damages;
+
+	//weapon that fired the projectile, the damage causer of its hit
+	TArray<TWeakObjectPtr<AActor>> Owners;
+
+	//EResult of the last Step, per projectile
+	TArray<int32> Results;
+
+	//hits of the last Step, in no particular order
+	TArray<FHit> Hits;
+
+	//projectiles that hit a wall or expired in the last Step
+	int32 NumStopped = 0;
+
+private:
+	void RemoveAtSwap(int32 Index);
+};
+
+/**
+ * Simulates bullets without an actor per bullet.
+ * AWeaponBase::Fire adds a projectile for weapons with a ProjectileSpeed; once per frame every projectile is moved
+ * and swept against the level collision grid and the living characters in one batch, hits are delivered through
+ * TakeDamage and the projectiles are drawn as instances of one grouped sprite component.
+ */
+UCLASS(config=Game)
+class VICTOR_API UProjectileSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/** Launches a projectile along Direction on the XZ plane. Characters of Team are passed through */
+	UFUNCTION(BlueprintCallable, Category = Projectiles)
+	bool FireProjectile(AActor* Owner, ETeam Team, FVector Location, FVector Direction, float Speed, float Damage, float Lifetime = 2.f);
+
+	UFUNCTION(BlueprintPure, Category = Projectiles)
+	int32 GetNumProjectiles() const { return Simulation.Num(); }
+
+	/** Projectiles over this are not fired */
+	UPROPERTY(Config, EditAnywhere, Category = Projectiles)
+	int32 MaxProjectiles = 4096;
+
+	/** Downward acceleration, 0 for bullets that fly straight */
+	UPROPERTY(Config, EditAnywhere, Category = Projectiles)
+	float Gravity = 0.f;
+
+	UPROPERTY(Config, EditAnywhere, Category = Projectiles)
+	bool bRunOnWorkerThreads = true;
+
+	/** Drawn for every projectile, nothing is drawn if unset */
+	UPROPERTY(Config, EditAnywhere, Category = Projectiles, meta = (AllowedClasses = "PaperSprite"))
+	FSoftObjectPath ProjectileSprite;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return Simulation.Num() > 0 || NumDrawnInstances > 0; }
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual ETickableTickType GetTickableTickType() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	void GatherTargets();
+
+	void ApplyHits();
+
+	void UpdateSprites();
+
+	FProjectileSimulation Simulation;
+
+	UPROPERTY(Transient)
+	TArray<AVictorCharacter*> TargetCharacters;
+
+	TArray<FProjectileTarget> Targets;
+
+	TSpatialHash2D<int32> TargetHash;
+
+	UPROPERTY(Transient)
+	UPaperSprite* LoadedSprite = nullptr;
+
+	UPROPERTY(Transient)
+	UPaperGroupedSpriteComponent* SpriteInstances = nullptr;
+
+	//instances that show a projectile, the ones past it are collapsed to zero scale and reused
+	int32 NumDrawnInstances = 0;
+};
@@ -3,7 +3,13 @@
 
 #include "WeaponBase.h"
 
-#include "Kismet/GameplayStatics.h"
+#include "HitscanSubsystem.h"
+#include "ProjectileSubsystem.h"
+#include "VictorCharacter.h"
+#include "VictorStats.h"
+#include "Audio/GameplayAudioSubsystem.h"
+#include "Engine/AssetManager.h"
+#include "Sound/SoundBase.h"
 
 // Sets default values
 AWeaponBase::AWeaponBase()
@@ -28,33 +34,80 @@ void AWeaponBase::Tick(float DeltaTime)
 
 bool AWeaponBase::CanShoot()
 {
-	return  !bIsCoolingDown;
+	return  !IsCoolingDown();
+}
+
+bool AWeaponBase::IsCoolingDown() const
+{
+	return GetWorld()->GetTimeSeconds() < CooldownEndTime;
 }
 
 bool AWeaponBase::Fire(FVector Location,FRotator Rotaion)
 {
+	VICTOR_SCOPE_CYCLE_COUNTER(WeaponFire);
 	if(CanShoot())
 	{
-		if (FireSound != nullptr)
+		RequestFireSound();
+		GetWorld()->GetSubsystem<UGameplayAudioSubsystem>()->PlaySound(FireSound.Get(), EGameplaySoundCategory::Weapons, Location);
+		const AVictorCharacter* Character = Cast<AVictorCharacter>(WeaponOwner);
+		const ETeam Team = Character != nullptr ? Character->GetTeam() : ETeam::ET_Guards;
+		if (bHitscan)
+		{
+			GetWorld()->GetSubsystem<UHitscanSubsystem>()->QueueTrace(this, Team, Location, Location + Rotaion.Vector() * HitscanRange, Damage);
+		}
+		else if (ProjectileSpeed > 0.f)
 		{
-			UGameplayStatics::PlaySoundAtLocation(GetWorld(), FireSound, Location, Rotaion);
+			GetWorld()->GetSubsystem<UProjectileSubsystem>()->FireProjectile(this, Team, Location, Rotaion.Vector(), ProjectileSpeed, Damage, ProjectileLifetime);
 		}
-		StartCooldownTimer();
+		StartCooldown();
 	}
 	return false;
 }
 
-void AWeaponBase::OnCooldownEnd()
+void AWeaponBase::RequestFireSound()
 {
-	bIsCoolingDown = false;
+	if (!FireSoundHandle.IsValid() && !FireSound.IsNull())
+	{
+		FireSoundHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(FireSound.ToSoftObjectPath());
+	}
 }
 
-void AWeaponBase::StartCooldownTimer()
+void AWeaponBase::ResetCooldown()
 {
+	CooldownEndTime = 0.f;
+}
+
+void AWeaponBase::StartCooldown()
+{
+	VICTOR_SCOPE_CYCLE_COUNTER(WeaponCooldown);
 	if(CooldownTime>0.f)
 	{
-		bIsCoolingDown = true;
-		GetWorldTimerManager().SetTimer(CooldownTimerHandle,this,&AWeaponBase::OnCooldownEnd,CooldownTime);
+		CooldownEndTime = GetWorld()->GetTimeSeconds() + CooldownTime;
 	}
 }
 
+void AWeaponBase::OnAcquiredFromPool()
+{
+	bIsInPool = false;
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	SetActorTickEnabled(true);
+	RequestFireSound();
+}
+
+void AWeaponBase::OnReturnedToPool()
+{
+	bIsInPool = true;
+	ResetCooldown();
+	WeaponOwner = nullptr;
+	SetHiddenInShadow(false);
+	DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+	SetActorTickEnabled(false);
+	if (FireSoundHandle.IsValid())
+	{
+		FireSoundHandle->ReleaseHandle();
+		FireSoundHandle.Reset();
+	}
+}
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "WeaponAnimTypes.h"
+#include "Engine/StreamableManager.h"
 #include "GameFramework/Actor.h"
 #include "WeaponBase.generated.h"
 
@@ -20,7 +21,11 @@ class VICTOR_API AWeaponBase : public AActor
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-	FTimerHandle CooldownTimerHandle;
+	//world time the cooldown ends at; a timestamp, so nothing has to run when it does
+	float CooldownEndTime = 0.f;
+
+	//Keeps FireSound loaded while the weapon is out of the pool
+	TSharedPtr<FStreamableHandle> FireSoundHandle;
 	public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
@@ -38,24 +43,53 @@ class VICTOR_API AWeaponBase : public AActor
 	UPROPERTY(BlueprintReadWrite,EditAnywhere,Category=Cooldown)
 	float CooldownTime = 0.f;
 	
-	UPROPERTY(BlueprintReadWrite,EditAnywhere,Category=Cooldown)
-	bool bIsCoolingDown = false;
+	UFUNCTION(BlueprintPure,Category=Cooldown)
+	bool IsCoolingDown() const;
 
 	UFUNCTION(BlueprintPure)
     virtual bool CanShoot();
+
+	//Speed of the projectile Fire launches through UProjectileSubsystem. 0 for weapons that don't shoot, like knives
+	UPROPERTY(BlueprintReadWrite,EditAnywhere,Category=Projectile)
+	float ProjectileSpeed = 0.f;
+
+	UPROPERTY(BlueprintReadWrite,EditAnywhere,Category=Projectile)
+	float ProjectileLifetime = 2.f;
+
+	//Instant-hit weapons queue a trace in UHitscanSubsystem instead of firing a projectile
+	UPROPERTY(BlueprintReadWrite,EditAnywhere,Category=Hitscan)
+	bool bHitscan = false;
+
+	UPROPERTY(BlueprintReadWrite,EditAnywhere,Category=Hitscan)
+	float HitscanRange = 3000.f;
 	
+	//Loaded when the weapon is handed out, a shot fired before it is in stays silent
 	UPROPERTY(BlueprintReadWrite,EditAnywhere,Category=Sound)
-	USoundBase* FireSound;
+	TSoftObjectPtr<USoundBase> FireSound;
+
+	/** Starts loading FireSound unless it is loaded or loading already */
+	void RequestFireSound();
 
 	UFUNCTION(BlueprintCallable)
     virtual bool Fire(FVector Location,FRotator Rotaion);
 
+	//Ends the cooldown now
 	UFUNCTION(BlueprintCallable)
-    virtual void OnCooldownEnd();
+    virtual void ResetCooldown();
 
 	UFUNCTION(BlueprintCallable)
-    void StartCooldownTimer();
+    void StartCooldown();
 
 	UFUNCTION(BlueprintCallable)
     virtual void SetHiddenInShadow(bool Hidden){}
+
+	//true while the weapon sits unused in UWeaponPoolSubsystem
+	UPROPERTY(BlueprintReadOnly,Transient,Category=Pool)
+	bool bIsInPool = false;
+
+	//Called by the weapon pool when this instance is handed out to a character
+	virtual void OnAcquiredFromPool();
+
+	//Called by the weapon pool when this instance is returned. Clears cooldown and owner so the next user gets a fresh weapon
+	virtual void OnReturnedToPool();
 };
\ No newline at end of file
@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WeaponPoolSubsystem.h"
+
+#include "WeaponBase.h"
+#include "VictorStats.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Weapon pool hits"), STAT_VictorWeaponPoolHits, STATGROUP_Victor);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Weapon pool misses"), STAT_VictorWeaponPoolMisses, STATGROUP_Victor);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled free weapons"), STAT_VictorWeaponPoolFree, STATGROUP_Victor);
+
+AWeaponBase* UWeaponPoolSubsystem::AcquireWeapon(TSubclassOf<AWeaponBase> WeaponClass)
+{
+	if (WeaponClass == nullptr)
+	{
+		return nullptr;
+	}
+
+	AWeaponBase* Weapon = nullptr;
+	if (FWeaponPoolBucket* Bucket = Buckets.Find(WeaponClass))
+	{
+		//instances may have been destroyed behind our back (level streaming, editor)
+		while (Weapon == nullptr && Bucket->FreeWeapons.Num() > 0)
+		{
+			Weapon = Bucket->FreeWeapons.Pop(false);
+			DEC_DWORD_STAT(STAT_VictorWeaponPoolFree);
+			if (Weapon != nullptr && Weapon->IsPendingKillPending())
+			{
+				Weapon = nullptr;
+			}
+		}
+	}
+
+	if (Weapon != nullptr)
+	{
+		PoolHits++;
+		INC_DWORD_STAT(STAT_VictorWeaponPoolHits);
+	}
+	else
+	{
+		Weapon = SpawnPooledWeapon(WeaponClass);
+		if (Weapon == nullptr)
+		{
+			return nullptr;
+		}
+		PoolMisses++;
+		INC_DWORD_STAT(STAT_VictorWeaponPoolMisses);
+	}
+
+	Weapon->OnAcquiredFromPool();
+	return Weapon;
+}
+
+void UWeaponPoolSubsystem::ReleaseWeapon(AWeaponBase* Weapon)
+{
+	if (Weapon == nullptr || Weapon->IsPendingKillPending() || Weapon->bIsInPool)
+	{
+		return;
+	}
+
+	Weapon->OnReturnedToPool();
+	Buckets.FindOrAdd(Weapon->GetClass()).FreeWeapons.Add(Weapon);
+	INC_DWORD_STAT(STAT_VictorWeaponPoolFree);
+}
+
+bool UWeaponPoolSubsystem::ReclaimWeapon(AWeaponBase* Weapon, AActor* NewOwner)
+{
+	if (Weapon == nullptr || Weapon->IsPendingKillPending())
+	{
+		return false;
+	}
+	if (!Weapon->bIsInPool)
+	{
+		//handed out again since, only its current owner keeps it
+		return Weapon->WeaponOwner == nullptr || Weapon->WeaponOwner == NewOwner;
+	}
+
+	if (FWeaponPoolBucket* Bucket = Buckets.Find(Weapon->GetClass()))
+	{
+		if (Bucket->FreeWeapons.RemoveSingleSwap(Weapon, false) > 0)
+		{
+			DEC_DWORD_STAT(STAT_VictorWeaponPoolFree);
+		}
+	}
+	Weapon->OnAcquiredFromPool();
+	return true;
+}
+
+void UWeaponPoolSubsystem::PrewarmWeapons(TSubclassOf<AWeaponBase> WeaponClass, int32 Count)
+{
+	if (WeaponClass == nullptr)
+	{
+		return;
+	}
+
+	FWeaponPoolBucket& Bucket = Buckets.FindOrAdd(WeaponClass);
+	while (Bucket.FreeWeapons.Num() < Count)
+	{
+		AWeaponBase* Weapon = SpawnPooledWeapon(WeaponClass);
+		if (Weapon == nullptr)
+		{
+			break;
+		}
+		Weapon->OnReturnedToPool();
+		Bucket.FreeWeapons.Add(Weapon);
+		INC_DWORD_STAT(STAT_VictorWeaponPoolFree);
+	}
+}
+
+int32 UWeaponPoolSubsystem::GetNumFreeWeapons(TSubclassOf<AWeaponBase> WeaponClass) const
+{
+	const FWeaponPoolBucket* Bucket = Buckets.Find(WeaponClass);
+	return Bucket != nullptr ? Bucket->FreeWeapons.Num() : 0;
+}
+
+void UWeaponPoolSubsystem::ResetPoolCounters()
+{
+	PoolHits = 0;
+	PoolMisses = 0;
+}
+
+AWeaponBase* UWeaponPoolSubsystem::SpawnPooledWeapon(UClass* WeaponClass)
+{
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return GetWorld()->SpawnActor<AWeaponBase>(WeaponClass, FTransform::Identity, SpawnParameters);
+}
@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WeaponPoolSubsystem.generated.h"
+
+class AWeaponBase;
+
+USTRUCT()
+struct FWeaponPoolBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	TArray<AWeaponBase*> FreeWeapons;
+};
+
+/**
+ * Keeps spawned weapons around instead of destroying them so possession swaps, deaths and reloads
+ * don't spawn new weapon actors. Weapons are pooled per class.
+ */
+UCLASS()
+class VICTOR_API UWeaponPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Returns a ready to use weapon of the given class, spawning one only if the pool for that class is empty */
+	UFUNCTION(BlueprintCallable, Category=WeaponPool)
+	AWeaponBase* AcquireWeapon(TSubclassOf<AWeaponBase> WeaponClass);
+
+	/** Resets the weapon and puts it back into the pool */
+	UFUNCTION(BlueprintCallable, Category=WeaponPool)
+	void ReleaseWeapon(AWeaponBase* Weapon);
+
+	/**
+	 * Takes a weapon that is still in the pool back out of it for NewOwner, e.g. one a loaded checkpoint gave a character again.
+	 * False if another actor holds the weapon by now, NewOwner must not take it then.
+	 */
+	bool ReclaimWeapon(AWeaponBase* Weapon, AActor* NewOwner);
+
+	/** Spawns weapons until the pool for the class holds at least Count free instances */
+	UFUNCTION(BlueprintCallable, Category=WeaponPool)
+	void PrewarmWeapons(TSubclassOf<AWeaponBase> WeaponClass, int32 Count);
+
+	/** How many AcquireWeapon calls were served from the pool */
+	UFUNCTION(BlueprintPure, Category=WeaponPool)
+	int32 GetPoolHits() const { return PoolHits; }
+
+	/** How many AcquireWeapon calls had to spawn a new actor */
+	UFUNCTION(BlueprintPure, Category=WeaponPool)
+	int32 GetPoolMisses() const { return PoolMisses; }
+
+	UFUNCTION(BlueprintPure, Category=WeaponPool)
+	int32 GetNumFreeWeapons(TSubclassOf<AWeaponBase> WeaponClass) const;
+
+	UFUNCTION(BlueprintCallable, Category=WeaponPool)
+	void ResetPoolCounters();
+
+protected:
+	AWeaponBase* SpawnPooledWeapon(UClass* WeaponClass);
+
+	UPROPERTY(Transient)
+	TMap<UClass*, FWeaponPoolBucket> Buckets;
+
+	int32 PoolHits = 0;
+
+	int32 PoolMisses = 0;
+};
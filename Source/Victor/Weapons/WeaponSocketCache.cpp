@@ -0,0 +1,154 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WeaponSocketCache.h"
+
+#include "PaperFlipbook.h"
+#include "PaperFlipbookComponent.h"
+#include "PaperSprite.h"
+#include "Engine/World.h"
+#include "UObject/UObjectGlobals.h"
+
+static const int32 NumSocketSlots = static_cast<int32>(EWeaponSocketSlot::Num);
+
+FWeaponSocketCache& FWeaponSocketCache::Get()
+{
+	static FWeaponSocketCache Instance;
+	return Instance;
+}
+
+FWeaponSocketCache::FWeaponSocketCache()
+{
+	//the cache outlives every world, so the delegates are never removed
+	FWorldDelegates::OnWorldCleanup.AddRaw(this, &FWeaponSocketCache::OnWorldCleanup);
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectPropertyChanged.AddRaw(this, &FWeaponSocketCache::OnObjectPropertyChanged);
+#endif
+}
+
+FName FWeaponSocketCache::GetSocketName(EWeaponSocketSlot Slot)
+{
+	static const FName SocketNames[] = { TEXT("WeaponHolding"), TEXT("PistolHolding") };
+	static_assert(UE_ARRAY_COUNT(SocketNames) == static_cast<int32>(EWeaponSocketSlot::Num), "Every socket slot needs a name");
+	return SocketNames[static_cast<int32>(Slot)];
+}
+
+EWeaponSocketSlot FWeaponSocketCache::GetSocketSlot(EWeaponAnimType AnimType)
+{
+	switch (AnimType)
+	{
+	case EWeaponAnimType::EWT_Pistol:
+		return EWeaponSocketSlot::PistolHolding;
+	case EWeaponAnimType::EWT_MeleeKnife:
+		return EWeaponSocketSlot::WeaponHolding;
+	default:
+		return EWeaponSocketSlot::WeaponHolding;
+	}
+}
+
+void FWeaponSocketCache::BakeFlipbook(UPaperFlipbook* Flipbook)
+{
+	FindOrBake(Flipbook);
+}
+
+bool FWeaponSocketCache::GetLocalSocketTransform(UPaperFlipbook* Flipbook, int32 KeyFrameIndex, EWeaponSocketSlot Slot, FTransform& OutTransform)
+{
+	const FBakedFlipbook* Baked = FindOrBake(Flipbook);
+	if (Baked == nullptr || KeyFrameIndex < 0 || KeyFrameIndex >= Baked->NumKeyFrames)
+	{
+		return false;
+	}
+
+	const int32 Index = KeyFrameIndex * NumSocketSlots + static_cast<int32>(Slot);
+	if (!Baked->bHasSocket[Index])
+	{
+		return false;
+	}
+	OutTransform = Baked->Transforms[Index];
+	return true;
+}
+
+FTransform FWeaponSocketCache::GetSocketTransform(UPaperFlipbookComponent* Component, EWeaponSocketSlot Slot)
+{
+	UPaperFlipbook* Flipbook = Component->GetFlipbook();
+	if (Flipbook != nullptr)
+	{
+		FTransform LocalTransform;
+		if (GetLocalSocketTransform(Flipbook, Flipbook->GetKeyFrameIndexAtTime(Component->GetPlaybackPosition()), Slot, LocalTransform))
+		{
+			return LocalTransform * Component->GetComponentTransform();
+		}
+	}
+	return Component->GetComponentTransform();
+}
+
+void FWeaponSocketCache::Reset()
+{
+	BakedFlipbooks.Reset();
+}
+
+void FWeaponSocketCache::PurgeStale()
+{
+	for (auto It = BakedFlipbooks.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FWeaponSocketCache::OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources)
+{
+	//the level's flipbooks may be unloaded after this, the next GC leaves their entries stale
+	PurgeStale();
+}
+
+#if WITH_EDITOR
+void FWeaponSocketCache::OnObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& Event)
+{
+	if (UPaperFlipbook* Flipbook = Cast<UPaperFlipbook>(Object))
+	{
+		BakedFlipbooks.Remove(Flipbook);
+	}
+	else if (Object->IsA<UPaperSprite>())
+	{
+		//sprites don't know which flipbooks show them
+		Reset();
+	}
+}
+#endif
+
+const FWeaponSocketCache::FBakedFlipbook* FWeaponSocketCache::FindOrBake(UPaperFlipbook* Flipbook)
+{
+	if (Flipbook == nullptr)
+	{
+		return nullptr;
+	}
+
+	const int32 NumKeyFrames = Flipbook->GetNumKeyFrames();
+	if (!BakedFlipbooks.Contains(Flipbook))
+	{
+		//new flipbooks are rare, a good time to drop the ones that were unloaded
+		PurgeStale();
+	}
+	FBakedFlipbook& Baked = BakedFlipbooks.FindOrAdd(Flipbook);
+	//a key frame count mismatch means the flipbook was edited since it was baked
+	if (Baked.NumKeyFrames == NumKeyFrames && Baked.Transforms.Num() == NumKeyFrames * NumSocketSlots)
+	{
+		return &Baked;
+	}
+
+	Baked.NumKeyFrames = NumKeyFrames;
+	Baked.Transforms.SetNum(NumKeyFrames * NumSocketSlots);
+	Baked.bHasSocket.Init(false, NumKeyFrames * NumSocketSlots);
+	for (int32 KeyFrame = 0; KeyFrame < NumKeyFrames; KeyFrame++)
+	{
+		for (int32 Slot = 0; Slot < NumSocketSlots; Slot++)
+		{
+			const int32 Index = KeyFrame * NumSocketSlots + Slot;
+			Baked.bHasSocket[Index] = Flipbook->FindSocket(GetSocketName(static_cast<EWeaponSocketSlot>(Slot)), KeyFrame, Baked.Transforms[Index]);
+		}
+	}
+	return &Baked;
+}
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WeaponAnimTypes.h"
+
+class UPaperFlipbook;
+class UPaperFlipbookComponent;
+class UWorld;
+struct FPropertyChangedEvent;
+
+//Weapon sockets that are baked for every flipbook key frame
+enum class EWeaponSocketSlot : uint8
+{
+	WeaponHolding,
+	PistolHolding,
+	Num
+};
+
+/**
+ * Baked local socket transforms for every (flipbook, key frame, weapon socket).
+ * Replaces the socket search UPaperFlipbookComponent::GetSocketLocation does on every call with an indexed lookup.
+ * Flipbooks are baked when characters begin play or on first lookup; game thread only.
+ * Entries of flipbooks that were unloaded are dropped when a world is cleaned up and whenever a new flipbook is baked.
+ * In the editor, changing a flipbook drops its entry and changing a sprite drops everything, so re-baked sockets are picked up.
+ */
+class VICTOR_API FWeaponSocketCache
+{
+public:
+	static FWeaponSocketCache& Get();
+
+	static FName GetSocketName(EWeaponSocketSlot Slot);
+
+	/** Socket the weapon of this anim type is attached to */
+	static EWeaponSocketSlot GetSocketSlot(EWeaponAnimType AnimType);
+
+	/** Bakes every key frame of the flipbook. Does nothing if the flipbook is already baked */
+	void BakeFlipbook(UPaperFlipbook* Flipbook);
+
+	/** Socket transform relative to the sprite, false if the key frame's sprite has no such socket */
+	bool GetLocalSocketTransform(UPaperFlipbook* Flipbook, int32 KeyFrameIndex, EWeaponSocketSlot Slot, FTransform& OutTransform);
+
+	/**
+	 * World transform of the socket for the frame the component is showing.
+	 * Matches UPaperFlipbookComponent::GetSocketTransform, including falling back to the component transform.
+	 */
+	FTransform GetSocketTransform(UPaperFlipbookComponent* Component, EWeaponSocketSlot Slot);
+
+	/** Drops all baked data, e.g. after flipbooks were edited */
+	void Reset();
+
+	/** Drops the entries of flipbooks that no longer exist */
+	void PurgeStale();
+
+	int32 Num() const { return BakedFlipbooks.Num(); }
+
+private:
+	FWeaponSocketCache();
+
+	void OnWorldCleanup(UWorld* World, bool bSessionEnded, bool bCleanupResources);
+
+#if WITH_EDITOR
+	void OnObjectPropertyChanged(UObject* Object, FPropertyChangedEvent& Event);
+#endif
+
+	struct FBakedFlipbook
+	{
+		int32 NumKeyFrames = 0;
+
+		//NumKeyFrames * EWeaponSocketSlot::Num entries
+		TArray<FTransform> Transforms;
+
+		TBitArray<> bHasSocket;
+	};
+
+	const FBakedFlipbook* FindOrBake(UPaperFlipbook* Flipbook);
+
+	TMap<TWeakObjectPtr<UPaperFlipbook>, FBakedFlipbook> BakedFlipbooks;
+};
@@ -0,0 +1,257 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ChunkStreamingSubsystem.h"
+
+#include "VictorCharacter.h"
+#include "VictorStats.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/LevelStreaming.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Characters/CharacterUpdateSubsystem.h"
+#include "World/LevelGridSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Chunk streaming"), STAT_VictorChunkStreaming, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Loaded chunks"), STAT_VictorLoadedChunks, STATGROUP_Victor);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Chunk streaming stalls"), STAT_VictorChunkStalls, STATGROUP_Victor);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Chunk grid update (ms)"), STAT_VictorChunkGridUpdate, STATGROUP_Victor);
+
+DEFINE_LOG_CATEGORY_STATIC(LogVictorChunkStreaming, Log, All);
+
+namespace
+{
+	bool RangesOverlap(float MinA, float MaxA, float MinB, float MaxB)
+	{
+		return MinA < MaxB && MinB < MaxA;
+	}
+
+	/** N of a package named ..._Chunk<N> */
+	bool ParseChunkIndex(const FString& PackageName, int32& OutIndex)
+	{
+		static const FString Marker = TEXT("_Chunk");
+		const int32 MarkerStart = PackageName.Find(Marker, ESearchCase::IgnoreCase, ESearchDir::FromEnd);
+		if (MarkerStart == INDEX_NONE)
+		{
+			return false;
+		}
+		const FString Number = PackageName.Mid(MarkerStart + Marker.Len());
+		if (Number.IsEmpty() || !Number.IsNumeric())
+		{
+			return false;
+		}
+		OutIndex = FCString::Atoi(*Number);
+		return true;
+	}
+}
+
+void UChunkStreamingSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	Collection.InitializeDependency(UCharacterUpdateSubsystem::StaticClass());
+	Collection.InitializeDependency(ULevelGridSubsystem::StaticClass());
+}
+
+void UChunkStreamingSubsystem::Deinitialize()
+{
+	Chunks.Empty();
+	NumGatheredStreamingLevels = INDEX_NONE;
+
+	Super::Deinitialize();
+}
+
+void UChunkStreamingSubsystem::SetViewOverride(const FVector2D& Center, float OrthoWidth)
+{
+	ViewOverrideCenter = Center;
+	ViewOverrideOrthoWidth = OrthoWidth;
+	bHasViewOverride = true;
+}
+
+FBox2D UChunkStreamingSubsystem::GetChunkBounds() const
+{
+	FBox2D Bounds(ForceInit);
+	for (const FChunk& Chunk : Chunks)
+	{
+		Bounds += FVector2D(Chunk.MinX, 0.f);
+		Bounds += FVector2D(Chunk.MaxX, 0.f);
+	}
+	return Bounds;
+}
+
+void UChunkStreamingSubsystem::GatherChunks()
+{
+	const TArray<ULevelStreaming*>& StreamingLevels = GetWorld()->GetStreamingLevels();
+	if (StreamingLevels.Num() == NumGatheredStreamingLevels)
+	{
+		return;
+	}
+	NumGatheredStreamingLevels = StreamingLevels.Num();
+
+	TArray<FChunk> PreviousChunks = MoveTemp(Chunks);
+	Chunks.Reset();
+	for (ULevelStreaming* StreamingLevel : StreamingLevels)
+	{
+		int32 Index = 0;
+		if (StreamingLevel == nullptr || !ParseChunkIndex(StreamingLevel->GetWorldAssetPackageName(), Index))
+		{
+			continue;
+		}
+		const FChunk* Previous = PreviousChunks.FindByPredicate([StreamingLevel](const FChunk& Chunk) { return Chunk.Level == StreamingLevel; });
+		const float MinX = ChunkOriginX + Index * ChunkWidth;
+		Chunks.Add({ StreamingLevel, MinX, MinX + ChunkWidth, Previous != nullptr ? Previous->RequestTime : 0.0 });
+	}
+	Chunks.Sort([](const FChunk& A, const FChunk& B) { return A.MinX < B.MinX; });
+	Stats.NumChunks = Chunks.Num();
+}
+
+bool UChunkStreamingSubsystem::GetView(FVector2D& OutCenter, float& OutOrthoWidth) const
+{
+	if (bHasViewOverride)
+	{
+		OutCenter = ViewOverrideCenter;
+		OutOrthoWidth = ViewOverrideOrthoWidth;
+		return true;
+	}
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (PlayerController == nullptr || PlayerController->PlayerCameraManager == nullptr)
+	{
+		return false;
+	}
+	const FMinimalViewInfo& View = PlayerController->PlayerCameraManager->GetCameraCachePOV();
+	OutCenter = FVector2D(View.Location.X, View.Location.Z);
+	OutOrthoWidth = View.ProjectionMode == ECameraProjectionMode::Orthographic ? View.OrthoWidth : DefaultOrthoWidth;
+	return true;
+}
+
+void UChunkStreamingSubsystem::GatherPinnedLocations(TArray<float>& OutLocations) const
+{
+	const UCharacterUpdateSubsystem* Characters = GetWorld()->GetSubsystem<UCharacterUpdateSubsystem>();
+	for (const AVictorCharacter* Character : Characters->GetCharacters())
+	{
+		if (Character->bControlledByPlayer || Character->IsPlayerControlled())
+		{
+			OutLocations.Add(Character->GetActorLocation().X);
+			if (Character->OriginalBody != nullptr)
+			{
+				OutLocations.Add(Character->OriginalBody->GetActorLocation().X);
+			}
+		}
+	}
+}
+
+void UChunkStreamingSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorChunkStreaming);
+
+	GatherChunks();
+	FVector2D ViewCenter;
+	float OrthoWidth = DefaultOrthoWidth;
+	if (Chunks.Num() == 0 || !GetView(ViewCenter, OrthoWidth))
+	{
+		return;
+	}
+
+	if (bHasLastView && DeltaTime > 0.f)
+	{
+		const float ViewVelocityX = (ViewCenter.X - LastViewX) / DeltaTime;
+		SmoothedViewVelocityX = FMath::Lerp(SmoothedViewVelocityX, ViewVelocityX, FMath::Min(DeltaTime * 4.f, 1.f));
+	}
+	LastViewX = ViewCenter.X;
+	bHasLastView = true;
+
+	//the view, the range to have loaded around it and the range to keep
+	const float HalfWidth = OrthoWidth * 0.5f;
+	const float ViewMinX = ViewCenter.X - HalfWidth;
+	const float ViewMaxX = ViewCenter.X + HalfWidth;
+	const int32 Direction = SmoothedViewVelocityX > 50.f ? 1 : SmoothedViewVelocityX < -50.f ? -1 : 0;
+	const float LoadMinX = ViewMinX - (Direction < 0 ? PreloadAhead : Direction > 0 ? KeepBehind : PreloadAhead * 0.5f);
+	const float LoadMaxX = ViewMaxX + (Direction > 0 ? PreloadAhead : Direction < 0 ? KeepBehind : PreloadAhead * 0.5f);
+
+	TArray<float, TInlineAllocator<8>> PinnedLocations;
+	GatherPinnedLocations(PinnedLocations);
+
+	const double Now = FPlatformTime::Seconds();
+	bool bStalledNow = false;
+	int32 NumLoaded = 0;
+	for (FChunk& Chunk : Chunks)
+	{
+		ULevelStreaming* Level = Chunk.Level.Get();
+		if (Level == nullptr)
+		{
+			continue;
+		}
+
+		const bool bPinned = PinnedLocations.ContainsByPredicate([&Chunk](float X) { return X >= Chunk.MinX && X < Chunk.MaxX; });
+		const bool bWanted = bPinned || RangesOverlap(Chunk.MinX, Chunk.MaxX, LoadMinX, LoadMaxX);
+		const bool bKept = bPinned || RangesOverlap(Chunk.MinX, Chunk.MaxX, LoadMinX - UnloadHysteresis, LoadMaxX + UnloadHysteresis);
+		if (bWanted && !Level->ShouldBeLoaded())
+		{
+			Level->SetShouldBeLoaded(true);
+			Level->SetShouldBeVisible(true);
+			Chunk.RequestTime = Now;
+			Stats.NumRequests++;
+		}
+		else if (!bKept && Level->ShouldBeLoaded())
+		{
+			Level->SetShouldBeVisible(false);
+			Level->SetShouldBeLoaded(false);
+			Chunk.RequestTime = 0.0;
+		}
+
+		const bool bVisible = Level->IsLevelVisible();
+		if (bVisible && Chunk.RequestTime > 0.0)
+		{
+			Stats.MaxLoadSeconds = FMath::Max(Stats.MaxLoadSeconds, Now - Chunk.RequestTime);
+			Chunk.RequestTime = 0.0;
+		}
+		if (!bVisible && RangesOverlap(Chunk.MinX, Chunk.MaxX, ViewMinX, ViewMaxX))
+		{
+			if (!bStalled && !bStalledNow)
+			{
+				UE_LOG(LogVictorChunkStreaming, Warning, TEXT("Stall: %s is in view but not visible yet"), *Level->GetWorldAssetPackageName());
+			}
+			bStalledNow = true;
+		}
+		NumLoaded += Level->IsLevelLoaded() ? 1 : 0;
+	}
+
+	if (bStalledNow)
+	{
+		Stats.NumStalls += bStalled ? 0 : 1;
+		Stats.StallFrames++;
+		Stats.StallSeconds += DeltaTime;
+	}
+	bStalled = bStalledNow;
+	Stats.NumLoadedChunks = NumLoaded;
+
+	//patch the grid for the chunks shown or hidden now rather than in whichever system asks for it next
+	ULevelGridSubsystem* LevelGrid = GetWorld()->GetSubsystem<ULevelGridSubsystem>();
+	if (LevelGrid != nullptr && LevelGrid->HasPendingLevelChanges())
+	{
+		const double GridStartTime = FPlatformTime::Seconds();
+		LevelGrid->GetCollisionGrid();
+		const double GridSeconds = FPlatformTime::Seconds() - GridStartTime;
+		Stats.NumGridUpdates++;
+		Stats.GridUpdateSeconds += GridSeconds;
+		Stats.MaxGridUpdateSeconds = FMath::Max(Stats.MaxGridUpdateSeconds, GridSeconds);
+		SET_FLOAT_STAT(STAT_VictorChunkGridUpdate, GridSeconds * 1000.0);
+	}
+
+	SET_DWORD_STAT(STAT_VictorLoadedChunks, NumLoaded);
+	SET_DWORD_STAT(STAT_VictorChunkStalls, Stats.NumStalls);
+}
+
+bool UChunkStreamingSubsystem::IsTickable() const
+{
+	return GetWorld()->GetStreamingLevels().Num() > 0;
+}
+
+TStatId UChunkStreamingSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UChunkStreamingSubsystem, STATGROUP_Tickables);
+}
+
+ETickableTickType UChunkStreamingSubsystem::GetTickableTickType() const
+{
+	return IsTemplate() ? ETickableTickType::Never : ETickableTickType::Conditional;
+}
@@ -0,0 +1,138 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "ChunkStreamingSubsystem.generated.h"
+
+class ULevelStreaming;
+
+/** What UChunkStreamingSubsystem did since the world started */
+struct FChunkStreamingStats
+{
+	int32 NumChunks = 0;
+
+	int32 NumLoadedChunks = 0;
+
+	//chunks asked to load, including ones loaded again after being dropped
+	int32 NumRequests = 0;
+
+	//times a chunk inside the view wasn't visible yet, and the frames and seconds spent that way
+	int32 NumStalls = 0;
+
+	int32 StallFrames = 0;
+
+	double StallSeconds = 0.0;
+
+	//longest time from a load request to the chunk being visible
+	double MaxLoadSeconds = 0.0;
+
+	//collision grid updates for chunks shown or hidden, the time they took and the longest one
+	int32 NumGridUpdates = 0;
+
+	double GridUpdateSeconds = 0.0;
+
+	double MaxGridUpdateSeconds = 0.0;
+};
+
+/**
+ * Streams the level in chunks along X, following the side view camera.
+ * A chunk is a streaming sublevel named <anything>_Chunk<N>, set to the Blueprint streaming method so it starts unloaded;
+ * it covers ChunkWidth units starting at ChunkOriginX + N * ChunkWidth.
+ * Chunks within one view plus PreloadAhead in the direction the camera travels are loaded and shown asynchronously,
+ * chunks further than UnloadHysteresis past that are dropped. Chunks holding a player controlled body or the player's
+ * original body are never dropped. Other streaming levels are left alone.
+ * A chunk that should be on screen but isn't visible yet counts as a stall, and is logged.
+ * The level collision grid is updated for shown and hidden chunks in the same frame, and that time is counted too.
+ */
+UCLASS(config=Game)
+class VICTOR_API UChunkStreamingSubsystem : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/** Streams around this view instead of the first local player's camera, e.g. for benchmarks */
+	void SetViewOverride(const FVector2D& Center, float OrthoWidth);
+
+	void ClearViewOverride() { bHasViewOverride = false; }
+
+	const FChunkStreamingStats& GetStats() const { return Stats; }
+
+	/** Smallest and largest X covered by chunks, or an invalid box without chunks */
+	FBox2D GetChunkBounds() const;
+
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	float ChunkWidth = 4096.f;
+
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	float ChunkOriginX = 0.f;
+
+	/** Loaded past the edge of the view on the side the camera moves to */
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	float PreloadAhead = 2048.f;
+
+	/** Kept past the edge of the view on the side the camera moves away from */
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	float KeepBehind = 512.f;
+
+	/** How much further than the load range a chunk must be to be dropped, so turning around doesn't reload it */
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	float UnloadHysteresis = 1024.f;
+
+	/** Used when the camera isn't orthographic */
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	float DefaultOrthoWidth = 2048.f;
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+	virtual ETickableTickType GetTickableTickType() const override;
+	// End of FTickableGameObject interface
+
+protected:
+	struct FChunk
+	{
+		TWeakObjectPtr<ULevelStreaming> Level;
+		float MinX;
+		float MaxX;
+		//when the pending load was requested, 0 if none is pending
+		double RequestTime;
+	};
+
+	/** Finds the chunks among the world's streaming levels, again whenever their number changes */
+	void GatherChunks();
+
+	bool GetView(FVector2D& OutCenter, float& OutOrthoWidth) const;
+
+	/** X of every body a player controls or will return to */
+	void GatherPinnedLocations(TArray<float>& OutLocations) const;
+
+	TArray<FChunk> Chunks;
+
+	int32 NumGatheredStreamingLevels = INDEX_NONE;
+
+	FChunkStreamingStats Stats;
+
+	FVector2D ViewOverrideCenter = FVector2D::ZeroVector;
+
+	float ViewOverrideOrthoWidth = 0.f;
+
+	bool bHasViewOverride = false;
+
+	float LastViewX = 0.f;
+
+	bool bHasLastView = false;
+
+	//camera speed along X, smoothed so a short turn keeps what was preloaded
+	float SmoothedViewVelocityX = 0.f;
+
+	bool bStalled = false;
+};
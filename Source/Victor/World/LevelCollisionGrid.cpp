@@ -0,0 +1,418 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LevelCollisionGrid.h"
+
+#include "EngineUtils.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/Level.h"
+#include "GameFramework/Pawn.h"
+#include "PhysicsEngine/BodySetup.h"
+
+//World boxes of each collision element; a component without a body setup contributes its bounds
+static void GatherCollisionBoxes(UPrimitiveComponent* Component, TArray<FBox>& OutBoxes)
+{
+	const FTransform ComponentTransform = Component->GetComponentTransform();
+	const UBodySetup* BodySetup = Component->GetBodySetup();
+	if (BodySetup == nullptr || BodySetup->AggGeom.GetElementCount() == 0)
+	{
+		OutBoxes.Add(Component->Bounds.GetBox());
+		return;
+	}
+
+	const FKAggregateGeom& AggGeom = BodySetup->AggGeom;
+	for (const FKBoxElem& Elem : AggGeom.BoxElems)
+	{
+		const FVector Extent(Elem.X * 0.5f, Elem.Y * 0.5f, Elem.Z * 0.5f);
+		OutBoxes.Add(FBox(-Extent, Extent).TransformBy(Elem.GetTransform() * ComponentTransform));
+	}
+	for (const FKConvexElem& Elem : AggGeom.ConvexElems)
+	{
+		OutBoxes.Add(Elem.ElemBox.TransformBy(Elem.GetTransform() * ComponentTransform));
+	}
+	for (const FKSphereElem& Elem : AggGeom.SphereElems)
+	{
+		const FVector Extent(Elem.Radius);
+		OutBoxes.Add(FBox(Elem.Center - Extent, Elem.Center + Extent).TransformBy(ComponentTransform));
+	}
+	for (const FKSphylElem& Elem : AggGeom.SphylElems)
+	{
+		const FVector Extent(Elem.Radius, Elem.Radius, Elem.Length * 0.5f + Elem.Radius);
+		OutBoxes.Add(FBox(-Extent, Extent).TransformBy(Elem.GetTransform() * ComponentTransform));
+	}
+}
+
+//Cell bounds are kept as 0-255 fractions of the cell, rounded outwards
+static uint32 PackCellBounds(int32 MinX, int32 MinZ, int32 MaxX, int32 MaxZ)
+{
+	return uint32(MinX) | uint32(MinZ) << 8 | uint32(MaxX) << 16 | uint32(MaxZ) << 24;
+}
+
+static FBox2D UnpackCellBounds(uint32 Bounds, const FVector2D& CellMin, float CellSize)
+{
+	const float Scale = CellSize / 255.f;
+	return FBox2D(
+		CellMin + FVector2D((Bounds & 0xff) * Scale, (Bounds >> 8 & 0xff) * Scale),
+		CellMin + FVector2D((Bounds >> 16 & 0xff) * Scale, (Bounds >> 24) * Scale));
+}
+
+static void GatherActorBoxes(AActor* Actor, ECollisionChannel Channel, TArray<FBox2D>& OutBoxes)
+{
+	//characters and other pawns move, they are not level geometry
+	if (Actor == nullptr || Actor->IsA<APawn>())
+	{
+		return;
+	}
+	TArray<FBox> Boxes;
+	for (UActorComponent* ActorComponent : Actor->GetComponents())
+	{
+		UPrimitiveComponent* Component = Cast<UPrimitiveComponent>(ActorComponent);
+		if (Component != nullptr
+			&& Component->Mobility != EComponentMobility::Movable
+			&& Component->IsCollisionEnabled()
+			&& Component->GetCollisionResponseToChannel(Channel) == ECR_Block)
+		{
+			GatherCollisionBoxes(Component, Boxes);
+		}
+	}
+	for (const FBox& Box : Boxes)
+	{
+		OutBoxes.Add(FBox2D(FVector2D(Box.Min.X, Box.Min.Z), FVector2D(Box.Max.X, Box.Max.Z)));
+	}
+}
+
+void FLevelCollisionGrid::Build(UWorld* World, float InCellSize, ECollisionChannel Channel)
+{
+	TArray<FBox2D> Boxes;
+	for (TActorIterator<AActor> It(World); It; ++It)
+	{
+		GatherActorBoxes(*It, Channel, Boxes);
+	}
+	Build(Boxes, InCellSize);
+}
+
+void FLevelCollisionGrid::GatherLevelBoxes(const ULevel* Level, TArray<FBox2D>& OutBoxes, ECollisionChannel Channel)
+{
+	for (AActor* Actor : Level->Actors)
+	{
+		GatherActorBoxes(Actor, Channel, OutBoxes);
+	}
+}
+
+void FLevelCollisionGrid::GatherComponentBoxes(UPrimitiveComponent* Component, TArray<FBox2D>& OutBoxes)
+{
+	TArray<FBox> Boxes;
+	GatherCollisionBoxes(Component, Boxes);
+	for (const FBox& Box : Boxes)
+	{
+		OutBoxes.Add(FBox2D(FVector2D(Box.Min.X, Box.Min.Z), FVector2D(Box.Max.X, Box.Max.Z)));
+	}
+}
+
+uint32 FLevelCollisionGrid::HashBoxes(const TArray<FBox2D>& Boxes)
+{
+	uint32 Hash = 0;
+	for (const FBox2D& Box : Boxes)
+	{
+		//not the whole FBox2D, its padding is not initialized
+		Hash = FCrc::MemCrc32(&Box.Min, sizeof(FVector2D), Hash);
+		Hash = FCrc::MemCrc32(&Box.Max, sizeof(FVector2D), Hash);
+	}
+	return Hash;
+}
+
+void FLevelCollisionGrid::Build(const TArray<FBox2D>& Boxes, float InCellSize)
+{
+	Reset();
+	if (Boxes.Num() == 0)
+	{
+		return;
+	}
+
+	FBox2D LevelBounds(ForceInit);
+	for (const FBox2D& Box : Boxes)
+	{
+		LevelBounds += Box;
+	}
+	//one empty cell of padding around the level
+	LevelBounds = LevelBounds.ExpandBy(InCellSize);
+	const FVector2D LevelSize = LevelBounds.GetSize();
+	Init(LevelBounds.Min, InCellSize, FMath::CeilToInt(LevelSize.X / InCellSize), FMath::CeilToInt(LevelSize.Y / InCellSize));
+
+	for (const FBox2D& Box : Boxes)
+	{
+		FillBox(Box);
+	}
+}
+
+bool FLevelCollisionGrid::Covers(const FBox2D& Box) const
+{
+	const FIntPoint MinCell = ToCell(Box.Min);
+	const FIntPoint MaxCell = ToCellExclusiveMax(Box.Max);
+	return IsBuilt() && MinCell.X >= 0 && MinCell.Y >= 0 && MaxCell.X < SizeX && MaxCell.Y < SizeZ;
+}
+
+void FLevelCollisionGrid::GrowToCover(const FBox2D& Box)
+{
+	if (!IsBuilt() || Covers(Box))
+	{
+		return;
+	}
+
+	//whole cells are added on each side, so the cells already there keep their bounds
+	const FIntPoint MinCell = ToCell(Box.Min);
+	const FIntPoint MaxCell = ToCellExclusiveMax(Box.Max);
+	const int32 AddMinX = FMath::Max(-MinCell.X, 0);
+	const int32 AddMinZ = FMath::Max(-MinCell.Y, 0);
+	const int32 NewSizeX = AddMinX + FMath::Max(MaxCell.X + 1, SizeX);
+	const int32 NewSizeZ = AddMinZ + FMath::Max(MaxCell.Y + 1, SizeZ);
+
+	TBitArray<> NewSolid(false, NewSizeX * NewSizeZ);
+	TArray<uint32> NewSolidBounds;
+	NewSolidBounds.SetNumZeroed(NewSizeX * NewSizeZ);
+	for (int32 Z = 0; Z < SizeZ; Z++)
+	{
+		for (int32 X = 0; X < SizeX; X++)
+		{
+			if (Solid[Z * SizeX + X])
+			{
+				const int32 NewIndex = (Z + AddMinZ) * NewSizeX + X + AddMinX;
+				NewSolid[NewIndex] = true;
+				NewSolidBounds[NewIndex] = SolidBounds[Z * SizeX + X];
+			}
+		}
+	}
+	Origin -= FVector2D(AddMinX * CellSize, AddMinZ * CellSize);
+	SizeX = NewSizeX;
+	SizeZ = NewSizeZ;
+	Solid = MoveTemp(NewSolid);
+	SolidBounds = MoveTemp(NewSolidBounds);
+}
+
+void FLevelCollisionGrid::Init(const FVector2D& InOrigin, float InCellSize, int32 InSizeX, int32 InSizeZ)
+{
+	Origin = InOrigin;
+	CellSize = InCellSize;
+	SizeX = InSizeX;
+	SizeZ = InSizeZ;
+	Solid.Init(false, SizeX * SizeZ);
+	SolidBounds.Reset();
+	SolidBounds.SetNumZeroed(SizeX * SizeZ);
+}
+
+void FLevelCollisionGrid::FillBox(const FBox2D& Box)
+{
+	FillCells(Box, ToCell(Box.Min), ToCellExclusiveMax(Box.Max));
+}
+
+void FLevelCollisionGrid::FillBoxWithin(const FBox2D& Box, const FBox2D& Within)
+{
+	//whole cells of Within, they were cleared whole too
+	const FIntPoint MinCell = ToCell(Box.Min).ComponentMax(ToCell(Within.Min));
+	const FIntPoint MaxCell = ToCellExclusiveMax(Box.Max).ComponentMin(ToCellExclusiveMax(Within.Max));
+	FillCells(Box, MinCell, MaxCell);
+}
+
+void FLevelCollisionGrid::ClearBox(const FBox2D& Box)
+{
+	ClearCells(ToCell(Box.Min), ToCellExclusiveMax(Box.Max));
+}
+
+void FLevelCollisionGrid::FillCells(const FBox2D& Box, const FIntPoint& MinCell, const FIntPoint& MaxCell)
+{
+	for (int32 Z = FMath::Max(MinCell.Y, 0); Z <= FMath::Min(MaxCell.Y, SizeZ - 1); Z++)
+	{
+		for (int32 X = FMath::Max(MinCell.X, 0); X <= FMath::Min(MaxCell.X, SizeX - 1); X++)
+		{
+			const int32 Index = Z * SizeX + X;
+			const FVector2D CellMin = Origin + FVector2D(X * CellSize, Z * CellSize);
+			const FVector2D LocalMin = ((Box.Min - CellMin) / CellSize).ClampAxes(0.f, 1.f) * 255.f;
+			const FVector2D LocalMax = ((Box.Max - CellMin) / CellSize).ClampAxes(0.f, 1.f) * 255.f;
+			int32 MinX = FMath::FloorToInt(LocalMin.X);
+			int32 MinZ = FMath::FloorToInt(LocalMin.Y);
+			int32 MaxX = FMath::CeilToInt(LocalMax.X);
+			int32 MaxZ = FMath::CeilToInt(LocalMax.Y);
+			//other geometry already in the cell
+			if (Solid[Index])
+			{
+				const uint32 Bounds = SolidBounds[Index];
+				MinX = FMath::Min<int32>(MinX, Bounds & 0xff);
+				MinZ = FMath::Min<int32>(MinZ, Bounds >> 8 & 0xff);
+				MaxX = FMath::Max<int32>(MaxX, Bounds >> 16 & 0xff);
+				MaxZ = FMath::Max<int32>(MaxZ, Bounds >> 24);
+			}
+			Solid[Index] = true;
+			SolidBounds[Index] = PackCellBounds(MinX, MinZ, MaxX, MaxZ);
+		}
+	}
+}
+
+void FLevelCollisionGrid::ClearCells(const FIntPoint& MinCell, const FIntPoint& MaxCell)
+{
+	for (int32 Z = FMath::Max(MinCell.Y, 0); Z <= FMath::Min(MaxCell.Y, SizeZ - 1); Z++)
+	{
+		for (int32 X = FMath::Max(MinCell.X, 0); X <= FMath::Min(MaxCell.X, SizeX - 1); X++)
+		{
+			Solid[Z * SizeX + X] = false;
+			SolidBounds[Z * SizeX + X] = 0;
+		}
+	}
+}
+
+void FLevelCollisionGrid::Reset()
+{
+	Origin = FVector2D::ZeroVector;
+	SizeX = 0;
+	SizeZ = 0;
+	Solid.Empty();
+	SolidBounds.Empty();
+}
+
+bool FLevelCollisionGrid::IsBoxBlocked(const FBox2D& Box) const
+{
+	const FIntPoint MinCell = ToCell(Box.Min);
+	const FIntPoint MaxCell = ToCellExclusiveMax(Box.Max);
+	for (int32 Z = FMath::Max(MinCell.Y, 0); Z <= FMath::Min(MaxCell.Y, SizeZ - 1); Z++)
+	{
+		for (int32 X = FMath::Max(MinCell.X, 0); X <= FMath::Min(MaxCell.X, SizeX - 1); X++)
+		{
+			if (Solid[Z * SizeX + X])
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool FLevelCollisionGrid::IsBoxOverlappingSolid(const FBox2D& Box) const
+{
+	const FIntPoint MinCell = ToCell(Box.Min);
+	const FIntPoint MaxCell = ToCellExclusiveMax(Box.Max);
+	for (int32 Z = FMath::Max(MinCell.Y, 0); Z <= FMath::Min(MaxCell.Y, SizeZ - 1); Z++)
+	{
+		for (int32 X = FMath::Max(MinCell.X, 0); X <= FMath::Min(MaxCell.X, SizeX - 1); X++)
+		{
+			const int32 Index = Z * SizeX + X;
+			if (!Solid[Index])
+			{
+				continue;
+			}
+			const FBox2D Bounds = UnpackCellBounds(SolidBounds[Index], Origin + FVector2D(X * CellSize, Z * CellSize), CellSize);
+			if (Box.Min.X < Bounds.Max.X && Box.Max.X > Bounds.Min.X && Box.Min.Y < Bounds.Max.Y && Box.Max.Y > Bounds.Min.Y)
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+float FLevelCollisionGrid::SweepBox(const FBox2D& Box, int32 Axis, float Distance) const
+{
+	if (Distance == 0.f)
+	{
+		return 0.f;
+	}
+	const int32 Other = 1 - Axis;
+	const FIntPoint MinCell = ToCell(Box.Min);
+	const FIntPoint MaxCell = ToCellExclusiveMax(Box.Max);
+	const int32 MinOther = FMath::Max(Other == 0 ? MinCell.X : MinCell.Y, 0);
+	const int32 MaxOther = FMath::Min(Other == 0 ? MaxCell.X : MaxCell.Y, (Other == 0 ? SizeX : SizeZ) - 1);
+	const int32 AxisSize = Axis == 0 ? SizeX : SizeZ;
+
+	auto IsLineSolid = [&](int32 Line)
+	{
+		for (int32 Cell = MinOther; Cell <= MaxOther; Cell++)
+		{
+			if (Axis == 0 ? IsSolid(Line, Cell) : IsSolid(Cell, Line))
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+
+	//lines of cells the leading edge crosses, nearest first
+	if (Distance > 0.f)
+	{
+		const float Edge = Box.Max[Axis];
+		const FIntPoint EndCell = ToCellExclusiveMax(Box.Max + (Axis == 0 ? FVector2D(Distance, 0.f) : FVector2D(0.f, Distance)));
+		const int32 First = FMath::Max((Axis == 0 ? MaxCell.X : MaxCell.Y) + 1, 0);
+		const int32 Last = FMath::Min(Axis == 0 ? EndCell.X : EndCell.Y, AxisSize - 1);
+		for (int32 Line = First; Line <= Last; Line++)
+		{
+			if (IsLineSolid(Line))
+			{
+				return FMath::Min(Distance, Origin[Axis] + Line * CellSize - Edge);
+			}
+		}
+	}
+	else
+	{
+		const float Edge = Box.Min[Axis];
+		const FIntPoint EndCell = ToCell(Box.Min + (Axis == 0 ? FVector2D(Distance, 0.f) : FVector2D(0.f, Distance)));
+		const int32 First = FMath::Min((Axis == 0 ? MinCell.X : MinCell.Y) - 1, AxisSize - 1);
+		const int32 Last = FMath::Max(Axis == 0 ? EndCell.X : EndCell.Y, 0);
+		for (int32 Line = First; Line >= Last; Line--)
+		{
+			if (IsLineSolid(Line))
+			{
+				return FMath::Max(Distance, Origin[Axis] + (Line + 1) * CellSize - Edge);
+			}
+		}
+	}
+	return Distance;
+}
+
+bool FLevelCollisionGrid::HasLineOfSight(const FVector2D& From, const FVector2D& To) const
+{
+	//Amanatides & Woo grid traversal
+	FIntPoint Cell = ToCell(From);
+	const FIntPoint EndCell = ToCell(To);
+	const FVector2D Delta = To - From;
+	const int32 StepX = Delta.X > 0.f ? 1 : -1;
+	const int32 StepZ = Delta.Y > 0.f ? 1 : -1;
+	const FVector2D LocalFrom = (From - Origin) / CellSize;
+
+	const float TDeltaX = Delta.X != 0.f ? FMath::Abs(CellSize / Delta.X) : MAX_flt;
+	const float TDeltaZ = Delta.Y != 0.f ? FMath::Abs(CellSize / Delta.Y) : MAX_flt;
+	const float NextBoundaryX = StepX > 0 ? FMath::FloorToFloat(LocalFrom.X) + 1.f - LocalFrom.X : LocalFrom.X - FMath::FloorToFloat(LocalFrom.X);
+	const float NextBoundaryZ = StepZ > 0 ? FMath::FloorToFloat(LocalFrom.Y) + 1.f - LocalFrom.Y : LocalFrom.Y - FMath::FloorToFloat(LocalFrom.Y);
+	float TMaxX = Delta.X != 0.f ? NextBoundaryX * TDeltaX : MAX_flt;
+	float TMaxZ = Delta.Y != 0.f ? NextBoundaryZ * TDeltaZ : MAX_flt;
+
+	const int32 MaxSteps = FMath::Abs(EndCell.X - Cell.X) + FMath::Abs(EndCell.Y - Cell.Y);
+	for (int32 Step = 0; Step <= MaxSteps; Step++)
+	{
+		if (IsSolid(Cell.X, Cell.Y))
+		{
+			return false;
+		}
+		if (Cell == EndCell)
+		{
+			break;
+		}
+		if (TMaxX < TMaxZ)
+		{
+			TMaxX += TDeltaX;
+			Cell.X += StepX;
+		}
+		else
+		{
+			TMaxZ += TDeltaZ;
+			Cell.Y += StepZ;
+		}
+	}
+	return true;
+}
+
+FIntPoint FLevelCollisionGrid::ToCellExclusiveMax(const FVector2D& Max) const
+{
+	//a box ending exactly on a cell edge doesn't touch the next cell
+	const FIntPoint Cell = ToCell(Max);
+	const FVector2D Local = (Max - Origin) / CellSize;
+	return FIntPoint(
+		Local.X == FMath::FloorToFloat(Local.X) ? Cell.X - 1 : Cell.X,
+		Local.Y == FMath::FloorToFloat(Local.Y) ? Cell.Y - 1 : Cell.Y);
+}
@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+
+class ULevel;
+class UPrimitiveComponent;
+class UWorld;
+
+/**
+ * Solid/empty cells of the level's static collision on the XZ plane.
+ * Built from the collision shapes of non-movable primitives, and patched where streamed levels come and go;
+ * only changed on the game thread, so worker threads can query it in between. Cells outside the grid are empty.
+ * Each solid cell also keeps the bounds of the geometry inside it, to 1/255 of a cell, for IsBoxOverlappingSolid.
+ */
+class VICTOR_API FLevelCollisionGrid
+{
+public:
+	/** Rasterizes every non-movable primitive that blocks Channel */
+	void Build(UWorld* World, float InCellSize, ECollisionChannel Channel = ECC_Pawn);
+
+	/** Sets up the grid around the boxes, with a cell of padding, and fills them */
+	void Build(const TArray<FBox2D>& Boxes, float InCellSize);
+
+	/** XZ boxes of the non-movable primitives in Level that block Channel, what Build rasterizes for that level */
+	static void GatherLevelBoxes(const ULevel* Level, TArray<FBox2D>& OutBoxes, ECollisionChannel Channel = ECC_Pawn);
+
+	/** XZ boxes of the collision shapes of one primitive where it is now, movable or not */
+	static void GatherComponentBoxes(UPrimitiveComponent* Component, TArray<FBox2D>& OutBoxes);
+
+	/** Hash of the boxes, in order. Equal for the same level content gathered twice */
+	static uint32 HashBoxes(const TArray<FBox2D>& Boxes);
+
+	/** Sets up an empty grid, used by Build and by synthetic levels in benchmarks */
+	void Init(const FVector2D& InOrigin, float InCellSize, int32 InSizeX, int32 InSizeZ);
+
+	/** Marks every cell the box touches as solid */
+	void FillBox(const FBox2D& Box);
+
+	/** Marks the cells touched by both boxes as solid */
+	void FillBoxWithin(const FBox2D& Box, const FBox2D& Within);
+
+	/** Marks every cell the box touches as empty */
+	void ClearBox(const FBox2D& Box);
+
+	/** True if every cell the box touches is inside the grid */
+	bool Covers(const FBox2D& Box) const;
+
+	/** Adds whole cells around a built grid until it covers the box, keeping the cells it has */
+	void GrowToCover(const FBox2D& Box);
+
+	void Reset();
+
+	bool IsBuilt() const { return SizeX > 0 && SizeZ > 0; }
+
+	float GetCellSize() const { return CellSize; }
+
+	FIntPoint GetSize() const { return FIntPoint(SizeX, SizeZ); }
+
+	FVector2D GetOrigin() const { return Origin; }
+
+	FIntPoint ToCell(const FVector2D& Location) const
+	{
+		return FIntPoint(FMath::FloorToInt((Location.X - Origin.X) / CellSize), FMath::FloorToInt((Location.Y - Origin.Y) / CellSize));
+	}
+
+	FBox2D GetCellBounds(const FIntPoint& Cell) const
+	{
+		const FVector2D Min = Origin + FVector2D(Cell.X * CellSize, Cell.Y * CellSize);
+		return FBox2D(Min, Min + FVector2D(CellSize, CellSize));
+	}
+
+	bool IsSolid(int32 X, int32 Z) const
+	{
+		return X >= 0 && Z >= 0 && X < SizeX && Z < SizeZ && Solid[Z * SizeX + X];
+	}
+
+	bool IsSolidAt(const FVector2D& Location) const
+	{
+		const FIntPoint Cell = ToCell(Location);
+		return IsSolid(Cell.X, Cell.Y);
+	}
+
+	/** True if any solid cell overlaps the box */
+	bool IsBoxBlocked(const FBox2D& Box) const;
+
+	/**
+	 * True if the geometry of any solid cell overlaps the box, tested against the bounds of what the cell holds
+	 * rather than the whole cell, so a box a few units short of a wall doesn't touch it. Boxes only touching edges don't overlap.
+	 */
+	bool IsBoxOverlappingSolid(const FBox2D& Box) const;
+
+	/**
+	 * How far the box can move along one axis (0 for X, 1 for Z) before it touches a solid cell, clamped to Distance.
+	 * Cells the box already overlaps don't block it.
+	 */
+	float SweepBox(const FBox2D& Box, int32 Axis, float Distance) const;
+
+	/** Walks the cells between the two points, true if none of them is solid */
+	bool HasLineOfSight(const FVector2D& From, const FVector2D& To) const;
+
+private:
+	FIntPoint ToCellExclusiveMax(const FVector2D& Max) const;
+
+	/** Marks the cells solid and grows their bounds by the part of the box inside each of them */
+	void FillCells(const FBox2D& Box, const FIntPoint& MinCell, const FIntPoint& MaxCell);
+
+	void ClearCells(const FIntPoint& MinCell, const FIntPoint& MaxCell);
+
+	FVector2D Origin = FVector2D::ZeroVector;
+
+	float CellSize = 32.f;
+
+	int32 SizeX = 0;
+
+	int32 SizeZ = 0;
+
+	TBitArray<> Solid;
+
+	//bounds of the geometry in each solid cell as fractions of the cell, min X, min Z, max X and max Z in 8 bits each
+	TArray<uint32> SolidBounds;
+};
@@ -0,0 +1,267 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LevelGridSubsystem.h"
+
+#include "VictorStats.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+
+DECLARE_CYCLE_STAT(TEXT("Build level collision grid"), STAT_VictorBuildCollisionGrid, STATGROUP_Victor);
+DECLARE_CYCLE_STAT(TEXT("Update level collision grid"), STAT_VictorUpdateCollisionGrid, STATGROUP_Victor);
+
+static bool IsMovableBlocker(const UPrimitiveComponent* Component)
+{
+	return Component->Mobility == EComponentMobility::Movable
+		&& Component->IsCollisionEnabled()
+		&& Component->GetCollisionResponseToChannel(ECC_Pawn) == ECR_Block;
+}
+
+void ULevelGridSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &ULevelGridSubsystem::OnLevelAdded);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &ULevelGridSubsystem::OnLevelRemoved);
+	ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &ULevelGridSubsystem::OnActorSpawned));
+}
+
+void ULevelGridSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	CollisionGrid.Reset();
+	MovableBlockers.Empty();
+	MovableBlockerHash.Reset();
+	LevelBoxes.Empty();
+	PendingAddedLevels.Empty();
+	PendingClearBoxes.Empty();
+
+	Super::Deinitialize();
+}
+
+const FLevelCollisionGrid& ULevelGridSubsystem::GetCollisionGrid()
+{
+	check(IsInGameThread());
+	if (bCollisionGridDirty)
+	{
+		BuildCollisionGrid();
+	}
+	else if (HasPendingLevelChanges())
+	{
+		ApplyLevelChanges();
+	}
+	return CollisionGrid;
+}
+
+uint32 ULevelGridSubsystem::GetLevelContentHash(const ULevel* Level) const
+{
+	const TArray<FBox2D>* Boxes = LevelBoxes.Find(Level);
+	return Boxes != nullptr ? FLevelCollisionGrid::HashBoxes(*Boxes) : 0;
+}
+
+void ULevelGridSubsystem::BuildCollisionGrid()
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorBuildCollisionGrid);
+	LevelBoxes.Reset();
+	PendingAddedLevels.Reset();
+	PendingClearBoxes.Reset();
+
+	TArray<FBox2D> Boxes;
+	for (ULevel* Level : GetWorld()->GetLevels())
+	{
+		if (Level != nullptr)
+		{
+			TArray<FBox2D>& Added = LevelBoxes.Add(Level);
+			FLevelCollisionGrid::GatherLevelBoxes(Level, Added);
+			Boxes.Append(Added);
+			for (AActor* Actor : Level->Actors)
+			{
+				RegisterMovableBlockers(Actor);
+			}
+		}
+	}
+	CollisionGrid.Build(Boxes, CellSize);
+	bCollisionGridDirty = false;
+	NumFullBuilds++;
+	GridRevision++;
+}
+
+void ULevelGridSubsystem::ApplyLevelChanges()
+{
+	SCOPE_CYCLE_COUNTER(STAT_VictorUpdateCollisionGrid);
+
+	if (PendingClearBoxes.Num() > 0)
+	{
+		for (const FBox2D& Box : PendingClearBoxes)
+		{
+			CollisionGrid.ClearBox(Box);
+		}
+		//geometry of the levels still there may share the cleared cells
+		for (const TPair<TObjectKey<ULevel>, TArray<FBox2D>>& Pair : LevelBoxes)
+		{
+			for (const FBox2D& Box : Pair.Value)
+			{
+				for (const FBox2D& Cleared : PendingClearBoxes)
+				{
+					if (Box.Intersect(Cleared))
+					{
+						CollisionGrid.FillBoxWithin(Box, Cleared);
+					}
+				}
+			}
+		}
+		PendingClearBoxes.Reset();
+	}
+
+	if (PendingAddedLevels.Num() > 0 && !CollisionGrid.IsBuilt())
+	{
+		//there was no geometry so far, set the grid up around what the new levels bring
+		BuildCollisionGrid();
+		return;
+	}
+	for (const TWeakObjectPtr<ULevel>& WeakLevel : PendingAddedLevels)
+	{
+		ULevel* Level = WeakLevel.Get();
+		if (Level == nullptr)
+		{
+			continue;
+		}
+		TArray<FBox2D>& Boxes = LevelBoxes.Add(Level);
+		FLevelCollisionGrid::GatherLevelBoxes(Level, Boxes);
+		for (AActor* Actor : Level->Actors)
+		{
+			RegisterMovableBlockers(Actor);
+		}
+		if (Boxes.Num() == 0)
+		{
+			continue;
+		}
+		FBox2D Bounds(ForceInit);
+		for (const FBox2D& Box : Boxes)
+		{
+			Bounds += Box;
+		}
+		CollisionGrid.GrowToCover(Bounds.ExpandBy(CellSize));
+		for (const FBox2D& Box : Boxes)
+		{
+			CollisionGrid.FillBox(Box);
+		}
+	}
+	PendingAddedLevels.Reset();
+	GridRevision++;
+}
+
+void ULevelGridSubsystem::OnLevelAdded(ULevel* Level, UWorld* World)
+{
+	if (World != GetWorld() || bCollisionGridDirty)
+	{
+		return;
+	}
+	if (Level == nullptr)
+	{
+		bCollisionGridDirty = true;
+		return;
+	}
+	//gathered when the grid is next asked for, the level's actors may still be initializing
+	PendingAddedLevels.AddUnique(Level);
+}
+
+void ULevelGridSubsystem::OnLevelRemoved(ULevel* Level, UWorld* World)
+{
+	if (World != GetWorld() || bCollisionGridDirty)
+	{
+		return;
+	}
+	if (Level == nullptr)
+	{
+		bCollisionGridDirty = true;
+		return;
+	}
+	//added and removed again before the grid saw it
+	if (PendingAddedLevels.Remove(Level) > 0)
+	{
+		return;
+	}
+	TArray<FBox2D> Boxes;
+	if (LevelBoxes.RemoveAndCopyValue(Level, Boxes))
+	{
+		PendingClearBoxes.Append(Boxes);
+	}
+}
+
+void ULevelGridSubsystem::OnActorSpawned(AActor* Actor)
+{
+	RegisterMovableBlockers(Actor);
+}
+
+void ULevelGridSubsystem::RegisterMovableBlockers(AActor* Actor)
+{
+	//characters don't hang from each other
+	if (Actor == nullptr || Actor->IsA<APawn>())
+	{
+		return;
+	}
+	for (UActorComponent* ActorComponent : Actor->GetComponents())
+	{
+		UPrimitiveComponent* Component = Cast<UPrimitiveComponent>(ActorComponent);
+		if (Component != nullptr && IsMovableBlocker(Component) && !MovableBlockerHash.Contains(Component))
+		{
+			MovableBlockers.Add(Component);
+			MovableBlockerHash.Add(Component, ToPlane2D(Component->Bounds.Origin), FVector2D(Component->Bounds.SphereRadius, Component->Bounds.SphereRadius));
+		}
+	}
+}
+
+void ULevelGridSubsystem::RefreshMovableBlockers()
+{
+	if (MovableBlockersFrame == GFrameCounter)
+	{
+		return;
+	}
+	MovableBlockersFrame = GFrameCounter;
+	for (int32 Index = MovableBlockers.Num() - 1; Index >= 0; Index--)
+	{
+		const TWeakObjectPtr<UPrimitiveComponent> Key = MovableBlockers[Index];
+		const UPrimitiveComponent* Component = Key.Get();
+		if (Component == nullptr || !IsMovableBlocker(Component))
+		{
+			MovableBlockerHash.Remove(Key);
+			MovableBlockers.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+		MovableBlockerHash.Move(Key, ToPlane2D(Component->Bounds.Origin));
+	}
+}
+
+bool ULevelGridSubsystem::IsBoxOverlappingMovableBlocker(const FBox2D& Box, const AActor* Ignore)
+{
+	check(IsInGameThread());
+	RefreshMovableBlockers();
+
+	bool bOverlapping = false;
+	TArray<FBox2D> Boxes;
+	MovableBlockerHash.ForEachInBox(Box, [&](const TWeakObjectPtr<UPrimitiveComponent>& Key, const FVector2D& Center, const FVector2D& HalfExtent)
+	{
+		UPrimitiveComponent* Component = Key.Get();
+		if (bOverlapping || Component == nullptr || (Ignore != nullptr && Component->GetOwner() == Ignore))
+		{
+			return;
+		}
+		//the hash only knows the bounding sphere, the collision shapes decide
+		Boxes.Reset();
+		FLevelCollisionGrid::GatherComponentBoxes(Component, Boxes);
+		for (const FBox2D& Blocker : Boxes)
+		{
+			if (Box.Min.X < Blocker.Max.X && Box.Max.X > Blocker.Min.X && Box.Min.Y < Blocker.Max.Y && Box.Max.Y > Blocker.Min.Y)
+			{
+				bOverlapping = true;
+				return;
+			}
+		}
+	});
+	return bOverlapping;
+}
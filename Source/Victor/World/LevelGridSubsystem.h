@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "World/LevelCollisionGrid.h"
+#include "World/SpatialHash2D.h"
+#include "LevelGridSubsystem.generated.h"
+
+/**
+ * Owns the baked 2D collision grid of the loaded level.
+ * The grid is built on first use. A streamed level added or removed only updates the cells its own geometry covers,
+ * from the boxes gathered when it was added, so chunk streaming doesn't iterate every actor in the world.
+ */
+UCLASS(config=Game)
+class VICTOR_API ULevelGridSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	virtual void Deinitialize() override;
+
+	/** Game thread only; the returned grid may be read from worker threads until the next call */
+	const FLevelCollisionGrid& GetCollisionGrid();
+
+	/** Number of full rebuilds, the rest of the changes only touched the cells of a streamed level */
+	int32 GetNumFullBuilds() const { return NumFullBuilds; }
+
+	/** Goes up every time the grid is built or patched */
+	int32 GetGridRevision() const { return GridRevision; }
+
+	/** Hash of the geometry the level put into the grid, 0 if it is not in it. Call GetCollisionGrid first */
+	uint32 GetLevelContentHash(const ULevel* Level) const;
+
+	/** Boxes the level put into the grid, nullptr if it is not in it. Call GetCollisionGrid first */
+	const TArray<FBox2D>* FindLevelBoxes(const ULevel* Level) const { return LevelBoxes.Find(Level); }
+
+	/** True if a streamed level was added or removed since the last GetCollisionGrid */
+	bool HasPendingLevelChanges() const { return PendingAddedLevels.Num() > 0 || PendingClearBoxes.Num() > 0; }
+
+	/** Forces a rebuild on the next GetCollisionGrid, e.g. after moving level geometry */
+	UFUNCTION(BlueprintCallable, Category = LevelGrid)
+	void MarkCollisionGridDirty() { bCollisionGridDirty = true; }
+
+	/**
+	 * True if the box overlaps the collision of a movable primitive that blocks characters, like a moving platform.
+	 * Pawns aren't in the hash; components of Ignore are skipped. Game thread only.
+	 */
+	bool IsBoxOverlappingMovableBlocker(const FBox2D& Box, const AActor* Ignore = nullptr);
+
+	/** Adds the movable primitives of the actor that block characters, for actors made movable or blocking after they spawned */
+	void RegisterMovableBlockers(AActor* Actor);
+
+	int32 GetNumMovableBlockers() const { return MovableBlockers.Num(); }
+
+	/** Size of a grid cell in unreal units. Smaller is more precise and uses more memory */
+	UPROPERTY(Config, EditAnywhere, Category = LevelGrid)
+	float CellSize = 32.f;
+
+protected:
+	void OnLevelAdded(ULevel* Level, UWorld* World);
+
+	void OnLevelRemoved(ULevel* Level, UWorld* World);
+
+	void OnActorSpawned(AActor* Actor);
+
+	void BuildCollisionGrid();
+
+	/** Moves the movable blockers to where they are this frame and drops the ones gone or no longer blocking */
+	void RefreshMovableBlockers();
+
+	/** Patches the cells of the levels added and removed since the grid was last updated */
+	void ApplyLevelChanges();
+
+	FLevelCollisionGrid CollisionGrid;
+
+	bool bCollisionGridDirty = true;
+
+	//boxes each level put into the grid
+	TMap<TObjectKey<ULevel>, TArray<FBox2D>> LevelBoxes;
+
+	TArray<TWeakObjectPtr<ULevel>> PendingAddedLevels;
+
+	//boxes of removed levels, their cells are cleared and what other levels have there is filled back in
+	TArray<FBox2D> PendingClearBoxes;
+
+	TArray<TWeakObjectPtr<UPrimitiveComponent>> MovableBlockers;
+
+	//entries are as large as the bounding sphere, so turning platforms stay in the cells they are hashed to
+	TSpatialHash2D<TWeakObjectPtr<UPrimitiveComponent>> MovableBlockerHash;
+
+	uint64 MovableBlockersFrame = MAX_uint64;
+
+	int32 NumFullBuilds = 0;
+
+	int32 GridRevision = 0;
+
+	FDelegateHandle LevelAddedHandle;
+
+	FDelegateHandle LevelRemovedHandle;
+
+	FDelegateHandle ActorSpawnedHandle;
+};
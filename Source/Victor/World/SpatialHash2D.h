@@ -0,0 +1,187 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Converts a world location to the XZ plane the game is played on */
+FORCEINLINE FVector2D ToPlane2D(const FVector& Location)
+{
+	return FVector2D(Location.X, Location.Z);
+}
+
+/**
+ * Uniform grid hash of 2D boxes on the XZ plane.
+ * Entries live in the cell that holds their center; queries are grown by the largest half extent seen,
+ * so boxes spanning several cells are still found. Moving an entry only touches the cell lists when it changes cell.
+ */
+template<typename KeyType>
+class TSpatialHash2D
+{
+public:
+	explicit TSpatialHash2D(float InCellSize = 256.f)
+		: CellSize(InCellSize)
+	{
+	}
+
+	void Add(KeyType Key, const FVector2D& Center, const FVector2D& HalfExtent)
+	{
+		if (EntryIndices.Contains(Key))
+		{
+			Move(Key, Center);
+			return;
+		}
+		const int32 Index = Entries.Add({ Key, Center, HalfExtent, ToCell(Center) });
+		EntryIndices.Add(Key, Index);
+		AddToCell(Index);
+		MaxHalfExtent = FVector2D(FMath::Max(MaxHalfExtent.X, HalfExtent.X), FMath::Max(MaxHalfExtent.Y, HalfExtent.Y));
+	}
+
+	void Move(KeyType Key, const FVector2D& Center)
+	{
+		const int32* Index = EntryIndices.Find(Key);
+		if (Index == nullptr)
+		{
+			return;
+		}
+		FEntry& Entry = Entries[*Index];
+		Entry.Center = Center;
+		const FIntPoint NewCell = ToCell(Center);
+		if (NewCell != Entry.Cell)
+		{
+			RemoveFromCell(*Index);
+			Entry.Cell = NewCell;
+			AddToCell(*Index);
+		}
+	}
+
+	void Remove(KeyType Key)
+	{
+		int32 Index = INDEX_NONE;
+		if (!EntryIndices.RemoveAndCopyValue(Key, Index))
+		{
+			return;
+		}
+		RemoveFromCell(Index);
+		const int32 LastIndex = Entries.Num() - 1;
+		if (Index != LastIndex)
+		{
+			RemoveFromCell(LastIndex);
+			Entries[Index] = Entries[LastIndex];
+			AddToCell(Index);
+			EntryIndices.Add(Entries[Index].Key, Index);
+		}
+		Entries.Pop(false);
+	}
+
+	bool Contains(KeyType Key) const { return EntryIndices.Contains(Key); }
+
+	int32 Num() const { return Entries.Num(); }
+
+	void Reset()
+	{
+		Entries.Reset();
+		EntryIndices.Reset();
+		Cells.Reset();
+		MaxHalfExtent = FVector2D::ZeroVector;
+	}
+
+	/**
+	 * Calls Visitor(Key, Center, HalfExtent) for every entry whose box overlaps Box.
+	 * Returns how many entries were examined, overlapping or not.
+	 */
+	template<typename VisitorType>
+	int32 ForEachInBox(const FBox2D& Box, VisitorType&& Visitor) const
+	{
+		const FVector2D BoxCenter = Box.GetCenter();
+		const FVector2D BoxExtent = Box.GetExtent();
+		const FIntPoint MinCell = ToCell(Box.Min - MaxHalfExtent);
+		const FIntPoint MaxCell = ToCell(Box.Max + MaxHalfExtent);
+		int32 NumExamined = 0;
+		for (int32 CellX = MinCell.X; CellX <= MaxCell.X; CellX++)
+		{
+			for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; CellY++)
+			{
+				const FCellEntries* CellEntries = Cells.Find(FIntPoint(CellX, CellY));
+				if (CellEntries == nullptr)
+				{
+					continue;
+				}
+				for (const int32 Index : *CellEntries)
+				{
+					const FEntry& Entry = Entries[Index];
+					NumExamined++;
+					if (FMath::Abs(Entry.Center.X - BoxCenter.X) <= Entry.HalfExtent.X + BoxExtent.X
+						&& FMath::Abs(Entry.Center.Y - BoxCenter.Y) <= Entry.HalfExtent.Y + BoxExtent.Y)
+					{
+						Visitor(Entry.Key, Entry.Center, Entry.HalfExtent);
+					}
+				}
+			}
+		}
+		return NumExamined;
+	}
+
+	/** Finds the entry whose box contains Point with the center closest to it, skipping keys Predicate rejects */
+	template<typename PredicateType>
+	bool FindAtPoint(const FVector2D& Point, PredicateType&& Predicate, KeyType& OutKey) const
+	{
+		float BestDistanceSquared = MAX_flt;
+		bool bFound = false;
+		ForEachInBox(FBox2D(Point, Point), [&](KeyType Key, const FVector2D& Center, const FVector2D& HalfExtent)
+		{
+			const float DistanceSquared = FVector2D::DistSquared(Center, Point);
+			if (DistanceSquared < BestDistanceSquared && Predicate(Key))
+			{
+				BestDistanceSquared = DistanceSquared;
+				OutKey = Key;
+				bFound = true;
+			}
+		});
+		return bFound;
+	}
+
+private:
+	struct FEntry
+	{
+		KeyType Key;
+		FVector2D Center;
+		FVector2D HalfExtent;
+		FIntPoint Cell;
+	};
+
+	typedef TArray<int32, TInlineAllocator<8>> FCellEntries;
+
+	FIntPoint ToCell(const FVector2D& Point) const
+	{
+		return FIntPoint(FMath::FloorToInt(Point.X / CellSize), FMath::FloorToInt(Point.Y / CellSize));
+	}
+
+	void AddToCell(int32 Index)
+	{
+		Cells.FindOrAdd(Entries[Index].Cell).Add(Index);
+	}
+
+	void RemoveFromCell(int32 Index)
+	{
+		const FIntPoint Cell = Entries[Index].Cell;
+		if (FCellEntries* CellEntries = Cells.Find(Cell))
+		{
+			CellEntries->RemoveSingleSwap(Index, false);
+			if (CellEntries->Num() == 0)
+			{
+				Cells.Remove(Cell);
+			}
+		}
+	}
+
+	float CellSize;
+
+	FVector2D MaxHalfExtent = FVector2D::ZeroVector;
+
+	TArray<FEntry> Entries;
+
+	TMap<KeyType, int32> EntryIndices;
+
+	TMap<FIntPoint, FCellEntries> Cells;
+};